@@ -0,0 +1,456 @@
+/*
+ * libFuzzer harness for the game's input surfaces: console line parsing,
+ * board events, ASCII UART commands (name entry, seed mode) and framed
+ * protocol traffic.
+ *
+ * The input is a stream of fixed three-byte records, `op a b`, each of
+ * which becomes one or more events. A custom mutator edits whole records
+ * so most mutations still decode to a meaningful script. The game is set
+ * up once; every run recycles it instead of calling board_init or
+ * game_init again. Output goes to a hardware context with no sink. Each
+ * input gets FUZZ_TIME_BUDGET_MS of virtual time, so a "tick" line or a
+ * run of long waits cannot spend it idling in attract mode.
+ *
+ * Cost grows with the record count. Looping the custom mutator into
+ * LLVMFuzzerTestOneInput from a plain gcc -O1 driver, without sanitizers
+ * or coverage, on one core: about 25k runs/s at the full 768 bytes and
+ * 0.8-1M runs/s for four-record inputs. Pass a smaller -max_len to trade
+ * script depth for rate.
+ *
+ * Build with clang from the repository root:
+ *
+ *   clang -std=gnu11 -g -O1 -fsanitize=fuzzer,address,undefined \
+ *       -DFLIGHT_RECORDER_ENABLED=0 -Isrc \
+ *       fuzz/fuzz_game.c src/board.c src/eeprom.c src/flight.c src/format.c \
+ *       src/game.c src/hardware.c src/journal.c src/protocol.c \
+ *       src/input.c src/seqlock.c src/sequence.c src/sketch.c \
+ *       src/timer_wheel.c -o fuzz_game
+ *   ./fuzz_game -max_len=768
+ */
+#include "board.h"
+#include "game.h"
+#include "hardware.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_RECORD_SIZE   3u
+// Virtual time one input may spend: the name-entry timeout and a few
+// levels at the slowest playback, but not an afternoon of attract mode.
+#define FUZZ_TIME_BUDGET_MS 30000u
+
+typedef enum {
+    FUZZ_OP_TICKS = 0,      // a % 32 + 1 ticks
+    FUZZ_OP_TICKS_LONG,     // (a + 1) * 16 ms of virtual time
+    FUZZ_OP_RUN_TIMER,      // skip to the next a % 4 + 1 deadlines
+    FUZZ_OP_BUTTON,         // pad a % SIMON_BUTTON_COUNT, long press if b is odd
+    FUZZ_OP_PRESS_EXPECTED, // the pad the game is waiting for, if any
+    FUZZ_OP_COMMAND,        // ASCII UART command a
+    FUZZ_OP_POT,            // pot reading from a and b
+    FUZZ_OP_TEXT_CHAR,      // append a to the pending text event
+    FUZZ_OP_TEXT_SEND,
+    FUZZ_OP_LINE_CHAR,      // append a to the pending console line
+    FUZZ_OP_LINE_SEND,
+    FUZZ_OP_UART_CHAR,      // append a to the pending UART burst
+    FUZZ_OP_UART_SEND,
+    FUZZ_OP_FRAME_SEND,     // wrap the UART burst in a valid frame
+    FUZZ_OP_COUNT
+} fuzz_op_t;
+
+typedef struct {
+    size_t text_length;
+    size_t line_length;
+    size_t uart_length;
+    char text[BOARD_MAX_TEXT];
+    char line[BOARD_MAX_LINE];
+    uint8_t uart[BOARD_MAX_UART_BYTES];
+} fuzz_scratch_t;
+
+static simon_game_t game;
+static simon_game_cold_t game_cold;
+// The leaderboard's seqlock count after the last restore; if it moved, the
+// run wrote the board.
+static uint32_t highscores_sequence;
+static uint32_t time_left_ms;
+static timer_wheel_t game_wheel;
+static simon_protocol_t protocol;
+static hardware_context_t null_hardware;
+
+size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t max_size);
+
+static void check_invariants(void)
+{
+    const char *broken = game_check_invariants(&game);
+
+    if (broken != NULL) {
+        fprintf(stderr, "invariant failed: %s\n", broken);
+        abort();
+    }
+}
+
+static void dispatch(const board_event_t *event)
+{
+    // As in the console loop, events take no virtual time of their own.
+    protocol_handle_event(&protocol, &game, event);
+}
+
+// Cut a wait down to what is left of this input's budget, and spend it.
+static uint32_t take_time(uint32_t ms)
+{
+    if (ms > time_left_ms) {
+        ms = time_left_ms;
+    }
+    time_left_ms -= ms;
+    return ms;
+}
+
+static void run_ticks(uint32_t count)
+{
+    while (count-- > 0u) {
+        game_tick_1ms(&game);
+    }
+}
+
+/*
+ * Ticking a few thousand idle milliseconds would dominate every run, so
+ * long waits jump the wheel over its idle stretches. Returns false once
+ * the next deadline is past the budget.
+ */
+static bool skip_to_deadline(void)
+{
+    uint32_t next = game_next_wakeup(&game);
+
+    if (next == TIMER_WHEEL_IDLE || next > time_left_ms) {
+        return false;
+    }
+    time_left_ms -= next;
+    game_advance_ms(&game, next);
+    return true;
+}
+
+static void press_button(uint8_t button, bool long_press)
+{
+    board_event_t event = {
+        .type = BOARD_EVENT_BUTTON,
+        .data.button = {.button = (board_button_t)button, .long_press = long_press},
+    };
+    dispatch(&event);
+}
+
+static void send_frame(const fuzz_scratch_t *scratch)
+{
+    uint8_t length = (uint8_t)scratch->uart_length;
+    uint16_t crc = protocol_crc16(0xFFFFu, length);
+
+    protocol_handle_uart_byte(&protocol, &game, PROTOCOL_SOF);
+    protocol_handle_uart_byte(&protocol, &game, length);
+    for (size_t i = 0u; i < scratch->uart_length; ++i) {
+        crc = protocol_crc16(crc, scratch->uart[i]);
+        protocol_handle_uart_byte(&protocol, &game, scratch->uart[i]);
+    }
+    protocol_handle_uart_byte(&protocol, &game, (uint8_t)(crc >> 8));
+    protocol_handle_uart_byte(&protocol, &game, (uint8_t)crc);
+}
+
+static void run_record(fuzz_scratch_t *scratch, uint8_t op, uint8_t a, uint8_t b)
+{
+    board_event_t event = {.type = BOARD_EVENT_NONE};
+
+    switch ((fuzz_op_t)(op % FUZZ_OP_COUNT)) {
+    case FUZZ_OP_TICKS:
+        run_ticks(take_time(a % 32u + 1u));
+        break;
+
+    case FUZZ_OP_TICKS_LONG:
+        game_advance_ms(&game, take_time((a + 1u) * 16u));
+        break;
+
+    case FUZZ_OP_RUN_TIMER:
+        for (uint8_t i = 0u; i <= a % 4u; ++i) {
+            if (!skip_to_deadline()) {
+                break;
+            }
+        }
+        break;
+
+    case FUZZ_OP_BUTTON:
+        press_button(a % SIMON_BUTTON_COUNT, (b & 1u) != 0u);
+        break;
+
+    case FUZZ_OP_PRESS_EXPECTED:
+        if (game.state == SIMON_STATE_WAIT_INPUT) {
+            press_button(sequence_get(&game.sequence, game.input_step), false);
+        }
+        break;
+
+    case FUZZ_OP_COMMAND:
+        event.type = BOARD_EVENT_COMMAND;
+        event.data.command.value = (char)a;
+        dispatch(&event);
+        break;
+
+    case FUZZ_OP_POT:
+        event.type = BOARD_EVENT_POT;
+        event.data.pot.value = (uint16_t)(((a << 8) | b) & 0x3FFu);
+        dispatch(&event);
+        break;
+
+    case FUZZ_OP_TEXT_CHAR:
+        if (scratch->text_length + 1u < sizeof scratch->text && a != 0u) {
+            scratch->text[scratch->text_length++] = (char)a;
+        }
+        break;
+
+    case FUZZ_OP_TEXT_SEND:
+        event.type = BOARD_EVENT_TEXT;
+        memcpy(event.data.text.text, scratch->text, scratch->text_length);
+        event.data.text.text[scratch->text_length] = '\0';
+        scratch->text_length = 0u;
+        dispatch(&event);
+        break;
+
+    case FUZZ_OP_LINE_CHAR:
+        if (scratch->line_length + 1u < sizeof scratch->line && a != '\n') {
+            scratch->line[scratch->line_length++] = (char)a;
+        }
+        break;
+
+    case FUZZ_OP_LINE_SEND: {
+        uint32_t clock_ms = 0u;
+        scratch->line[scratch->line_length] = '\0';
+        scratch->line_length = 0u;
+        event = board_parse_line(scratch->line, &clock_ms);
+        if (event.type != BOARD_EVENT_QUIT) {
+            // "tick <n>" may ask for a day; it gets what the budget has left.
+            game_advance_ms(&game, take_time(event.timestamp_ms));
+            dispatch(&event);
+        }
+        break;
+    }
+
+    case FUZZ_OP_UART_CHAR:
+        if (scratch->uart_length < sizeof scratch->uart) {
+            scratch->uart[scratch->uart_length++] = a;
+        }
+        break;
+
+    case FUZZ_OP_UART_SEND:
+        event.type = BOARD_EVENT_UART;
+        event.data.uart.length = (uint8_t)scratch->uart_length;
+        memcpy(event.data.uart.bytes, scratch->uart, scratch->uart_length);
+        scratch->uart_length = 0u;
+        dispatch(&event);
+        break;
+
+    case FUZZ_OP_FRAME_SEND:
+        send_frame(scratch);
+        scratch->uart_length = 0u;
+        break;
+
+    case FUZZ_OP_COUNT:
+    default:
+        break;
+    }
+}
+
+/*
+ * Recycling resets the session fields of the cold part; the leaderboard,
+ * best score and sketches are only cleared when this run changed them, as
+ * most runs never finish a game.
+ */
+static void restore_game(void)
+{
+    bool dirty = game_cold.best_score != 0u || game_cold.highscores_lock.sequence != highscores_sequence;
+
+#if SIMON_SKETCH_K > 0
+    dirty = dirty || game_cold.sketches != NULL;
+#endif
+    // Unlink the timer before the wheel is wiped so recycling cannot touch
+    // stale slot pointers.
+    timer_wheel_cancel(&game_wheel, &game.timer);
+    timer_wheel_init(&game_wheel);
+    hardware_context_init(&null_hardware, NULL, NULL);
+    protocol_init(&protocol);
+    game_recycle(&game, &game_wheel, dirty);
+    highscores_sequence = game_cold.highscores_lock.sequence;
+    time_left_ms = FUZZ_TIME_BUDGET_MS;
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+
+    hardware_context_init(&null_hardware, NULL, NULL);
+    hardware_bind_context(&null_hardware);
+    timer_wheel_init(&game_wheel);
+    game_init(&game, &game_cold, &game_wheel);
+    highscores_sequence = game_cold.highscores_lock.sequence;
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    fuzz_scratch_t scratch = {0};
+
+    restore_game();
+    for (size_t i = 0u; i + FUZZ_RECORD_SIZE <= size; i += FUZZ_RECORD_SIZE) {
+        run_record(&scratch, data[i], data[i + 1u], data[i + 2u]);
+        check_invariants();
+    }
+    return 0;
+}
+
+/*
+ * Record-level mutations, with a fallback to libFuzzer's byte mutator for
+ * the argument bytes. The state machine needs long runs of ticks and
+ * presses, so new records lean towards those.
+ */
+static uint32_t mutator_next(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint8_t random_op(uint32_t *rng)
+{
+    static const uint8_t weighted[] = {
+        FUZZ_OP_TICKS, FUZZ_OP_TICKS_LONG, FUZZ_OP_RUN_TIMER, FUZZ_OP_RUN_TIMER,
+        FUZZ_OP_BUTTON, FUZZ_OP_PRESS_EXPECTED, FUZZ_OP_PRESS_EXPECTED, FUZZ_OP_PRESS_EXPECTED,
+        FUZZ_OP_COMMAND, FUZZ_OP_COMMAND, FUZZ_OP_POT, FUZZ_OP_TEXT_CHAR,
+        FUZZ_OP_TEXT_SEND, FUZZ_OP_LINE_CHAR, FUZZ_OP_LINE_SEND, FUZZ_OP_UART_CHAR,
+        FUZZ_OP_UART_SEND, FUZZ_OP_FRAME_SEND,
+    };
+    return weighted[mutator_next(rng) % sizeof weighted];
+}
+
+static void random_record(uint32_t *rng, uint8_t *record)
+{
+    static const char commands[] = "sSrRhHaAzZeEgGkKlL\r\n\b\x7f 0123456789";
+    uint32_t bits = mutator_next(rng);
+
+    record[0] = random_op(rng);
+    record[1] = (uint8_t)bits;
+    record[2] = (uint8_t)(bits >> 8);
+    if (record[0] == FUZZ_OP_COMMAND && (bits & 0x10000u) != 0u) {
+        record[1] = (uint8_t)commands[(bits >> 17) % (sizeof commands - 1u)];
+    }
+}
+
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed)
+{
+    uint32_t rng = seed | 1u;
+    size_t count = size / FUZZ_RECORD_SIZE;
+    size_t capacity = max_size / FUZZ_RECORD_SIZE;
+
+    if (capacity == 0u) {
+        return 0u;
+    }
+
+    switch (mutator_next(&rng) % 6u) {
+    case 0: { // insert a fresh record
+        if (count >= capacity) {
+            break;
+        }
+        size_t at = mutator_next(&rng) % (count + 1u);
+        memmove(data + (at + 1u) * FUZZ_RECORD_SIZE, data + at * FUZZ_RECORD_SIZE, (count - at) * FUZZ_RECORD_SIZE);
+        random_record(&rng, data + at * FUZZ_RECORD_SIZE);
+        count++;
+        break;
+    }
+
+    case 1: { // delete a run of records
+        if (count == 0u) {
+            break;
+        }
+        size_t at = mutator_next(&rng) % count;
+        size_t run = 1u + mutator_next(&rng) % ((count - at < 4u) ? count - at : 4u);
+        memmove(data + at * FUZZ_RECORD_SIZE, data + (at + run) * FUZZ_RECORD_SIZE, (count - at - run) * FUZZ_RECORD_SIZE);
+        count -= run;
+        break;
+    }
+
+    case 2: { // repeat a run of records in place
+        if (count == 0u) {
+            break;
+        }
+        size_t at = mutator_next(&rng) % count;
+        size_t run = 1u + mutator_next(&rng) % ((count - at < 8u) ? count - at : 8u);
+        if (count + run > capacity) {
+            break;
+        }
+        memmove(data + (at + run) * FUZZ_RECORD_SIZE, data + at * FUZZ_RECORD_SIZE, (count - at) * FUZZ_RECORD_SIZE);
+        count += run;
+        break;
+    }
+
+    case 3: { // swap two records
+        if (count < 2u) {
+            break;
+        }
+        uint8_t *x = data + (mutator_next(&rng) % count) * FUZZ_RECORD_SIZE;
+        uint8_t *y = data + (mutator_next(&rng) % count) * FUZZ_RECORD_SIZE;
+        uint8_t held[FUZZ_RECORD_SIZE];
+        memcpy(held, x, FUZZ_RECORD_SIZE);
+        memcpy(x, y, FUZZ_RECORD_SIZE);
+        memcpy(y, held, FUZZ_RECORD_SIZE);
+        break;
+    }
+
+    case 4: { // replace one record
+        if (count == 0u) {
+            break;
+        }
+        random_record(&rng, data + (mutator_next(&rng) % count) * FUZZ_RECORD_SIZE);
+        break;
+    }
+
+    default: { // byte-level edits of the arguments, then realign
+        if (count == 0u) {
+            break;
+        }
+        size_t length = LLVMFuzzerMutate(data, count * FUZZ_RECORD_SIZE, capacity * FUZZ_RECORD_SIZE);
+        count = length / FUZZ_RECORD_SIZE;
+        break;
+    }
+    }
+
+    if (count == 0u) {
+        random_record(&rng, data);
+        count = 1u;
+    }
+    return count * FUZZ_RECORD_SIZE;
+}
+
+size_t LLVMFuzzerCustomCrossOver(const uint8_t *data1, size_t size1, const uint8_t *data2, size_t size2,
+                                 uint8_t *out, size_t max_out_size, unsigned int seed)
+{
+    uint32_t rng = seed | 1u;
+    size_t count1 = size1 / FUZZ_RECORD_SIZE;
+    size_t count2 = size2 / FUZZ_RECORD_SIZE;
+    size_t capacity = max_out_size / FUZZ_RECORD_SIZE;
+    size_t head = (count1 == 0u) ? 0u : mutator_next(&rng) % (count1 + 1u);
+    size_t tail_start = (count2 == 0u) ? 0u : mutator_next(&rng) % (count2 + 1u);
+    size_t tail = count2 - tail_start;
+
+    // Keep a prefix of the first script and finish with a suffix of the
+    // second, so the splice point lands on a record boundary.
+    if (head > capacity) {
+        head = capacity;
+    }
+    if (head + tail > capacity) {
+        tail = capacity - head;
+    }
+    memcpy(out, data1, head * FUZZ_RECORD_SIZE);
+    memcpy(out + head * FUZZ_RECORD_SIZE, data2 + tail_start * FUZZ_RECORD_SIZE, tail * FUZZ_RECORD_SIZE);
+    return (head + tail) * FUZZ_RECORD_SIZE;
+}
@@ -0,0 +1,186 @@
+"""
+Flash and stack budget report for the firmware image.
+
+Runs after the link step of a PlatformIO build (see `extra_scripts` in
+platformio.ini) and prints:
+
+  * flash and RAM totals from the section headers,
+  * the largest symbols in flash,
+  * the worst-case stack depth from main and from each interrupt vector.
+
+Stack depth combines the per-function frames from -fstack-usage (.su files
+next to the objects) with a call graph read from the disassembly. Indirect
+calls and recursion cannot be bounded statically; the report flags the
+functions involved instead of guessing.
+
+It can also be run by hand against any toolchain:
+
+    python3 scripts/budget_report.py firmware.elf build_dir [tool-prefix]
+"""
+
+import os
+import re
+import subprocess
+import sys
+
+TOP_SYMBOLS = 15
+TOP_FRAMES = 10
+
+FUNCTION_RE = re.compile(r"^[0-9a-f]+ <([^>]+)>:$")
+CALL_RE = re.compile(r"\b(r?call|callq?)\s+(?:0x)?[0-9a-f]+\s+<([^>+]+)>")
+TAIL_RE = re.compile(r"\b(r?jmp|jmpq?)\s+(?:0x)?[0-9a-f]+\s+<([^>+]+)>")
+INDIRECT_RE = re.compile(r"\b(e?icall|e?ijmp|callq?\s+\*)")
+
+
+def run(tool, *args):
+    return subprocess.run([tool, *args], check=True, capture_output=True, text=True).stdout
+
+
+def read_sections(prefix, elf):
+    sections = {}
+    for line in run(prefix + "size", "-A", elf).splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+    return sections
+
+
+def read_symbols(prefix, elf):
+    symbols = []
+    for line in run(prefix + "nm", "--size-sort", "-S", "-t", "d", elf).splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[2] in "tTrRdD":
+            symbols.append((int(fields[1]), fields[2], fields[3]))
+    return sorted(symbols, reverse=True)
+
+
+def read_frames(build_dir):
+    # Each line is "file:line:col:function<TAB>bytes<TAB>static|dynamic|...".
+    frames = {}
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name)) as handle:
+                for line in handle:
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) != 3:
+                        continue
+                    function = fields[0].rsplit(":", 1)[-1]
+                    frames[function] = (int(fields[1]), fields[2] != "static")
+    return frames
+
+
+def read_call_graph(prefix, elf):
+    calls = {}
+    indirect = set()
+    current = None
+    for line in run(prefix + "objdump", "-d", elf).splitlines():
+        header = FUNCTION_RE.match(line)
+        if header:
+            current = header.group(1)
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        for pattern in (CALL_RE, TAIL_RE):
+            match = pattern.search(line)
+            if match:
+                target = match.group(2).split("@")[0]
+                if target != current:
+                    calls[current].add(target)
+        if INDIRECT_RE.search(line):
+            indirect.add(current)
+    return calls, indirect
+
+
+def worst_stack(function, frames, calls, memo, active):
+    """Deepest stack below `function`, plus the notes found on the way."""
+    if function in memo:
+        return memo[function]
+    if function in active:
+        return 0, [function], {"recursion: " + function}
+
+    active.add(function)
+    frame, dynamic = frames.get(function, (0, False))
+    notes = set()
+    if dynamic:
+        notes.add("dynamic frame: " + function)
+
+    best_depth, best_path = 0, []
+    for callee in sorted(calls.get(function, ())):
+        depth, path, callee_notes = worst_stack(callee, frames, calls, memo, active)
+        notes |= callee_notes
+        if depth > best_depth:
+            best_depth, best_path = depth, path
+    active.discard(function)
+
+    memo[function] = (frame + best_depth, [function] + best_path, notes)
+    return memo[function]
+
+
+def report(elf, build_dir, prefix):
+    sections = read_sections(prefix, elf)
+    flash = sum(size for name, size in sections.items() if name in (".text", ".rodata", ".data"))
+    ram = sum(size for name, size in sections.items() if name in (".data", ".bss", ".noinit"))
+
+    print("Budget report for %s" % elf)
+    print("  flash %6d bytes   ram (static) %6d bytes" % (flash, ram))
+
+    print("\n  Largest flash symbols:")
+    for size, kind, name in read_symbols(prefix, elf)[:TOP_SYMBOLS]:
+        print("    %6d  %s  %s" % (size, kind, name))
+
+    frames = read_frames(build_dir)
+    if not frames:
+        print("\n  No .su files under %s; build with -fstack-usage for stack figures." % build_dir)
+        return flash, ram, None
+
+    print("\n  Largest stack frames:")
+    for name, (size, dynamic) in sorted(frames.items(), key=lambda item: -item[1][0])[:TOP_FRAMES]:
+        print("    %6d  %s%s" % (size, name, " (dynamic)" if dynamic else ""))
+
+    calls, indirect = read_call_graph(prefix, elf)
+    memo = {}
+    roots = ["main"] + sorted(name for name in calls if name.startswith("__vector_"))
+    worst = {}
+    print("\n  Worst-case stack by entry point:")
+    for root in roots:
+        if root not in calls:
+            continue
+        depth, path, notes = worst_stack(root, frames, calls, memo, set())
+        worst[root] = depth
+        print("    %6d  %s" % (depth, " > ".join(path)))
+        for note in sorted(notes):
+            print("            %s" % note)
+
+    reaching = sorted(name for name in indirect if name in memo)
+    if reaching:
+        print("    indirect calls not followed in: %s" % ", ".join(reaching))
+
+    # One interrupt can land on top of main's deepest point.
+    peak = worst.get("main", 0) + max([depth for name, depth in worst.items() if name != "main"] or [0])
+    print("\n  peak stack %d bytes (main plus the deepest vector)" % peak)
+    return flash, ram, peak
+
+
+def check_budget(label, value, budget):
+    if budget and value is not None and value > int(budget):
+        print("  warning: %s %d bytes exceeds the budget of %s" % (label, value, budget))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        sys.exit("usage: budget_report.py firmware.elf build_dir [tool-prefix]")
+    report(sys.argv[1], sys.argv[2], sys.argv[3] if len(sys.argv) > 3 else "")
+else:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+
+    def after_link(target, source, env):
+        cc = os.path.basename(env.subst("$CC"))
+        prefix = cc[: -len("gcc")] if cc.endswith("gcc") else ""
+        flash, _, peak = report(str(target[0]), env.subst("$BUILD_DIR"), prefix)
+        check_budget("flash", flash, env.GetProjectOption("custom_flash_budget", ""))
+        check_budget("peak stack", peak, env.GetProjectOption("custom_stack_budget", ""))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)  # noqa: F821
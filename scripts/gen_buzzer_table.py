@@ -0,0 +1,101 @@
+"""
+Generate src/buzzer_table.h: buzzer settings for every tone and octave shift.
+
+The QUTy drives the buzzer from TCA0 in single-slope PWM mode. For each
+(tone, octave shift) pair this picks the smallest prescaler whose period
+fits the 16-bit counter and emits PER and CMP0 (50% duty) along with the
+frequency in centi-Hz for the console log and hardware observers.
+
+There is one table per cabinet size (SIMON_BUTTON_COUNT 4, 6 or 8) and
+the preprocessor keeps only the one being built. The larger cabinets keep
+the four original tones and continue the same 4:3 steps upwards.
+
+Centi-Hz values reproduce the single-precision arithmetic the buzzer used
+before the table existed (tone * 2^shift, printed with "%.2f"), so the
+host log is unchanged byte for byte.
+
+Rerun after changing the tones, the shift range or the clock:
+
+    python3 scripts/gen_buzzer_table.py > src/buzzer_table.h
+"""
+
+import struct
+
+F_CPU = 20000000 // 6  # 20 MHz oscillator, default /6 main clock prescaler
+TONES = ("364.84", "486.45", "648.60", "864.80", "1153.07", "1537.42", "2049.90", "2733.20")
+BUTTON_COUNTS = (4, 6, 8)
+SHIFT_MIN = -3
+SHIFT_MAX = 3
+PRESCALERS = (1, 2, 4, 8, 16, 64, 256, 1024)  # TCA_SINGLE_CLKSEL order
+
+
+def f32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def tone_frequency(tone, shift):
+    frequency = f32(float(tone))
+    if shift > 0:
+        frequency = f32(frequency * (1 << shift))
+    elif shift < 0:
+        frequency = f32(frequency / (1 << -shift))
+    return frequency
+
+
+def centi_hz(frequency):
+    # "%.2f" rounds the float's exact binary value.
+    whole, cents = ("%.2f" % frequency).split(".")
+    return int(whole) * 100 + int(cents)
+
+
+def timer_setting(frequency):
+    for clksel, prescaler in enumerate(PRESCALERS):
+        ticks = round(F_CPU / (prescaler * frequency))
+        if ticks <= 65536:
+            return clksel, ticks - 1, ticks // 2
+    raise ValueError("%.2f Hz is below the timer range" % frequency)
+
+
+def main():
+    print("#ifndef BUZZER_TABLE_H")
+    print("#define BUZZER_TABLE_H")
+    print()
+    print("/* Generated by scripts/gen_buzzer_table.py; do not edit. */")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("#include \"variant.h\"")
+    print()
+    print("#define BUZZER_TONES       SIMON_BUTTON_COUNT")
+    print("#define BUZZER_SHIFT_MIN   (%d)" % SHIFT_MIN)
+    print("#define BUZZER_SHIFT_MAX   %d" % SHIFT_MAX)
+    print("#define BUZZER_SHIFTS      %du" % (SHIFT_MAX - SHIFT_MIN + 1))
+    print("#define BUZZER_F_CPU       %dul" % F_CPU)
+    print()
+    print("typedef struct {")
+    print("    uint32_t centi_hz;")
+    print("    uint16_t period;  // TCA0.SINGLE.PER")
+    print("    uint16_t compare; // TCA0.SINGLE.CMP0")
+    print("    uint8_t clksel;   // TCA_SINGLE_CLKSEL group position")
+    print("} buzzer_setting_t;")
+    print()
+    for index, count in enumerate(BUTTON_COUNTS):
+        print("#%s SIMON_BUTTON_COUNT == %d" % ("if" if index == 0 else "elif", count))
+        print("static const buzzer_setting_t buzzer_settings[BUZZER_TONES][BUZZER_SHIFTS] = {")
+        for tone in TONES[:count]:
+            print("    {")
+            for shift in range(SHIFT_MIN, SHIFT_MAX + 1):
+                frequency = tone_frequency(tone, shift)
+                clksel, period, compare = timer_setting(frequency)
+                print("        {%7du, %5du, %5du, %du}, // %s Hz, shift %+d, /%d"
+                      % (centi_hz(frequency), period, compare, clksel, "%.2f" % frequency, shift,
+                         PRESCALERS[clksel]))
+            print("    },")
+        print("};")
+    print("#endif")
+    print()
+    print("#endif /* BUZZER_TABLE_H */")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,213 @@
+"""
+Framed UART protocol check against the host console build, over a pty.
+
+Runs the console emulator on a pseudo-terminal in raw mode, drives the
+framed protocol (src/protocol.h) through its "frame <hex>" lines and
+checks the replies: a status record, a batched request, an echoed tag,
+a NAK for a bad CRC, recovery from a torn frame and from one that
+stalls, and that the ASCII commands still answer alongside. Then it reads the game state both
+ways, 'c'/'b'/'d' against a framed STATUS, and reports the round trips and
+UART bytes each costs.
+
+    gcc -std=gnu11 -O2 -pthread src/*.c -o simon
+    python3 scripts/protocol_pty.py ./simon [--reads 2000]
+
+It exits non-zero when a check fails.
+"""
+
+import argparse
+import os
+import select
+import subprocess
+import sys
+import time
+import tty
+
+PROMPT = b"> "
+SOF = 0x02
+REPLY_FLAG = 0x80
+REPLY_ERROR = 0x7F
+ERROR_CRC = 0x01
+
+CMD_STATUS = 0x01
+CMD_HIGHSCORES = 0x04
+CMD_ECHO = 0x0A
+
+# Record 0x81, then score and best (u32), delay (u16), level (u32), state
+# and octave; see reply_status. Framed, that is 21 bytes on the wire.
+STATUS_RECORD_BYTES = 17
+
+
+def crc16(data, crc=0xFFFF):
+    # CRC-16/CCITT-FALSE, as protocol_crc16.
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def frame(payload):
+    body = bytes([len(payload)]) + bytes(payload)
+    crc = crc16(body)
+    return bytes([SOF]) + body + bytes([crc >> 8, crc & 0xFF])
+
+
+def parse_frames(data):
+    """Split console output into reply payloads; None if one is cut short."""
+    payloads = []
+    pos = data.find(bytes([SOF]))
+    while pos >= 0:
+        if pos + 2 > len(data):
+            return None
+        length = data[pos + 1]
+        end = pos + 2 + length + 2
+        if end > len(data):
+            return None
+        body = data[pos + 1:end - 2]
+        if crc16(body) != (data[end - 2] << 8 | data[end - 1]):
+            return None
+        payloads.append(body[1:])
+        pos = data.find(bytes([SOF]), end)
+    return payloads
+
+
+class Console:
+    def __init__(self, binary):
+        master, slave = os.openpty()
+        # Raw, so reply bytes such as 0x0A reach us untranslated.
+        tty.setraw(slave)
+        self.process = subprocess.Popen([binary], stdin=slave, stdout=slave, stderr=subprocess.DEVNULL,
+                                        close_fds=True)
+        os.close(slave)
+        self.fd = master
+        self.read_until_prompt()
+
+    def read_until_prompt(self, frames=False, at_least=0):
+        # A reply frame can end in the prompt's bytes, so when one is due
+        # wait for a whole frame (or a known length) before the prompt.
+        data = b""
+        while True:
+            ready, _, _ = select.select([self.fd], [], [], 5.0)
+            if not ready:
+                raise RuntimeError("console stopped answering")
+            data += os.read(self.fd, 4096)
+            if not data.endswith(PROMPT) or len(data) < at_least + len(PROMPT):
+                continue
+            if at_least or not frames or parse_frames(data[:-len(PROMPT)]) is not None:
+                return data[:-len(PROMPT)]
+
+    def send(self, line, frames=False, at_least=0):
+        os.write(self.fd, line.encode() + b"\n")
+        return self.read_until_prompt(frames, at_least)
+
+    def send_frame_bytes(self, data):
+        return parse_frames(self.send("frame " + data.hex(), frames=True))
+
+    def close(self):
+        os.write(self.fd, b"quit\n")
+        try:
+            self.process.wait(timeout=2)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+        os.close(self.fd)
+
+
+def check(results, name, ok, detail=""):
+    results.append(ok)
+    print("%-36s %s%s" % (name, "ok" if ok else "FAIL", "" if ok else "  " + detail))
+
+
+def run_checks(console):
+    results = []
+    status = frame([CMD_STATUS])
+
+    replies = console.send_frame_bytes(status)
+    check(results, "status record", len(replies) == 1 and replies[0][0] == CMD_STATUS | REPLY_FLAG
+          and len(replies[0]) == STATUS_RECORD_BYTES, repr(replies))
+
+    replies = console.send_frame_bytes(frame([CMD_STATUS, CMD_HIGHSCORES]))
+    check(results, "batched status and highscores", len(replies) == 1 and replies[0][0] == CMD_STATUS | REPLY_FLAG
+          and replies[0][STATUS_RECORD_BYTES] == CMD_HIGHSCORES | REPLY_FLAG, repr(replies))
+
+    replies = console.send_frame_bytes(frame([CMD_ECHO, 0x5A, CMD_STATUS]))
+    check(results, "echo tags the reply", len(replies) == 1 and replies[0][:3] == bytes([CMD_ECHO | REPLY_FLAG, 0x5A,
+          CMD_STATUS | REPLY_FLAG]), repr(replies))
+
+    bad = bytearray(status)
+    bad[-1] ^= 0xFF
+    replies = console.send_frame_bytes(bytes(bad))
+    check(results, "bad CRC is NAKed", replies == [bytes([REPLY_ERROR, ERROR_CRC])], repr(replies))
+
+    # A frame that lost its tail runs into the next one; the parser must
+    # find the second SOF again rather than lose both.
+    replies = console.send_frame_bytes(bytes([SOF, 5, CMD_STATUS]) + status + bytes(4))
+    check(results, "resync after a torn frame", len(replies) == 2 and replies[0] == bytes([REPLY_ERROR, ERROR_CRC])
+          and replies[1][0] == CMD_STATUS | REPLY_FLAG, repr(replies))
+
+    # A frame that stalls is abandoned once the line has been quiet.
+    console.send("frame %02x%02x" % (SOF, 3))
+    console.send("tick 50")
+    replies = console.send_frame_bytes(status)
+    check(results, "stalled frame times out", len(replies) == 1 and replies[0][0] == CMD_STATUS | REPLY_FLAG,
+          repr(replies))
+
+    text = console.send("cmd c")
+    check(results, "ASCII commands still answer", text.strip() == b"SCORE 0", repr(text))
+    return all(results)
+
+
+def compare_throughput(console, reads):
+    request = frame([CMD_STATUS])
+    line = "frame " + request.hex()
+    reply_bytes = len(frame(bytes(STATUS_RECORD_BYTES)))
+
+    start = time.perf_counter()
+    ascii_out = ascii_back = 0
+    for _ in range(reads):
+        for command in "cbd":
+            ascii_out += 1
+            ascii_back += len(console.send("cmd " + command))
+    ascii_seconds = time.perf_counter() - start
+
+    # Replies are checked once afterwards, so the timing is the link's and
+    # not this script's CRC.
+    start = time.perf_counter()
+    last = b""
+    for _ in range(reads):
+        last = console.send(line, at_least=reply_bytes)
+    framed_seconds = time.perf_counter() - start
+    replies = parse_frames(last)
+    if not replies or replies[0][0] != CMD_STATUS | REPLY_FLAG:
+        raise RuntimeError("bad STATUS reply %r" % last)
+
+    ascii_wire = (ascii_out + ascii_back) / reads
+    framed_wire = len(request) + reply_bytes
+    print("\nreading the game state %d times over the pty:" % reads)
+    print("  ASCII 'c','b','d': 3 round trips, %.0f B out, %.0f B back, %.1f us/read (score, best, delay)"
+          % (ascii_out / reads, ascii_back / reads, ascii_seconds / reads * 1e6))
+    print("  framed STATUS:     1 round trip,  %d B out, %d B back, %.1f us/read (all six fields)"
+          % (len(request), reply_bytes, framed_seconds / reads * 1e6))
+    # On the board the wire time dominates: ten bit times a byte at 115200.
+    print("  at 115200 baud:    ASCII %.2f ms on the wire, framed %.2f ms"
+          % (ascii_wire * 10 / 115.2, framed_wire * 10 / 115.2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("binary", help="host console build")
+    parser.add_argument("--reads", type=int, default=2000, help="state reads per path in the comparison")
+    args = parser.parse_args()
+
+    console = Console(args.binary)
+    try:
+        ok = run_checks(console)
+        if args.reads > 0:
+            compare_throughput(console, args.reads)
+    finally:
+        console.close()
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
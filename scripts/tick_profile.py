@@ -0,0 +1,313 @@
+"""
+Tick budget profiler for the QUTy firmware under simavr.
+
+Builds the [env:QUTy_profile] firmware, which adds the tick markers from
+src/profile.h and replays a stimulus script instead of reading the
+console. It runs the firmware under simavr with GPIOR0 (markers) and
+GPIOR1 (game state) traced to a VCD, and reports:
+
+  * the worst and mean cycles per main-loop tick in each game state,
+    against the 1 ms budget;
+  * inclusive cycles per instrumented function;
+  * what ran inside the worst tick of each state.
+
+It exits non-zero when any tick exceeds the budget less the margin, so
+CI can catch a change that eats the headroom.
+
+    python3 scripts/tick_profile.py [--script scripts/profile_stimulus.txt]
+                                    [--margin 20] [--simavr simavr]
+    python3 scripts/tick_profile.py --vcd trace.vcd     # report only
+    python3 scripts/tick_profile.py --table-only        # regenerate the table
+
+The stimulus table (src/stimulus_table.h) is generated from the script,
+and only written when it differs from what is there. The checked-in
+table is the default script's; a run with another --script puts it back
+once the firmware is built, so profiling leaves the tree clean.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+TABLE_PATH = os.path.join(ROOT, "src", "stimulus_table.h")
+DEFAULT_SCRIPT = os.path.join(ROOT, "scripts", "profile_stimulus.txt")
+
+F_CPU = 20000000 // 6
+MCU = "attiny1626"
+GPIOR0 = 0x1C
+GPIOR1 = 0x1D
+
+# Must match profile_marker_t in src/profile.h.
+MARKERS = {
+    1: "tick",
+    2: "game_tick_1ms",
+    3: "on_game_timer",
+    4: "game_handle_event",
+    5: "game_handle_uart_char",
+    6: "finalise_pending_highscore",
+    7: "apply_seed_from_buffer",
+    8: "journal_record_insert",
+    9: "input",
+    10: "hardware_task_display",
+}
+MARKER_TICK = 1
+MARKER_DONE = 0x7F
+MARKER_EXIT = 0x80
+
+# Must match simon_state_t in src/game.h.
+STATES = ["attract", "playback", "wait input", "level complete", "failure", "name entry"]
+
+# Must match stimulus_kind_t in src/stimulus.h.
+STIMULUS_KINDS = {
+    "press": "STIMULUS_PRESS",
+    "expected": "STIMULUS_EXPECTED",
+    "wrong": "STIMULUS_WRONG",
+    "play": "STIMULUS_PLAY",
+    "pot": "STIMULUS_POT",
+    "uart": "STIMULUS_UART",
+    "end": "STIMULUS_END",
+}
+
+
+def c_string(text):
+    escapes = {"\r": "\\r", "\n": "\\n", "\b": "\\b"}
+    out = []
+    for char in text:
+        if char in escapes:
+            out.append(escapes[char])
+        elif char in "\\\"":
+            out.append("\\" + char)
+        elif 32 <= ord(char) < 127:
+            out.append(char)
+        else:
+            out.append("\\x%02x\"\"" % ord(char))
+    return "\"%s\"" % "".join(out)
+
+
+def parse_script(path):
+    steps = []
+    with open(path) as handle:
+        for number, line in enumerate(handle, 1):
+            line = line.split("#", 1)[0].rstrip()
+            if not line.strip():
+                continue
+            fields = line.split(None, 2)
+            if len(fields) < 2 or fields[1] not in STIMULUS_KINDS:
+                raise SystemExit("%s:%d: expected '<delay> <action> [argument]'" % (path, number))
+            delay, action = int(fields[0]), fields[1]
+            argument = fields[2] if len(fields) > 2 else ""
+            value, text = 0, None
+            if action == "uart":
+                text = argument.replace("\\r", "\r").replace("\\n", "\n")
+            elif action in ("press", "play", "pot"):
+                value = int(argument)
+            steps.append((delay, action, value, text))
+    if not steps or steps[-1][1] != "end":
+        steps.append((0, "end", 0, None))
+    return steps
+
+
+def write_table(script):
+    lines = [
+        "#ifndef STIMULUS_TABLE_H",
+        "#define STIMULUS_TABLE_H",
+        "",
+        "/* Generated by scripts/tick_profile.py from %s; do not edit. */"
+        % os.path.relpath(script, ROOT),
+        "",
+        "#include \"stimulus.h\"",
+        "",
+        "static const stimulus_step_t stimulus_steps[] = {",
+    ]
+    for delay, action, value, text in parse_script(script):
+        lines.append("    {%du, %s, %du, %s}," % (delay, STIMULUS_KINDS[action], value,
+                                                 c_string(text) if text is not None else "NULL"))
+    lines += ["};", "", "#endif /* STIMULUS_TABLE_H */", ""]
+    text = "\n".join(lines)
+
+    # An unchanged table keeps its timestamp, so nothing rebuilds for it.
+    try:
+        with open(TABLE_PATH) as handle:
+            if handle.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(TABLE_PATH, "w") as handle:
+        handle.write(text)
+
+
+def build(env):
+    subprocess.run(["pio", "run", "-e", env], cwd=ROOT, check=True)
+    return os.path.join(ROOT, ".pio", "build", env, "firmware.elf")
+
+
+def simulate(simavr, elf, vcd):
+    subprocess.run([simavr, "-m", MCU, "-f", str(F_CPU),
+                    "--add-vcd-trace", "marker=trace@0x%04x/0xff" % GPIOR0,
+                    "--add-vcd-trace", "state=trace@0x%04x/0xff" % GPIOR1,
+                    "--output", vcd, elf], check=True)
+
+
+def read_vcd(path):
+    """Yield (time in seconds, signal name, value) in file order."""
+    scale = 1e-9
+    names = {}
+    time = 0
+    with open(path) as handle:
+        in_header = True
+        for line in handle:
+            line = line.strip()
+            if in_header:
+                match = re.match(r"\$timescale\s*(\d+)\s*(s|ms|us|ns|ps|fs)", line)
+                if match:
+                    unit = {"s": 1, "ms": 1e-3, "us": 1e-6, "ns": 1e-9, "ps": 1e-12, "fs": 1e-15}
+                    scale = int(match.group(1)) * unit[match.group(2)]
+                match = re.match(r"\$var\s+\S+\s+\d+\s+(\S+)\s+(\S+)", line)
+                if match:
+                    names[match.group(1)] = match.group(2)
+                if line.startswith("$enddefinitions"):
+                    in_header = False
+                continue
+            if line.startswith("#"):
+                time = int(line[1:])
+            elif line.startswith("b"):
+                bits, code = line[1:].split()
+                if code in names and set(bits) <= set("01"):
+                    yield time * scale, names[code], int(bits, 2)
+            elif line and line[0] in "01" and line[1:] in names:
+                yield time * scale, names[line[1:]], int(line[0])
+
+
+class Stat:
+    def __init__(self):
+        self.count = 0
+        self.total = 0
+        self.worst = 0
+        self.worst_detail = None
+
+    def add(self, cycles, detail=None):
+        self.count += 1
+        self.total += cycles
+        if cycles > self.worst:
+            self.worst = cycles
+            self.worst_detail = detail
+
+
+def analyse(vcd, freq):
+    functions = {}
+    ticks = {}
+    stack = []
+    state = 0
+    children = []
+    tick_index = 0
+    finished = False
+
+    for seconds, name, value in read_vcd(vcd):
+        cycles = round(seconds * freq)
+        if name == "state":
+            state = value
+            continue
+        if name != "marker":
+            continue
+        if value == MARKER_DONE:
+            finished = True
+            break
+        if value == 0:
+            continue  # reset value before the first marker
+
+        marker = value & ~MARKER_EXIT
+        if (value & MARKER_EXIT) == 0:
+            if marker == MARKER_TICK:
+                children = []
+                tick_state = state
+            stack.append((marker, cycles))
+            continue
+
+        # Unwind to the matching entry; anything left open was cut short.
+        while stack and stack[-1][0] != marker:
+            stack.pop()
+        if not stack:
+            continue
+        _, start = stack.pop()
+        spent = cycles - start
+        functions.setdefault(marker, Stat()).add(spent)
+        if marker == MARKER_TICK:
+            tick_index += 1
+            ticks.setdefault(tick_state, Stat()).add(spent, (tick_index, seconds, children))
+        elif stack and stack[-1][0] == MARKER_TICK:
+            children.append((marker, spent))
+
+    return functions, ticks, finished
+
+
+def report(functions, ticks, finished, freq, margin):
+    budget = freq // 1000
+    limit = budget * (100 - margin) // 100
+    print("Tick budget %d cycles (1 ms at %.3f MHz); failing above %d (%d%% margin)"
+          % (budget, freq / 1e6, limit, margin))
+    if not finished:
+        print("warning: the trace ends before the stimulus script did")
+
+    print("\n  %-15s %8s %8s %8s %7s" % ("state", "ticks", "mean", "worst", "budget"))
+    failures = []
+    for index, name in enumerate(STATES):
+        stat = ticks.get(index)
+        if stat is None:
+            print("  %-15s %8s" % (name, "-"))
+            continue
+        print("  %-15s %8d %8d %8d %6.1f%%" % (name, stat.count, stat.total // stat.count, stat.worst,
+                                                100.0 * stat.worst / budget))
+        if stat.worst > limit:
+            failures.append((name, stat))
+
+    print("\n  %-28s %8s %8s %8s" % ("function (inclusive)", "calls", "mean", "worst"))
+    for marker, stat in sorted(functions.items(), key=lambda item: -item[1].worst):
+        print("  %-28s %8d %8d %8d" % (MARKERS.get(marker, "marker %d" % marker), stat.count,
+                                       stat.total // stat.count, stat.worst))
+
+    print("\n  Worst tick per state:")
+    for index, name in enumerate(STATES):
+        stat = ticks.get(index)
+        if stat is None or stat.worst_detail is None:
+            continue
+        number, seconds, children = stat.worst_detail
+        parts = ", ".join("%s %d" % (MARKERS.get(marker, str(marker)), spent) for marker, spent in children)
+        print("    %-15s tick %d at %.3f s: %d cycles (%s)" % (name, number, seconds, stat.worst, parts or "no calls"))
+
+    for name, stat in failures:
+        print("FAIL: %s tick takes %d cycles, over the %d-cycle limit" % (name, stat.worst, limit))
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--script", default=DEFAULT_SCRIPT)
+    parser.add_argument("--margin", type=int, default=20, help="headroom to keep, percent of 1 ms")
+    parser.add_argument("--freq", type=int, default=F_CPU)
+    parser.add_argument("--env", default="QUTy_profile")
+    parser.add_argument("--simavr", default="simavr")
+    parser.add_argument("--vcd", help="analyse an existing trace instead of building and running")
+    parser.add_argument("--table-only", action="store_true", help="only regenerate src/stimulus_table.h")
+    args = parser.parse_args()
+
+    if args.vcd is None:
+        write_table(args.script)
+        if args.table_only:
+            return 0
+        try:
+            elf = build(args.env)
+        finally:
+            if os.path.abspath(args.script) != DEFAULT_SCRIPT:
+                write_table(DEFAULT_SCRIPT)
+        args.vcd = os.path.join(ROOT, ".pio", "build", args.env, "tick_profile.vcd")
+        simulate(args.simavr, elf, args.vcd)
+
+    functions, ticks, finished = analyse(args.vcd, args.freq)
+    return report(functions, ticks, finished, args.freq, args.margin)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,1046 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "archive.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MIN_MATCH        4u
+#define NICE_MATCH       256u  // a match this long ends the search
+#define CHAIN_DEPTH      32u
+#define HASH_BITS        16u
+#define HASH_SLOTS       (1u << HASH_BITS)
+#define NO_POSITION      UINT32_MAX
+#define SEGMENT_MAX      255u  // longest line training keeps
+#define SCAN_MAX_THREADS 64u
+#define FNV64_OFFSET     0xCBF29CE484222325ull
+#define FNV64_PRIME      0x100000001B3ull
+#define PROMPT           "> "  // what the console prints before reading each line
+#define PROMPT_LENGTH    2u
+
+_Static_assert(sizeof(archive_header_t) == 16u, "the file header is 16 bytes");
+_Static_assert(sizeof(archive_entry_t) == 32u, "index entries are 32 bytes");
+_Static_assert(sizeof(archive_block_header_t) == 40u, "block headers are 40 bytes");
+_Static_assert(sizeof(archive_trailer_t) == 24u, "the trailer is 24 bytes");
+_Static_assert(sizeof(archive_key_t) == 8u, "keys are 8 bytes");
+
+// Index entry and both keys: the footer bytes each session costs.
+#define FOOTER_BYTES_PER_SESSION (sizeof(archive_entry_t) + ARCHIVE_KEY_COUNT * sizeof(archive_key_t))
+
+/*
+ * FNV-1a over eight-byte words with a shift to carry the high bits down,
+ * folded to 32 bits. Byte at a time it cost more than unpacking did.
+ */
+static uint32_t session_hash(const uint8_t *data, size_t length)
+{
+    uint64_t hash = FNV64_OFFSET;
+    size_t i = 0u;
+
+    for (; i + 8u <= length; i += 8u) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof word);
+        hash = (hash ^ word) * FNV64_PRIME;
+        hash ^= hash >> 29;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ data[i]) * FNV64_PRIME;
+    }
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static uint64_t fnv64(const char *data, size_t length)
+{
+    uint64_t hash = FNV64_OFFSET;
+    for (size_t i = 0u; i < length; ++i) {
+        hash = (hash ^ (uint8_t)data[i]) * FNV64_PRIME;
+    }
+    return hash;
+}
+
+static bool write_all(int fd, const void *data, size_t length)
+{
+    const uint8_t *bytes = data;
+    while (length > 0u) {
+        ssize_t written = write(fd, bytes, length);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool read_at(int fd, void *data, size_t length, uint64_t offset)
+{
+    uint8_t *bytes = data;
+    while (length > 0u) {
+        ssize_t got = pread(fd, bytes, length, (off_t)offset);
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        length -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return true;
+}
+
+static uint8_t *put_varint(uint8_t *out, uint32_t value)
+{
+    while (value >= 0x80u) {
+        *out++ = (uint8_t)(value | 0x80u);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static bool get_varint(const uint8_t **in, const uint8_t *end, uint32_t *value)
+{
+    uint32_t result = 0u;
+    for (uint32_t shift = 0u; shift < 35u; shift += 7u) {
+        if (*in == end) {
+            return false;
+        }
+        uint8_t byte = *(*in)++;
+        result |= (uint32_t)(byte & 0x7Fu) << shift;
+        if ((byte & 0x80u) == 0u) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t hash4(const uint8_t *at)
+{
+    uint32_t word;
+    memcpy(&word, at, sizeof word);
+    return (word * 2654435761u) >> (32u - HASH_BITS);
+}
+
+static uint32_t common_length(const uint8_t *a, const uint8_t *b, uint32_t limit)
+{
+    uint32_t length = 0u;
+
+    while (length + 8u <= limit) {
+        uint64_t left;
+        uint64_t right;
+        memcpy(&left, a + length, sizeof left);
+        memcpy(&right, b + length, sizeof right);
+        if (left != right) {
+            return length + (uint32_t)__builtin_ctzll(left ^ right) / 8u;
+        }
+        length += 8u;
+    }
+    while (length < limit && a[length] == b[length]) {
+        length++;
+    }
+    return length;
+}
+
+static uint8_t *put_sequence(uint8_t *out, const uint8_t *literals, uint32_t literal_count, uint32_t offset,
+                             uint32_t match_length)
+{
+    uint32_t match_code = match_length > 0u ? match_length - MIN_MATCH : 0u;
+    uint8_t *token = out++;
+
+    *token = (uint8_t)(((literal_count < 15u ? literal_count : 15u) << 4) | (match_code < 15u ? match_code : 15u));
+    if (literal_count >= 15u) {
+        out = put_varint(out, literal_count - 15u);
+    }
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+    if (match_length > 0u) {
+        out = put_varint(out, offset);
+        if (match_code >= 15u) {
+            out = put_varint(out, match_code - 15u);
+        }
+    }
+    return out;
+}
+
+// Room for the dictionary and a session of `length` bytes, and its worst-case packing.
+static bool ensure_scratch(archive_writer_t *writer, size_t length)
+{
+    size_t window = writer->dict_bytes + length;
+    if (window <= writer->scratch_bytes) {
+        return true;
+    }
+
+    uint8_t *bytes = realloc(writer->window, window);
+    if (bytes != NULL) {
+        writer->window = bytes;
+    }
+    uint32_t *chain = realloc(writer->chain, window * sizeof *chain);
+    if (chain != NULL) {
+        writer->chain = chain;
+    }
+    // Four-byte matches at long offsets cost up to five bytes each.
+    uint8_t *packed = realloc(writer->packed, 2u * length + 32u);
+    if (packed != NULL) {
+        writer->packed = packed;
+    }
+    if (bytes == NULL || chain == NULL || packed == NULL) {
+        return false;
+    }
+    writer->scratch_bytes = window;
+    return true;
+}
+
+static void insert_position(archive_writer_t *writer, uint32_t position)
+{
+    uint32_t slot = hash4(writer->window + position);
+    writer->chain[position] = writer->head[slot];
+    writer->head[slot] = position;
+}
+
+/*
+ * Greedy parse with hash chains. Every position of the dictionary goes
+ * into the chains first, so the session's first lines find their matches
+ * there.
+ */
+static size_t pack_session(archive_writer_t *writer, const uint8_t *data, uint32_t length)
+{
+    uint8_t *window = writer->window;
+    uint32_t start = writer->dict_bytes;
+    uint32_t total = start + length;
+    uint8_t *out = writer->packed;
+
+    memcpy(window, writer->dict, start);
+    memcpy(window + start, data, length);
+    memset(writer->head, 0xFF, HASH_SLOTS * sizeof *writer->head);
+    for (uint32_t position = 0u; position < start && position + MIN_MATCH <= total; ++position) {
+        insert_position(writer, position);
+    }
+
+    uint32_t anchor = start;
+    uint32_t position = start;
+    while (position + MIN_MATCH <= total) {
+        uint32_t limit = total - position;
+        uint32_t best_length = 0u;
+        uint32_t best_offset = 0u;
+        uint32_t candidate = writer->head[hash4(window + position)];
+
+        for (uint32_t depth = 0u; candidate != NO_POSITION && depth < CHAIN_DEPTH; ++depth) {
+            if (window[candidate + best_length] == window[position + best_length]) {
+                uint32_t match = common_length(window + candidate, window + position, limit);
+                if (match > best_length) {
+                    best_length = match;
+                    best_offset = position - candidate;
+                    if (match >= NICE_MATCH || match == limit) {
+                        break;
+                    }
+                }
+            }
+            candidate = writer->chain[candidate];
+        }
+
+        if (best_length < MIN_MATCH) {
+            insert_position(writer, position++);
+            continue;
+        }
+        out = put_sequence(out, window + anchor, position - anchor, best_offset, best_length);
+        for (uint32_t end = position + best_length; position < end; ++position) {
+            if (position + MIN_MATCH <= total) {
+                insert_position(writer, position);
+            }
+        }
+        anchor = position;
+    }
+    if (anchor < total) {
+        out = put_sequence(out, window + anchor, total - anchor, 0u, 0u);
+    }
+    return (size_t)(out - writer->packed);
+}
+
+// Copies forwards; an offset shorter than the match repeats the bytes it covers.
+static void copy_match(uint8_t *out, uint32_t offset, uint32_t length)
+{
+    const uint8_t *from = out - offset;
+
+    // Each pass doubles what has been laid down since `from`.
+    while (length > 0u) {
+        size_t chunk = (size_t)(out - from);
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(out, from, chunk);
+        out += chunk;
+        length -= (uint32_t)chunk;
+    }
+}
+
+static bool unpack_session(const uint8_t *dict, uint32_t dict_bytes, const uint8_t *in, uint32_t in_bytes,
+                           uint8_t *out, uint32_t raw_bytes)
+{
+    const uint8_t *end = in + in_bytes;
+    uint8_t *at = out;
+    uint8_t *out_end = out + raw_bytes;
+
+    while (at < out_end) {
+        uint32_t more;
+        if (in == end) {
+            return false;
+        }
+        uint8_t token = *in++;
+        uint32_t literals = token >> 4;
+        if (literals == 15u) {
+            if (!get_varint(&in, end, &more) || more > raw_bytes) {
+                return false;
+            }
+            literals += more;
+        }
+        if (literals > (size_t)(end - in) || literals > (size_t)(out_end - at)) {
+            return false;
+        }
+        memcpy(at, in, literals);
+        at += literals;
+        in += literals;
+        if (at == out_end) {
+            break;
+        }
+
+        uint32_t offset;
+        uint32_t length = (token & 15u) + MIN_MATCH;
+        if (!get_varint(&in, end, &offset)) {
+            return false;
+        }
+        if ((token & 15u) == 15u) {
+            if (!get_varint(&in, end, &more) || more > raw_bytes) {
+                return false;
+            }
+            length += more;
+        }
+        size_t produced = (size_t)(at - out);
+        if (offset == 0u || offset > produced + dict_bytes || length > (size_t)(out_end - at)) {
+            return false;
+        }
+        if (offset > produced) {
+            uint32_t from_dict = (uint32_t)(offset - produced);
+            uint32_t count = from_dict < length ? from_dict : length;
+            memcpy(at, dict + dict_bytes - from_dict, count);
+            at += count;
+            length -= count;
+        }
+        copy_match(at, offset, length);
+        at += length;
+    }
+    return in == end;
+}
+
+typedef struct {
+    uint64_t hash;
+    const char *text;
+    uint32_t length;
+    uint32_t sample;
+} train_segment_t;
+
+typedef struct {
+    const char *text;
+    uint32_t length;
+    uint64_t score;
+} train_pick_t;
+
+static int compare_segment(const void *a, const void *b)
+{
+    const train_segment_t *left = a;
+    const train_segment_t *right = b;
+    if (left->hash != right->hash) {
+        return left->hash < right->hash ? -1 : 1;
+    }
+    if (left->length != right->length) {
+        return left->length < right->length ? -1 : 1;
+    }
+    return (left->sample > right->sample) - (left->sample < right->sample);
+}
+
+static int compare_pick(const void *a, const void *b)
+{
+    const train_pick_t *left = a;
+    const train_pick_t *right = b;
+    if (left->score != right->score) {
+        return left->score > right->score ? -1 : 1;
+    }
+    // Ties go by text, so a dictionary does not depend on qsort's whims.
+    uint32_t shorter = left->length < right->length ? left->length : right->length;
+    int order = memcmp(left->text, right->text, shorter);
+    return order != 0 ? order : (int)left->length - (int)right->length;
+}
+
+/*
+ * Every line of the samples is a candidate, scored by its length times
+ * the number of samples it turns up in: the dictionary only has to cover a
+ * line's first appearance, as the session itself covers the rest. A run
+ * of prompts is a tick after tick, so a line keeps only its last one.
+ */
+uint32_t archive_train_dict(const char *const *samples, const size_t *lengths, uint32_t count, uint8_t *dict,
+                            uint32_t capacity)
+{
+    train_segment_t *segments = NULL;
+    size_t segment_count = 0u;
+    size_t segment_capacity = 0u;
+
+    for (uint32_t sample = 0u; sample < count; ++sample) {
+        const char *text = samples[sample];
+        const char *text_end = text + lengths[sample];
+        while (text < text_end) {
+            const char *newline = memchr(text, '\n', (size_t)(text_end - text));
+            const char *line_end = newline != NULL ? newline + 1 : text_end;
+            const char *line = text;
+            text = line_end;
+
+            while (line_end - line >= 2 * (ptrdiff_t)PROMPT_LENGTH && memcmp(line, PROMPT PROMPT, 4u) == 0) {
+                line += PROMPT_LENGTH;
+            }
+            size_t length = (size_t)(line_end - line);
+            if (length < MIN_MATCH || length > SEGMENT_MAX) {
+                continue;
+            }
+            if (segment_count == segment_capacity) {
+                segment_capacity = segment_capacity > 0u ? segment_capacity * 2u : 4096u;
+                train_segment_t *grown = realloc(segments, segment_capacity * sizeof *segments);
+                if (grown == NULL) {
+                    free(segments);
+                    return 0u;
+                }
+                segments = grown;
+            }
+            segments[segment_count++] = (train_segment_t){
+                .hash = fnv64(line, length), .text = line, .length = (uint32_t)length, .sample = sample};
+        }
+    }
+    qsort(segments, segment_count, sizeof *segments, compare_segment);
+
+    // Segments sort into groups of one line; count the samples in each.
+    train_pick_t *picks = malloc((segment_count > 0u ? segment_count : 1u) * sizeof *picks);
+    size_t pick_count = 0u;
+    if (picks == NULL) {
+        free(segments);
+        return 0u;
+    }
+    for (size_t i = 0u; i < segment_count;) {
+        size_t j = i;
+        uint64_t appearances = 0u;
+        while (j < segment_count && segments[j].hash == segments[i].hash && segments[j].length == segments[i].length) {
+            appearances += (j == i || segments[j].sample != segments[j - 1u].sample) ? 1u : 0u;
+            j++;
+        }
+        // A line from one sample alone says nothing about the next session.
+        if (appearances > 1u) {
+            picks[pick_count++] = (train_pick_t){
+                .text = segments[i].text, .length = segments[i].length, .score = appearances * segments[i].length};
+        }
+        i = j;
+    }
+    qsort(picks, pick_count, sizeof *picks, compare_pick);
+
+    size_t chosen = 0u;
+    uint32_t used = 0u;
+    for (size_t i = 0u; i < pick_count; ++i) {
+        if (used + picks[i].length <= capacity) {
+            used += picks[i].length;
+            picks[chosen++] = picks[i];
+        }
+    }
+    // Best last, where offsets from the session are shortest.
+    uint32_t at = 0u;
+    for (size_t i = chosen; i-- > 0u;) {
+        memcpy(dict + at, picks[i].text, picks[i].length);
+        at += picks[i].length;
+    }
+
+    free(picks);
+    free(segments);
+    return used;
+}
+
+bool archive_writer_open(archive_writer_t *writer, const char *path, const uint8_t *dict, uint32_t dict_bytes)
+{
+    memset(writer, 0, sizeof *writer);
+    writer->fd = -1;
+    if (dict_bytes > ARCHIVE_DICT_MAX) {
+        return false;
+    }
+    memcpy(writer->dict, dict, dict_bytes);
+    writer->dict_bytes = dict_bytes;
+    writer->head = malloc(HASH_SLOTS * sizeof *writer->head);
+    if (writer->head == NULL) {
+        return false;
+    }
+
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    archive_header_t header = {.version = ARCHIVE_VERSION, .dict_bytes = dict_bytes};
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof header.magic);
+    if (writer->fd < 0 || !write_all(writer->fd, &header, sizeof header) || !write_all(writer->fd, dict, dict_bytes)) {
+        if (writer->fd >= 0) {
+            close(writer->fd);
+        }
+        free(writer->head);
+        writer->head = NULL;
+        return false;
+    }
+    writer->offset = sizeof header + dict_bytes;
+    return true;
+}
+
+bool archive_writer_add(archive_writer_t *writer, uint32_t seed, uint32_t started_at, const char *data, size_t length)
+{
+    if (length > UINT32_MAX - ARCHIVE_DICT_MAX || !ensure_scratch(writer, length)) {
+        return false;
+    }
+    if (writer->entry_count == writer->entry_capacity) {
+        uint32_t capacity = writer->entry_capacity > 0u ? writer->entry_capacity * 2u : 1024u;
+        archive_entry_t *grown = realloc(writer->entries, capacity * sizeof *grown);
+        if (grown == NULL) {
+            return false;
+        }
+        writer->entries = grown;
+        writer->entry_capacity = capacity;
+    }
+
+    size_t packed = pack_session(writer, (const uint8_t *)data, (uint32_t)length);
+    archive_block_header_t block = {
+        .magic = ARCHIVE_BLOCK_MAGIC,
+        .id = writer->entry_count,
+        .entry = {.offset = writer->offset, .seed = seed, .started_at = started_at, .raw_bytes = (uint32_t)length,
+                  .packed_bytes = (uint32_t)packed, .hash = session_hash((const uint8_t *)data, length)},
+    };
+    if (!write_all(writer->fd, &block, sizeof block) || !write_all(writer->fd, writer->packed, packed)) {
+        return false;
+    }
+    writer->entries[writer->entry_count++] = block.entry;
+    writer->offset += sizeof block + packed;
+    return true;
+}
+
+static int compare_key(const void *a, const void *b)
+{
+    const archive_key_t *left = a;
+    const archive_key_t *right = b;
+    if (left->value != right->value) {
+        return left->value < right->value ? -1 : 1;
+    }
+    return (left->id > right->id) - (left->id < right->id);
+}
+
+// The `kind` key of every entry, sorted; NULL if memory runs out.
+static archive_key_t *sort_keys(const archive_entry_t *entries, uint32_t count, archive_key_kind_t kind)
+{
+    archive_key_t *keys = malloc((count > 0u ? count : 1u) * sizeof *keys);
+    if (keys == NULL) {
+        return NULL;
+    }
+    for (uint32_t id = 0u; id < count; ++id) {
+        keys[id].value = kind == ARCHIVE_KEY_SEED ? entries[id].seed : entries[id].started_at;
+        keys[id].id = id;
+    }
+    qsort(keys, count, sizeof *keys, compare_key);
+    return keys;
+}
+
+bool archive_writer_close(archive_writer_t *writer)
+{
+    bool ok = writer->fd >= 0;
+    if (ok) {
+        archive_trailer_t trailer = {.index_offset = writer->offset, .entry_count = writer->entry_count};
+        memcpy(trailer.magic, ARCHIVE_TRAILER_MAGIC, sizeof trailer.magic);
+        ok = write_all(writer->fd, writer->entries, writer->entry_count * sizeof *writer->entries);
+        for (uint32_t kind = 0u; ok && kind < ARCHIVE_KEY_COUNT; ++kind) {
+            archive_key_t *keys = sort_keys(writer->entries, writer->entry_count, (archive_key_kind_t)kind);
+            ok = keys != NULL && write_all(writer->fd, keys, writer->entry_count * sizeof *keys);
+            free(keys);
+        }
+        ok = ok && write_all(writer->fd, &trailer, sizeof trailer);
+        ok = close(writer->fd) == 0 && ok;
+        writer->fd = -1;
+    }
+    free(writer->entries);
+    free(writer->window);
+    free(writer->chain);
+    free(writer->head);
+    free(writer->packed);
+    writer->entries = NULL;
+    writer->window = NULL;
+    writer->chain = NULL;
+    writer->head = NULL;
+    writer->packed = NULL;
+    return ok;
+}
+
+// Without a trailer the blocks are the index; a torn last block is left out.
+static bool rebuild_index(archive_reader_t *reader, uint64_t size)
+{
+    uint64_t offset = sizeof(archive_header_t) + reader->dict_bytes;
+    uint32_t capacity = 0u;
+    archive_block_header_t block;
+
+    while (size - offset >= sizeof block && read_at(reader->fd, &block, sizeof block, offset)) {
+        if (block.magic != ARCHIVE_BLOCK_MAGIC || block.id != reader->entry_count || block.entry.offset != offset ||
+            block.entry.packed_bytes > size - offset - sizeof block) {
+            break;
+        }
+        if (reader->entry_count == capacity) {
+            capacity = capacity > 0u ? capacity * 2u : 1024u;
+            archive_entry_t *grown = realloc(reader->entries, capacity * sizeof *grown);
+            if (grown == NULL) {
+                return false;
+            }
+            reader->entries = grown;
+        }
+        reader->entries[reader->entry_count++] = block.entry;
+        offset += sizeof block + block.entry.packed_bytes;
+    }
+    return true;
+}
+
+bool archive_reader_open(archive_reader_t *reader, const char *path)
+{
+    archive_header_t header;
+    archive_trailer_t trailer;
+    struct stat info;
+
+    memset(reader, 0, sizeof *reader);
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) {
+        return false;
+    }
+    if (fstat(reader->fd, &info) != 0 || (uint64_t)info.st_size < sizeof header ||
+        !read_at(reader->fd, &header, sizeof header, 0u) || memcmp(header.magic, ARCHIVE_MAGIC, 8u) != 0 ||
+        header.version != ARCHIVE_VERSION || header.dict_bytes > ARCHIVE_DICT_MAX ||
+        !read_at(reader->fd, reader->dict, header.dict_bytes, sizeof header)) {
+        archive_reader_close(reader);
+        return false;
+    }
+    reader->dict_bytes = header.dict_bytes;
+
+    uint64_t size = (uint64_t)info.st_size;
+    uint64_t blocks = sizeof header + header.dict_bytes;
+    if (size >= blocks + sizeof trailer && read_at(reader->fd, &trailer, sizeof trailer, size - sizeof trailer) &&
+        memcmp(trailer.magic, ARCHIVE_TRAILER_MAGIC, 8u) == 0 && trailer.index_offset >= blocks &&
+        trailer.index_offset + (uint64_t)trailer.entry_count * FOOTER_BYTES_PER_SESSION == size - sizeof trailer) {
+        reader->index_offset = trailer.index_offset;
+        reader->entry_count = trailer.entry_count;
+        return true;
+    }
+    bool ok = rebuild_index(reader, size);
+    for (uint32_t kind = 0u; ok && kind < ARCHIVE_KEY_COUNT; ++kind) {
+        reader->keys[kind] = sort_keys(reader->entries, reader->entry_count, (archive_key_kind_t)kind);
+        ok = reader->keys[kind] != NULL;
+    }
+    if (!ok) {
+        archive_reader_close(reader);
+    }
+    return ok;
+}
+
+bool archive_reader_entry(archive_reader_t *reader, uint32_t id, archive_entry_t *entry)
+{
+    if (id >= reader->entry_count) {
+        return false;
+    }
+    if (reader->entries != NULL) {
+        *entry = reader->entries[id];
+        return true;
+    }
+    return read_at(reader->fd, entry, sizeof *entry, reader->index_offset + (uint64_t)id * sizeof *entry);
+}
+
+bool archive_reader_load_index(archive_reader_t *reader)
+{
+    if (reader->entries != NULL || reader->entry_count == 0u) {
+        return true;
+    }
+    reader->entries = malloc(reader->entry_count * sizeof *reader->entries);
+    if (reader->entries == NULL) {
+        return false;
+    }
+    if (!read_at(reader->fd, reader->entries, reader->entry_count * sizeof *reader->entries, reader->index_offset)) {
+        free(reader->entries);
+        reader->entries = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool read_key(const archive_reader_t *reader, archive_key_kind_t kind, uint32_t rank, archive_key_t *key)
+{
+    if (reader->keys[kind] != NULL) {
+        *key = reader->keys[kind][rank];
+        return true;
+    }
+    uint64_t table = reader->index_offset + (uint64_t)reader->entry_count * sizeof(archive_entry_t) +
+                     (uint64_t)kind * reader->entry_count * sizeof *key;
+    return read_at(reader->fd, key, sizeof *key, table + (uint64_t)rank * sizeof *key);
+}
+
+bool archive_reader_find(archive_reader_t *reader, archive_key_kind_t kind, uint32_t value, archive_key_t *key)
+{
+    uint32_t low = 0u;
+    uint32_t high = reader->entry_count;
+
+    // Lower bound: keys are sorted by value and then id, so the first at or
+    // above `value` is also the lowest id among equal ones.
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2u;
+        if (!read_key(reader, kind, middle, key)) {
+            return false;
+        }
+        if (key->value < value) {
+            low = middle + 1u;
+        } else {
+            high = middle;
+        }
+    }
+    return low < reader->entry_count && read_key(reader, kind, low, key) && key->id < reader->entry_count;
+}
+
+static bool block_matches(const archive_block_header_t *block, const archive_entry_t *entry)
+{
+    return block->magic == ARCHIVE_BLOCK_MAGIC && block->entry.offset == entry->offset &&
+           block->entry.raw_bytes == entry->raw_bytes && block->entry.packed_bytes == entry->packed_bytes &&
+           block->entry.hash == entry->hash;
+}
+
+bool archive_reader_session(const archive_reader_t *reader, const archive_entry_t *entry, char *out)
+{
+    uint8_t *block = malloc(sizeof(archive_block_header_t) + entry->packed_bytes);
+    archive_block_header_t header;
+    bool ok = block != NULL &&
+              read_at(reader->fd, block, sizeof header + entry->packed_bytes, entry->offset);
+
+    if (ok) {
+        memcpy(&header, block, sizeof header);
+        ok = block_matches(&header, entry) &&
+             unpack_session(reader->dict, reader->dict_bytes, block + sizeof header, entry->packed_bytes,
+                            (uint8_t *)out, entry->raw_bytes) &&
+             session_hash((const uint8_t *)out, entry->raw_bytes) == entry->hash;
+    }
+    free(block);
+    return ok;
+}
+
+void archive_reader_close(archive_reader_t *reader)
+{
+    if (reader->fd >= 0) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+    free(reader->entries);
+    reader->entries = NULL;
+    for (uint32_t kind = 0u; kind < ARCHIVE_KEY_COUNT; ++kind) {
+        free(reader->keys[kind]);
+        reader->keys[kind] = NULL;
+    }
+}
+
+int archive_get(const char *path, const char *key, uint32_t value)
+{
+    archive_reader_t reader;
+    archive_entry_t entry;
+    uint32_t id = 0u;
+    bool found = false;
+
+    if (!archive_reader_open(&reader, path)) {
+        fprintf(stderr, "%s: not a session archive\n", path);
+        return 1;
+    }
+    if (strcmp(key, "id") == 0) {
+        id = value;
+        found = archive_reader_entry(&reader, id, &entry);
+    } else {
+        // A seed has to match; a time finds the first session started since.
+        archive_key_kind_t kind = strcmp(key, "seed") == 0 ? ARCHIVE_KEY_SEED : ARCHIVE_KEY_STARTED_AT;
+        archive_key_t found_key = {0};
+        found = archive_reader_find(&reader, kind, value, &found_key) &&
+                (kind != ARCHIVE_KEY_SEED || found_key.value == value);
+        id = found_key.id;
+        found = found && archive_reader_entry(&reader, id, &entry);
+    }
+    if (!found) {
+        fprintf(stderr, "%s: no session with %s %u\n", path, key, value);
+        archive_reader_close(&reader);
+        return 1;
+    }
+
+    char *session = malloc(entry.raw_bytes > 0u ? entry.raw_bytes : 1u);
+    bool ok = session != NULL && archive_reader_session(&reader, &entry, session);
+    if (ok) {
+        fprintf(stderr, "session %u: seed %u, started %u, %u bytes packed into %u\n", id, entry.seed,
+                entry.started_at, entry.raw_bytes, entry.packed_bytes);
+        fwrite(session, 1u, entry.raw_bytes, stdout);
+    } else {
+        fprintf(stderr, "%s: session %u is damaged\n", path, id);
+    }
+    free(session);
+    archive_reader_close(&reader);
+    return ok ? 0 : 1;
+}
+
+typedef struct {
+    const archive_reader_t *reader;
+    const uint8_t *base;
+    uint64_t size;
+    const char *text;
+    size_t text_length;
+    uint32_t *next_session;
+    archive_scan_totals_t totals;
+} scan_worker_t;
+
+static uint64_t count_lines_with(const char *data, size_t length, const char *text, size_t text_length)
+{
+    uint64_t lines = 0u;
+    const char *end = data + length;
+
+    while (text_length > 0u && data < end) {
+        const char *found = memmem(data, (size_t)(end - data), text, text_length);
+        if (found == NULL) {
+            break;
+        }
+        lines++;
+        const char *newline = memchr(found, '\n', (size_t)(end - found));
+        data = newline != NULL ? newline + 1 : end;
+    }
+    return lines;
+}
+
+static void *scan_worker_main(void *argument)
+{
+    scan_worker_t *worker = argument;
+    const archive_reader_t *reader = worker->reader;
+    char *out = NULL;
+    size_t out_capacity = 0u;
+
+    for (;;) {
+        uint32_t id = __atomic_fetch_add(worker->next_session, 1u, __ATOMIC_RELAXED);
+        if (id >= reader->entry_count) {
+            break;
+        }
+
+        const archive_entry_t *entry = &reader->entries[id];
+        archive_block_header_t block;
+        worker->totals.sessions++;
+        if (entry->offset > worker->size || worker->size - entry->offset < sizeof block + entry->packed_bytes) {
+            worker->totals.damaged++;
+            continue;
+        }
+        if (entry->raw_bytes > out_capacity) {
+            char *grown = realloc(out, entry->raw_bytes);
+            if (grown == NULL) {
+                worker->totals.damaged++;
+                continue;
+            }
+            out = grown;
+            out_capacity = entry->raw_bytes;
+        }
+
+        memcpy(&block, worker->base + entry->offset, sizeof block);
+        if (!block_matches(&block, entry) ||
+            !unpack_session(reader->dict, reader->dict_bytes, worker->base + entry->offset + sizeof block,
+                            entry->packed_bytes, (uint8_t *)out, entry->raw_bytes) ||
+            session_hash((const uint8_t *)out, entry->raw_bytes) != entry->hash) {
+            worker->totals.damaged++;
+            continue;
+        }
+        worker->totals.raw_bytes += entry->raw_bytes;
+        worker->totals.packed_bytes += entry->packed_bytes;
+        worker->totals.lines += count_lines_with(out, entry->raw_bytes, worker->text, worker->text_length);
+    }
+
+    free(out);
+    return NULL;
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool archive_scan_sessions(const char *path, uint32_t threads, const char *text, archive_scan_totals_t *totals,
+                           double *seconds)
+{
+    static scan_worker_t workers[SCAN_MAX_THREADS];
+    pthread_t ids[SCAN_MAX_THREADS];
+    archive_reader_t reader;
+    struct stat info;
+    uint32_t next_session = 0u;
+
+    memset(totals, 0, sizeof *totals);
+    if (!archive_reader_open(&reader, path)) {
+        return false;
+    }
+    if (!archive_reader_load_index(&reader) || fstat(reader.fd, &info) != 0) {
+        archive_reader_close(&reader);
+        return false;
+    }
+    const uint8_t *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, reader.fd, 0);
+    if (base == MAP_FAILED) {
+        archive_reader_close(&reader);
+        return false;
+    }
+
+    threads = threads == 0u ? 1u : (threads > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : threads);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t started = 0u;
+    for (; started < threads; ++started) {
+        workers[started] = (scan_worker_t){.reader = &reader, .base = base, .size = (uint64_t)info.st_size,
+                                           .text = text, .text_length = text != NULL ? strlen(text) : 0u,
+                                           .next_session = &next_session};
+        if (pthread_create(&ids[started], NULL, scan_worker_main, &workers[started]) != 0) {
+            break;
+        }
+    }
+    // Workers take sessions from a shared counter, so fewer threads only
+    // cost time; with none at all the scan runs here.
+    uint32_t ran = started;
+    if (started == 0u) {
+        (void)scan_worker_main(&workers[0]);
+        ran = 1u;
+    }
+    for (uint32_t i = 0u; i < ran; ++i) {
+        if (i < started) {
+            pthread_join(ids[i], NULL);
+        }
+        totals->sessions += workers[i].totals.sessions;
+        totals->raw_bytes += workers[i].totals.raw_bytes;
+        totals->packed_bytes += workers[i].totals.packed_bytes;
+        totals->lines += workers[i].totals.lines;
+        totals->damaged += workers[i].totals.damaged;
+    }
+    *seconds = seconds_since(&start);
+
+    munmap((void *)base, (size_t)info.st_size);
+    archive_reader_close(&reader);
+    return true;
+}
+
+int archive_scan(const char *path, uint32_t threads, const char *text)
+{
+    archive_scan_totals_t totals;
+    double seconds;
+
+    if (!archive_scan_sessions(path, threads, text, &totals, &seconds)) {
+        fprintf(stderr, "%s: not a session archive\n", path);
+        return 1;
+    }
+    printf("%llu sessions, %.1f MB unpacked from %.1f MB in %.3f s with %u threads: %.0f MB/s\n",
+           (unsigned long long)totals.sessions, (double)totals.raw_bytes / 1e6, (double)totals.packed_bytes / 1e6,
+           seconds, threads, seconds > 0.0 ? (double)totals.raw_bytes / seconds / 1e6 : 0.0);
+    if (text != NULL) {
+        printf("%llu lines contain \"%s\"\n", (unsigned long long)totals.lines, text);
+    }
+    if (totals.damaged > 0u) {
+        printf("%llu sessions damaged\n", (unsigned long long)totals.damaged);
+    }
+    return totals.damaged > 0u ? 1 : 0;
+}
+
+// Read a whole file into a fresh buffer; NULL if it cannot be read.
+static char *read_file(const char *path, size_t *length, uint32_t *modified)
+{
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    char *data = malloc((size_t)info.st_size > 0u ? (size_t)info.st_size : 1u);
+    size_t done = 0u;
+    while (data != NULL && done < (size_t)info.st_size) {
+        ssize_t got = read(fd, data + done, (size_t)info.st_size - done);
+        if (got <= 0) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        done += (size_t)got;
+    }
+    close(fd);
+    *length = done;
+    if (modified != NULL) {
+        *modified = (uint32_t)info.st_mtime;
+    }
+    return data;
+}
+
+int archive_pack(const char *path, const char *const *samples, uint32_t sample_count, const char *const *logs,
+                 uint32_t log_count)
+{
+    static uint8_t dict[ARCHIVE_DICT_MAX];
+    char **texts = calloc(sample_count > 0u ? sample_count : 1u, sizeof *texts);
+    size_t *lengths = calloc(sample_count > 0u ? sample_count : 1u, sizeof *lengths);
+    uint32_t dict_bytes = 0u;
+    bool ok = texts != NULL && lengths != NULL;
+
+    for (uint32_t i = 0u; ok && i < sample_count; ++i) {
+        texts[i] = read_file(samples[i], &lengths[i], NULL);
+        if (texts[i] == NULL) {
+            perror(samples[i]);
+            ok = false;
+        }
+    }
+    if (ok) {
+        dict_bytes = archive_train_dict((const char *const *)texts, lengths, sample_count, dict, ARCHIVE_DICT_MAX);
+        printf("dictionary: %u bytes trained on %u samples\n", dict_bytes, sample_count);
+    }
+    for (uint32_t i = 0u; texts != NULL && i < sample_count; ++i) {
+        free(texts[i]);
+    }
+    free(texts);
+    free(lengths);
+    if (!ok) {
+        return 1;
+    }
+
+    // A log does not carry its game's seed, so sessions go in with seed 0
+    // and the log's modification time as their start.
+    archive_writer_t writer;
+    uint64_t raw_bytes = 0u;
+    if (!archive_writer_open(&writer, path, dict, dict_bytes)) {
+        perror(path);
+        return 1;
+    }
+    for (uint32_t i = 0u; ok && i < log_count; ++i) {
+        size_t length = 0u;
+        uint32_t modified = 0u;
+        char *data = read_file(logs[i], &length, &modified);
+        if (data == NULL) {
+            perror(logs[i]);
+            ok = false;
+            break;
+        }
+        ok = archive_writer_add(&writer, 0u, modified, data, length);
+        if (!ok) {
+            perror(path);
+        }
+        raw_bytes += length;
+        free(data);
+    }
+    ok = archive_writer_close(&writer) && ok;
+    struct stat info;
+    if (!ok || stat(path, &info) != 0) {
+        return 1;
+    }
+    uint64_t packed_bytes = (uint64_t)info.st_size;
+    printf("%u sessions, %.1f KB packed into %.1f KB, ratio %.1f\n", log_count, (double)raw_bytes / 1e3,
+           (double)packed_bytes / 1e3, packed_bytes > 0u ? (double)raw_bytes / (double)packed_bytes : 0.0);
+    return 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,166 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#if defined(__linux__)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Write-once archive of console sessions, each compressed on its own so
+ * any one of them can be read back without touching the rest:
+ *
+ *   header      magic, version and the size of the dictionary
+ *   dictionary  text common to most sessions, trained from samples
+ *   blocks      one per session: a block header, then the packed bytes
+ *   index       one entry per session, in id order
+ *   seeds       a key per session, sorted by seed and then id
+ *   times       a key per session, sorted by start time and then id
+ *   trailer     where the index starts and how many entries it has
+ *
+ * Session ids count up from 0 in the order sessions were added, so the
+ * entry for an id sits at a fixed place in the index: reading one session
+ * costs the same few reads (header and dictionary, trailer, entry, block)
+ * however large the archive. Finding one by seed or start time is a binary
+ * search of the matching key table, a read per step, since sessions need
+ * not be added in either order.
+ * Every block header repeats its index entry, so an archive whose writer
+ * died before the trailer went out is read by walking the blocks instead,
+ * and its key tables are sorted in memory.
+ *
+ * Blocks are LZ77 over the dictionary followed by the session, as a run
+ * of sequences:
+ *
+ *   token     literal count in the high nibble, match length - 4 in the
+ *             low; 15 in either means the rest follows as a varint
+ *   literals  [varint] literal bytes
+ *   match     varint offset back from the current position, [varint]
+ *
+ * The last sequence stops after its literals once the session is whole.
+ * Offsets may reach back into the dictionary, which is what lets a short
+ * session compress at all. Varints are LEB128, so a run of ticks costs a
+ * few bytes however long it is.
+ */
+#define ARCHIVE_MAGIC         "SIMONARC"
+#define ARCHIVE_TRAILER_MAGIC "SIMONIDX"
+#define ARCHIVE_VERSION       2u
+#define ARCHIVE_BLOCK_MAGIC   0x4B4C4253u  // "SBLK"
+#define ARCHIVE_DICT_MAX      32768u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t dict_bytes;
+} archive_header_t;
+
+typedef struct {
+    uint64_t offset;       // of the block header
+    uint32_t seed;         // as the outcome reported it; 0 if the game never ended
+    uint32_t started_at;   // unix seconds
+    uint32_t raw_bytes;
+    uint32_t packed_bytes;
+    uint32_t hash;         // of the raw session, to catch damage
+    uint32_t reserved;
+} archive_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t id;
+    archive_entry_t entry;
+} archive_block_header_t;
+
+typedef enum {
+    ARCHIVE_KEY_SEED = 0,
+    ARCHIVE_KEY_STARTED_AT,
+    ARCHIVE_KEY_COUNT
+} archive_key_kind_t;
+
+typedef struct {
+    uint32_t value;
+    uint32_t id;
+} archive_key_t;
+
+typedef struct {
+    uint64_t index_offset;
+    uint32_t entry_count;
+    uint32_t reserved;
+    char magic[8];
+} archive_trailer_t;
+
+typedef struct {
+    int fd;
+    uint64_t offset;
+    uint8_t dict[ARCHIVE_DICT_MAX];
+    uint32_t dict_bytes;
+    archive_entry_t *entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    // Compression scratch, grown to the largest session so far.
+    uint8_t *window;
+    uint32_t *chain;
+    uint32_t *head;
+    uint8_t *packed;
+    size_t scratch_bytes;
+} archive_writer_t;
+
+typedef struct {
+    int fd;
+    uint8_t dict[ARCHIVE_DICT_MAX];
+    uint32_t dict_bytes;
+    uint64_t index_offset;
+    uint32_t entry_count;
+    archive_entry_t *entries;  // loaded on demand, or rebuilt from the blocks
+    // Only for a rebuilt index; otherwise the key tables are searched in place.
+    archive_key_t *keys[ARCHIVE_KEY_COUNT];
+} archive_reader_t;
+
+typedef struct {
+    uint64_t sessions;
+    uint64_t raw_bytes;
+    uint64_t packed_bytes;
+    uint64_t lines;     // containing the scan's text
+    uint64_t damaged;
+} archive_scan_totals_t;
+
+/*
+ * Fill `dict` with the lines most sessions share, best last, so the ones
+ * worth most sit closest to the data. Returns the bytes used.
+ */
+uint32_t archive_train_dict(const char *const *samples, const size_t *lengths, uint32_t count, uint8_t *dict,
+                            uint32_t capacity);
+
+bool archive_writer_open(archive_writer_t *writer, const char *path, const uint8_t *dict, uint32_t dict_bytes);
+// Pack one session; its id is the number of sessions added before it.
+bool archive_writer_add(archive_writer_t *writer, uint32_t seed, uint32_t started_at, const char *data,
+                        size_t length);
+// Write the index and trailer; the archive is complete once this succeeds.
+bool archive_writer_close(archive_writer_t *writer);
+
+bool archive_reader_open(archive_reader_t *reader, const char *path);
+bool archive_reader_entry(archive_reader_t *reader, uint32_t id, archive_entry_t *entry);
+bool archive_reader_load_index(archive_reader_t *reader);
+/*
+ * The first key of `kind` at or above `value`, lowest id first among
+ * equals; false when every key is below it.
+ */
+bool archive_reader_find(archive_reader_t *reader, archive_key_kind_t kind, uint32_t value, archive_key_t *key);
+// Unpack a session into `out`, which holds at least entry->raw_bytes.
+bool archive_reader_session(const archive_reader_t *reader, const archive_entry_t *entry, char *out);
+void archive_reader_close(archive_reader_t *reader);
+// Unpack every session on `threads` threads; false if the archive would not open.
+bool archive_scan_sessions(const char *path, uint32_t threads, const char *text, archive_scan_totals_t *totals,
+                           double *seconds);
+
+// Console modes: one session to stdout by id, seed or start time, and a
+// threaded scan counting the lines that contain `text`.
+int archive_get(const char *path, const char *key, uint32_t value);
+int archive_scan(const char *path, uint32_t threads, const char *text);
+// Train a dictionary on the `samples` files and pack each of the `logs`
+// files into `path` as one session.
+int archive_pack(const char *path, const char *const *samples, uint32_t sample_count, const char *const *logs,
+                 uint32_t log_count);
+
+#endif /* __linux__ */
+
+#endif /* ARCHIVE_H */
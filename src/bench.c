@@ -0,0 +1,968 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "bench.h"
+#include "archive.h"
+#include "board.h"
+#include "game.h"
+#include "hardware.h"
+#include "pool.h"
+#include "protocol.h"
+#include "sequence.h"
+#include "timer_wheel.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (uint64_t)(end->tv_sec - start->tv_sec) * 1000000000u + (uint64_t)end->tv_nsec - (uint64_t)start->tv_nsec;
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void discard_output(void *user, const char *data, size_t length)
+{
+    (void)user;
+    (void)data;
+    (void)length;
+}
+
+// --- sequence store ---
+
+static bool bench_sequence_run(uint32_t steps)
+{
+    simon_sequence_t sequence;
+    struct timespec start;
+    struct timespec end;
+    uint32_t state = 0xACE1u;
+    uint32_t sum = 0u;
+    uint32_t expected = 0u;
+
+    sequence_init(&sequence);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < steps; ++i) {
+        state = state * 1664525u + 1013904223u;
+        if (!sequence_append(&sequence, (uint8_t)((state >> 24) % SIMON_BUTTON_COUNT))) {
+            printf("%u steps: out of memory at step %u\n", steps, i);
+            sequence_free(&sequence);
+            return false;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t append_ns = elapsed_ns(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < steps; ++i) {
+        sum += sequence_get(&sequence, i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t lookup_ns = elapsed_ns(&start, &end);
+
+    // The same stream again, so the lookups cannot be thrown away and the
+    // store is checked while we are at it.
+    state = 0xACE1u;
+    for (uint32_t i = 0u; i < steps; ++i) {
+        state = state * 1664525u + 1013904223u;
+        expected += (state >> 24) % SIMON_BUTTON_COUNT;
+    }
+
+    printf("%8u steps: %8u B, append %.1f ns/step, lookup %.2f ns/step\n", steps,
+           sequence_storage_bytes(&sequence), (double)append_ns / steps, (double)lookup_ns / steps);
+
+    // A second game reuses the buffer the first one grew.
+    sequence_clear(&sequence);
+    uint32_t kept = sequence_storage_bytes(&sequence);
+    sequence_free(&sequence);
+    if (sum != expected || kept < (steps + SEQUENCE_STEPS_PER_BYTE - 1u) / SEQUENCE_STEPS_PER_BYTE) {
+        printf("%8u steps: store mismatch\n", steps);
+        return false;
+    }
+    return true;
+}
+
+int bench_sequence(uint32_t steps)
+{
+    static const uint32_t sizes[] = {1000u, 100000u, 1000000u};
+    bool ok = true;
+
+    if (steps != 0u) {
+        return bench_sequence_run(steps) ? 0 : 1;
+    }
+    for (uint32_t i = 0u; i < sizeof sizes / sizeof sizes[0]; ++i) {
+        ok = bench_sequence_run(sizes[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
+
+// --- game pool ---
+
+#define BENCH_POOL_RUN_MS 1000u
+
+static bool bench_pool_run(uint32_t games)
+{
+    static simon_pool_t pool;
+    static timer_wheel_t wheel;
+    struct timespec start;
+    struct timespec end;
+    bool ok = true;
+
+    simon_pool_handle_t *handles = malloc((size_t)games * sizeof *handles);
+    if (handles == NULL) {
+        return false;
+    }
+    simon_pool_init(&pool);
+    timer_wheel_init(&wheel);
+
+    // First use: every slot is set up with game_init.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < games && ok; ++i) {
+        handles[i] = simon_pool_acquire(&pool, &wheel, false);
+        ok = handles[i] != SIMON_POOL_INVALID;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t acquire_ns = elapsed_ns(&start, &end);
+    if (!ok) {
+        printf("%8u games: out of memory\n", games);
+        free(handles);
+        simon_pool_destroy(&pool);
+        return false;
+    }
+
+    // Every game playing its sequence back, all on the one shared wheel,
+    // the way the server runs a fleet; only the hot slabs are walked.
+    for (uint32_t i = 0u; i < games; ++i) {
+        game_start(simon_pool_get(&pool, handles[i]));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t ms = 0u; ms < BENCH_POOL_RUN_MS; ++ms) {
+        timer_wheel_tick(&wheel);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t run_ns = elapsed_ns(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < games; ++i) {
+        simon_pool_release(&pool, handles[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t release_ns = elapsed_ns(&start, &end);
+
+    // Second and third use: released games come back through game_recycle,
+    // first as a new player at the same cabinet, then with the cold part
+    // cleared as well. The handles from before must no longer resolve.
+    simon_pool_handle_t stale = handles[0];
+    uint64_t recycle_ns[2];
+    for (uint32_t pass = 0u; pass < 2u; ++pass) {
+        if (pass > 0u) {
+            for (uint32_t i = 0u; i < games; ++i) {
+                simon_pool_release(&pool, handles[i]);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t i = 0u; i < games; ++i) {
+            handles[i] = simon_pool_acquire(&pool, &wheel, pass > 0u);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        recycle_ns[pass] = elapsed_ns(&start, &end);
+    }
+    ok = simon_pool_get(&pool, stale) == NULL && pool.live == games && pool.high_water == games;
+
+    printf("%8u games: acquire %.0f ns, release %.0f ns, recycle %.0f ns (fresh cold %.0f ns), %.1f M game-ms/s\n",
+           games, (double)acquire_ns / games, (double)release_ns / games, (double)recycle_ns[0] / games,
+           (double)recycle_ns[1] / games, (double)games * BENCH_POOL_RUN_MS / ((double)run_ns / 1e3));
+    if (!ok) {
+        printf("%8u games: stale handle resolved or slots leaked\n", games);
+    }
+
+    free(handles);
+    simon_pool_destroy(&pool);
+    return ok;
+}
+
+int bench_pool(uint32_t games)
+{
+    static const uint32_t sizes[] = {1000u, 10000u, 100000u, 1000000u};
+    hardware_context_t context;
+    bool ok = true;
+
+    hardware_context_init(&context, discard_output, NULL);
+    hardware_bind_context(&context);
+    printf("hot %zu B and cold %zu B a game\n", sizeof(simon_game_t), sizeof(simon_game_cold_t));
+
+    if (games != 0u) {
+        ok = bench_pool_run(games);
+    } else {
+        for (uint32_t i = 0u; i < sizeof sizes / sizeof sizes[0]; ++i) {
+            ok = bench_pool_run(sizes[i]) && ok;
+        }
+    }
+
+    hardware_bind_context(NULL);
+    return ok ? 0 : 1;
+}
+
+// --- leaderboard readers ---
+
+#define STRESS_MAX_READERS 64u
+
+typedef struct {
+    const simon_game_t *game;
+    const bool *stop;
+    uint64_t reads;
+    uint64_t retries;
+    uint64_t torn;
+} stress_reader_t;
+
+/*
+ * Every score the stress writer inserts is named after itself and beats
+ * the last, so a whole table is strictly descending with matching names.
+ */
+static bool stress_table_consistent(const simon_highscore_table_t *table)
+{
+    for (size_t i = 0; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        const simon_highscore_entry_t *entry = &table->entries[i];
+        char expected[SIMON_MAX_NAME_LENGTH];
+
+        if (entry->score == 0u) {
+            if (entry->name[0] != '\0') {
+                return false;
+            }
+            continue;
+        }
+        if (i > 0u && entry->score >= table->entries[i - 1u].score) {
+            return false;
+        }
+        snprintf(expected, sizeof expected, "S%lu", (unsigned long)entry->score);
+        if (strcmp(entry->name, expected) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *stress_reader_main(void *argument)
+{
+    stress_reader_t *reader = argument;
+
+    while (!__atomic_load_n(reader->stop, __ATOMIC_RELAXED)) {
+        simon_highscore_table_t table;
+        reader->retries += game_read_highscores(reader->game, &table);
+        if (!stress_table_consistent(&table)) {
+            reader->torn++;
+        }
+        reader->reads++;
+    }
+    return NULL;
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+    uint32_t left = *(const uint32_t *)a;
+    uint32_t right = *(const uint32_t *)b;
+    return (left > right) - (left < right);
+}
+
+// One tick and one insert per sample; returns false if the table went wrong.
+static bool stress_run(simon_game_t *game, simon_score_t *score, uint32_t *latency, uint32_t ticks)
+{
+    for (uint32_t i = 0u; i < ticks; ++i) {
+        char name[SIMON_MAX_NAME_LENGTH];
+        struct timespec start;
+        struct timespec end;
+
+        ++*score;
+        snprintf(name, sizeof name, "S%lu", (unsigned long)*score);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        game_tick_1ms(game);
+        (void)game_record_highscore(game, name, *score);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        latency[i] = (uint32_t)elapsed_ns(&start, &end);
+    }
+    qsort(latency, ticks, sizeof latency[0], compare_latency);
+    return stress_table_consistent(&game->cold->highscores);
+}
+
+static void print_latency(const char *label, const uint32_t *latency, uint32_t ticks)
+{
+    printf("%-12s tick+insert p50 %5lu ns  p99 %5lu ns  p99.9 %6lu ns  max %7lu ns\n", label,
+           (unsigned long)latency[ticks / 2u], (unsigned long)latency[(uint64_t)ticks * 99u / 100u],
+           (unsigned long)latency[(uint64_t)ticks * 999u / 1000u], (unsigned long)latency[ticks - 1u]);
+}
+
+int bench_highscore_stress(uint32_t readers, uint32_t ticks)
+{
+    static simon_game_cold_t cold;
+    static timer_wheel_t wheel;
+    static simon_game_t game;
+    hardware_context_t context;
+    pthread_t threads[STRESS_MAX_READERS];
+    stress_reader_t stress[STRESS_MAX_READERS];
+    bool stop = false;
+    uint32_t started = 0u;
+    int error = 0;
+    simon_score_t score = 0u;
+    uint32_t *latency;
+    bool consistent;
+
+    if (readers > STRESS_MAX_READERS) {
+        readers = STRESS_MAX_READERS;
+    }
+    if (ticks == 0u || (latency = malloc(ticks * sizeof *latency)) == NULL) {
+        return 1;
+    }
+
+    hardware_context_init(&context, NULL, NULL);
+    hardware_bind_context(&context);
+    timer_wheel_init(&wheel);
+    game_init(&game, &cold, &wheel);
+
+    consistent = stress_run(&game, &score, latency, ticks);
+    print_latency("no readers", latency, ticks);
+
+    for (; started < readers; ++started) {
+        stress[started] = (stress_reader_t){.game = &game, .stop = &stop};
+        error = pthread_create(&threads[started], NULL, stress_reader_main, &stress[started]);
+        if (error != 0) {
+            break;
+        }
+    }
+    if (error == 0) {
+        consistent = stress_run(&game, &score, latency, ticks) && consistent;
+    }
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+    for (uint32_t i = 0u; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    if (error != 0) {
+        fprintf(stderr, "highscore stress: cannot start reader %u: %s\n", started, strerror(error));
+        game_shutdown(&game);
+        hardware_bind_context(NULL);
+        free(latency);
+        return 1;
+    }
+
+    char label[24];
+    snprintf(label, sizeof label, "%u readers", readers);
+    print_latency(label, latency, ticks);
+
+    uint64_t torn = 0u;
+    for (uint32_t i = 0u; i < readers; ++i) {
+        printf("  reader %u: %llu tables, %llu retries, %llu torn\n", i, (unsigned long long)stress[i].reads,
+               (unsigned long long)stress[i].retries, (unsigned long long)stress[i].torn);
+        torn += stress[i].torn;
+    }
+
+    game_shutdown(&game);
+    hardware_bind_context(NULL);
+    free(latency);
+    return (consistent && torn == 0u) ? 0 : 1;
+}
+
+// --- reaction times ---
+
+#define BENCH_MERGE_PARTS 64u
+#define BENCH_CLOCK_PAIRS 100000u
+
+static uint32_t bench_random(uint32_t *state)
+{
+    uint32_t value = *state;
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    *state = value;
+    return value;
+}
+
+// Shaped like a player's: mostly 250 to 650 ms, with the odd long pause.
+static uint16_t sample_reaction(uint32_t *state)
+{
+    uint32_t reaction = 250u + (bench_random(state) % 200u) + (bench_random(state) % 200u);
+
+    if ((bench_random(state) & 15u) == 0u) {
+        reaction += bench_random(state) % 3000u;
+    }
+    return (uint16_t)reaction;
+}
+
+static uint64_t bench_clock_overhead_ns(void)
+{
+    struct timespec start;
+    struct timespec end;
+    uint64_t total = 0u;
+
+    for (uint32_t i = 0u; i < BENCH_CLOCK_PAIRS; ++i) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed_ns(&start, &end);
+    }
+    return total / BENCH_CLOCK_PAIRS;
+}
+
+// Play an endurance game to `presses` correct presses; returns the time spent in them.
+static uint64_t bench_presses(simon_game_t *game, uint32_t presses, uint32_t *state)
+{
+    uint64_t total = 0u;
+
+    game->cold->endurance = true;
+    game_start(game);
+    for (uint32_t done = 0u; done < presses; ++done) {
+        while (game->state != SIMON_STATE_WAIT_INPUT) {
+            uint32_t wakeup = game_next_wakeup(game);
+            game_advance_ms(game, wakeup == TIMER_WHEEL_IDLE ? 1u : wakeup);
+        }
+        game_advance_ms(game, sample_reaction(state));
+
+        uint8_t mask = (uint8_t)(1u << sequence_get(&game->sequence, game->input_step));
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        game_handle_button(game, mask);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed_ns(&start, &end);
+    }
+    return total;
+}
+
+#if SIMON_SKETCH_K > 0
+
+static const uint16_t bench_permilles[] = {100u, 500u, 900u, 990u};
+
+static int compare_reaction(const void *a, const void *b)
+{
+    uint16_t left = *(const uint16_t *)a;
+    uint16_t right = *(const uint16_t *)b;
+    return (left > right) - (left < right);
+}
+
+// How far `estimate` sits from the exact `permille` quantile, as a fraction of all samples.
+static double bench_rank_error(const uint16_t *sorted, uint32_t count, uint16_t estimate, uint16_t permille)
+{
+    uint32_t below = 0u;
+    uint32_t through = 0u;
+    double target = (double)count * permille / 1000.0;
+
+    while (below < count && sorted[below] < estimate) {
+        below++;
+    }
+    through = below;
+    while (through < count && sorted[through] == estimate) {
+        through++;
+    }
+    if (target < below) {
+        return (below - target) / count;
+    }
+    if (target > through) {
+        return (target - through) / count;
+    }
+    return 0.0;
+}
+
+static void bench_report_sketch(const char *label, const sketch_t *sketch, const uint16_t *sorted, uint32_t count)
+{
+    printf("%-10s", label);
+    for (size_t i = 0u; i < sizeof bench_permilles / sizeof bench_permilles[0]; ++i) {
+        uint16_t estimate = sketch_quantile(sketch, bench_permilles[i]);
+        uint16_t exact = sorted[(uint64_t)count * bench_permilles[i] / 1000u];
+        printf("  p%-2u %4u/%4u (%.2f%%)", bench_permilles[i] / 10u, estimate, exact,
+               100.0 * bench_rank_error(sorted, count, estimate, bench_permilles[i]));
+    }
+    printf("\n");
+}
+
+static bool bench_sketch(uint32_t samples)
+{
+    static sketch_t parts[BENCH_MERGE_PARTS];
+    sketch_t whole;
+    sketch_t merged;
+    uint16_t *values = malloc(samples * sizeof *values);
+    uint32_t state = 0x2545F491u;
+
+    if (values == NULL) {
+        return false;
+    }
+    for (uint32_t i = 0u; i < samples; ++i) {
+        values[i] = sample_reaction(&state);
+    }
+
+    struct timespec start;
+    struct timespec end;
+    sketch_init(&whole);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < samples; ++i) {
+        sketch_update(&whole, values[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("sketch: K=%u, %zu bytes per player, update %.1f ns/sample amortized\n", SIMON_SKETCH_K,
+           sizeof(sketch_t), (double)elapsed_ns(&start, &end) / samples);
+
+    // The same stream split across cabinets and merged back together.
+    for (uint32_t p = 0u; p < BENCH_MERGE_PARTS; ++p) {
+        sketch_init(&parts[p]);
+    }
+    for (uint32_t i = 0u; i < samples; ++i) {
+        sketch_update(&parts[i % BENCH_MERGE_PARTS], values[i]);
+    }
+    // Each cabinet's sketch travels in its export form, as it would off the board.
+    uint64_t exported = 0u;
+    bool imported = true;
+    sketch_init(&merged);
+    for (uint32_t p = 0u; p < BENCH_MERGE_PARTS; ++p) {
+        uint8_t bytes[SKETCH_EXPORT_MAX];
+        sketch_t copy;
+        uint16_t length = sketch_export(&parts[p], bytes, sizeof bytes);
+        exported += length;
+        imported = imported && length != 0u && sketch_import(&copy, bytes, length);
+        if (imported) {
+            sketch_merge(&merged, &copy);
+        }
+    }
+    printf("export: %.0f bytes per cabinet sketch on average, %u at most\n", (double)exported / BENCH_MERGE_PARTS,
+           SKETCH_EXPORT_MAX);
+
+    qsort(values, samples, sizeof values[0], compare_reaction);
+    printf("quantile estimate/exact (rank error) over %u samples:\n", samples);
+    bench_report_sketch("streamed", &whole, values, samples);
+    char label[16];
+    snprintf(label, sizeof label, "%u merged", BENCH_MERGE_PARTS);
+    bench_report_sketch(label, &merged, values, samples);
+    free(values);
+    return imported && merged.count == samples;
+}
+
+#endif /* SIMON_SKETCH_K > 0 */
+
+int bench_reaction(uint32_t presses)
+{
+    static simon_game_cold_t cold;
+    static timer_wheel_t wheel;
+    static simon_game_t game;
+    hardware_context_t context;
+    uint32_t state = 0x9E3779B9u;
+    bool ok = true;
+
+    if (presses == 0u) {
+        return 1;
+    }
+
+#if SIMON_SKETCH_K > 0
+    ok = bench_sketch(presses);
+#else
+    printf("sketches left out (SIMON_SKETCH_K=0)\n");
+#endif
+
+    hardware_context_init(&context, NULL, NULL);
+    hardware_bind_context(&context);
+    timer_wheel_init(&wheel);
+    game_init(&game, &cold, &wheel);
+
+    uint64_t overhead = bench_clock_overhead_ns();
+    uint64_t total = bench_presses(&game, presses, &state);
+    double per_press = (double)total / presses - (double)overhead;
+    printf("press path: %u presses up to level %lu, %.1f ns/press (clock overhead %llu ns removed)\n", presses,
+           (unsigned long)game.level, per_press, (unsigned long long)overhead);
+#if SIMON_SKETCH_K > 0
+    uint32_t held = cold.sketches != NULL ? cold.sketches->reactions.count : 0u;
+    printf("  game sketch holds %lu presses\n", (unsigned long)held);
+    ok = ok && held == presses;
+#endif
+
+    game_shutdown(&game);
+    hardware_bind_context(NULL);
+    return ok ? 0 : 1;
+}
+
+// --- session archive ---
+
+#define BENCH_TRAIN_SESSIONS  64u
+#define BENCH_ACCESS_SAMPLES  1000u
+#define BENCH_SLIP_PERMILLE   25u    // presses the simulated player gets wrong
+#define SESSION_PROMPT        "> "   // what the console prints before reading each line
+#define SESSION_PROMPT_LENGTH 2u
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t *starts;  // count + 1 of them; session i is [starts[i], starts[i + 1])
+    uint32_t *seeds;
+    uint32_t *started_at;
+    uint32_t count;
+    bool failed;
+} corpus_t;
+
+typedef struct {
+    simon_game_t game;
+    simon_game_cold_t cold;
+    timer_wheel_t wheel;
+    simon_protocol_t protocol;
+    hardware_context_t hardware;
+    corpus_t *corpus;
+    uint64_t rng;
+    bool ended;
+    uint32_t seed;
+} session_player_t;
+
+static uint32_t corpus_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (uint32_t)(*state >> 32);
+}
+
+static char *corpus_reserve(corpus_t *corpus, size_t length)
+{
+    if (corpus->length + length > corpus->capacity) {
+        size_t capacity = corpus->capacity > 0u ? corpus->capacity : 1u << 20;
+        while (capacity < corpus->length + length) {
+            capacity *= 2u;
+        }
+        char *grown = realloc(corpus->data, capacity);
+        if (grown == NULL) {
+            corpus->failed = true;
+            return NULL;
+        }
+        corpus->data = grown;
+        corpus->capacity = capacity;
+    }
+    char *at = corpus->data + corpus->length;
+    corpus->length += length;
+    return at;
+}
+
+static void player_output(void *user, const char *data, size_t length)
+{
+    session_player_t *player = user;
+    char *at = corpus_reserve(player->corpus, length);
+    if (at != NULL) {
+        memcpy(at, data, length);
+    }
+}
+
+static void player_outcome(void *user, const simon_outcome_t *outcome)
+{
+    session_player_t *player = user;
+    player->ended = true;
+    player->seed = outcome->seed;
+}
+
+static void player_prompts(session_player_t *player, uint32_t count)
+{
+    char *at = corpus_reserve(player->corpus, (size_t)count * SESSION_PROMPT_LENGTH);
+    for (uint32_t i = 0u; at != NULL && i < count; ++i) {
+        memcpy(at + i * SESSION_PROMPT_LENGTH, SESSION_PROMPT, SESSION_PROMPT_LENGTH);
+    }
+}
+
+static void player_event(session_player_t *player, board_event_t *event)
+{
+    event->timestamp_ms = player->wheel.now;
+    player_prompts(player, 1u);
+    protocol_handle_event(&player->protocol, &player->game, event);
+}
+
+/*
+ * A console driver ticking once a millisecond; the prompts for the quiet
+ * stretches are written in one go and the game skips to its next timer.
+ */
+static void player_idle(session_player_t *player, uint32_t ms)
+{
+    while (ms > 0u) {
+        uint32_t wakeup = game_next_wakeup(&player->game);
+        uint32_t step = wakeup == 0u ? 1u : (wakeup < ms ? wakeup : ms);
+        if (step > 1u) {
+            player_prompts(player, step - 1u);
+            game_advance_ms(&player->game, step - 1u);
+        }
+        player_prompts(player, 1u);
+        game_advance_ms(&player->game, 1u);
+        ms -= step;
+    }
+}
+
+static void player_button(session_player_t *player, uint8_t pad)
+{
+    board_event_t event = {.type = BOARD_EVENT_BUTTON};
+    event.data.button.button = (board_button_t)pad;
+    player_event(player, &event);
+}
+
+static void player_command(session_player_t *player, char value)
+{
+    board_event_t event = {.type = BOARD_EVENT_COMMAND};
+    event.data.command.value = value;
+    player_event(player, &event);
+}
+
+static void player_text(session_player_t *player, const char *text)
+{
+    board_event_t event = {.type = BOARD_EVENT_TEXT};
+    snprintf(event.data.text.text, sizeof event.data.text.text, "%s", text);
+    player_event(player, &event);
+}
+
+static void player_pot(session_player_t *player, uint16_t value)
+{
+    board_event_t event = {.type = BOARD_EVENT_POT};
+    event.data.pot.value = value;
+    player_event(player, &event);
+}
+
+// One power-on of the console: set up, one game played to a slip, a look at the scores.
+static void play_session(session_player_t *player)
+{
+    static const char *const names[] = {"ada", "bo", "cyd", "dee", "eli", "fay", "gus", "hal", "ivy", "jo"};
+    char seed[16];
+
+    player->ended = false;
+    player->seed = 0u;
+    hardware_context_init(&player->hardware, player_output, player);
+    hardware_bind_context(&player->hardware);
+    timer_wheel_init(&player->wheel);
+    game_init(&player->game, &player->cold, &player->wheel);
+    game_set_outcome_sink(&player->game, player_outcome, player);
+    protocol_init(&player->protocol);
+
+    player_pot(player, (uint16_t)(corpus_random(&player->rng) % 1024u));
+    player_idle(player, 200u + corpus_random(&player->rng) % 800u);
+    player_command(player, 'g');
+    snprintf(seed, sizeof seed, "%u", corpus_random(&player->rng) % 100000u);
+    player_text(player, seed);
+    player_idle(player, 200u + corpus_random(&player->rng) % 800u);
+    player_button(player, BOARD_BUTTON_S1);
+
+    while (!player->ended || player->game.state != SIMON_STATE_ATTRACT) {
+        switch (player->game.state) {
+        case SIMON_STATE_WAIT_INPUT: {
+            uint8_t pad = sequence_get(&player->game.sequence, player->game.input_step);
+            player_idle(player, 250u + corpus_random(&player->rng) % 200u + corpus_random(&player->rng) % 200u);
+            if (corpus_random(&player->rng) % 1000u < BENCH_SLIP_PERMILLE) {
+                pad = (uint8_t)((pad + 1u) % SIMON_BUTTON_COUNT);
+            }
+            player_button(player, pad);
+            break;
+        }
+
+        case SIMON_STATE_NAME_ENTRY:
+            player_idle(player, 1000u + corpus_random(&player->rng) % 3000u);
+            player_text(player, names[corpus_random(&player->rng) % (sizeof names / sizeof names[0])]);
+            break;
+
+        default: {
+            uint32_t wakeup = game_next_wakeup(&player->game);
+            player_idle(player, wakeup == TIMER_WHEEL_IDLE ? 1u : wakeup);
+            break;
+        }
+        }
+    }
+
+    if ((corpus_random(&player->rng) & 1u) != 0u) {
+        player_command(player, 'h');
+    }
+    if (corpus_random(&player->rng) % 3u == 0u) {
+        player_command(player, 'b');
+    }
+    player_idle(player, 500u + corpus_random(&player->rng) % 1500u);
+    game_shutdown(&player->game);
+    hardware_bind_context(NULL);
+}
+
+static bool generate_corpus(corpus_t *corpus, uint32_t sessions, uint64_t rng)
+{
+    static session_player_t player;
+    uint32_t started_at = 1700000000u;
+
+    memset(corpus, 0, sizeof *corpus);
+    corpus->starts = malloc(((size_t)sessions + 1u) * sizeof *corpus->starts);
+    corpus->seeds = malloc(((size_t)sessions + 1u) * sizeof *corpus->seeds);
+    corpus->started_at = malloc(((size_t)sessions + 1u) * sizeof *corpus->started_at);
+    if (corpus->starts == NULL || corpus->seeds == NULL || corpus->started_at == NULL) {
+        return false;
+    }
+
+    player.corpus = corpus;
+    player.rng = rng;
+    corpus->starts[0] = 0u;
+    for (uint32_t i = 0u; i < sessions && !corpus->failed; ++i) {
+        play_session(&player);
+        corpus->seeds[i] = player.seed;
+        corpus->started_at[i] = started_at;
+        corpus->starts[i + 1u] = corpus->length;
+        corpus->count++;
+        started_at += player.wheel.now / 1000u + corpus_random(&player.rng) % 600u;
+    }
+    return !corpus->failed;
+}
+
+static void corpus_free(corpus_t *corpus)
+{
+    free(corpus->data);
+    free(corpus->starts);
+    free(corpus->seeds);
+    free(corpus->started_at);
+    memset(corpus, 0, sizeof *corpus);
+}
+
+static bool write_corpus(const char *path, const corpus_t *corpus, const uint8_t *dict, uint32_t dict_bytes)
+{
+    archive_writer_t writer;
+    bool ok = archive_writer_open(&writer, path, dict, dict_bytes);
+
+    for (uint32_t i = 0u; ok && i < corpus->count; ++i) {
+        ok = archive_writer_add(&writer, corpus->seeds[i], corpus->started_at[i], corpus->data + corpus->starts[i],
+                                corpus->starts[i + 1u] - corpus->starts[i]);
+    }
+    if (writer.fd >= 0) {
+        ok = archive_writer_close(&writer) && ok;
+    }
+    return ok;
+}
+
+static uint64_t file_size(const char *path)
+{
+    struct stat info;
+    return stat(path, &info) == 0 ? (uint64_t)info.st_size : 0u;
+}
+
+/*
+ * The baseline is the whole log gzipped as one stream, the way the raw
+ * logs are kept now; gzip runs as a child so nothing links against zlib.
+ */
+static void bench_gzip(const char *path, const corpus_t *corpus)
+{
+    char gz_path[4096];
+    char command[8300];
+    struct timespec start;
+
+    snprintf(gz_path, sizeof gz_path, "%s.txt.gz", path);
+    snprintf(command, sizeof command, "gzip -6 -c > '%s'", gz_path);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    FILE *gzip = popen(command, "w");
+    bool ok = gzip != NULL && fwrite(corpus->data, 1u, corpus->length, gzip) == corpus->length;
+    ok = gzip != NULL && pclose(gzip) == 0 && ok;
+    double pack_seconds = seconds_since(&start);
+    if (!ok) {
+        printf("gzip: unavailable\n");
+        unlink(gz_path);
+        return;
+    }
+
+    snprintf(command, sizeof command, "gzip -dc '%s' > /dev/null", gz_path);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ok = system(command) == 0;
+    double unpack_seconds = seconds_since(&start);
+    uint64_t packed = file_size(gz_path);
+    printf("gzip -6:      %8.2f MB, ratio %6.1f, pack %6.0f MB/s, unpack %6.0f MB/s%s\n", (double)packed / 1e6,
+           packed > 0u ? (double)corpus->length / (double)packed : 0.0, (double)corpus->length / pack_seconds / 1e6,
+           (double)corpus->length / unpack_seconds / 1e6, ok ? "" : " (failed)");
+    printf("              one session needs the stream unpacked up to it: %.1f MB on average\n",
+           (double)corpus->length / 2e6);
+    unlink(gz_path);
+}
+
+int bench_archive(const char *path, uint32_t sessions, uint32_t threads)
+{
+    static uint8_t dict[ARCHIVE_DICT_MAX];
+    corpus_t samples;
+    corpus_t corpus;
+    struct timespec start;
+
+    if (sessions == 0u) {
+        return 1;
+    }
+
+    // Train on sessions of their own, as a dictionary shipped ahead of the data would be.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!generate_corpus(&samples, BENCH_TRAIN_SESSIONS, 0x7EA1D1C7ull) ||
+        !generate_corpus(&corpus, sessions, 0x5E55107Eull)) {
+        fprintf(stderr, "out of memory generating sessions\n");
+        corpus_free(&samples);
+        corpus_free(&corpus);
+        return 1;
+    }
+    printf("%u sessions played in %.2f s: %.1f MB of console text, %.1f KB per session\n", sessions,
+           seconds_since(&start), (double)corpus.length / 1e6, (double)corpus.length / sessions / 1e3);
+
+    const char *texts[BENCH_TRAIN_SESSIONS];
+    size_t lengths[BENCH_TRAIN_SESSIONS];
+    for (uint32_t i = 0u; i < samples.count; ++i) {
+        texts[i] = samples.data + samples.starts[i];
+        lengths[i] = samples.starts[i + 1u] - samples.starts[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t dict_bytes = archive_train_dict(texts, lengths, samples.count, dict, ARCHIVE_DICT_MAX);
+    printf("dictionary:   %u bytes trained on %u sessions in %.3f s\n\n", dict_bytes, samples.count,
+           seconds_since(&start));
+    corpus_free(&samples);
+
+    char plain_path[4096];
+    snprintf(plain_path, sizeof plain_path, "%s.nodict", path);
+    const char *paths[2] = {plain_path, path};
+    const char *labels[2] = {"no dict:", "archive:"};
+    bool ok = true;
+    for (uint32_t pass = 0u; pass < 2u && ok; ++pass) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ok = write_corpus(paths[pass], &corpus, dict, pass == 0u ? 0u : dict_bytes);
+        double seconds = seconds_since(&start);
+        uint64_t packed = file_size(paths[pass]);
+        printf("%-13s %8.2f MB, ratio %6.1f, pack %6.0f MB/s\n", labels[pass], (double)packed / 1e6,
+               packed > 0u ? (double)corpus.length / (double)packed : 0.0, (double)corpus.length / seconds / 1e6);
+    }
+    unlink(plain_path);
+    if (!ok) {
+        perror(path);
+        corpus_free(&corpus);
+        return 1;
+    }
+
+    uint32_t counts[2] = {1u, threads > 1u ? threads : 1u};
+    for (uint32_t pass = 0u; pass < (threads > 1u ? 2u : 1u); ++pass) {
+        archive_scan_totals_t totals = {0u};
+        double seconds = 0.0;
+        ok = ok && archive_scan_sessions(path, counts[pass], NULL, &totals, &seconds) && totals.damaged == 0u &&
+             totals.raw_bytes == corpus.length;
+        printf("scan, %2u thr: %6.0f MB/s unpacked%s\n", counts[pass],
+               seconds > 0.0 ? (double)totals.raw_bytes / seconds / 1e6 : 0.0, ok ? "" : " (mismatch)");
+    }
+
+    // Random sessions by id, checked against what was played.
+    archive_reader_t reader;
+    if (ok && archive_reader_open(&reader, path)) {
+        uint64_t rng = 0xACCE55ull;
+        char *out = malloc(corpus.length);
+        double seconds = 0.0;
+        for (uint32_t i = 0u; out != NULL && ok && i < BENCH_ACCESS_SAMPLES; ++i) {
+            uint32_t id = corpus_random(&rng) % corpus.count;
+            archive_entry_t entry;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ok = archive_reader_entry(&reader, id, &entry) && archive_reader_session(&reader, &entry, out);
+            seconds += seconds_since(&start);
+            ok = ok && entry.raw_bytes == corpus.starts[id + 1u] - corpus.starts[id] &&
+                 memcmp(out, corpus.data + corpus.starts[id], entry.raw_bytes) == 0;
+        }
+        printf("random get:   %.1f us per session by id over %u sessions, checked%s\n\n",
+               seconds / BENCH_ACCESS_SAMPLES * 1e6, BENCH_ACCESS_SAMPLES, ok && out != NULL ? "" : " (mismatch)");
+        free(out);
+        archive_reader_close(&reader);
+    }
+
+    bench_gzip(path, &corpus);
+    corpus_free(&corpus);
+    return ok ? 0 : 1;
+}
+
+#endif /* __linux__ */
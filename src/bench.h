@@ -0,0 +1,43 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+/*
+ * Host benchmarks for the console modes. Each prints its figures and
+ * returns the process exit status.
+ */
+
+// Append and look up `steps` colours in the packed sequence store; 0 runs
+// 1k, 100k and 1M steps.
+int bench_sequence(uint32_t steps);
+/*
+ * Acquire `games` from the pool, run them on one shared wheel, release
+ * them and acquire them again, keeping and then clearing the cold part;
+ * 0 runs 1k, 10k, 100k and 1M games.
+ */
+int bench_pool(uint32_t games);
+/*
+ * Tick one game while `readers` threads copy its leaderboard, inserting a
+ * score every tick, and report tick latency with and without them.
+ */
+int bench_highscore_stress(uint32_t readers, uint32_t ticks);
+/*
+ * Cost of a press with the reaction-time sketch, and the sketch's rank
+ * error against the exact quantiles of `presses` samples.
+ */
+int bench_reaction(uint32_t presses);
+/*
+ * Play `sessions` console sessions, pack them into the archive at `path`
+ * with and without a trained dictionary, scan it on `threads` threads,
+ * read sessions back at random and compare with gzip -6 over the whole
+ * log. gzip packs tighter (about 128 to the archive's 110); what the
+ * archive buys is reading one session without unpacking the rest.
+ */
+int bench_archive(const char *path, uint32_t sessions, uint32_t threads);
+
+#endif /* __linux__ */
+
+#endif /* BENCH_H */
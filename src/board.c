@@ -1,9 +1,20 @@
 #include "board.h"
+#include "format.h"
+#include "hardware.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
+
 #define PROMPT "> "
+// Longest fixed prefix in a status line, "Playback Position: ".
+#define BOARD_MAX_LABEL 20u
+// Longest single "tick <n>", one day of virtual time.
+#define BOARD_MAX_TICK_MS 86400000ul
 
 typedef struct {
     const char *name;
@@ -15,6 +26,14 @@ static const button_alias_t button_aliases[] = {
     {"s2", BOARD_BUTTON_S2},
     {"s3", BOARD_BUTTON_S3},
     {"s4", BOARD_BUTTON_S4},
+#if SIMON_BUTTON_COUNT >= 6
+    {"s5", BOARD_BUTTON_S5},
+    {"s6", BOARD_BUTTON_S6},
+#endif
+#if SIMON_BUTTON_COUNT >= 8
+    {"s7", BOARD_BUTTON_S7},
+    {"s8", BOARD_BUTTON_S8},
+#endif
 };
 
 static void trim(char *text)
@@ -38,11 +57,18 @@ void board_init(void)
     puts(" CAB202 Simon Emulator (Console Mode) ");
     puts("======================================");
     puts("Commands:");
-    puts("  tick                -> advance virtual time");
+    puts("  tick [n]            -> advance virtual time by n ms (default 1)");
+#if SIMON_BUTTON_COUNT == 4
     puts("  s1|s2|s3|s4         -> press a button");
+#elif SIMON_BUTTON_COUNT == 6
+    puts("  s1|s2|...|s6        -> press a button");
+#else
+    puts("  s1|s2|...|s8        -> press a button");
+#endif
     puts("  cmd <char>          -> send UART command character");
     puts("  name <text>         -> submit player name");
     puts("  pot <0-1023>        -> update potentiometer value");
+    puts("  frame <hex bytes>   -> send raw bytes to the UART");
     puts("  quit                -> exit");
     puts("Press ENTER without typing to emit a tick.");
     fputs(PROMPT, stdout);
@@ -54,21 +80,67 @@ void board_shutdown(void)
     puts("Exiting emulator.");
 }
 
-static board_event_t make_tick_event(void)
+// Virtual time of the console, moved only by tick lines.
+static uint32_t console_clock_ms;
+
+static int hex_value(char c)
 {
-    board_event_t event = {.type = BOARD_EVENT_TICK};
-    return event;
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool parse_hex_bytes(const char *text, board_event_t *event)
+{
+    event->data.uart.length = 0u;
+
+    while (*text != '\0') {
+        if (*text == ' ') {
+            text++;
+            continue;
+        }
+
+        int high = hex_value(text[0]);
+        int low = (high < 0) ? -1 : hex_value(text[1]);
+        if (low < 0 || event->data.uart.length >= BOARD_MAX_UART_BYTES) {
+            return false;
+        }
+
+        event->data.uart.bytes[event->data.uart.length++] = (uint8_t)((high << 4) | low);
+        text += 2;
+    }
+
+    return event->data.uart.length > 0u;
+}
+
+static bool parse_tick_count(const char *text, uint32_t *advance_ms)
+{
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || text[0] == '-') {
+        return false;
+    }
+    *advance_ms = (uint32_t)(value > BOARD_MAX_TICK_MS ? BOARD_MAX_TICK_MS : value);
+    return true;
 }
 
-static board_event_t parse_line(char *line)
+static board_event_t parse_event(char *line, uint32_t *advance_ms)
 {
     trim(line);
-    if (line[0] == '\0') {
-        return make_tick_event();
+    if (line[0] == '\0' || strcmp(line, "tick") == 0) {
+        *advance_ms = 1u;
+        return (board_event_t){.type = BOARD_EVENT_TICK};
     }
 
-    if (strcmp(line, "tick") == 0) {
-        return make_tick_event();
+    if (strncmp(line, "tick ", 5) == 0 && parse_tick_count(line + 5, advance_ms)) {
+        return (board_event_t){.type = BOARD_EVENT_TICK};
     }
 
     if (strcmp(line, "quit") == 0) {
@@ -101,6 +173,13 @@ static board_event_t parse_line(char *line)
         return event;
     }
 
+    if (strncmp(line, "frame ", 6) == 0) {
+        board_event_t event = {.type = BOARD_EVENT_UART};
+        if (parse_hex_bytes(line + 6, &event)) {
+            return event;
+        }
+    }
+
     if (strncmp(line, "pot ", 4) == 0 && line[4] != '\0') {
         char *end = NULL;
         long value = strtol(line + 4, &end, 10);
@@ -123,61 +202,119 @@ static board_event_t parse_line(char *line)
     return (board_event_t){.type = BOARD_EVENT_NONE};
 }
 
+board_event_t board_parse_line(char *line, uint32_t *clock_ms)
+{
+    uint32_t advance_ms = 0u;
+    board_event_t event = parse_event(line, &advance_ms);
+
+    *clock_ms += advance_ms;
+    event.timestamp_ms = *clock_ms;
+    return event;
+}
+
 board_event_t board_wait_for_event(void)
 {
-    char line[BOARD_MAX_TEXT];
+    char line[BOARD_MAX_LINE];
 
     fputs(PROMPT, stdout);
     fflush(stdout);
 
     if (fgets(line, sizeof(line), stdin) != NULL) {
-        return parse_line(line);
+        return board_parse_line(line, &console_clock_ms);
+    }
+
+    // Keep time moving once the input runs out.
+    line[0] = '\0';
+    return board_parse_line(line, &console_clock_ms);
+}
+
+#if defined(__AVR__)
+board_event_t board_event_after_sleep(uint32_t slept_ms)
+{
+    console_clock_ms += slept_ms;
+
+    if ((USART0.STATUS & USART_RXCIF_bm) != 0u) {
+        return board_wait_for_event();
     }
 
-    return make_tick_event();
+    // An empty line is one tick, as at the prompt.
+    char line[1] = "";
+    return board_parse_line(line, &console_clock_ms);
+}
+#endif
+
+static void show_text(const char *text)
+{
+    hardware_console_write(text, strlen(text));
+}
+
+// "<label><value>\n"; labels are short literals.
+static void show_labelled_value(const char *label, uint32_t value)
+{
+    char line[BOARD_MAX_LABEL + FORMAT_DECIMAL_MAX + 1u];
+    uint16_t pos = 0u;
+
+    format_append_text(line, &pos, label);
+    format_append_decimal(line, &pos, value);
+    line[pos++] = '\n';
+    hardware_console_write(line, pos);
 }
 
 void board_show_message(const char *message)
 {
-    printf("%s\n", message);
+    show_text(message);
+    show_text("\n");
 }
 
 void board_show_prompt(const char *prompt)
 {
-    printf("%s", prompt);
+    show_text(prompt);
 }
 
 void board_show_color(uint8_t colour_index)
 {
-    printf("Color: %u\n", colour_index);
+    show_labelled_value("Color: ", colour_index);
 }
 
 void board_show_idle_animation(void)
 {
-    printf("Idle animation running...\n");
+    show_text("Idle animation running...\n");
 }
 
-void board_show_score(uint16_t score)
+void board_show_score(uint32_t score)
 {
-    printf("Score: %u\n", score);
+    show_labelled_value("Score: ", score);
+}
+
+void board_show_playback_position(uint32_t step, uint32_t total)
+{
+    char line[BOARD_MAX_LABEL + 2u * FORMAT_DECIMAL_MAX + 2u];
+    uint16_t pos = 0u;
+
+    format_append_text(line, &pos, "Playback Position: ");
+    format_append_decimal(line, &pos, step);
+    line[pos++] = '/';
+    format_append_decimal(line, &pos, total);
+    line[pos++] = '\n';
+    hardware_console_write(line, pos);
 }
 
-void board_show_playback_position(uint8_t step, uint8_t total)
+void board_show_failure(uint32_t score)
 {
-    printf("Playback Position: %u/%u\n", step, total);
+    show_labelled_value("Failure! Score: ", score);
 }
 
-void board_show_failure(uint16_t score)
+void board_show_success(uint32_t level)
 {
-    printf("Failure! Score: %u\n", score);
+    show_labelled_value("Success! Level: ", level);
 }
 
-void board_show_success(uint16_t level)
+void board_show_high_scores_begin(void)
 {
-    printf("Success! Level: %u\n", level);
+    show_text("High Scores:\n");
 }
 
-void board_show_high_scores(const char *table_representation)
+void board_show_high_score_line(const char *line)
 {
-    printf("High Scores:\n%s", table_representation);
+    show_text(line);
 }
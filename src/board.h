@@ -4,13 +4,23 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "variant.h"
+
 #define BOARD_MAX_TEXT 32
+#define BOARD_MAX_UART_BYTES 64
+// Room for "frame " and a full run of "xx " byte pairs, the newline and NUL.
+#define BOARD_MAX_LINE (6 + BOARD_MAX_UART_BYTES * 3 + 2)
 
 typedef enum {
     BOARD_BUTTON_S1 = 0,
     BOARD_BUTTON_S2 = 1,
     BOARD_BUTTON_S3 = 2,
-    BOARD_BUTTON_S4 = 3
+    BOARD_BUTTON_S4 = 3,
+    // Only on the six- and eight-pad cabinets.
+    BOARD_BUTTON_S5 = 4,
+    BOARD_BUTTON_S6 = 5,
+    BOARD_BUTTON_S7 = 6,
+    BOARD_BUTTON_S8 = 7
 } board_button_t;
 
 typedef enum {
@@ -20,11 +30,19 @@ typedef enum {
     BOARD_EVENT_COMMAND,
     BOARD_EVENT_TEXT,
     BOARD_EVENT_POT,
-    BOARD_EVENT_QUIT
+    BOARD_EVENT_QUIT,
+    BOARD_EVENT_UART
 } board_event_type_t;
 
+/*
+ * `timestamp_ms` is the virtual time the event happened at. Tick events
+ * only move that clock forward; the loop consuming the events catches the
+ * game up to each timestamp, so time does not depend on how many other
+ * events arrive in between.
+ */
 typedef struct {
     board_event_type_t type;
+    uint32_t timestamp_ms;
     union {
         struct {
             board_button_t button;
@@ -39,21 +57,34 @@ typedef struct {
         struct {
             uint16_t value;
         } pot;
+        struct {
+            uint8_t length;
+            uint8_t bytes[BOARD_MAX_UART_BYTES];
+        } uart;
     } data;
 } board_event_t;
 
 void board_init(void);
 void board_shutdown(void);
 board_event_t board_wait_for_event(void);
+// Stamps the event from `clock_ms`, which tick lines advance first.
+board_event_t board_parse_line(char *line, uint32_t *clock_ms);
+#if defined(__AVR__)
+// After the main loop slept `slept_ms`: credit that time to the console
+// clock, then read the line whose first byte woke the part, or return a
+// one millisecond tick if the wake timer ended the sleep.
+board_event_t board_event_after_sleep(uint32_t slept_ms);
+#endif
 
 void board_show_message(const char *message);
 void board_show_prompt(const char *prompt);
 void board_show_color(uint8_t colour_index);
 void board_show_idle_animation(void);
-void board_show_score(uint16_t score);
-void board_show_playback_position(uint8_t step, uint8_t total);
-void board_show_failure(uint16_t score);
-void board_show_success(uint16_t level);
-void board_show_high_scores(const char *table_representation);
+void board_show_score(uint32_t score);
+void board_show_playback_position(uint32_t step, uint32_t total);
+void board_show_failure(uint32_t score);
+void board_show_success(uint32_t level);
+void board_show_high_scores_begin(void);
+void board_show_high_score_line(const char *line);
 
 #endif /* BOARD_H */
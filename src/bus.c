@@ -0,0 +1,482 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "bus.h"
+#include "game.h"
+#include "hardware.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NS_PER_US          1000ull
+#define NS_PER_MS          1000000ull
+#define NS_PER_S           1000000000ull
+#define BITS_PER_BYTE      10u  // start, eight data, stop
+#define NO_WAKE            UINT64_MAX
+#define STATUS_REPLY_BYTES 17u
+#define ECHO_REPLY_BYTES   2u
+
+#define PLAYER_IDLE_MIN_MS      2000u
+#define PLAYER_IDLE_SPAN_MS     4000u
+#define PLAYER_REACTION_MIN_MS  300u
+#define PLAYER_REACTION_SPAN_MS 600u
+#define PLAYER_RECHECK_MS       100u
+
+typedef enum {
+    BUS_EVENT_DELIVER = 0,  // a byte reaches the board's UART
+    BUS_EVENT_WAKE,         // one of the board's game timers is due
+    BUS_EVENT_PLAYER,       // the player looks at the board
+    BUS_EVENT_POLL          // the link agent asks the peer for status
+} bus_event_kind_t;
+
+typedef struct {
+    uint64_t time_ns;
+    uint64_t order;
+    uint32_t board;
+    uint32_t tag;  // DELIVER: the byte; WAKE: the wake generation
+    uint8_t kind;
+} bus_event_t;
+
+typedef struct {
+    uint64_t busy_until_ns;
+    uint64_t bytes_sent;
+    uint64_t bytes_lost;
+    uint64_t peak_backlog_ns;
+} bus_line_t;
+
+struct bus_sim;
+
+typedef struct {
+    simon_game_t game;
+    simon_game_cold_t cold;
+    timer_wheel_t wheel;
+    hardware_context_t hardware;
+    simon_protocol_t protocol;
+    struct bus_sim *sim;
+    uint32_t index;
+    uint32_t now_ms;
+    uint32_t wake_generation;
+    uint64_t wake_at_ns;
+    bus_line_t tx;
+    uint32_t rng;
+    // Link agent
+    bool awaiting_reply;
+    uint8_t request_tag;  // echoed ahead of the status record
+    uint64_t request_sent_ns;
+    simon_score_t peer_score;
+    uint64_t requests;
+    uint64_t replies;
+    uint64_t timeouts;
+    uint64_t late_replies;
+    uint64_t naks;
+    uint64_t rtt_total_ns;
+    uint64_t rtt_max_ns;
+    // Finished games
+    uint64_t games;
+    uint64_t score_total;
+} bus_board_t;
+
+typedef struct bus_sim {
+    bus_config_t config;
+    bus_board_t *boards;
+    bus_event_t *heap;
+    size_t heap_length;
+    size_t heap_capacity;
+    uint64_t next_order;
+    uint64_t now_ns;
+    uint64_t byte_ns;
+    uint64_t events;
+    uint64_t loss_rng;
+    uint64_t digest;
+} bus_sim_t;
+
+static bool event_before(const bus_event_t *a, const bus_event_t *b)
+{
+    return a->time_ns != b->time_ns ? a->time_ns < b->time_ns : a->order < b->order;
+}
+
+static void push_event(bus_sim_t *sim, uint64_t time_ns, bus_event_kind_t kind, uint32_t board, uint32_t tag)
+{
+    if (sim->heap_length == sim->heap_capacity) {
+        size_t capacity = sim->heap_capacity == 0u ? 1024u : sim->heap_capacity * 2u;
+        bus_event_t *grown = realloc(sim->heap, capacity * sizeof *grown);
+        if (grown == NULL) {
+            perror("bus event queue");
+            exit(1);
+        }
+        sim->heap = grown;
+        sim->heap_capacity = capacity;
+    }
+
+    bus_event_t event = {.time_ns = time_ns, .order = sim->next_order++, .board = board, .tag = tag,
+                         .kind = (uint8_t)kind};
+    size_t child = sim->heap_length++;
+    while (child > 0u) {
+        size_t parent = (child - 1u) / 2u;
+        if (!event_before(&event, &sim->heap[parent])) {
+            break;
+        }
+        sim->heap[child] = sim->heap[parent];
+        child = parent;
+    }
+    sim->heap[child] = event;
+}
+
+static bus_event_t pop_event(bus_sim_t *sim)
+{
+    bus_event_t top = sim->heap[0];
+    bus_event_t last = sim->heap[--sim->heap_length];
+    size_t parent = 0u;
+
+    for (;;) {
+        size_t child = parent * 2u + 1u;
+        if (child >= sim->heap_length) {
+            break;
+        }
+        if (child + 1u < sim->heap_length && event_before(&sim->heap[child + 1u], &sim->heap[child])) {
+            child++;
+        }
+        if (!event_before(&sim->heap[child], &last)) {
+            break;
+        }
+        sim->heap[parent] = sim->heap[child];
+        parent = child;
+    }
+    sim->heap[parent] = last;
+    return top;
+}
+
+static uint32_t board_random(bus_board_t *board, uint32_t span)
+{
+    board->rng = board->rng * 1103515245u + 12345u;
+    return (board->rng >> 8) % span;
+}
+
+static bool line_loses_byte(bus_sim_t *sim)
+{
+    sim->loss_rng ^= sim->loss_rng << 13;
+    sim->loss_rng ^= sim->loss_rng >> 7;
+    sim->loss_rng ^= sim->loss_rng << 17;
+    return (sim->loss_rng >> 32) % 1000000u < sim->config.loss_ppm;
+}
+
+static void mix_digest(bus_sim_t *sim, uint64_t value)
+{
+    // FNV-1a over the bytes of `value`.
+    for (unsigned i = 0u; i < 8u; ++i) {
+        sim->digest ^= (value >> (8u * i)) & 0xFFu;
+        sim->digest *= 0x100000001B3ull;
+    }
+}
+
+static uint32_t peer_of(uint32_t board)
+{
+    return board ^ 1u;
+}
+
+// hardware_output_fn for a board's UART: every byte queues on its TX line.
+static void board_uart_output(void *user, const char *data, size_t length)
+{
+    bus_board_t *board = user;
+    bus_sim_t *sim = board->sim;
+    bus_line_t *line = &board->tx;
+
+    for (size_t i = 0; i < length; ++i) {
+        uint64_t start = line->busy_until_ns > sim->now_ns ? line->busy_until_ns : sim->now_ns;
+        line->busy_until_ns = start + sim->byte_ns;
+        line->bytes_sent++;
+        if (line->busy_until_ns - sim->now_ns > line->peak_backlog_ns) {
+            line->peak_backlog_ns = line->busy_until_ns - sim->now_ns;
+        }
+        if (line_loses_byte(sim)) {
+            line->bytes_lost++;
+            continue;
+        }
+        push_event(sim, line->busy_until_ns + sim->config.latency_us * NS_PER_US, BUS_EVENT_DELIVER,
+                   peer_of(board->index), (uint8_t)data[i]);
+    }
+}
+
+static uint32_t read_u32(const uint8_t *bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+// protocol_reply_fn for the link agent.
+static void board_peer_reply(void *user, const uint8_t *payload, uint8_t length)
+{
+    bus_board_t *board = user;
+
+    if (length == 0u) {
+        return;
+    }
+    if (payload[0] == PROTOCOL_REPLY_ERROR) {
+        // The peer saw our request corrupted; the next poll asks again.
+        board->naks++;
+        board->awaiting_reply = false;
+        return;
+    }
+    if (payload[0] != (PROTOCOL_CMD_ECHO | PROTOCOL_REPLY_FLAG) || length < ECHO_REPLY_BYTES + STATUS_REPLY_BYTES ||
+        payload[ECHO_REPLY_BYTES] != (PROTOCOL_CMD_STATUS | PROTOCOL_REPLY_FLAG)) {
+        return;
+    }
+    // The answer to a request already given up on; its score is stale.
+    if (!board->awaiting_reply || payload[1] != board->request_tag) {
+        board->late_replies++;
+        return;
+    }
+    payload += ECHO_REPLY_BYTES;
+
+    uint64_t rtt = board->sim->now_ns - board->request_sent_ns;
+    board->peer_score = read_u32(&payload[1]);
+    board->awaiting_reply = false;
+    board->replies++;
+    board->rtt_total_ns += rtt;
+    board->rtt_max_ns = rtt > board->rtt_max_ns ? rtt : board->rtt_max_ns;
+}
+
+// simon_outcome_fn counting each board's finished games.
+static void board_outcome(void *user, const simon_outcome_t *outcome)
+{
+    bus_board_t *board = user;
+    board->games++;
+    board->score_total += outcome->score;
+}
+
+static void run_board_to(bus_board_t *board, uint64_t time_ns)
+{
+    uint32_t target = (uint32_t)(time_ns / NS_PER_MS);
+    if (target != board->now_ms) {
+        game_advance_ms(&board->game, target - board->now_ms);
+        board->now_ms = target;
+    }
+}
+
+// Keep exactly one live WAKE queued, for the game's next deadline.
+static void reschedule_wake(bus_sim_t *sim, bus_board_t *board)
+{
+    uint32_t next = game_next_wakeup(&board->game);
+    uint64_t wake_at = next == TIMER_WHEEL_IDLE ? NO_WAKE : ((uint64_t)board->now_ms + next) * NS_PER_MS;
+
+    if (wake_at != board->wake_at_ns) {
+        board->wake_at_ns = wake_at;
+        board->wake_generation++;
+        if (wake_at != NO_WAKE) {
+            push_event(sim, wake_at, BUS_EVENT_WAKE, board->index, board->wake_generation);
+        }
+    }
+}
+
+/*
+ * The player starts a game a few seconds after the last one and answers
+ * each step after a human reaction time, slipping more often as the
+ * sequence grows. They never type a name, so the name prompt times out.
+ */
+static void run_player(bus_sim_t *sim, bus_board_t *board)
+{
+    simon_game_t *game = &board->game;
+    uint32_t delay = PLAYER_RECHECK_MS;
+
+    switch ((simon_state_t)game->state) {
+    case SIMON_STATE_ATTRACT:
+        game_handle_button(game, (uint8_t)(1u << board_random(board, SIMON_BUTTON_COUNT)));
+        break;
+
+    case SIMON_STATE_WAIT_INPUT: {
+        uint8_t expected = sequence_get(&game->sequence, game->input_step);
+        bool slip = board_random(board, 24u) < game->level;
+        game_handle_button(game, (uint8_t)(1u << (slip ? (expected + 1u) % SIMON_BUTTON_COUNT : expected)));
+        delay = PLAYER_REACTION_MIN_MS + board_random(board, PLAYER_REACTION_SPAN_MS);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (game->state == SIMON_STATE_ATTRACT) {
+        delay = PLAYER_IDLE_MIN_MS + board_random(board, PLAYER_IDLE_SPAN_MS);
+    }
+    push_event(sim, sim->now_ns + delay * NS_PER_MS, BUS_EVENT_PLAYER, board->index, 0u);
+}
+
+static void run_poll(bus_sim_t *sim, bus_board_t *board)
+{
+    if (board->awaiting_reply) {
+        board->timeouts++;
+    }
+    board->request_tag++;
+    const uint8_t request[] = {PROTOCOL_CMD_ECHO, board->request_tag, PROTOCOL_CMD_STATUS};
+    board->awaiting_reply = true;
+    board->request_sent_ns = sim->now_ns;
+    board->requests++;
+    protocol_send_frame(request, sizeof request);
+    push_event(sim, sim->now_ns + sim->config.poll_ms * NS_PER_MS, BUS_EVENT_POLL, board->index, 0u);
+}
+
+static void run_event(bus_sim_t *sim, const bus_event_t *event)
+{
+    bus_board_t *board = &sim->boards[event->board];
+
+    if (event->kind == BUS_EVENT_WAKE && event->tag != board->wake_generation) {
+        return;  // superseded by a later reschedule
+    }
+
+    sim->now_ns = event->time_ns;
+    sim->events++;
+    hardware_bind_context(&board->hardware);
+    run_board_to(board, event->time_ns);
+
+    switch ((bus_event_kind_t)event->kind) {
+    case BUS_EVENT_DELIVER:
+        mix_digest(sim, event->time_ns ^ ((uint64_t)event->board << 40) ^ ((uint64_t)event->tag << 56));
+        protocol_handle_uart_byte(&board->protocol, &board->game, (uint8_t)event->tag);
+        break;
+
+    case BUS_EVENT_WAKE:
+        board->wake_at_ns = NO_WAKE;
+        break;
+
+    case BUS_EVENT_PLAYER:
+        run_player(sim, board);
+        break;
+
+    case BUS_EVENT_POLL:
+        run_poll(sim, board);
+        break;
+    }
+
+    reschedule_wake(sim, board);
+    hardware_bind_context(NULL);
+}
+
+static void init_board(bus_sim_t *sim, bus_board_t *board, uint32_t index)
+{
+    board->sim = sim;
+    board->index = index;
+    board->rng = sim->config.seed * 2654435761u + index;
+    board->wake_at_ns = NO_WAKE;
+
+    // Console text goes nowhere; only the UART reaches the line.
+    hardware_context_init(&board->hardware, NULL, NULL);
+    hardware_context_set_uart(&board->hardware, board_uart_output, board);
+    hardware_bind_context(&board->hardware);
+    timer_wheel_init(&board->wheel);
+    game_init(&board->game, &board->cold, &board->wheel);
+    game_set_outcome_sink(&board->game, board_outcome, board);
+    protocol_init(&board->protocol);
+    protocol_set_link(&board->protocol, board_peer_reply, board);
+    reschedule_wake(sim, board);
+    hardware_bind_context(NULL);
+
+    // Stagger the boards so they do not all act on the same instant.
+    push_event(sim, (uint64_t)board_random(board, PLAYER_IDLE_SPAN_MS) * NS_PER_MS, BUS_EVENT_PLAYER, index, 0u);
+    push_event(sim, (uint64_t)board_random(board, sim->config.poll_ms) * NS_PER_MS, BUS_EVENT_POLL, index, 0u);
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void print_report(const bus_sim_t *sim, double wall)
+{
+    const bus_config_t *config = &sim->config;
+    uint64_t sent = 0u, lost = 0u, peak = 0u, requests = 0u, replies = 0u, timeouts = 0u, naks = 0u;
+    uint64_t late = 0u;
+    uint64_t rtt_total = 0u, rtt_max = 0u, games = 0u, score_total = 0u, bad = 0u, dropped = 0u;
+    uint64_t abandoned = 0u;
+
+    for (uint32_t i = 0u; i < config->boards; ++i) {
+        const bus_board_t *board = &sim->boards[i];
+        sent += board->tx.bytes_sent;
+        lost += board->tx.bytes_lost;
+        peak = board->tx.peak_backlog_ns > peak ? board->tx.peak_backlog_ns : peak;
+        requests += board->requests;
+        replies += board->replies;
+        timeouts += board->timeouts;
+        late += board->late_replies;
+        naks += board->naks;
+        rtt_total += board->rtt_total_ns;
+        rtt_max = board->rtt_max_ns > rtt_max ? board->rtt_max_ns : rtt_max;
+        games += board->games;
+        score_total += board->score_total;
+        bad += board->protocol.frames_bad;
+        abandoned += board->protocol.frames_timed_out;
+        dropped += board->protocol.bytes_dropped;
+    }
+
+    printf("%u boards, %u s virtual in %.3f s wall: %.0fx real time\n", config->boards, config->seconds, wall,
+           wall > 0.0 ? config->seconds / wall : 0.0);
+    printf("%llu events, %.2f M events/s\n", (unsigned long long)sim->events,
+           wall > 0.0 ? (double)sim->events / wall / 1e6 : 0.0);
+    printf("line: %u baud, %u us latency, %u ppm loss\n", config->baud, config->latency_us, config->loss_ppm);
+    printf("  %llu bytes sent, %llu lost, peak TX backlog %.2f ms\n", (unsigned long long)sent,
+           (unsigned long long)lost, (double)peak / NS_PER_MS);
+    printf("link agents: %llu status requests, %llu replies, %llu timeouts, %llu late replies dropped, %llu NAKs\n",
+           (unsigned long long)requests, (unsigned long long)replies, (unsigned long long)timeouts,
+           (unsigned long long)late, (unsigned long long)naks);
+    printf("  round trip mean %.3f ms, max %.3f ms\n",
+           replies > 0u ? (double)rtt_total / (double)replies / NS_PER_MS : 0.0, (double)rtt_max / NS_PER_MS);
+    printf("receivers: %llu bad CRCs, %llu frames timed out, %llu stray bytes dropped\n", (unsigned long long)bad,
+           (unsigned long long)abandoned, (unsigned long long)dropped);
+    printf("games: %llu finished, mean score %.2f\n", (unsigned long long)games,
+           games > 0u ? (double)score_total / (double)games : 0.0);
+    printf("digest %016llx\n", (unsigned long long)sim->digest);
+}
+
+int bus_simulate(const bus_config_t *config)
+{
+    bus_sim_t sim = {.config = *config, .loss_rng = 0x9E3779B97F4A7C15ull ^ config->seed,
+                     .digest = 0xCBF29CE484222325ull};
+
+    sim.config.boards &= ~1u;
+    if (sim.config.boards == 0u || sim.config.baud == 0u || sim.config.poll_ms == 0u) {
+        fprintf(stderr, "link simulation needs at least two boards, a baud rate and a poll interval\n");
+        return 1;
+    }
+    sim.byte_ns = BITS_PER_BYTE * NS_PER_S / sim.config.baud;
+    sim.boards = aligned_alloc(SIMON_CACHE_LINE, sim.config.boards * sizeof *sim.boards);
+    if (sim.boards == NULL) {
+        perror("bus boards");
+        return 1;
+    }
+    memset(sim.boards, 0, sim.config.boards * sizeof *sim.boards);
+
+    for (uint32_t i = 0u; i < sim.config.boards; ++i) {
+        init_board(&sim, &sim.boards[i], i);
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t end = (uint64_t)sim.config.seconds * NS_PER_S;
+    while (sim.heap_length > 0u && sim.heap[0].time_ns < end) {
+        bus_event_t event = pop_event(&sim);
+        run_event(&sim, &event);
+    }
+    double wall = seconds_since(&start);
+
+    for (uint32_t i = 0u; i < sim.config.boards; ++i) {
+        mix_digest(&sim, sim.boards[i].peer_score);
+        mix_digest(&sim, sim.boards[i].games);
+    }
+    print_report(&sim, wall);
+
+    for (uint32_t i = 0u; i < sim.config.boards; ++i) {
+        hardware_bind_context(&sim.boards[i].hardware);
+        game_shutdown(&sim.boards[i].game);
+    }
+    hardware_bind_context(NULL);
+    free(sim.boards);
+    free(sim.heap);
+    return 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,42 @@
+#ifndef BUS_H
+#define BUS_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+/*
+ * Link-play simulation: many emulated boards in one process, paired head
+ * to head, each pair joined by a virtual UART with one line per direction.
+ * A line sends one 8N1 byte at a time at the configured baud, adds a fixed
+ * latency and loses bytes at random at the configured rate.
+ *
+ * A discrete-event scheduler drives every board from one virtual clock.
+ * Boards only run when a byte arrives, their player acts, their link agent
+ * polls the peer or one of their game timers is due, and skip straight
+ * over the idle time in between, so hundreds of boards run far faster
+ * than real time. Events at the same instant run in the order they were
+ * scheduled, and every random draw comes from a seeded generator, so a
+ * configuration always plays out the same way.
+ *
+ * The link agent stands in for the head-to-head firmware: it asks the
+ * peer for its status every poll interval and keeps the latest score it
+ * hears back. Each request is tagged with an ECHO, so a reply that only
+ * arrives after the next poll is dropped rather than taken for its answer. Each board's UART carries those frames, the peer's replies
+ * and whatever the game itself prints to the UART.
+ */
+typedef struct {
+    uint32_t boards;      // rounded down to an even count
+    uint32_t seconds;     // virtual time to run
+    uint32_t baud;
+    uint32_t latency_us;  // added to every byte after it is sent
+    uint32_t loss_ppm;    // bytes lost per million sent
+    uint32_t poll_ms;     // how often each agent asks its peer for status
+    uint32_t seed;
+} bus_config_t;
+
+int bus_simulate(const bus_config_t *config);
+
+#endif /* __linux__ */
+
+#endif /* BUS_H */
@@ -0,0 +1,196 @@
+#ifndef BUZZER_TABLE_H
+#define BUZZER_TABLE_H
+
+/* Generated by scripts/gen_buzzer_table.py; do not edit. */
+
+#include <stdint.h>
+
+#include "variant.h"
+
+#define BUZZER_TONES       SIMON_BUTTON_COUNT
+#define BUZZER_SHIFT_MIN   (-3)
+#define BUZZER_SHIFT_MAX   3
+#define BUZZER_SHIFTS      7u
+#define BUZZER_F_CPU       3333333ul
+
+typedef struct {
+    uint32_t centi_hz;
+    uint16_t period;  // TCA0.SINGLE.PER
+    uint16_t compare; // TCA0.SINGLE.CMP0
+    uint8_t clksel;   // TCA_SINGLE_CLKSEL group position
+} buzzer_setting_t;
+
+#if SIMON_BUTTON_COUNT == 4
+static const buzzer_setting_t buzzer_settings[BUZZER_TONES][BUZZER_SHIFTS] = {
+    {
+        {   4560u, 36545u, 18273u, 1u}, // 45.60 Hz, shift -3, /2
+        {   9121u, 36545u, 18273u, 0u}, // 91.21 Hz, shift -2, /1
+        {  18242u, 18272u,  9136u, 0u}, // 182.42 Hz, shift -1, /1
+        {  36484u,  9135u,  4568u, 0u}, // 364.84 Hz, shift +0, /1
+        {  72968u,  4567u,  2284u, 0u}, // 729.68 Hz, shift +1, /1
+        { 145936u,  2283u,  1142u, 0u}, // 1459.36 Hz, shift +2, /1
+        { 291872u,  1141u,   571u, 0u}, // 2918.72 Hz, shift +3, /1
+    },
+    {
+        {   6081u, 54818u, 27409u, 0u}, // 60.81 Hz, shift -3, /1
+        {  12161u, 27408u, 13704u, 0u}, // 121.61 Hz, shift -2, /1
+        {  24323u, 13704u,  6852u, 0u}, // 243.23 Hz, shift -1, /1
+        {  48645u,  6851u,  3426u, 0u}, // 486.45 Hz, shift +0, /1
+        {  97290u,  3425u,  1713u, 0u}, // 972.90 Hz, shift +1, /1
+        { 194580u,  1712u,   856u, 0u}, // 1945.80 Hz, shift +2, /1
+        { 389160u,   856u,   428u, 0u}, // 3891.60 Hz, shift +3, /1
+    },
+    {
+        {   8107u, 41113u, 20557u, 0u}, // 81.07 Hz, shift -3, /1
+        {  16215u, 20556u, 10278u, 0u}, // 162.15 Hz, shift -2, /1
+        {  32430u, 10278u,  5139u, 0u}, // 324.30 Hz, shift -1, /1
+        {  64860u,  5138u,  2569u, 0u}, // 648.60 Hz, shift +0, /1
+        { 129720u,  2569u,  1285u, 0u}, // 1297.20 Hz, shift +1, /1
+        { 259440u,  1284u,   642u, 0u}, // 2594.40 Hz, shift +2, /1
+        { 518880u,   641u,   321u, 0u}, // 5188.80 Hz, shift +3, /1
+    },
+    {
+        {  10810u, 30835u, 15418u, 0u}, // 108.10 Hz, shift -3, /1
+        {  21620u, 15417u,  7709u, 0u}, // 216.20 Hz, shift -2, /1
+        {  43240u,  7708u,  3854u, 0u}, // 432.40 Hz, shift -1, /1
+        {  86480u,  3853u,  1927u, 0u}, // 864.80 Hz, shift +0, /1
+        { 172960u,  1926u,   963u, 0u}, // 1729.60 Hz, shift +1, /1
+        { 345920u,   963u,   482u, 0u}, // 3459.20 Hz, shift +2, /1
+        { 691840u,   481u,   241u, 0u}, // 6918.40 Hz, shift +3, /1
+    },
+};
+#elif SIMON_BUTTON_COUNT == 6
+static const buzzer_setting_t buzzer_settings[BUZZER_TONES][BUZZER_SHIFTS] = {
+    {
+        {   4560u, 36545u, 18273u, 1u}, // 45.60 Hz, shift -3, /2
+        {   9121u, 36545u, 18273u, 0u}, // 91.21 Hz, shift -2, /1
+        {  18242u, 18272u,  9136u, 0u}, // 182.42 Hz, shift -1, /1
+        {  36484u,  9135u,  4568u, 0u}, // 364.84 Hz, shift +0, /1
+        {  72968u,  4567u,  2284u, 0u}, // 729.68 Hz, shift +1, /1
+        { 145936u,  2283u,  1142u, 0u}, // 1459.36 Hz, shift +2, /1
+        { 291872u,  1141u,   571u, 0u}, // 2918.72 Hz, shift +3, /1
+    },
+    {
+        {   6081u, 54818u, 27409u, 0u}, // 60.81 Hz, shift -3, /1
+        {  12161u, 27408u, 13704u, 0u}, // 121.61 Hz, shift -2, /1
+        {  24323u, 13704u,  6852u, 0u}, // 243.23 Hz, shift -1, /1
+        {  48645u,  6851u,  3426u, 0u}, // 486.45 Hz, shift +0, /1
+        {  97290u,  3425u,  1713u, 0u}, // 972.90 Hz, shift +1, /1
+        { 194580u,  1712u,   856u, 0u}, // 1945.80 Hz, shift +2, /1
+        { 389160u,   856u,   428u, 0u}, // 3891.60 Hz, shift +3, /1
+    },
+    {
+        {   8107u, 41113u, 20557u, 0u}, // 81.07 Hz, shift -3, /1
+        {  16215u, 20556u, 10278u, 0u}, // 162.15 Hz, shift -2, /1
+        {  32430u, 10278u,  5139u, 0u}, // 324.30 Hz, shift -1, /1
+        {  64860u,  5138u,  2569u, 0u}, // 648.60 Hz, shift +0, /1
+        { 129720u,  2569u,  1285u, 0u}, // 1297.20 Hz, shift +1, /1
+        { 259440u,  1284u,   642u, 0u}, // 2594.40 Hz, shift +2, /1
+        { 518880u,   641u,   321u, 0u}, // 5188.80 Hz, shift +3, /1
+    },
+    {
+        {  10810u, 30835u, 15418u, 0u}, // 108.10 Hz, shift -3, /1
+        {  21620u, 15417u,  7709u, 0u}, // 216.20 Hz, shift -2, /1
+        {  43240u,  7708u,  3854u, 0u}, // 432.40 Hz, shift -1, /1
+        {  86480u,  3853u,  1927u, 0u}, // 864.80 Hz, shift +0, /1
+        { 172960u,  1926u,   963u, 0u}, // 1729.60 Hz, shift +1, /1
+        { 345920u,   963u,   482u, 0u}, // 3459.20 Hz, shift +2, /1
+        { 691840u,   481u,   241u, 0u}, // 6918.40 Hz, shift +3, /1
+    },
+    {
+        {  14413u, 23126u, 11563u, 0u}, // 144.13 Hz, shift -3, /1
+        {  28827u, 11562u,  5781u, 0u}, // 288.27 Hz, shift -2, /1
+        {  57653u,  5781u,  2891u, 0u}, // 576.53 Hz, shift -1, /1
+        { 115307u,  2890u,  1445u, 0u}, // 1153.07 Hz, shift +0, /1
+        { 230614u,  1444u,   722u, 0u}, // 2306.14 Hz, shift +1, /1
+        { 461228u,   722u,   361u, 0u}, // 4612.28 Hz, shift +2, /1
+        { 922456u,   360u,   180u, 0u}, // 9224.56 Hz, shift +3, /1
+    },
+    {
+        {  19218u, 17344u,  8672u, 0u}, // 192.18 Hz, shift -3, /1
+        {  38436u,  8672u,  4336u, 0u}, // 384.36 Hz, shift -2, /1
+        {  76871u,  4335u,  2168u, 0u}, // 768.71 Hz, shift -1, /1
+        { 153742u,  2167u,  1084u, 0u}, // 1537.42 Hz, shift +0, /1
+        { 307484u,  1083u,   542u, 0u}, // 3074.84 Hz, shift +1, /1
+        { 614968u,   541u,   271u, 0u}, // 6149.68 Hz, shift +2, /1
+        {1229936u,   270u,   135u, 0u}, // 12299.36 Hz, shift +3, /1
+    },
+};
+#elif SIMON_BUTTON_COUNT == 8
+static const buzzer_setting_t buzzer_settings[BUZZER_TONES][BUZZER_SHIFTS] = {
+    {
+        {   4560u, 36545u, 18273u, 1u}, // 45.60 Hz, shift -3, /2
+        {   9121u, 36545u, 18273u, 0u}, // 91.21 Hz, shift -2, /1
+        {  18242u, 18272u,  9136u, 0u}, // 182.42 Hz, shift -1, /1
+        {  36484u,  9135u,  4568u, 0u}, // 364.84 Hz, shift +0, /1
+        {  72968u,  4567u,  2284u, 0u}, // 729.68 Hz, shift +1, /1
+        { 145936u,  2283u,  1142u, 0u}, // 1459.36 Hz, shift +2, /1
+        { 291872u,  1141u,   571u, 0u}, // 2918.72 Hz, shift +3, /1
+    },
+    {
+        {   6081u, 54818u, 27409u, 0u}, // 60.81 Hz, shift -3, /1
+        {  12161u, 27408u, 13704u, 0u}, // 121.61 Hz, shift -2, /1
+        {  24323u, 13704u,  6852u, 0u}, // 243.23 Hz, shift -1, /1
+        {  48645u,  6851u,  3426u, 0u}, // 486.45 Hz, shift +0, /1
+        {  97290u,  3425u,  1713u, 0u}, // 972.90 Hz, shift +1, /1
+        { 194580u,  1712u,   856u, 0u}, // 1945.80 Hz, shift +2, /1
+        { 389160u,   856u,   428u, 0u}, // 3891.60 Hz, shift +3, /1
+    },
+    {
+        {   8107u, 41113u, 20557u, 0u}, // 81.07 Hz, shift -3, /1
+        {  16215u, 20556u, 10278u, 0u}, // 162.15 Hz, shift -2, /1
+        {  32430u, 10278u,  5139u, 0u}, // 324.30 Hz, shift -1, /1
+        {  64860u,  5138u,  2569u, 0u}, // 648.60 Hz, shift +0, /1
+        { 129720u,  2569u,  1285u, 0u}, // 1297.20 Hz, shift +1, /1
+        { 259440u,  1284u,   642u, 0u}, // 2594.40 Hz, shift +2, /1
+        { 518880u,   641u,   321u, 0u}, // 5188.80 Hz, shift +3, /1
+    },
+    {
+        {  10810u, 30835u, 15418u, 0u}, // 108.10 Hz, shift -3, /1
+        {  21620u, 15417u,  7709u, 0u}, // 216.20 Hz, shift -2, /1
+        {  43240u,  7708u,  3854u, 0u}, // 432.40 Hz, shift -1, /1
+        {  86480u,  3853u,  1927u, 0u}, // 864.80 Hz, shift +0, /1
+        { 172960u,  1926u,   963u, 0u}, // 1729.60 Hz, shift +1, /1
+        { 345920u,   963u,   482u, 0u}, // 3459.20 Hz, shift +2, /1
+        { 691840u,   481u,   241u, 0u}, // 6918.40 Hz, shift +3, /1
+    },
+    {
+        {  14413u, 23126u, 11563u, 0u}, // 144.13 Hz, shift -3, /1
+        {  28827u, 11562u,  5781u, 0u}, // 288.27 Hz, shift -2, /1
+        {  57653u,  5781u,  2891u, 0u}, // 576.53 Hz, shift -1, /1
+        { 115307u,  2890u,  1445u, 0u}, // 1153.07 Hz, shift +0, /1
+        { 230614u,  1444u,   722u, 0u}, // 2306.14 Hz, shift +1, /1
+        { 461228u,   722u,   361u, 0u}, // 4612.28 Hz, shift +2, /1
+        { 922456u,   360u,   180u, 0u}, // 9224.56 Hz, shift +3, /1
+    },
+    {
+        {  19218u, 17344u,  8672u, 0u}, // 192.18 Hz, shift -3, /1
+        {  38436u,  8672u,  4336u, 0u}, // 384.36 Hz, shift -2, /1
+        {  76871u,  4335u,  2168u, 0u}, // 768.71 Hz, shift -1, /1
+        { 153742u,  2167u,  1084u, 0u}, // 1537.42 Hz, shift +0, /1
+        { 307484u,  1083u,   542u, 0u}, // 3074.84 Hz, shift +1, /1
+        { 614968u,   541u,   271u, 0u}, // 6149.68 Hz, shift +2, /1
+        {1229936u,   270u,   135u, 0u}, // 12299.36 Hz, shift +3, /1
+    },
+    {
+        {  25624u, 13008u,  6504u, 0u}, // 256.24 Hz, shift -3, /1
+        {  51247u,  6503u,  3252u, 0u}, // 512.47 Hz, shift -2, /1
+        { 102495u,  3251u,  1626u, 0u}, // 1024.95 Hz, shift -1, /1
+        { 204990u,  1625u,   813u, 0u}, // 2049.90 Hz, shift +0, /1
+        { 409980u,   812u,   406u, 0u}, // 4099.80 Hz, shift +1, /1
+        { 819960u,   406u,   203u, 0u}, // 8199.60 Hz, shift +2, /1
+        {1639920u,   202u,   101u, 0u}, // 16399.20 Hz, shift +3, /1
+    },
+    {
+        {  34165u,  9756u,  4878u, 0u}, // 341.65 Hz, shift -3, /1
+        {  68330u,  4877u,  2439u, 0u}, // 683.30 Hz, shift -2, /1
+        { 136660u,  2438u,  1219u, 0u}, // 1366.60 Hz, shift -1, /1
+        { 273320u,  1219u,   610u, 0u}, // 2733.20 Hz, shift +0, /1
+        { 546640u,   609u,   305u, 0u}, // 5466.40 Hz, shift +1, /1
+        {1093280u,   304u,   152u, 0u}, // 10932.80 Hz, shift +2, /1
+        {2186560u,   151u,    76u, 0u}, // 21865.60 Hz, shift +3, /1
+    },
+};
+#endif
+
+#endif /* BUZZER_TABLE_H */
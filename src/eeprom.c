@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+
+#include "eeprom.h"
+
+#if defined(__AVR__)
+
+#include <avr/cpufunc.h>
+#include <avr/eeprom.h>
+#include <avr/io.h>
+
+void eeprom_read(uint16_t address, void *data, uint16_t length)
+{
+    eeprom_read_block(data, (const void *)address, length);
+}
+
+/*
+ * eeprom_update_block programs one byte at a time and waits out each one,
+ * several milliseconds a byte from inside the tick. Instead, load the
+ * bytes that differ into the page buffer through the mapped EEPROM and
+ * start a single erase/write of the page. The CPU carries on while the
+ * page programs; only a write that follows within a page time waits.
+ */
+void eeprom_write(uint16_t address, const void *data, uint16_t length)
+{
+    const uint8_t *bytes = data;
+    volatile uint8_t *mapped = (volatile uint8_t *)MAPPED_EEPROM_START;
+
+    while (length > 0u) {
+        uint16_t chunk = (uint16_t)(EEPROM_PAGE_SIZE - address % EEPROM_PAGE_SIZE);
+        bool loaded = false;
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        while ((NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm) != 0u) {
+        }
+
+        // Only bytes loaded into the page buffer are erased and written.
+        for (uint16_t i = 0u; i < chunk; ++i) {
+            if (mapped[address + i] != bytes[i]) {
+                mapped[address + i] = bytes[i];
+                loaded = true;
+            }
+        }
+        if (loaded) {
+            _PROTECTED_WRITE_SPM(NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEERASEWRITE_gc);
+        }
+
+        address = (uint16_t)(address + chunk);
+        bytes += chunk;
+        length = (uint16_t)(length - chunk);
+    }
+}
+
+#else
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+static uint8_t image[EEPROM_SIZE];
+static bool image_loaded;
+static int backing_fd = -1;
+static eeprom_stats_t stats;
+static bool power_cut_armed;
+static bool power_lost;
+static uint32_t bytes_until_power_cut;
+
+static void load_erased_image(void)
+{
+    if (!image_loaded) {
+        memset(image, EEPROM_ERASED, sizeof image);
+        image_loaded = true;
+    }
+}
+
+static void sync_page(uint16_t page)
+{
+    if (backing_fd >= 0) {
+        (void)pwrite(backing_fd, image + page * EEPROM_PAGE_SIZE, EEPROM_PAGE_SIZE, (off_t)page * EEPROM_PAGE_SIZE);
+    }
+}
+
+bool eeprom_open(const char *path)
+{
+    eeprom_close();
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    memset(image, EEPROM_ERASED, sizeof image);
+    ssize_t length = pread(fd, image, sizeof image, 0);
+    if (length < (ssize_t)sizeof image) {
+        // New or short file: the rest of the part is erased.
+        memset(image + (length > 0 ? length : 0), EEPROM_ERASED, sizeof image - (size_t)(length > 0 ? length : 0));
+        (void)pwrite(fd, image, sizeof image, 0);
+    }
+
+    backing_fd = fd;
+    image_loaded = true;
+    return true;
+}
+
+void eeprom_close(void)
+{
+    if (backing_fd >= 0) {
+        close(backing_fd);
+        backing_fd = -1;
+    }
+}
+
+const eeprom_stats_t *eeprom_get_stats(void)
+{
+    return &stats;
+}
+
+void eeprom_reset_stats(void)
+{
+    memset(&stats, 0, sizeof stats);
+}
+
+void eeprom_cut_power_after(uint32_t bytes)
+{
+    power_cut_armed = true;
+    bytes_until_power_cut = bytes;
+}
+
+void eeprom_restore_power(void)
+{
+    power_cut_armed = false;
+    power_lost = false;
+}
+
+void eeprom_read(uint16_t address, void *data, uint16_t length)
+{
+    load_erased_image();
+    memcpy(data, image + address, length);
+    stats.bytes_read += length;
+}
+
+void eeprom_write(uint16_t address, const void *data, uint16_t length)
+{
+    const uint8_t *bytes = data;
+
+    load_erased_image();
+
+    while (length > 0u && !power_lost) {
+        uint16_t page = (uint16_t)(address / EEPROM_PAGE_SIZE);
+        uint16_t offset = (uint16_t)(address % EEPROM_PAGE_SIZE);
+        uint16_t chunk = (uint16_t)(EEPROM_PAGE_SIZE - offset);
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        // Every touched page costs one erase/write cycle.
+        stats.page_writes[page]++;
+        stats.write_time_us += EEPROM_PAGE_WRITE_US;
+
+        uint16_t programmed = chunk;
+        if (power_cut_armed && bytes_until_power_cut < chunk) {
+            programmed = (uint16_t)bytes_until_power_cut;
+            power_lost = true;
+        } else if (power_cut_armed) {
+            bytes_until_power_cut -= chunk;
+        }
+
+        memcpy(image + address, bytes, programmed);
+        memset(image + address + programmed, EEPROM_ERASED, chunk - programmed);
+        sync_page(page);
+
+        address = (uint16_t)(address + chunk);
+        bytes += chunk;
+        length = (uint16_t)(length - chunk);
+    }
+}
+
+#endif /* __AVR__ */
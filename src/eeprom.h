@@ -0,0 +1,52 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Byte-addressed EEPROM programmed a page at a time. On the board this is
+ * the ATtiny1626's 256-byte EEPROM. Host builds keep the image in RAM,
+ * optionally mirrored to a file, and count the page cycles and programming
+ * time the real part would spend.
+ */
+#define EEPROM_SIZE             256u
+#define EEPROM_PAGE_SIZE        32u
+#define EEPROM_PAGE_COUNT       (EEPROM_SIZE / EEPROM_PAGE_SIZE)
+#define EEPROM_ERASED           0xFFu
+#define EEPROM_PAGE_WRITE_US    4000u
+#define EEPROM_READ_NS_PER_BYTE 50u
+#define EEPROM_ENDURANCE_CYCLES 100000u
+
+void eeprom_read(uint16_t address, void *data, uint16_t length);
+void eeprom_write(uint16_t address, const void *data, uint16_t length);
+
+#if !defined(__AVR__)
+
+typedef struct {
+    uint32_t page_writes[EEPROM_PAGE_COUNT];
+    uint64_t bytes_read;
+    uint64_t write_time_us;
+} eeprom_stats_t;
+
+/*
+ * Back the image with `path`, creating an erased one if it does not exist.
+ * Without a file the image starts erased and lives only in memory.
+ */
+bool eeprom_open(const char *path);
+void eeprom_close(void);
+const eeprom_stats_t *eeprom_get_stats(void);
+void eeprom_reset_stats(void);
+
+/*
+ * Fault injection for recovery tests: power fails after `bytes` more bytes
+ * have been programmed. The page being written keeps the bytes that made
+ * it and reads as erased after them; later writes are dropped until
+ * eeprom_restore_power.
+ */
+void eeprom_cut_power_after(uint32_t bytes);
+void eeprom_restore_power(void);
+
+#endif /* !__AVR__ */
+
+#endif /* EEPROM_H */
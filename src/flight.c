@@ -0,0 +1,262 @@
+#define _GNU_SOURCE
+
+#include "flight.h"
+
+#if FLIGHT_RECORDER_ENABLED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FLIGHT_PATH_MAX      256u
+#define FLIGHT_ALT_STACK     16384u
+
+typedef struct {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t record_count;
+    uint32_t next_sequence;
+    uint32_t reserved;
+} flight_header_t;
+
+static flight_record_t ring[FLIGHT_RECORD_COUNT];
+static uint32_t next_sequence;
+static uint32_t current_time_ms;
+static bool armed;
+static char dump_path[FLIGHT_PATH_MAX];
+static unsigned char alt_stack[FLIGHT_ALT_STACK];
+
+static const char *const event_names[] = {
+    "none", "tick", "button", "command", "text", "pot", "quit", "uart",
+};
+
+static const char *const state_names[] = {
+    "ATTRACT", "PLAYBACK", "WAIT_INPUT", "LEVEL_COMPLETE", "FAILURE", "NAME_ENTRY",
+};
+
+void flight_record(flight_kind_t kind, uint8_t a, uint16_t b, uint32_t c)
+{
+    if (!__atomic_load_n(&armed, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    uint32_t sequence = __atomic_fetch_add(&next_sequence, 1u, __ATOMIC_RELAXED) + 1u;
+    flight_record_t *record = &ring[sequence & (FLIGHT_RECORD_COUNT - 1u)];
+
+    // Clear the sequence first so a dump taken mid-write skips the slot
+    // rather than mixing two records.
+    __atomic_store_n(&record->sequence, 0u, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    record->time_ms = __atomic_load_n(&current_time_ms, __ATOMIC_RELAXED);
+    record->kind = (uint8_t)kind;
+    record->a = a;
+    record->b = b;
+    record->c = c;
+    __atomic_store_n(&record->sequence, sequence, __ATOMIC_RELEASE);
+}
+
+void flight_set_time(uint32_t time_ms)
+{
+    if (!__atomic_load_n(&armed, __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_store_n(&current_time_ms, time_ms, __ATOMIC_RELAXED);
+}
+
+static int write_all(int fd, const void *data, size_t length)
+{
+    const char *bytes = data;
+
+    while (length > 0u) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+int flight_dump(int fd)
+{
+    // Only write(2) from here on: this runs inside signal handlers.
+    flight_header_t header = {
+        .record_size = sizeof(flight_record_t),
+        .record_count = FLIGHT_RECORD_COUNT,
+        .next_sequence = __atomic_load_n(&next_sequence, __ATOMIC_RELAXED),
+        .reserved = 0u,
+    };
+    memcpy(header.magic, FLIGHT_MAGIC, sizeof header.magic);
+
+    if (write_all(fd, &header, sizeof header) != 0) {
+        return -1;
+    }
+    return write_all(fd, ring, sizeof ring);
+}
+
+static void on_signal(int signal_number)
+{
+    int saved_errno = errno;
+    int fd = open(dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd >= 0) {
+        (void)flight_dump(fd);
+        close(fd);
+    }
+    errno = saved_errno;
+
+    // SA_RESETHAND already restored the default action for fatal signals;
+    // re-raising lets it run once this handler returns.
+    if (signal_number != SIGUSR1) {
+        raise(signal_number);
+    }
+}
+
+int flight_install(const char *path)
+{
+    if (strlen(path) >= sizeof dump_path) {
+        return -1;
+    }
+    strcpy(dump_path, path);
+
+    stack_t stack = {.ss_sp = alt_stack, .ss_size = sizeof alt_stack, .ss_flags = 0};
+    if (sigaltstack(&stack, NULL) != 0) {
+        return -1;
+    }
+
+    struct sigaction fatal = {.sa_handler = on_signal, .sa_flags = SA_RESETHAND | SA_ONSTACK};
+    struct sigaction snapshot = {.sa_handler = on_signal, .sa_flags = SA_RESTART};
+    sigemptyset(&fatal.sa_mask);
+    sigemptyset(&snapshot.sa_mask);
+
+    if (sigaction(SIGSEGV, &fatal, NULL) != 0 || sigaction(SIGABRT, &fatal, NULL) != 0
+        || sigaction(SIGUSR1, &snapshot, NULL) != 0) {
+        return -1;
+    }
+    __atomic_store_n(&armed, true, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// The dump's next_sequence; decode orders records by how far behind it they are.
+static uint32_t decode_next_sequence;
+
+static int compare_records(const void *left, const void *right)
+{
+    // Sequences wrap at 2^32, so compare ages rather than raw values.
+    uint32_t a = decode_next_sequence - ((const flight_record_t *)left)->sequence;
+    uint32_t b = decode_next_sequence - ((const flight_record_t *)right)->sequence;
+    return (a < b) - (a > b);
+}
+
+static void print_record(const flight_record_t *record)
+{
+    printf("%10u %10u ms  ", record->sequence, record->time_ms);
+
+    switch ((flight_kind_t)record->kind) {
+    case FLIGHT_KIND_EVENT:
+        printf("EVENT    %s", record->a < sizeof event_names / sizeof event_names[0] ? event_names[record->a] : "?");
+        if (record->b != 0u || record->c != 0u) {
+            printf(" %u", (unsigned)record->c);
+        }
+        break;
+
+    case FLIGHT_KIND_STATE:
+        printf("STATE    %s -> %s",
+               record->a < sizeof state_names / sizeof state_names[0] ? state_names[record->a] : "?",
+               record->b < sizeof state_names / sizeof state_names[0] ? state_names[record->b] : "?");
+        break;
+
+    case FLIGHT_KIND_TIMER:
+        printf("TIMER    %s +%u ms",
+               record->a < sizeof state_names / sizeof state_names[0] ? state_names[record->a] : "?",
+               (unsigned)record->c);
+        break;
+
+    case FLIGHT_KIND_BUZZER:
+        if (record->a == 0xFFu) {
+            printf("BUZZER   off");
+        } else {
+            printf("BUZZER   tone %u octave %d", record->a, (int)(int16_t)record->b);
+        }
+        break;
+
+    case FLIGHT_KIND_PATTERN:
+        printf("PATTERN  0x%02X", record->a);
+        break;
+
+    case FLIGHT_KIND_SEGMENTS:
+        printf("SEGMENTS %02X:%02X", record->a, (unsigned)record->b);
+        break;
+
+    case FLIGHT_KIND_UART: {
+        char text[5];
+        uint8_t shown = record->a < 4u ? record->a : 4u;
+        for (uint8_t i = 0u; i < shown; ++i) {
+            char value = (char)(record->c >> (8u * i));
+            text[i] = (value >= 0x20 && value < 0x7F) ? value : '.';
+        }
+        text[shown] = '\0';
+        printf("UART     %u bytes \"%s%s\"", record->a, text, record->a > 4u ? "..." : "");
+        break;
+    }
+
+    default:
+        printf("?        kind %u", record->kind);
+        break;
+    }
+    putchar('\n');
+}
+
+int flight_decode(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    flight_header_t header;
+    if (fread(&header, sizeof header, 1u, file) != 1u || memcmp(header.magic, FLIGHT_MAGIC, sizeof header.magic) != 0
+        || header.record_size != sizeof(flight_record_t) || header.record_count == 0u) {
+        fprintf(stderr, "%s: not a flight recorder dump\n", path);
+        fclose(file);
+        return 1;
+    }
+
+    flight_record_t *records = calloc(header.record_count, sizeof *records);
+    if (records == NULL) {
+        fclose(file);
+        return 1;
+    }
+
+    size_t count = fread(records, sizeof *records, header.record_count, file);
+    fclose(file);
+
+    size_t used = 0u;
+    for (size_t i = 0u; i < count; ++i) {
+        if (records[i].sequence != 0u) {
+            records[used++] = records[i];
+        }
+    }
+    decode_next_sequence = header.next_sequence;
+    qsort(records, used, sizeof *records, compare_records);
+
+    printf("%zu records, %u written in total\n", used, header.next_sequence);
+    for (size_t i = 0u; i < used; ++i) {
+        print_record(&records[i]);
+    }
+
+    free(records);
+    return 0;
+}
+
+#endif /* FLIGHT_RECORDER_ENABLED */
@@ -0,0 +1,66 @@
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include <stdint.h>
+
+/*
+ * Flight recorder for the console and the server: a fixed ring of small
+ * binary records covering events handled, state changes, timer arming and
+ * hardware outputs. The ring is dumped on SIGSEGV/SIGABRT (and on SIGUSR1
+ * without stopping) and read back with `simon --decode-flight <file>`.
+ */
+#if !defined(FLIGHT_RECORDER_ENABLED)
+#if defined(__AVR__)
+#define FLIGHT_RECORDER_ENABLED 0
+#else
+#define FLIGHT_RECORDER_ENABLED 1
+#endif
+#endif
+
+#define FLIGHT_RECORD_BITS  13u
+#define FLIGHT_RECORD_COUNT (1u << FLIGHT_RECORD_BITS)
+#define FLIGHT_MAGIC        "SIMFLT01"
+
+typedef enum {
+    FLIGHT_KIND_EVENT = 1,
+    FLIGHT_KIND_STATE,
+    FLIGHT_KIND_TIMER,
+    FLIGHT_KIND_BUZZER,
+    FLIGHT_KIND_PATTERN,
+    FLIGHT_KIND_SEGMENTS,
+    FLIGHT_KIND_UART
+} flight_kind_t;
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t time_ms;
+    uint8_t kind;
+    uint8_t a;
+    uint16_t b;
+    uint32_t c;
+} flight_record_t;
+
+#if FLIGHT_RECORDER_ENABLED
+
+void flight_record(flight_kind_t kind, uint8_t a, uint16_t b, uint32_t c);
+void flight_set_time(uint32_t time_ms);
+/*
+ * Arm the dump handlers and start recording. Only the console and the
+ * server install it; batch modes drive many boards from many threads,
+ * whose records would interleave in the one ring, so they record nothing.
+ */
+int flight_install(const char *path);
+int flight_dump(int fd);
+int flight_decode(const char *path);
+
+#define FLIGHT_RECORD(kind, a, b, c) flight_record((kind), (uint8_t)(a), (uint16_t)(b), (uint32_t)(c))
+#define FLIGHT_SET_TIME(time_ms)     flight_set_time(time_ms)
+
+#else
+
+#define FLIGHT_RECORD(kind, a, b, c) ((void)0)
+#define FLIGHT_SET_TIME(time_ms)     ((void)0)
+
+#endif
+
+#endif /* FLIGHT_H */
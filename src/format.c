@@ -0,0 +1,58 @@
+#include "format.h"
+
+static uint8_t decimal_digits(char *digits, uint32_t value)
+{
+    uint8_t count = 0u;
+
+    // Least significant digit first.
+    do {
+        digits[count++] = (char)('0' + (uint8_t)(value % 10u));
+        value /= 10u;
+    } while (value > 0u && count < FORMAT_DECIMAL_MAX);
+
+    return count;
+}
+
+void format_append_text(char *buffer, uint16_t *pos, const char *text)
+{
+    while (*text != '\0') {
+        buffer[(*pos)++] = *text++;
+    }
+}
+
+void format_append_padded_text(char *buffer, uint16_t *pos, const char *text, uint8_t width)
+{
+    uint16_t start = *pos;
+
+    format_append_text(buffer, pos, text);
+    while ((uint16_t)(*pos - start) < width) {
+        buffer[(*pos)++] = ' ';
+    }
+}
+
+void format_append_decimal(char *buffer, uint16_t *pos, uint32_t value)
+{
+    format_append_padded_decimal(buffer, pos, value, 0u);
+}
+
+void format_append_padded_decimal(char *buffer, uint16_t *pos, uint32_t value, uint8_t width)
+{
+    char digits[FORMAT_DECIMAL_MAX];
+    uint8_t count = decimal_digits(digits, value);
+
+    while (width > count) {
+        buffer[(*pos)++] = ' ';
+        width--;
+    }
+    while (count > 0u) {
+        buffer[(*pos)++] = digits[--count];
+    }
+}
+
+void format_append_hex8(char *buffer, uint16_t *pos, uint8_t value)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    buffer[(*pos)++] = hex_digits[value >> 4];
+    buffer[(*pos)++] = hex_digits[value & 0x0Fu];
+}
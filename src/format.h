@@ -0,0 +1,20 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdint.h>
+
+/*
+ * Minimal text formatting for the console and UART paths, so the target
+ * build does not pull in the printf family. Each helper appends at
+ * buffer[*pos] and advances *pos; callers size the buffer for the longest
+ * output and add the terminator themselves.
+ */
+#define FORMAT_DECIMAL_MAX 10u
+
+void format_append_text(char *buffer, uint16_t *pos, const char *text);
+void format_append_padded_text(char *buffer, uint16_t *pos, const char *text, uint8_t width);
+void format_append_decimal(char *buffer, uint16_t *pos, uint32_t value);
+void format_append_padded_decimal(char *buffer, uint16_t *pos, uint32_t value, uint8_t width);
+void format_append_hex8(char *buffer, uint16_t *pos, uint8_t value);
+
+#endif /* FORMAT_H */
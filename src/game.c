@@ -1,8 +1,15 @@
+#define _GNU_SOURCE
+
 #include "game.h"
+#include "flight.h"
+#include "format.h"
 #include "hardware.h"
+#include "journal.h"
+#include "profile.h"
 
 #include <ctype.h>
-#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define PLAYBACK_DELAY_MIN           250u
@@ -12,20 +19,51 @@
 #define LEVEL_ADVANCE_PAUSE          800u
 #define FAILURE_PAUSE                1200u
 #define NAME_TIMEOUT_MS              5000u
-#define IDLE_ANIMATION_INTERVAL_MASK 0x1Fu
-#define IDLE_ANIMATION_FRAME_SHIFT   5u
+#define IDLE_ANIMATION_PERIOD_MS     32u
 #define OCTAVE_SHIFT_MAX             3
 #define OCTAVE_SHIFT_MIN            -3
-
-static const uint8_t display_patterns[4] = {
+// Rank, ". ", name, ' ', score, '\n' and the terminator.
+#define HIGHSCORE_LINE_MAX           (4u + SIMON_MAX_NAME_LENGTH + 1u + FORMAT_DECIMAL_MAX + 2u)
+// Name, " n=" and the count, four " pNN=" quantiles, "\r\n" and the terminator.
+#define REACTION_LINE_MAX            (SIMON_MAX_NAME_LENGTH + 3u + FORMAT_DECIMAL_MAX + 4u * 10u + 3u)
+
+// One LED per pad, first pad leftmost (highest bit).
+#if SIMON_BUTTON_COUNT == 4
+static const uint8_t display_patterns[SIMON_BUTTON_COUNT] = {
+    0x08u,
+    0x04u,
+    0x02u,
+    0x01u,
+};
+#elif SIMON_BUTTON_COUNT == 6
+static const uint8_t display_patterns[SIMON_BUTTON_COUNT] = {
+    0x20u,
+    0x10u,
+    0x08u,
+    0x04u,
+    0x02u,
+    0x01u,
+};
+#else
+static const uint8_t display_patterns[SIMON_BUTTON_COUNT] = {
+    0x80u,
+    0x40u,
+    0x20u,
+    0x10u,
     0x08u,
     0x04u,
     0x02u,
     0x01u,
 };
+#endif
 
-static const uint8_t success_pattern = 0b01111111u;
+static const uint8_t success_pattern = (uint8_t)(0b01111111u | SIMON_BUTTON_MASK);
+// Eight pads leave no spare LED, so failure lights the two outer ones.
+#if SIMON_BUTTON_COUNT == 8
+static const uint8_t failure_pattern = 0b10000001u;
+#else
 static const uint8_t failure_pattern = 0b01000000u;
+#endif
 
 static uint8_t lfsr_next_from_state(uint32_t *state)
 {
@@ -41,7 +79,10 @@ static uint8_t lfsr_next_from_state(uint32_t *state)
     }
 
     *state = value;
-    return (uint8_t)(value & 0x03u);
+    // Scale the top 16 bits to a pad instead of taking a remainder: a
+    // 32-bit % 6 is a division libcall on the AVR, and this multiply costs
+    // the same for every pad count.
+    return (uint8_t)(((uint32_t)(uint16_t)(value >> 16u) * SIMON_BUTTON_COUNT) >> 16u);
 }
 
 static uint16_t map_pot_to_delay(uint16_t value)
@@ -82,29 +123,33 @@ static uint16_t playback_tone_off_duration(const simon_game_t *game)
     return off;
 }
 
-static void append_decimal(char *buffer, uint16_t *pos, uint32_t value)
+static void set_state(simon_game_t *game, simon_state_t state)
 {
-    char digits[6];
-    uint8_t count = 0u;
+    FLIGHT_RECORD(FLIGHT_KIND_STATE, game->state, state, 0u);
+    PROFILE_STATE(state);
+    game->state = (uint8_t)state;
+}
 
-    do {
-        digits[count++] = (char)('0' + (uint8_t)(value % 10u));
-        value /= 10u;
-    } while (value > 0u && count < sizeof digits);
+static void arm_timer(simon_game_t *game, uint32_t delay)
+{
+    FLIGHT_RECORD(FLIGHT_KIND_TIMER, game->state, 0u, delay);
+    timer_wheel_schedule(game->wheel, &game->timer, delay);
+}
 
-    while (count > 0u) {
-        buffer[(*pos)++] = digits[--count];
-    }
+static void enter_attract_timing(simon_game_t *game)
+{
+    game->idle_frame = 0u;
+    arm_timer(game, IDLE_ANIMATION_PERIOD_MS);
 }
 
-static void display_level_value(uint16_t value)
+static void display_level_value(uint32_t value)
 {
     if (value >= 100u) {
         hardware_display_pattern(success_pattern);
         return;
     }
 
-    uint16_t remaining = value;
+    uint8_t remaining = (uint8_t)value;
     uint8_t tens = 0u;
     while (remaining >= 10u) {
         remaining -= 10u;
@@ -122,32 +167,23 @@ static void uart_send_delay(const simon_game_t *game)
 {
     char buffer[16];
     uint16_t pos = 0u;
-    buffer[pos++] = 'D';
-    buffer[pos++] = 'E';
-    buffer[pos++] = 'L';
-    buffer[pos++] = 'A';
-    buffer[pos++] = 'Y';
-    buffer[pos++] = ' ';
-    append_decimal(buffer, &pos, game->playback_delay_ms);
-    buffer[pos++] = '\0';
+    format_append_text(buffer, &pos, "DELAY ");
+    format_append_decimal(buffer, &pos, game->playback_delay_ms);
+    format_append_text(buffer, &pos, "\r\n");
+    buffer[pos] = '\0';
     hardware_uart_write_string(buffer);
-    hardware_uart_write_string("\r\n");
 }
 
-static void uart_send_score(const char *label, uint16_t value)
+static void uart_send_score(const char *label, uint32_t value)
 {
     char buffer[24];
     uint16_t pos = 0u;
 
-    while (label[pos] != '\0') {
-        buffer[pos] = label[pos];
-        pos++;
-    }
-
-    append_decimal(buffer, &pos, value);
-    buffer[pos++] = '\0';
+    format_append_text(buffer, &pos, label);
+    format_append_decimal(buffer, &pos, value);
+    format_append_text(buffer, &pos, "\r\n");
+    buffer[pos] = '\0';
     hardware_uart_write_string(buffer);
-    hardware_uart_write_string("\r\n");
 }
 
 static void initialise_highscores(simon_highscore_table_t *table)
@@ -158,40 +194,55 @@ static void initialise_highscores(simon_highscore_table_t *table)
     }
 }
 
-static void format_highscore_table(const simon_highscore_table_t *table, char *buffer, size_t size)
+/*
+ * One table row, "N. NAME     SCORE\n": the name is left-justified to at
+ * least eight columns and the score right-justified to four.
+ */
+static void format_highscore_line(const simon_highscore_entry_t *entry, uint8_t rank, char *line)
 {
-    size_t pos = 0u;
+    uint16_t pos = 0u;
 
-    for (size_t i = 0; i < SIMON_HIGHSCORE_ENTRIES && pos + 1u < size; ++i) {
-        const simon_highscore_entry_t *entry = &table->entries[i];
-        int written = snprintf(
-            buffer + pos,
-            size - pos,
-            "%zu. %-8s %4u\n",
-            i + 1u,
-            entry->name[0] == '\0' ? "---" : entry->name,
-            entry->score);
-        if (written < 0) {
-            break;
-        }
-        pos += (size_t)written;
+    format_append_decimal(line, &pos, rank);
+    format_append_text(line, &pos, ". ");
+    format_append_padded_text(line, &pos, entry->name[0] == '\0' ? "---" : entry->name, 8u);
+    line[pos++] = ' ';
+    format_append_padded_decimal(line, &pos, entry->score, 4u);
+    line[pos++] = '\n';
+    line[pos] = '\0';
+}
+
+// Rows are formatted one at a time so no caller needs a whole-table buffer.
+static void show_highscore_table(const simon_highscore_table_t *table)
+{
+    char line[HIGHSCORE_LINE_MAX];
+
+    board_show_high_scores_begin();
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        format_highscore_line(&table->entries[i], (uint8_t)(i + 1u), line);
+        board_show_high_score_line(line);
     }
+}
 
-    if (pos >= size) {
-        buffer[size - 1u] = '\0';
+static void uart_send_highscore_table(const simon_highscore_table_t *table)
+{
+    char line[HIGHSCORE_LINE_MAX];
+
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        format_highscore_line(&table->entries[i], (uint8_t)(i + 1u), line);
+        hardware_uart_write_string(line);
     }
 }
 
-static bool highscore_qualifies(const simon_highscore_table_t *table, uint16_t score)
+static bool highscore_qualifies(const simon_highscore_table_t *table, simon_score_t score)
 {
     return score > table->entries[SIMON_HIGHSCORE_ENTRIES - 1u].score;
 }
 
-static void insert_highscore(simon_highscore_table_t *table, const char *name, uint16_t score)
+uint8_t game_insert_highscore(simon_highscore_table_t *table, const char *name, simon_score_t score)
 {
-    size_t insert_index = SIMON_HIGHSCORE_ENTRIES;
+    uint8_t insert_index = SIMON_HIGHSCORE_ENTRIES;
 
-    for (size_t i = 0; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
         if (score > table->entries[i].score) {
             insert_index = i;
             break;
@@ -199,7 +250,7 @@ static void insert_highscore(simon_highscore_table_t *table, const char *name, u
     }
 
     if (insert_index >= SIMON_HIGHSCORE_ENTRIES) {
-        return;
+        return insert_index;
     }
 
     for (size_t i = SIMON_HIGHSCORE_ENTRIES - 1u; i > insert_index; --i) {
@@ -210,30 +261,196 @@ static void insert_highscore(simon_highscore_table_t *table, const char *name, u
     strncpy(entry->name, name, SIMON_MAX_NAME_LENGTH - 1u);
     entry->name[SIMON_MAX_NAME_LENGTH - 1u] = '\0';
     entry->score = score;
+    return insert_index;
 }
 
-static void finalise_pending_highscore(simon_game_t *game)
+// The only way the leaderboard changes once the game is running.
+uint8_t game_record_highscore(simon_game_t *game, const char *name, simon_score_t score)
 {
-    const char *name = game->name_buffer[0] == '\0' ? "???" : game->name_buffer;
-    insert_highscore(&game->highscores, name, game->pending_score);
+    seqlock_write_begin(&game->cold->highscores_lock);
+    uint8_t index = game_insert_highscore(&game->cold->highscores, name, score);
+    seqlock_write_end(&game->cold->highscores_lock);
+    return index;
+}
+
+uint32_t game_read_highscores(const simon_game_t *game, simon_highscore_table_t *table)
+{
+    return seqlock_read(&game->cold->highscores_lock, &game->cold->highscores, table, sizeof *table);
+}
+
+#if SIMON_SKETCH_K > 0
+
+static void init_sketches(simon_game_sketches_t *sketches)
+{
+    sketch_init(&sketches->reactions);
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        sketches->players[i].name[0] = '\0';
+        sketch_init(&sketches->players[i].reactions);
+    }
+}
+
+static void free_sketches(simon_game_cold_t *cold)
+{
+    free(cold->sketches);
+    cold->sketches = NULL;
+}
+
+// Start the game's own sketch again, if there is one yet.
+static void clear_game_reactions(simon_game_cold_t *cold)
+{
+    if (cold->sketches != NULL) {
+        sketch_init(&cold->sketches->reactions);
+    }
+}
 
-    char table_buffer[256];
-    format_highscore_table(&game->highscores, table_buffer, sizeof table_buffer);
-    board_show_high_scores(table_buffer);
+static void record_reaction(simon_game_t *game)
+{
+    simon_game_cold_t *cold = game->cold;
+    uint32_t elapsed = game->wheel->now - cold->last_press_ms;
+
+    // Without the memory the press simply goes unrecorded.
+    if (cold->sketches == NULL) {
+        cold->sketches = malloc(sizeof *cold->sketches);
+        if (cold->sketches == NULL) {
+            return;
+        }
+        init_sketches(cold->sketches);
+    }
+    sketch_update(&cold->sketches->reactions, elapsed > UINT16_MAX ? UINT16_MAX : (uint16_t)elapsed);
+    cold->last_press_ms = game->wheel->now;
+}
+
+static bool name_on_leaderboard(const simon_game_cold_t *cold, const char *name)
+{
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        if (strncmp(cold->highscores.entries[i].name, name, SIMON_MAX_NAME_LENGTH) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Merge the game's reaction times into `name`'s sketch. There are as many
+ * rows as leaderboard entries and games are only filed under a name that
+ * just made the board, so a new name takes an empty row or one whose name
+ * has since dropped off the board. Players on the board never lose theirs
+ * to a newcomer, whatever their press counts; the row with the fewest
+ * presses is only a fallback.
+ */
+static void file_reactions(simon_game_cold_t *cold, const char *name)
+{
+    simon_game_sketches_t *sketches = cold->sketches;
+    if (sketches == NULL) {
+        return;
+    }
+
+    simon_player_sketch_t *player = NULL;
+    simon_player_sketch_t *fewest = &sketches->players[0];
+
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        simon_player_sketch_t *row = &sketches->players[i];
+        if (strncmp(row->name, name, SIMON_MAX_NAME_LENGTH) == 0) {
+            player = row;
+            break;
+        }
+        if (player == NULL && (row->name[0] == '\0' || !name_on_leaderboard(cold, row->name))) {
+            player = row;
+        }
+        if (row->reactions.count < fewest->reactions.count) {
+            fewest = row;
+        }
+    }
+    if (player == NULL) {
+        player = fewest;
+    }
+
+    if (strncmp(player->name, name, SIMON_MAX_NAME_LENGTH) != 0) {
+        strncpy(player->name, name, SIMON_MAX_NAME_LENGTH - 1u);
+        player->name[SIMON_MAX_NAME_LENGTH - 1u] = '\0';
+        sketch_init(&player->reactions);
+    }
+    sketch_merge(&player->reactions, &sketches->reactions);
+    sketch_init(&sketches->reactions);
+}
+
+const sketch_t *game_player_reactions(const simon_game_t *game, const char *name)
+{
+    for (uint8_t i = 0u; game->cold->sketches != NULL && i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        const simon_player_sketch_t *player = &game->cold->sketches->players[i];
+        if (player->name[0] != '\0' && strncmp(player->name, name, SIMON_MAX_NAME_LENGTH) == 0) {
+            return &player->reactions;
+        }
+    }
+    return NULL;
+}
+
+static void uart_send_reactions(const simon_game_t *game)
+{
+    static const uint16_t permilles[] = {100u, 500u, 900u, 990u};
+    static const char *const labels[] = {" p10=", " p50=", " p90=", " p99="};
+    char line[REACTION_LINE_MAX];
+
+    hardware_uart_write_string("REACTIONS\r\n");
+    for (uint8_t i = 0u; game->cold->sketches != NULL && i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        const simon_player_sketch_t *player = &game->cold->sketches->players[i];
+        if (player->name[0] == '\0') {
+            continue;
+        }
+
+        uint16_t pos = 0u;
+        format_append_text(line, &pos, player->name);
+        format_append_text(line, &pos, " n=");
+        format_append_decimal(line, &pos, player->reactions.count);
+        for (uint8_t q = 0u; q < 4u; ++q) {
+            format_append_text(line, &pos, labels[q]);
+            format_append_decimal(line, &pos, sketch_quantile(&player->reactions, permilles[q]));
+        }
+        format_append_text(line, &pos, "\r\n");
+        line[pos] = '\0';
+        hardware_uart_write_string(line);
+    }
+}
+
+#endif /* SIMON_SKETCH_K > 0 */
+
+// `timed_out` when nobody confirmed a name; whatever was typed still goes on the board.
+static void finalise_pending_highscore(simon_game_t *game, bool timed_out)
+{
+    PROFILE_ENTER(PROFILE_HIGHSCORE);
+    bool named = !timed_out && game->cold->name_buffer[0] != '\0';
+    const char *name = game->cold->name_buffer[0] == '\0' ? "???" : game->cold->name_buffer;
+    uint8_t index = game_record_highscore(game, name, game->cold->pending_score);
+    if (game->cold->journal != NULL) {
+        journal_record_insert(game->cold->journal, index, &game->cold->highscores.entries[index]);
+    }
+#if SIMON_SKETCH_K > 0
+    // Only a player who gave a name gets a row; "???" would pool strangers.
+    if (named) {
+        file_reactions(game->cold, name);
+    } else {
+        clear_game_reactions(game->cold);
+    }
+#else
+    (void)named;
+#endif
+
+    show_highscore_table(&game->cold->highscores);
     hardware_uart_write_string("HIGHSCORES\r\n");
-    hardware_uart_write_string(table_buffer);
+    uart_send_highscore_table(&game->cold->highscores);
 
-    game->pending_score = 0u;
+    game->cold->pending_score = 0u;
     game->pending_highscore = false;
     game_end(game);
+    PROFILE_LEAVE(PROFILE_HIGHSCORE);
 }
 
 static void prompt_for_name(simon_game_t *game)
 {
-    game->state = SIMON_STATE_NAME_ENTRY;
-    game->name_length = 0u;
-    game->name_buffer[0] = '\0';
-    game->name_timeout = NAME_TIMEOUT_MS;
+    set_state(game, SIMON_STATE_NAME_ENTRY);
+    game->cold->name_length = 0u;
+    game->cold->name_buffer[0] = '\0';
+    arm_timer(game, NAME_TIMEOUT_MS);
     board_show_prompt("Enter name: ");
     hardware_uart_write_string("NAME?\r\n");
 }
@@ -242,72 +459,79 @@ static void reset_round_state(simon_game_t *game)
 {
     game->playback_step = 0u;
     game->input_step = 0u;
-    game->playback_timer = 0u;
     game->playback_tone_active = false;
     game->pending_success = false;
-    game->state_timer = 0u;
 }
 
-static void extend_sequence(simon_game_t *game)
+static simon_level_t sequence_cap(const simon_game_t *game)
+{
+    return game->cold->endurance ? SIMON_ENDURANCE_MAX_SEQUENCE : SIMON_MAX_SEQUENCE;
+}
+
+static bool extend_sequence(simon_game_t *game)
 {
-    if (game->level < SIMON_MAX_SEQUENCE) {
-        (void)lfsr_next_from_state(&game->rng_state);
-        game->level++;
+    if (game->level >= sequence_cap(game)) {
+        return false;
     }
+    if (!sequence_append(&game->sequence, lfsr_next_from_state(&game->rng_state))) {
+        return false;
+    }
+    game->level++;
+    return true;
 }
 
 static void begin_playback(simon_game_t *game)
 {
     apply_pending_playback_delay(game);
     reset_round_state(game);
-    game->state = SIMON_STATE_PLAYBACK;
-    game->playback_state = game->sequence_seed;
+    set_state(game, SIMON_STATE_PLAYBACK);
+    arm_timer(game, 1u);
     hardware_display_pattern(0u);
     board_show_playback_position(0u, game->level);
 }
 
-static void update_best_score(simon_game_t *game, uint16_t score)
+static void update_best_score(simon_game_t *game, simon_score_t score)
 {
-    if (score > game->best_score) {
-        game->best_score = score;
+    if (score > game->cold->best_score) {
+        game->cold->best_score = score;
         uart_send_score("BEST ", score);
     }
 }
 
 static void enter_level_complete_state(simon_game_t *game)
 {
-    game->state = SIMON_STATE_LEVEL_COMPLETE;
-    game->state_timer = LEVEL_ADVANCE_PAUSE;
+    set_state(game, SIMON_STATE_LEVEL_COMPLETE);
     game->pending_success = true;
-    game->score = game->level;
+    arm_timer(game, 1u);
+    game->cold->score = game->level;
     board_show_success(game->level);
     hardware_display_pattern(success_pattern);
     display_level_value(game->level);
     update_best_score(game, game->level);
 }
 
-static void enter_failure_state(simon_game_t *game, uint16_t final_score)
+static void enter_failure_state(simon_game_t *game, simon_score_t final_score)
 {
-    game->state = SIMON_STATE_FAILURE;
-    game->state_timer = FAILURE_PAUSE;
-    game->score = final_score;
+    set_state(game, SIMON_STATE_FAILURE);
+    arm_timer(game, FAILURE_PAUSE + 1u);
+    game->cold->score = final_score;
     hardware_stop_buzzer();
     hardware_display_pattern(failure_pattern);
     board_show_failure(final_score);
     update_best_score(game, final_score);
 
-    if (highscore_qualifies(&game->highscores, final_score)) {
-        game->pending_score = final_score;
+    if (highscore_qualifies(&game->cold->highscores, final_score)) {
+        game->cold->pending_score = final_score;
         game->pending_highscore = true;
     } else {
-        game->pending_score = 0u;
+        game->cold->pending_score = 0u;
         game->pending_highscore = false;
     }
 }
 
 static int8_t mask_to_index(uint8_t button_mask)
 {
-    for (uint8_t i = 0u; i < 4u; ++i) {
+    for (uint8_t i = 0u; i < SIMON_BUTTON_COUNT; ++i) {
         if ((button_mask & (1u << i)) != 0u) {
             return (int8_t)i;
         }
@@ -315,32 +539,41 @@ static int8_t mask_to_index(uint8_t button_mask)
     return -1;
 }
 
+// Copy console text into a name-sized buffer, cut to fit; returns its length.
+static uint8_t copy_text(char *buffer, const char *text)
+{
+    size_t length = strnlen(text, SIMON_MAX_NAME_LENGTH - 1u);
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    return (uint8_t)length;
+}
+
 static void handle_name_text(simon_game_t *game, const char *text)
 {
-    strncpy(game->name_buffer, text, SIMON_MAX_NAME_LENGTH - 1u);
-    game->name_buffer[SIMON_MAX_NAME_LENGTH - 1u] = '\0';
-    game->name_length = (uint8_t)strlen(game->name_buffer);
-    finalise_pending_highscore(game);
+    game->cold->name_length = copy_text(game->cold->name_buffer, text);
+    finalise_pending_highscore(game, false);
 }
 
 static void apply_seed_from_buffer(simon_game_t *game)
 {
+    PROFILE_ENTER(PROFILE_SEED);
     uint32_t seed = 0u;
-    for (uint8_t i = 0u; i < game->seed_length; ++i) {
-        seed = (seed * 33u) + (uint8_t)game->seed_buffer[i];
+    for (uint8_t i = 0u; i < game->cold->seed_length; ++i) {
+        seed = (seed * 33u) + (uint8_t)game->cold->seed_buffer[i];
     }
     if (seed != 0u) {
         game->rng_state ^= seed;
     }
-    game->awaiting_seed = false;
-    game->seed_length = 0u;
-    game->seed_buffer[0] = '\0';
+    game->cold->awaiting_seed = false;
+    game->cold->seed_length = 0u;
+    game->cold->seed_buffer[0] = '\0';
     hardware_uart_write_string("SEED OK\r\n");
+    PROFILE_LEAVE(PROFILE_SEED);
 }
 
 static void handle_seed_char(simon_game_t *game, char value)
 {
-    if (!game->awaiting_seed) {
+    if (!game->cold->awaiting_seed) {
         return;
     }
 
@@ -349,97 +582,76 @@ static void handle_seed_char(simon_game_t *game, char value)
         return;
     }
 
-    if (game->seed_length + 1u < SIMON_MAX_NAME_LENGTH) {
-        game->seed_buffer[game->seed_length++] = value;
-        game->seed_buffer[game->seed_length] = '\0';
+    // Same character rule as name entry; a NUL here would cut the seed
+    // text short of seed_length.
+    if (game->cold->seed_length + 1u < SIMON_MAX_NAME_LENGTH && isprint((unsigned char)value)) {
+        game->cold->seed_buffer[game->cold->seed_length++] = value;
+        game->cold->seed_buffer[game->cold->seed_length] = '\0';
     }
 }
 
 static void show_highscores(const simon_game_t *game)
 {
-    char table_buffer[256];
-    format_highscore_table(&game->highscores, table_buffer, sizeof table_buffer);
-    board_show_high_scores(table_buffer);
-    hardware_uart_write_string(table_buffer);
+#if defined(__AVR__)
+    // One thread, and no stack to spare for a copy.
+    const simon_highscore_table_t *table = &game->cold->highscores;
+#else
+    // A console or socket handler may answer 'h' off the game's thread.
+    simon_highscore_table_t copy;
+    (void)game_read_highscores(game, &copy);
+    const simon_highscore_table_t *table = &copy;
+#endif
+
+    show_highscore_table(table);
+    uart_send_highscore_table(table);
 }
 
-void game_init(simon_game_t *game)
+/*
+ * Every state has at most one deadline pending, so a single timer per game
+ * covers them all. The old per-tick countdowns expired on the tick after
+ * they reached zero; the delays below keep that timing.
+ */
+static void on_game_timer(timer_node_t *node)
 {
-    game->level = 0u;
-    game->playback_step = 0u;
-    game->input_step = 0u;
-    game->playback_delay_ms = PLAYBACK_DELAY_MIN;
-    game->best_score = 0u;
-    game->score = 0u;
-    game->state = SIMON_STATE_ATTRACT;
-    game->rng_state = 0x1u;
-    game->sequence_seed = game->rng_state;
-    game->playback_state = game->rng_state;
-    game->input_state = game->rng_state;
-    game->pot_update_pending = false;
-    game->playback_tone_active = false;
-    game->pending_success = false;
-    game->pending_highscore = false;
-    game->octave_shift = 0;
-    game->name_length = 0u;
-    game->seed_length = 0u;
-    game->name_timeout = NAME_TIMEOUT_MS;
-    game->pot_value = 0u;
-    game->awaiting_seed = false;
-    game->pending_pot_value = 0u;
-    game->playback_timer = 0u;
-    game->state_timer = 0u;
-    game->pending_score = 0u;
-    game->idle_frame = 0u;
-    game->name_buffer[0] = '\0';
-    game->seed_buffer[0] = '\0';
+    simon_game_t *game = (simon_game_t *)((char *)node - offsetof(simon_game_t, timer));
 
-    initialise_highscores(&game->highscores);
-    board_show_message("Welcome to Simon!");
-    hardware_display_pattern(0u);
-}
-
-void game_tick_1ms(simon_game_t *game)
-{
-    apply_pending_playback_delay(game);
-
-    switch (game->state) {
+    PROFILE_ENTER(PROFILE_GAME_TIMER);
+    switch ((simon_state_t)game->state) {
     case SIMON_STATE_ATTRACT:
-        game->state_timer++;
-        if ((game->state_timer & IDLE_ANIMATION_INTERVAL_MASK) == 0u) {
-            game->idle_frame++;
-            hardware_display_idle_animation(game->idle_frame);
-        }
+        game->idle_frame++;
+        hardware_display_idle_animation(game->idle_frame);
+        arm_timer(game, IDLE_ANIMATION_PERIOD_MS);
         break;
 
     case SIMON_STATE_PLAYBACK:
+        apply_pending_playback_delay(game);
+
         if (game->playback_step >= game->level) {
-            game->state = SIMON_STATE_WAIT_INPUT;
+            set_state(game, SIMON_STATE_WAIT_INPUT);
             game->input_step = 0u;
-            game->input_state = game->sequence_seed;
+#if SIMON_SKETCH_K > 0
+            game->cold->last_press_ms = game->wheel->now;
+#endif
             hardware_stop_buzzer();
             hardware_display_pattern(0u);
             break;
         }
 
-        if (game->playback_timer > 0u) {
-            game->playback_timer--;
-            break;
-        }
-
         if (!game->playback_tone_active) {
-            uint8_t index = lfsr_next_from_state(&game->playback_state);
+            uint8_t index = sequence_get(&game->sequence, game->playback_step);
             hardware_set_buzzer_tone(index);
             hardware_display_pattern(display_patterns[index]);
             board_show_playback_position(game->playback_step + 1u, game->level);
             game->playback_tone_active = true;
-            game->playback_timer = playback_tone_on_duration(game);
+            arm_timer(game, playback_tone_on_duration(game) + 1u);
         } else {
             hardware_stop_buzzer();
             hardware_display_pattern(0u);
             game->playback_tone_active = false;
-            game->playback_timer = playback_tone_off_duration(game);
             game->playback_step++;
+            // The last note hands over to input on the next tick; the gap
+            // only separates notes.
+            arm_timer(game, game->playback_step >= game->level ? 1u : playback_tone_off_duration(game) + 1u);
         }
         break;
 
@@ -450,40 +662,154 @@ void game_tick_1ms(simon_game_t *game)
         if (game->pending_success) {
             game->pending_success = false;
             hardware_display_pattern(success_pattern);
-        }
-        if (game->state_timer > 0u) {
-            game->state_timer--;
+            arm_timer(game, LEVEL_ADVANCE_PAUSE);
+        } else if (extend_sequence(game)) {
+            begin_playback(game);
         } else {
-            if (game->level < SIMON_MAX_SEQUENCE) {
-                extend_sequence(game);
-                begin_playback(game);
-            } else {
-                game_end(game);
-            }
+            game_end(game);
         }
         break;
 
     case SIMON_STATE_FAILURE:
-        if (game->state_timer > 0u) {
-            game->state_timer--;
+        if (game->pending_highscore) {
+            prompt_for_name(game);
         } else {
-            if (game->pending_highscore) {
-                prompt_for_name(game);
-            } else {
-                game_end(game);
-            }
+            game_end(game);
         }
         break;
 
     case SIMON_STATE_NAME_ENTRY:
-        if (game->name_timeout > 0u) {
-            game->name_timeout--;
-            if (game->name_timeout == 0u) {
-                finalise_pending_highscore(game);
-            }
-        }
+        finalise_pending_highscore(game, true);
         break;
     }
+    PROFILE_LEAVE(PROFILE_GAME_TIMER);
+}
+
+static void init_hot_state(simon_game_t *game)
+{
+    game->level = 0u;
+    game->playback_step = 0u;
+    game->input_step = 0u;
+    game->playback_delay_ms = PLAYBACK_DELAY_MIN;
+    set_state(game, SIMON_STATE_ATTRACT);
+    game->rng_state = 0x1u;
+    game->pot_update_pending = false;
+    game->playback_tone_active = false;
+    game->pending_success = false;
+    game->pending_highscore = false;
+    game->pending_pot_value = 0u;
+    game->idle_frame = 0u;
+}
+
+static void init_session_state(simon_game_cold_t *cold, uint32_t seed)
+{
+    cold->score = 0u;
+    cold->pending_score = 0u;
+    cold->sequence_seed = seed;
+    cold->pot_value = 0u;
+    cold->octave_shift = 0;
+    cold->endurance = false;
+    cold->awaiting_seed = false;
+    cold->name_length = 0u;
+    cold->seed_length = 0u;
+    cold->name_buffer[0] = '\0';
+    cold->seed_buffer[0] = '\0';
+}
+
+void game_init(simon_game_t *game, simon_game_cold_t *cold, timer_wheel_t *wheel)
+{
+    game->cold = cold;
+    game->wheel = wheel;
+    timer_node_init(&game->timer, on_game_timer);
+    init_hot_state(game);
+    init_session_state(cold, game->rng_state);
+    cold->best_score = 0u;
+    cold->journal = NULL;
+    cold->outcome_sink = NULL;
+    cold->outcome_user = NULL;
+
+    seqlock_init(&cold->highscores_lock);
+    initialise_highscores(&cold->highscores);
+#if SIMON_SKETCH_K > 0
+    cold->sketches = NULL;
+    cold->last_press_ms = 0u;
+#endif
+    sequence_init(&game->sequence);
+    enter_attract_timing(game);
+    board_show_message("Welcome to Simon!");
+    hardware_display_pattern(0u);
+}
+
+void game_attach_journal(simon_game_t *game, highscore_journal_t *journal)
+{
+    seqlock_write_begin(&game->cold->highscores_lock);
+    journal_recover(journal, &game->cold->highscores);
+    seqlock_write_end(&game->cold->highscores_lock);
+    game->cold->journal = journal;
+    if (game->cold->highscores.entries[0].score > game->cold->best_score) {
+        game->cold->best_score = game->cold->highscores.entries[0].score;
+    }
+}
+
+void game_set_outcome_sink(simon_game_t *game, simon_outcome_fn sink, void *user)
+{
+    game->cold->outcome_sink = sink;
+    game->cold->outcome_user = user;
+}
+
+void game_recycle(simon_game_t *game, timer_wheel_t *wheel, bool fresh_cold)
+{
+    simon_game_cold_t *cold = game->cold;
+
+    // The sequence buffer an endurance run grew is kept for reuse.
+    timer_wheel_cancel(game->wheel, &game->timer);
+    game->wheel = wheel;
+    init_hot_state(game);
+    init_session_state(cold, game->rng_state);
+#if SIMON_SKETCH_K > 0
+    cold->last_press_ms = 0u;
+#endif
+    if (fresh_cold) {
+        cold->best_score = 0u;
+        cold->journal = NULL;
+        cold->outcome_sink = NULL;
+        cold->outcome_user = NULL;
+        seqlock_write_begin(&cold->highscores_lock);
+        initialise_highscores(&cold->highscores);
+        seqlock_write_end(&cold->highscores_lock);
+#if SIMON_SKETCH_K > 0
+        free_sketches(cold);
+#endif
+    }
+    sequence_clear(&game->sequence);
+    enter_attract_timing(game);
+    board_show_message("Welcome to Simon!");
+    hardware_display_pattern(0u);
+}
+
+void game_tick_1ms(simon_game_t *game)
+{
+    PROFILE_ENTER(PROFILE_GAME_TICK);
+    apply_pending_playback_delay(game);
+    timer_wheel_tick(game->wheel);
+    FLIGHT_SET_TIME(game->wheel->now);
+    PROFILE_LEAVE(PROFILE_GAME_TICK);
+}
+
+uint32_t game_next_wakeup(const simon_game_t *game)
+{
+    // A pot change is folded in on the next tick.
+    if (game->pot_update_pending) {
+        return 1u;
+    }
+    return timer_wheel_next_work(game->wheel);
+}
+
+void game_advance_ms(simon_game_t *game, uint32_t ms)
+{
+    apply_pending_playback_delay(game);
+    timer_wheel_advance(game->wheel, ms);
+    FLIGHT_SET_TIME(game->wheel->now);
 }
 
 void game_handle_button(simon_game_t *game, uint8_t button_mask)
@@ -508,41 +834,49 @@ void game_handle_button(simon_game_t *game, uint8_t button_mask)
         return;
     }
 
-    uint8_t expected = lfsr_next_from_state(&game->input_state);
+    uint8_t expected = sequence_get(&game->sequence, game->input_step);
 
     if (button == expected) {
+#if SIMON_SKETCH_K > 0
+        // A wrong press is a slip, not a reaction time.
+        record_reaction(game);
+#endif
         game->input_step++;
         board_show_playback_position(game->input_step, game->level);
         if (game->input_step >= game->level) {
             enter_level_complete_state(game);
         }
     } else {
-        uint16_t completed = (game->input_step == 0u) ? 0u : game->input_step;
+        simon_score_t completed = game->input_step;
         enter_failure_state(game, completed);
     }
 }
 
 void game_update_playback_delay(simon_game_t *game, uint16_t pot_value)
 {
-    game->pot_value = pot_value;
+    game->cold->pot_value = pot_value;
     game->pending_pot_value = pot_value;
     game->pot_update_pending = true;
     uart_send_delay(game);
 }
 
-void game_handle_uart_char(simon_game_t *game, char value)
+static void handle_uart_char(simon_game_t *game, char value)
 {
+    // Serial bytes often bypass game_handle_event, so every command
+    // character is logged here and only here.
+    FLIGHT_RECORD(FLIGHT_KIND_EVENT, BOARD_EVENT_COMMAND, 1u, (uint8_t)value);
+
     if (game->state == SIMON_STATE_NAME_ENTRY) {
         if (value == '\r' || value == '\n') {
-            finalise_pending_highscore(game);
+            finalise_pending_highscore(game, false);
         } else if (value == '\b') {
-            if (game->name_length > 0u) {
-                game->name_length--;
-                game->name_buffer[game->name_length] = '\0';
+            if (game->cold->name_length > 0u) {
+                game->cold->name_length--;
+                game->cold->name_buffer[game->cold->name_length] = '\0';
             }
-        } else if (game->name_length + 1u < SIMON_MAX_NAME_LENGTH && isprint((unsigned char)value)) {
-            game->name_buffer[game->name_length++] = value;
-            game->name_buffer[game->name_length] = '\0';
+        } else if (game->cold->name_length + 1u < SIMON_MAX_NAME_LENGTH && isprint((unsigned char)value)) {
+            game->cold->name_buffer[game->cold->name_length++] = value;
+            game->cold->name_buffer[game->cold->name_length] = '\0';
         }
         return;
     }
@@ -565,12 +899,12 @@ void game_handle_uart_char(simon_game_t *game, char value)
 
     case 'b':
     case 'B':
-        uart_send_score("BEST ", game->best_score);
+        uart_send_score("BEST ", game->cold->best_score);
         break;
 
     case 'c':
     case 'C':
-        uart_send_score("SCORE ", game->score);
+        uart_send_score("SCORE ", game->cold->score);
         break;
 
     case 'h':
@@ -578,25 +912,47 @@ void game_handle_uart_char(simon_game_t *game, char value)
         show_highscores(game);
         break;
 
+#if SIMON_SKETCH_K > 0
+    case 'q':
+    case 'Q':
+        // As with e, a seed being typed may contain the letter.
+        if (game->cold->awaiting_seed) {
+            handle_seed_char(game, value);
+        } else {
+            uart_send_reactions(game);
+        }
+        break;
+#endif
+
     case '+':
-        if (game->octave_shift < OCTAVE_SHIFT_MAX) {
-            game->octave_shift++;
-            hardware_set_buzzer_octave_shift(game->octave_shift);
+        if (game->cold->octave_shift < OCTAVE_SHIFT_MAX) {
+            game->cold->octave_shift++;
+            hardware_set_buzzer_octave_shift(game->cold->octave_shift);
         }
         break;
 
     case '-':
-        if (game->octave_shift > OCTAVE_SHIFT_MIN) {
-            game->octave_shift--;
-            hardware_set_buzzer_octave_shift(game->octave_shift);
+        if (game->cold->octave_shift > OCTAVE_SHIFT_MIN) {
+            game->cold->octave_shift--;
+            hardware_set_buzzer_octave_shift(game->cold->octave_shift);
+        }
+        break;
+
+    case 'e':
+    case 'E':
+        if (game->cold->awaiting_seed) {
+            handle_seed_char(game, value);
+        } else if (game->state == SIMON_STATE_ATTRACT) {
+            game->cold->endurance = !game->cold->endurance;
+            hardware_uart_write_string(game->cold->endurance ? "ENDURANCE ON\r\n" : "ENDURANCE OFF\r\n");
         }
         break;
 
     case 'g':
     case 'G':
-        game->awaiting_seed = true;
-        game->seed_length = 0u;
-        game->seed_buffer[0] = '\0';
+        game->cold->awaiting_seed = true;
+        game->cold->seed_length = 0u;
+        game->cold->seed_buffer[0] = '\0';
         hardware_uart_write_string("SEED MODE\r\n");
         break;
 
@@ -606,14 +962,50 @@ void game_handle_uart_char(simon_game_t *game, char value)
     }
 }
 
-void game_handle_event(simon_game_t *game, const board_event_t *event)
+void game_handle_uart_char(simon_game_t *game, char value)
+{
+    PROFILE_ENTER(PROFILE_UART_CHAR);
+    handle_uart_char(game, value);
+    PROFILE_LEAVE(PROFILE_UART_CHAR);
+}
+
+#if FLIGHT_RECORDER_ENABLED
+static uint32_t event_payload(const board_event_t *event)
 {
+    switch (event->type) {
+    case BOARD_EVENT_BUTTON:
+        return (uint32_t)event->data.button.button | (event->data.button.long_press ? 0x100u : 0u);
+    case BOARD_EVENT_COMMAND:
+        return (uint8_t)event->data.command.value;
+    case BOARD_EVENT_POT:
+        return event->data.pot.value;
+    case BOARD_EVENT_UART:
+        return event->data.uart.length;
+    default:
+        return 0u;
+    }
+}
+#endif
+
+static void handle_event(simon_game_t *game, const board_event_t *event)
+{
+    // Command characters are logged once, by handle_uart_char.
+    if (event->type != BOARD_EVENT_COMMAND) {
+        FLIGHT_RECORD(FLIGHT_KIND_EVENT, event->type, event->type != BOARD_EVENT_TICK, event_payload(event));
+    }
+
     switch (event->type) {
     case BOARD_EVENT_TICK:
-        game_tick_1ms(game);
+        // Ticks only carry a timestamp; the caller has already advanced the
+        // game to it.
         break;
 
     case BOARD_EVENT_BUTTON: {
+        // Long-press notifications follow the original press; they are not
+        // a second pad hit.
+        if (event->data.button.long_press) {
+            break;
+        }
         uint8_t mask = (uint8_t)(1u << (uint8_t)event->data.button.button);
         game_handle_button(game, mask);
         break;
@@ -626,10 +1018,8 @@ void game_handle_event(simon_game_t *game, const board_event_t *event)
     case BOARD_EVENT_TEXT:
         if (game->state == SIMON_STATE_NAME_ENTRY) {
             handle_name_text(game, event->data.text.text);
-        } else if (game->awaiting_seed) {
-            strncpy(game->seed_buffer, event->data.text.text, SIMON_MAX_NAME_LENGTH - 1u);
-            game->seed_length = (uint8_t)strlen(game->seed_buffer);
-            game->seed_buffer[SIMON_MAX_NAME_LENGTH - 1u] = '\0';
+        } else if (game->cold->awaiting_seed) {
+            game->cold->seed_length = copy_text(game->cold->seed_buffer, event->data.text.text);
             apply_seed_from_buffer(game);
         }
         break;
@@ -638,6 +1028,12 @@ void game_handle_event(simon_game_t *game, const board_event_t *event)
         game_update_playback_delay(game, event->data.pot.value);
         break;
 
+    case BOARD_EVENT_UART:
+        for (uint8_t i = 0u; i < event->data.uart.length; ++i) {
+            game_handle_uart_char(game, (char)event->data.uart.bytes[i]);
+        }
+        break;
+
     case BOARD_EVENT_QUIT:
         game_end(game);
         break;
@@ -648,27 +1044,57 @@ void game_handle_event(simon_game_t *game, const board_event_t *event)
     }
 }
 
+void game_handle_event(simon_game_t *game, const board_event_t *event)
+{
+    PROFILE_ENTER(PROFILE_EVENT);
+    handle_event(game, event);
+    PROFILE_LEAVE(PROFILE_EVENT);
+}
+
+static void report_outcome(const simon_game_t *game)
+{
+    const simon_game_cold_t *cold = game->cold;
+    simon_outcome_t outcome = {
+        .score = cold->score,
+        .level = game->level,
+        .seed = cold->sequence_seed,
+        .duration_ms = game->wheel->now - cold->started_ms,
+        .playback_delay_ms = game->playback_delay_ms,
+        .octave_shift = cold->octave_shift,
+    };
+    cold->outcome_sink(cold->outcome_user, &outcome);
+}
+
+// Only a game in progress has an outcome; leaving attract does not.
+static void report_game_in_progress(const simon_game_t *game)
+{
+    if (game->state != SIMON_STATE_ATTRACT && game->cold->outcome_sink != NULL) {
+        report_outcome(game);
+    }
+}
+
 static void reset_for_new_game(simon_game_t *game)
 {
+    // A game abandoned with 'r' or 's' is reported like one that ended.
+    report_game_in_progress(game);
     game->level = 0u;
     game->playback_step = 0u;
     game->input_step = 0u;
-    game->score = 0u;
-    game->state_timer = 0u;
+    game->cold->score = 0u;
     game->idle_frame = 0u;
     game->pending_success = false;
     game->pending_highscore = false;
-    game->pending_score = 0u;
-    game->sequence_seed = game->rng_state;
-    game->playback_state = game->sequence_seed;
-    game->input_state = game->sequence_seed;
+    game->cold->pending_score = 0u;
+    game->cold->sequence_seed = game->rng_state;
+    sequence_clear(&game->sequence);
     hardware_display_pattern(0u);
 }
 
 void game_reset(simon_game_t *game)
 {
     reset_for_new_game(game);
-    game->state = SIMON_STATE_ATTRACT;
+    set_state(game, SIMON_STATE_ATTRACT);
+    enter_attract_timing(game);
     board_show_message("Game reset.");
 }
 
@@ -678,21 +1104,156 @@ void game_start(simon_game_t *game)
     if (game->rng_state == 0u) {
         game->rng_state = 0x1u;
     }
-    game->rng_state ^= (uint32_t)(game->pot_value + 1u) * 1103515245u;
-    game->sequence_seed = game->rng_state;
-    game->playback_state = game->sequence_seed;
-    game->input_state = game->sequence_seed;
-    extend_sequence(game);
+    game->rng_state ^= (uint32_t)(game->cold->pot_value + 1u) * 1103515245u;
+    game->cold->sequence_seed = game->rng_state;
+    game->cold->started_ms = game->wheel->now;
+#if SIMON_SKETCH_K > 0
+    // An earlier game that ended without a name goes unfiled.
+    clear_game_reactions(game->cold);
+#endif
+    (void)extend_sequence(game);
     begin_playback(game);
     board_show_message("Starting game...");
 }
 
 void game_end(simon_game_t *game)
 {
-    game->state = SIMON_STATE_ATTRACT;
-    game->state_timer = 0u;
-    game->idle_frame = 0u;
+    report_game_in_progress(game);
+    set_state(game, SIMON_STATE_ATTRACT);
+    enter_attract_timing(game);
     hardware_stop_buzzer();
     hardware_display_pattern(0u);
     board_show_message("Press a button to play.");
 }
+
+void game_shutdown(simon_game_t *game)
+{
+    timer_wheel_cancel(game->wheel, &game->timer);
+    sequence_free(&game->sequence);
+#if SIMON_SKETCH_K > 0
+    free_sketches(game->cold);
+#endif
+}
+
+#if !defined(__AVR__)
+
+void game_snapshot_init(simon_game_snapshot_t *snapshot)
+{
+    snapshot->steps = NULL;
+    snapshot->steps_capacity = 0u;
+}
+
+bool game_snapshot_take(simon_game_snapshot_t *snapshot, const simon_game_t *game)
+{
+    uint32_t length = game->sequence.length;
+
+    if (length > snapshot->steps_capacity) {
+        uint8_t *steps = realloc(snapshot->steps, length);
+        if (steps == NULL) {
+            return false;
+        }
+        snapshot->steps = steps;
+        snapshot->steps_capacity = length;
+    }
+
+    snapshot->game = *game;
+    snapshot->cold = *game->cold;
+#if SIMON_SKETCH_K > 0
+    if (game->cold->sketches != NULL) {
+        snapshot->sketches = *game->cold->sketches;
+    }
+#endif
+    snapshot->wheel_now = game->wheel->now;
+    snapshot->timer_delay = timer_node_pending(&game->timer) ? game->timer.expires - game->wheel->now
+                                                              : TIMER_WHEEL_IDLE;
+    for (uint32_t i = 0u; i < length; ++i) {
+        snapshot->steps[i] = sequence_get(&game->sequence, i);
+    }
+    return true;
+}
+
+void game_snapshot_restore(const simon_game_snapshot_t *snapshot, simon_game_t *game)
+{
+    simon_game_cold_t *cold = game->cold;
+    timer_wheel_t *wheel = game->wheel;
+    simon_sequence_t sequence = game->sequence;
+    highscore_journal_t *journal = cold->journal;
+    simon_outcome_fn outcome_sink = cold->outcome_sink;
+    void *outcome_user = cold->outcome_user;
+#if SIMON_SKETCH_K > 0
+    simon_game_sketches_t *sketches = cold->sketches;
+#endif
+
+    // The copied timer node and sequence still point into the original.
+    *game = snapshot->game;
+    game->cold = cold;
+    game->wheel = wheel;
+    game->sequence = sequence;
+    timer_node_init(&game->timer, on_game_timer);
+    *cold = snapshot->cold;
+    cold->journal = journal;
+    cold->outcome_sink = outcome_sink;
+    cold->outcome_user = outcome_user;
+#if SIMON_SKETCH_K > 0
+    // The sketches are the game's own; only their contents come across.
+    cold->sketches = sketches;
+    if (snapshot->cold.sketches == NULL) {
+        free_sketches(cold);
+    } else {
+        if (cold->sketches == NULL) {
+            cold->sketches = malloc(sizeof *cold->sketches);
+        }
+        if (cold->sketches != NULL) {
+            *cold->sketches = snapshot->sketches;
+        }
+    }
+#endif
+
+    sequence_clear(&game->sequence);
+    for (uint32_t i = 0u; i < snapshot->game.sequence.length; ++i) {
+        (void)sequence_append(&game->sequence, snapshot->steps[i]);
+    }
+
+    timer_wheel_init(wheel);
+    wheel->now = snapshot->wheel_now;
+    if (snapshot->timer_delay != TIMER_WHEEL_IDLE) {
+        timer_wheel_schedule(wheel, &game->timer, snapshot->timer_delay);
+    }
+}
+
+void game_snapshot_free(simon_game_snapshot_t *snapshot)
+{
+    free(snapshot->steps);
+    game_snapshot_init(snapshot);
+}
+
+#define CHECK_INVARIANT(condition) \
+    do {                           \
+        if (!(condition)) {        \
+            return #condition;     \
+        }                          \
+    } while (0)
+
+const char *game_check_invariants(const simon_game_t *game)
+{
+    const simon_game_cold_t *cold = game->cold;
+
+    CHECK_INVARIANT(game->state <= SIMON_STATE_NAME_ENTRY);
+    CHECK_INVARIANT(game->level <= game->sequence.length);
+    CHECK_INVARIANT(cold->endurance || game->level <= SIMON_MAX_SEQUENCE);
+    CHECK_INVARIANT(game->input_step <= game->level);
+    CHECK_INVARIANT(game->playback_step <= game->level);
+    CHECK_INVARIANT(game->state != SIMON_STATE_WAIT_INPUT || game->input_step < game->level);
+
+    CHECK_INVARIANT(cold->name_length < SIMON_MAX_NAME_LENGTH);
+    CHECK_INVARIANT(strnlen(cold->name_buffer, SIMON_MAX_NAME_LENGTH) == cold->name_length);
+    CHECK_INVARIANT(cold->seed_length < SIMON_MAX_NAME_LENGTH);
+    CHECK_INVARIANT(strnlen(cold->seed_buffer, SIMON_MAX_NAME_LENGTH) == cold->seed_length);
+
+    for (size_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        CHECK_INVARIANT(memchr(cold->highscores.entries[i].name, '\0', SIMON_MAX_NAME_LENGTH) != NULL);
+    }
+    return NULL;
+}
+
+#endif /* !__AVR__ */
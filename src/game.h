@@ -6,20 +6,71 @@
 
 #include "board.h"
 #include "hardware.h"
+#include "seqlock.h"
+#include "sequence.h"
+#include "sketch.h"
+#include "timer_wheel.h"
+#include "variant.h"
 
-#define SIMON_MAX_SEQUENCE 32
 #define SIMON_MAX_NAME_LENGTH 32
-#define SIMON_HIGHSCORE_ENTRIES 5
+#define SIMON_ENDURANCE_MAX_SEQUENCE 0x00FFFFFFu
+
+#if defined(__AVR__)
+#define SIMON_CACHE_ALIGNED
+#else
+#define SIMON_CACHE_LINE 64
+#define SIMON_CACHE_ALIGNED __attribute__((aligned(SIMON_CACHE_LINE)))
+#endif
+
+typedef uint32_t simon_level_t;
+typedef uint32_t simon_score_t;
 
 typedef struct {
     char name[SIMON_MAX_NAME_LENGTH];
-    uint16_t score;
+    simon_score_t score;
 } simon_highscore_entry_t;
 
 typedef struct {
     simon_highscore_entry_t entries[SIMON_HIGHSCORE_ENTRIES];
 } simon_highscore_table_t;
 
+#if !defined(__AVR__)
+_Static_assert(sizeof(simon_highscore_table_t) % sizeof(uint32_t) == 0u, "seqlock readers copy the table in words");
+#endif
+
+struct highscore_journal;
+
+/*
+ * How one game ended, reported once it is over: the final score, the
+ * level reached, the settings it was played with and the game time from
+ * the first playback to the end.
+ */
+typedef struct {
+    simon_score_t score;
+    simon_level_t level;
+    uint32_t seed;
+    uint32_t duration_ms;
+    uint16_t playback_delay_ms;
+    int8_t octave_shift;
+} simon_outcome_t;
+
+typedef void (*simon_outcome_fn)(void *user, const simon_outcome_t *outcome);
+
+#if SIMON_SKETCH_K > 0
+// Gaps between one player's presses, under the name they gave the leaderboard.
+typedef struct {
+    char name[SIMON_MAX_NAME_LENGTH];
+    sketch_t reactions;
+} simon_player_sketch_t;
+
+typedef struct {
+    // This game's gaps before correct presses; filed under the player if
+    // they confirm a name for the leaderboard.
+    sketch_t reactions;
+    simon_player_sketch_t players[SIMON_HIGHSCORE_ENTRIES];
+} simon_game_sketches_t;
+#endif
+
 typedef enum {
     SIMON_STATE_ATTRACT = 0,
     SIMON_STATE_PLAYBACK,
@@ -29,46 +80,156 @@ typedef enum {
     SIMON_STATE_NAME_ENTRY
 } simon_state_t;
 
+#define SIMON_STATE_COUNT 6u
+
+/*
+ * Fields the game touches outside the tick path: scores, text entry and the
+ * leaderboard. Kept apart from simon_game_t so a fleet of games can keep
+ * its per-tick state densely packed.
+ */
 typedef struct {
-    uint8_t level;
-    uint8_t playback_step;
-    uint8_t input_step;
-    uint16_t playback_delay_ms;
-    uint16_t best_score;
-    uint16_t score;
-    simon_state_t state;
-    uint32_t rng_state;
+    simon_score_t best_score;
+    simon_score_t score;
+    simon_score_t pending_score;
     uint32_t sequence_seed;
-    uint32_t playback_state;
-    uint32_t input_state;
-    bool pot_update_pending;
-    bool playback_tone_active;
-    bool pending_success;
-    bool pending_highscore;
+    // Wheel time when the current game started.
+    uint32_t started_ms;
+    uint16_t pot_value;
     int8_t octave_shift;
+    bool endurance;
+    bool awaiting_seed;
     uint8_t name_length;
     uint8_t seed_length;
-    uint16_t name_timeout;
-    uint16_t pot_value;
-    bool awaiting_seed;
-    uint16_t pending_pot_value;
-    uint16_t playback_timer;
-    uint16_t state_timer;
-    uint16_t pending_score;
-    uint8_t idle_frame;
     char name_buffer[SIMON_MAX_NAME_LENGTH];
     char seed_buffer[SIMON_MAX_NAME_LENGTH];
     simon_highscore_table_t highscores;
-} simon_game_t;
+    // Bumped around every leaderboard write; see game_read_highscores.
+    seqlock_t highscores_lock;
+    // Persists leaderboard inserts when set; NULL keeps them in RAM only.
+    struct highscore_journal *journal;
+    // Told about every finished game when set.
+    simon_outcome_fn outcome_sink;
+    void *outcome_user;
+#if SIMON_SKETCH_K > 0
+    // Wheel time of the last correct press, or of the turn starting.
+    uint32_t last_press_ms;
+    // Allocated at the first press, so a fleet of idle games carries
+    // no sketches; NULL until then.
+    simon_game_sketches_t *sketches;
+#endif
+} simon_game_cold_t;
 
-void game_init(simon_game_t *game);
+/*
+ * State touched when a timer fires or a button arrives, ordered by size so
+ * it packs into whole cache lines on the host. `state` holds a
+ * simon_state_t.
+ */
+typedef struct {
+    timer_node_t timer;
+    simon_sequence_t sequence;
+    simon_game_cold_t *cold;
+    timer_wheel_t *wheel;
+    uint32_t rng_state;
+    simon_level_t level;
+    simon_level_t playback_step;
+    simon_level_t input_step;
+    uint16_t playback_delay_ms;
+    uint16_t pending_pot_value;
+    uint8_t state;
+    uint8_t idle_frame;
+    bool pot_update_pending;
+    bool playback_tone_active;
+    bool pending_success;
+    bool pending_highscore;
+} SIMON_CACHE_ALIGNED simon_game_t;
+
+#if !defined(__AVR__)
+_Static_assert(sizeof(simon_game_t) == 2 * SIMON_CACHE_LINE, "simon_game_t must fill exactly two cache lines");
+#endif
+
+/*
+ * Games register their deadlines in `wheel`, which may be shared by any
+ * number of games. game_tick_1ms advances the game's wheel, so it is only
+ * for a game that owns its wheel; a fleet sharing one wheel calls
+ * timer_wheel_tick once per millisecond instead.
+ */
+void game_init(simon_game_t *game, simon_game_cold_t *cold, timer_wheel_t *wheel);
+/*
+ * As game_init for a game set up before, keeping its sequence buffer. A
+ * new player on the same cabinet keeps the cold part's leaderboard, best
+ * score, sketches, journal and outcome sink; `fresh_cold` clears those
+ * too, as for a cabinet starting over.
+ */
+void game_recycle(simon_game_t *game, timer_wheel_t *wheel, bool fresh_cold);
+/*
+ * Restore the leaderboard from `journal` and record every later insert in
+ * it. Games that never attach one keep their leaderboard in RAM.
+ */
+void game_attach_journal(simon_game_t *game, struct highscore_journal *journal);
+// Report each finished game to `sink`; NULL stops reporting.
+void game_set_outcome_sink(simon_game_t *game, simon_outcome_fn sink, void *user);
+uint8_t game_insert_highscore(simon_highscore_table_t *table, const char *name, simon_score_t score);
+// Insert into the game's own leaderboard; only the owning thread writes it.
+uint8_t game_record_highscore(simon_game_t *game, const char *name, simon_score_t score);
+/*
+ * Copy the leaderboard out from any thread while the owning thread keeps
+ * playing. Readers never hold up the game: they retry instead if an insert
+ * lands mid-copy, and only ever see a whole table. Returns the retries.
+ */
+uint32_t game_read_highscores(const simon_game_t *game, simon_highscore_table_t *table);
+#if SIMON_SKETCH_K > 0
+// `name`'s reaction times, or NULL if no game was filed under it.
+const sketch_t *game_player_reactions(const simon_game_t *game, const char *name);
+#endif
 void game_tick_1ms(simon_game_t *game);
+/*
+ * Milliseconds until the game next has to tick, or TIMER_WHEEL_IDLE when
+ * only a button, pot or UART event can change anything. The ticks before
+ * the deadline are no-ops, so a platform may sleep through them and catch
+ * up with game_advance_ms, which is the same as `ms` calls to
+ * game_tick_1ms.
+ */
+uint32_t game_next_wakeup(const simon_game_t *game);
+void game_advance_ms(simon_game_t *game, uint32_t ms);
 void game_handle_button(simon_game_t *game, uint8_t button_mask);
 void game_update_playback_delay(simon_game_t *game, uint16_t pot_value);
 void game_handle_uart_char(simon_game_t *game, char value);
+/*
+ * Handling an event takes no virtual time; the caller advances the game to
+ * the event's timestamp first.
+ */
 void game_handle_event(simon_game_t *game, const board_event_t *event);
 void game_reset(simon_game_t *game);
 void game_start(simon_game_t *game);
 void game_end(simon_game_t *game);
+void game_shutdown(simon_game_t *game);
+
+#if !defined(__AVR__)
+/*
+ * A game's state detached from the addresses it ran at, so it can be
+ * restored into any game that owns its wheel. Lets a host replay many
+ * variations of one event trace from a common prefix.
+ */
+typedef struct {
+    simon_game_t game;
+    simon_game_cold_t cold;
+#if SIMON_SKETCH_K > 0
+    simon_game_sketches_t sketches;  // valid when cold.sketches is set
+#endif
+    uint32_t wheel_now;
+    uint32_t timer_delay;  // TIMER_WHEEL_IDLE when no deadline is armed
+    uint8_t *steps;        // one colour per byte
+    uint32_t steps_capacity;
+} simon_game_snapshot_t;
+
+void game_snapshot_init(simon_game_snapshot_t *snapshot);
+bool game_snapshot_take(simon_game_snapshot_t *snapshot, const simon_game_t *game);
+// `game` keeps its own journal and outcome sink.
+void game_snapshot_restore(const simon_game_snapshot_t *snapshot, simon_game_t *game);
+void game_snapshot_free(simon_game_snapshot_t *snapshot);
+
+// The first invariant `game` breaks, as C source, or NULL if it holds.
+const char *game_check_invariants(const simon_game_t *game);
+#endif
 
 #endif /* GAME_H */
@@ -1,53 +1,141 @@
 #include "hardware.h"
+#include "buzzer_table.h"
+#include "flight.h"
+#include "format.h"
 
 #include <stdio.h>
 
-typedef struct {
-    bool buzzer_enabled;
-    int8_t octave_shift;
-    uint8_t led_pattern;
-    uint8_t buttons;
-    uint16_t pot_value;
-} hardware_state_t;
+#if defined(__AVR__)
+#include <avr/io.h>
+#endif
 
-static hardware_state_t hw_state;
+static void write_stdout(void *user, const char *data, size_t length);
 
-static const float tone_frequencies[4] = {
-    364.84f,
-    486.45f,
-    648.60f,
-    864.80f,
-};
+static hardware_context_t default_context = {.output = write_stdout};
+#if defined(__AVR__)
+static hardware_context_t *hw_state = &default_context;
+#else
+// Each host thread binds the board it is driving.
+static _Thread_local hardware_context_t *hw_state = &default_context;
+#endif
 
-static void log_buzzer_frequency(float frequency)
+static void write_stdout(void *user, const char *data, size_t length)
 {
-    if (frequency <= 0.0f) {
-        printf("BUZZER:OFF\n");
+    (void)user;
+    fwrite(data, 1u, length, stdout);
+    fflush(stdout);
+}
+
+static void log_buzzer_frequency(uint32_t centi_hz)
+{
+    char line[8u + FORMAT_DECIMAL_MAX + 4u];
+    uint16_t pos = 0u;
+
+    // Nothing is listening, so skip the formatting.
+    if (hw_state->output == NULL) {
+        return;
+    }
+
+    format_append_text(line, &pos, "BUZZER:");
+    if (centi_hz == 0u) {
+        format_append_text(line, &pos, "OFF");
     } else {
-        printf("BUZZER:%.2f\n", frequency);
+        uint8_t cents = (uint8_t)(centi_hz % 100u);
+        format_append_decimal(line, &pos, centi_hz / 100u);
+        line[pos++] = '.';
+        line[pos++] = (char)('0' + cents / 10u);
+        line[pos++] = (char)('0' + cents % 10u);
     }
-    fflush(stdout);
+    line[pos++] = '\n';
+    hardware_console_write(line, pos);
+}
+
+static const buzzer_setting_t *buzzer_setting(uint8_t tone_index, int8_t shift)
+{
+    if (shift < BUZZER_SHIFT_MIN) {
+        shift = BUZZER_SHIFT_MIN;
+    } else if (shift > BUZZER_SHIFT_MAX) {
+        shift = BUZZER_SHIFT_MAX;
+    }
+    return &buzzer_settings[tone_index][shift - BUZZER_SHIFT_MIN];
 }
 
 static void log_led_pattern(uint8_t pattern)
 {
-    char buffer[5];
-    for (int i = 0; i < 4; ++i) {
-        uint8_t mask = (uint8_t)(0x08u >> i);
+    char buffer[SIMON_BUTTON_COUNT + 1];
+    for (int i = 0; i < SIMON_BUTTON_COUNT; ++i) {
+        uint8_t mask = (uint8_t)(1u << (SIMON_BUTTON_COUNT - 1 - i));
         buffer[i] = (pattern & mask) != 0u ? '|' : ' ';
     }
-    buffer[4] = '\0';
-    printf("%s\n", buffer);
-    fflush(stdout);
+    buffer[SIMON_BUTTON_COUNT] = '\n';
+    hardware_console_write(buffer, sizeof buffer);
 }
 
 void hardware_init(void)
 {
-    hw_state.buzzer_enabled = false;
-    hw_state.octave_shift = 0;
-    hw_state.led_pattern = 0u;
-    hw_state.buttons = 0u;
-    hw_state.pot_value = 0u;
+    hardware_context_init(&default_context, write_stdout, NULL);
+    hw_state = &default_context;
+#if defined(__AVR__)
+    // The buzzer sits on PB0, TCA0's waveform output 0. Set up the
+    // single-slope PWM once, held low and stopped, so starting a tone
+    // only loads the period, duty and prescaler.
+    PORTB.OUTCLR = PIN0_bm;
+    PORTB.DIRSET = PIN0_bm;
+    TCA0.SINGLE.CTRLA = 0u;
+    TCA0.SINGLE.CTRLB = TCA_SINGLE_WGMODE_SINGLESLOPE_gc | TCA_SINGLE_CMP0EN_bm;
+#endif
+}
+
+void hardware_context_init(hardware_context_t *context, hardware_output_fn output, void *user)
+{
+    context->buzzer_enabled = false;
+    context->octave_shift = 0;
+    context->led_pattern = 0u;
+    context->buttons = 0u;
+    context->pot_value = 0u;
+    context->output = output;
+    context->output_user = user;
+    context->uart_output = NULL;
+    context->uart_user = NULL;
+    context->observer_count = 0u;
+}
+
+void hardware_context_set_uart(hardware_context_t *context, hardware_output_fn output, void *user)
+{
+    context->uart_output = output;
+    context->uart_user = user;
+}
+
+void hardware_bind_context(hardware_context_t *context)
+{
+    hw_state = (context != NULL) ? context : &default_context;
+}
+
+bool hardware_add_observer(hardware_observer_fn observer, void *user)
+{
+    if (hw_state->observer_count >= HARDWARE_MAX_OBSERVERS) {
+        return false;
+    }
+    hw_state->observers[hw_state->observer_count] = observer;
+    hw_state->observer_users[hw_state->observer_count] = user;
+    hw_state->observer_count++;
+    return true;
+}
+
+static void notify_observer(uint8_t kind, uint8_t a, uint8_t b, uint32_t value)
+{
+    hardware_change_t change = {.kind = kind, .a = a, .b = b, .value = value};
+
+    for (uint8_t i = 0u; i < hw_state->observer_count; ++i) {
+        hw_state->observers[i](hw_state->observer_users[i], &change);
+    }
+}
+
+void hardware_console_write(const char *data, size_t length)
+{
+    if (hw_state->output != NULL) {
+        hw_state->output(hw_state->output_user, data, length);
+    }
 }
 
 void hardware_task_display(void)
@@ -56,61 +144,89 @@ void hardware_task_display(void)
 
 void hardware_set_buzzer_tone(uint8_t tone_index)
 {
-    if (tone_index < 4u) {
-        hw_state.buzzer_enabled = true;
-        float frequency = tone_frequencies[tone_index];
-        if (hw_state.octave_shift > 0) {
-            uint8_t shift = (uint8_t)hw_state.octave_shift;
-            frequency *= (float)(1u << shift);
-        } else if (hw_state.octave_shift < 0) {
-            uint8_t shift = (uint8_t)(-hw_state.octave_shift);
-            frequency /= (float)(1u << shift);
+    if (tone_index < BUZZER_TONES) {
+        // Period, compare and prescaler come precomputed from
+        // buzzer_table.h, so no arithmetic happens here.
+        const buzzer_setting_t *setting = buzzer_setting(tone_index, hw_state->octave_shift);
+        hw_state->buzzer_enabled = true;
+        FLIGHT_RECORD(FLIGHT_KIND_BUZZER, tone_index, hw_state->octave_shift, 0u);
+#if defined(__AVR__)
+        if (TCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm) {
+            // Buffered, so a running tone changes at the end of a period.
+            TCA0.SINGLE.PERBUF = setting->period;
+            TCA0.SINGLE.CMP0BUF = setting->compare;
+        } else {
+            // Stopped: load directly, or the first period runs to the old TOP.
+            TCA0.SINGLE.CNT = 0u;
+            TCA0.SINGLE.PER = setting->period;
+            TCA0.SINGLE.CMP0 = setting->compare;
         }
-        log_buzzer_frequency(frequency);
+        TCA0.SINGLE.CTRLA = (uint8_t)(setting->clksel << TCA_SINGLE_CLKSEL_gp) | TCA_SINGLE_ENABLE_bm;
+#endif
+        log_buzzer_frequency(setting->centi_hz);
+        notify_observer(HARDWARE_CHANGE_BUZZER, tone_index, (uint8_t)hw_state->octave_shift, setting->centi_hz);
     }
 }
 
 void hardware_stop_buzzer(void)
 {
-    hw_state.buzzer_enabled = false;
-    log_buzzer_frequency(0.0f);
+    hw_state->buzzer_enabled = false;
+    FLIGHT_RECORD(FLIGHT_KIND_BUZZER, 0xFFu, 0u, 0u);
+#if defined(__AVR__)
+    TCA0.SINGLE.CTRLA = 0u;
+    // RESTART clears the waveform output, so the pin is not left high.
+    TCA0.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESTART_gc;
+#endif
+    log_buzzer_frequency(0u);
+    notify_observer(HARDWARE_CHANGE_BUZZER, 0xFFu, 0u, 0u);
 }
 
 void hardware_set_buzzer_octave_shift(int8_t shift)
 {
-    hw_state.octave_shift = shift;
+    hw_state->octave_shift = shift;
 }
 
 int8_t hardware_get_buzzer_octave_shift(void)
 {
-    return hw_state.octave_shift;
+    return hw_state->octave_shift;
 }
 
 void hardware_display_segments(uint8_t left_digit, uint8_t right_digit)
 {
-    printf("SEG:%02X:%02X\n", left_digit, right_digit);
-    fflush(stdout);
+    FLIGHT_RECORD(FLIGHT_KIND_SEGMENTS, left_digit, right_digit, 0u);
+    notify_observer(HARDWARE_CHANGE_SEGMENTS, left_digit, right_digit, 0u);
+    char line[10];
+    uint16_t pos = 0u;
+
+    format_append_text(line, &pos, "SEG:");
+    format_append_hex8(line, &pos, left_digit);
+    line[pos++] = ':';
+    format_append_hex8(line, &pos, right_digit);
+    line[pos++] = '\n';
+    hardware_console_write(line, pos);
 }
 
 void hardware_display_pattern(uint8_t pattern)
 {
-    hw_state.led_pattern = pattern;
+    hw_state->led_pattern = pattern;
+    FLIGHT_RECORD(FLIGHT_KIND_PATTERN, pattern, 0u, 0u);
+    notify_observer(HARDWARE_CHANGE_PATTERN, pattern, 0u, 0u);
     log_led_pattern(pattern);
 }
 
 void hardware_display_idle_animation(uint8_t frame)
 {
-    hw_state.led_pattern = frame;
+    hw_state->led_pattern = frame;
 }
 
 uint8_t hardware_read_buttons(void)
 {
-    return hw_state.buttons;
+    return hw_state->buttons;
 }
 
 uint16_t hardware_read_pot(void)
 {
-    return hw_state.pot_value;
+    return hw_state->pot_value;
 }
 
 bool hardware_uart_read(char *value)
@@ -119,15 +235,30 @@ bool hardware_uart_read(char *value)
     return false;
 }
 
+static void uart_write(const char *data, size_t length)
+{
+    if (hw_state->uart_output != NULL) {
+        hw_state->uart_output(hw_state->uart_user, data, length);
+    } else {
+        hardware_console_write(data, length);
+    }
+}
+
 void hardware_uart_write_char(char value)
 {
-    fputc((unsigned char)value, stdout);
-    fflush(stdout);
+    uart_write(&value, 1u);
 }
 
 void hardware_uart_write_string(const char *text)
 {
-    while (*text != '\0') {
-        hardware_uart_write_char(*text++);
+    size_t length = 0u;
+    uint32_t head = 0u;
+    while (text[length] != '\0') {
+        if (length < 4u) {
+            head |= (uint32_t)(uint8_t)text[length] << (8u * length);
+        }
+        length++;
     }
+    FLIGHT_RECORD(FLIGHT_KIND_UART, length > 0xFFu ? 0xFFu : length, 0u, head);
+    uart_write(text, length);
 }
@@ -1,10 +1,62 @@
 #ifndef HARDWARE_H
 #define HARDWARE_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+typedef void (*hardware_output_fn)(void *user, const char *data, size_t length);
+
+typedef enum {
+    HARDWARE_CHANGE_PATTERN = 1, // a = LED pattern
+    HARDWARE_CHANGE_SEGMENTS,    // a = left digit, b = right digit
+    HARDWARE_CHANGE_BUZZER       // a = tone or 0xFF for off, b = octave shift, value = centi-Hz
+} hardware_change_kind_t;
+
+/*
+ * One visible change on the board, packed into eight bytes so observers
+ * can copy it as a single word.
+ */
+typedef struct {
+    uint8_t kind;
+    uint8_t a;
+    uint8_t b;
+    uint8_t reserved;
+    uint32_t value;
+} hardware_change_t;
+
+typedef void (*hardware_observer_fn)(void *user, const hardware_change_t *change);
+
+#define HARDWARE_MAX_OBSERVERS 4u
+
+/*
+ * Everything one emulated board owns. The default context writes to
+ * stdout; hosts running several boards bind a context per board before
+ * driving its game; on the host the binding is per thread. UART bytes
+ * share the console output unless the context gives them a line of their
+ * own.
+ */
+typedef struct {
+    bool buzzer_enabled;
+    int8_t octave_shift;
+    uint8_t led_pattern;
+    uint8_t buttons;
+    uint16_t pot_value;
+    hardware_output_fn output;
+    void *output_user;
+    hardware_output_fn uart_output;
+    void *uart_user;
+    uint8_t observer_count;
+    hardware_observer_fn observers[HARDWARE_MAX_OBSERVERS];
+    void *observer_users[HARDWARE_MAX_OBSERVERS];
+} hardware_context_t;
+
 void hardware_init(void);
+void hardware_context_init(hardware_context_t *context, hardware_output_fn output, void *user);
+void hardware_context_set_uart(hardware_context_t *context, hardware_output_fn output, void *user);
+void hardware_bind_context(hardware_context_t *context);
+bool hardware_add_observer(hardware_observer_fn observer, void *user);
+void hardware_console_write(const char *data, size_t length);
 void hardware_task_display(void);
 
 void hardware_set_buzzer_tone(uint8_t tone_index);
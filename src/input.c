@@ -0,0 +1,188 @@
+#include "input.h"
+
+#include <string.h>
+
+static void enqueue_event(input_conditioner_t *input, const board_event_t *event)
+{
+    if (input->queue_count >= INPUT_QUEUE_LENGTH) {
+        input->stats.dropped++;
+        return;
+    }
+
+    uint8_t tail = (uint8_t)((input->queue_head + input->queue_count) % INPUT_QUEUE_LENGTH);
+    input->queue[tail] = *event;
+    input->queue[tail].timestamp_ms = input->now_ms;
+    input->queue_count++;
+}
+
+static void enqueue_button(input_conditioner_t *input, uint8_t button, bool long_press)
+{
+    board_event_t event = {
+        .type = BOARD_EVENT_BUTTON,
+        .data.button = {.button = (board_button_t)button, .long_press = long_press},
+    };
+    enqueue_event(input, &event);
+    input->stats.delivered_buttons++;
+}
+
+static uint16_t pot_distance(uint16_t a, uint16_t b)
+{
+    return (a > b) ? (uint16_t)(a - b) : (uint16_t)(b - a);
+}
+
+static bool pot_change_is_meaningful(const input_conditioner_t *input, uint16_t value)
+{
+    if (!input->pot_valid) {
+        return true;
+    }
+    if (value == input->pot_delivered) {
+        return false;
+    }
+    if (pot_distance(value, input->pot_delivered) >= INPUT_POT_HYSTERESIS) {
+        return true;
+    }
+
+    // Let the rails through even inside the dead band so the full delay
+    // range stays reachable.
+    return value == 0u || value == INPUT_POT_MAX;
+}
+
+static void accept_pot_value(input_conditioner_t *input, uint16_t value)
+{
+    input->pot_valid = true;
+    input->pot_pending = false;
+    input->pot_delivered = value;
+    input->pot_quiet_ms = 0u;
+    input->stats.delivered_pot++;
+}
+
+void input_init(input_conditioner_t *input)
+{
+    memset(input, 0, sizeof *input);
+    input->pot_quiet_ms = INPUT_POT_MIN_PERIOD_MS;
+}
+
+bool input_filter_event(input_conditioner_t *input, board_event_t *event)
+{
+    switch (event->type) {
+    case BOARD_EVENT_BUTTON:
+        // Console and scripted presses are already clean edges and never
+        // touched the pins.
+        input->stats.delivered_buttons++;
+        return true;
+
+    case BOARD_EVENT_POT:
+        input->stats.raw_pot++;
+        if (!pot_change_is_meaningful(input, event->data.pot.value)) {
+            input->pot_pending = false;
+            return false;
+        }
+        if (input->pot_quiet_ms < INPUT_POT_MIN_PERIOD_MS) {
+            input->pot_candidate = event->data.pot.value;
+            input->pot_pending = true;
+            return false;
+        }
+        accept_pot_value(input, event->data.pot.value);
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+void input_tick_1ms(input_conditioner_t *input, uint8_t raw_buttons)
+{
+    input->now_ms++;
+    uint8_t edges = (uint8_t)(raw_buttons & (uint8_t)~input->raw_last);
+    if (edges != 0u) {
+        input->stats.raw_buttons += (uint32_t)__builtin_popcount(edges);
+    }
+    input->raw_last = raw_buttons;
+
+    for (uint8_t i = 0u; i < INPUT_BUTTON_COUNT; ++i) {
+        uint8_t mask = (uint8_t)(1u << i);
+        uint8_t *integrator = &input->integrators[i];
+
+        if ((raw_buttons & mask) != 0u) {
+            if (*integrator < INPUT_DEBOUNCE_MS) {
+                (*integrator)++;
+            }
+        } else if (*integrator > 0u) {
+            (*integrator)--;
+        }
+
+        if ((input->pressed_mask & mask) == 0u) {
+            if (*integrator >= INPUT_DEBOUNCE_MS) {
+                input->pressed_mask |= mask;
+                input->long_reported_mask &= (uint8_t)~mask;
+                input->held_ms[i] = 0u;
+                enqueue_button(input, i, false);
+            }
+            continue;
+        }
+
+        if (*integrator == 0u) {
+            input->pressed_mask &= (uint8_t)~mask;
+            continue;
+        }
+
+        if (input->held_ms[i] < INPUT_LONG_PRESS_MS) {
+            input->held_ms[i]++;
+        } else if ((input->long_reported_mask & mask) == 0u) {
+            input->long_reported_mask |= mask;
+            enqueue_button(input, i, true);
+        }
+    }
+
+    if (input->pot_quiet_ms < INPUT_POT_MIN_PERIOD_MS) {
+        input->pot_quiet_ms++;
+    }
+
+    if (input->pot_pending && input->pot_quiet_ms >= INPUT_POT_MIN_PERIOD_MS) {
+        board_event_t event = {
+            .type = BOARD_EVENT_POT,
+            .data.pot = {.value = input->pot_candidate},
+        };
+        accept_pot_value(input, input->pot_candidate);
+        enqueue_event(input, &event);
+    }
+}
+
+bool input_poll(input_conditioner_t *input, board_event_t *event)
+{
+    if (input->queue_count == 0u) {
+        return false;
+    }
+
+    *event = input->queue[input->queue_head];
+    input->queue_head = (uint8_t)((input->queue_head + 1u) % INPUT_QUEUE_LENGTH);
+    input->queue_count--;
+    return true;
+}
+
+bool input_is_idle(const input_conditioner_t *input, uint8_t raw_buttons)
+{
+    if (raw_buttons != 0u || input->pressed_mask != 0u || input->pot_pending) {
+        return false;
+    }
+    for (uint8_t i = 0u; i < INPUT_BUTTON_COUNT; ++i) {
+        if (input->integrators[i] != 0u) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void input_skip_ms(input_conditioner_t *input, uint32_t ms)
+{
+    input->now_ms += ms;
+
+    // Only the pot rate limit keeps time while the buttons are idle.
+    uint32_t quiet = input->pot_quiet_ms + ms;
+    input->pot_quiet_ms = (uint16_t)(quiet < INPUT_POT_MIN_PERIOD_MS ? quiet : INPUT_POT_MIN_PERIOD_MS);
+}
+
+const input_stats_t *input_get_stats(const input_conditioner_t *input)
+{
+    return &input->stats;
+}
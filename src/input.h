@@ -0,0 +1,58 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+
+#define INPUT_BUTTON_COUNT      SIMON_BUTTON_COUNT
+#define INPUT_DEBOUNCE_MS       5u
+#define INPUT_LONG_PRESS_MS     800u
+#define INPUT_POT_HYSTERESIS    4u
+#define INPUT_POT_MIN_PERIOD_MS 50u
+#define INPUT_POT_MAX           1023u
+#define INPUT_QUEUE_LENGTH      8u
+
+typedef struct {
+    uint32_t raw_buttons;        // press edges on the pins, bounces included
+    uint32_t delivered_buttons;  // presses and long presses handed on
+    uint32_t raw_pot;
+    uint32_t delivered_pot;
+    uint32_t dropped;
+} input_stats_t;
+
+typedef struct {
+    uint8_t integrators[INPUT_BUTTON_COUNT];
+    uint16_t held_ms[INPUT_BUTTON_COUNT];
+    uint8_t pressed_mask;
+    uint8_t long_reported_mask;
+    uint8_t raw_last;  // the previous sample, for counting raw edges
+    bool pot_valid;
+    bool pot_pending;
+    uint16_t pot_delivered;
+    uint16_t pot_candidate;
+    uint16_t pot_quiet_ms;
+    uint8_t queue_head;
+    uint8_t queue_count;
+    board_event_t queue[INPUT_QUEUE_LENGTH];
+    // Virtual time of the last sample; stamps the queued events.
+    uint32_t now_ms;
+    input_stats_t stats;
+} input_conditioner_t;
+
+void input_init(input_conditioner_t *input);
+bool input_filter_event(input_conditioner_t *input, board_event_t *event);
+void input_tick_1ms(input_conditioner_t *input, uint8_t raw_buttons);
+bool input_poll(input_conditioner_t *input, board_event_t *event);
+/*
+ * True when input_tick_1ms has nothing to do while the raw buttons stay
+ * at `raw_buttons`: no press is settling or being held and no pot value
+ * is waiting out its rate limit. Idle milliseconds can then be skipped
+ * with input_skip_ms instead of ticked.
+ */
+bool input_is_idle(const input_conditioner_t *input, uint8_t raw_buttons);
+void input_skip_ms(input_conditioner_t *input, uint32_t ms);
+const input_stats_t *input_get_stats(const input_conditioner_t *input);
+
+#endif /* INPUT_H */
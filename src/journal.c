@@ -0,0 +1,302 @@
+#define _GNU_SOURCE
+
+#include "journal.h"
+#include "profile.h"
+#include "protocol.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define RECORD_SEQUENCE_OFFSET 0u
+#define RECORD_SCORE_OFFSET    3u
+#define RECORD_NAME_OFFSET     6u
+#define RECORD_CRC_OFFSET      14u
+#define SEQUENCE_MASK          0x00FFFFFFu
+
+static void put_u24(uint8_t *bytes, uint32_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+}
+
+static uint32_t get_u24(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16);
+}
+
+static uint16_t record_crc(const uint8_t *record)
+{
+    uint16_t crc = 0xFFFFu;
+    for (uint8_t i = 0u; i < RECORD_CRC_OFFSET; ++i) {
+        crc = protocol_crc16(crc, record[i]);
+    }
+    return crc;
+}
+
+static void read_record(uint8_t slot, uint8_t *record)
+{
+    eeprom_read((uint16_t)(slot * JOURNAL_RECORD_SIZE), record, JOURNAL_RECORD_SIZE);
+}
+
+static bool record_is_valid(const uint8_t *record)
+{
+    uint16_t stored = (uint16_t)((record[RECORD_CRC_OFFSET] << 8) | record[RECORD_CRC_OFFSET + 1u]);
+
+    // An erased slot is all ones and never passes the CRC.
+    return stored == record_crc(record);
+}
+
+static bool slot_is_live(const highscore_journal_t *journal, uint8_t slot)
+{
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        if (journal->entry_slots[i] == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ranks_before(uint32_t score, uint32_t sequence, uint32_t other_score, uint32_t other_sequence)
+{
+    // Matches the leaderboard: higher scores first, earlier entries win ties.
+    return score > other_score || (score == other_score && sequence < other_sequence);
+}
+
+void journal_recover(highscore_journal_t *journal, simon_highscore_table_t *table)
+{
+    uint8_t record[JOURNAL_RECORD_SIZE];
+    uint32_t valid_mask = 0u;
+    uint32_t newest_sequence = 0u;
+    uint8_t newest_slot = JOURNAL_NO_SLOT;
+
+    // One CRC pass; the ranking passes below only re-read valid slots.
+    for (uint8_t slot = 0u; slot < JOURNAL_SLOT_COUNT; ++slot) {
+        read_record(slot, record);
+        if (!record_is_valid(record)) {
+            continue;
+        }
+        valid_mask |= 1ul << slot;
+
+        uint32_t sequence = get_u24(record + RECORD_SEQUENCE_OFFSET);
+        if (newest_slot == JOURNAL_NO_SLOT || sequence > newest_sequence) {
+            newest_sequence = sequence;
+            newest_slot = slot;
+        }
+    }
+
+    journal->next_sequence = (newest_slot == JOURNAL_NO_SLOT) ? 1u : (newest_sequence + 1u) & SEQUENCE_MASK;
+    journal->next_slot = (newest_slot == JOURNAL_NO_SLOT) ? 0u : (uint8_t)((newest_slot + 1u) % JOURNAL_SLOT_COUNT);
+
+    for (uint8_t rank = 0u; rank < SIMON_HIGHSCORE_ENTRIES; ++rank) {
+        uint8_t best_slot = JOURNAL_NO_SLOT;
+        uint32_t best_score = 0u;
+        uint32_t best_sequence = 0u;
+
+        for (uint8_t slot = 0u; slot < JOURNAL_SLOT_COUNT; ++slot) {
+            if ((valid_mask & (1ul << slot)) == 0u) {
+                continue;
+            }
+            read_record(slot, record);
+            uint32_t score = get_u24(record + RECORD_SCORE_OFFSET);
+            uint32_t sequence = get_u24(record + RECORD_SEQUENCE_OFFSET);
+            if (best_slot == JOURNAL_NO_SLOT || ranks_before(score, sequence, best_score, best_sequence)) {
+                best_slot = slot;
+                best_score = score;
+                best_sequence = sequence;
+            }
+        }
+
+        simon_highscore_entry_t *entry = &table->entries[rank];
+        journal->entry_slots[rank] = best_slot;
+        if (best_slot == JOURNAL_NO_SLOT) {
+            entry->name[0] = '\0';
+            entry->score = 0u;
+            continue;
+        }
+
+        valid_mask &= ~(1ul << best_slot);
+        read_record(best_slot, record);
+        memcpy(entry->name, record + RECORD_NAME_OFFSET, JOURNAL_NAME_LENGTH);
+        entry->name[JOURNAL_NAME_LENGTH] = '\0';
+        entry->score = best_score;
+    }
+}
+
+void journal_record_insert(highscore_journal_t *journal, uint8_t index, const simon_highscore_entry_t *entry)
+{
+    uint8_t record[JOURNAL_RECORD_SIZE];
+
+    if (index >= SIMON_HIGHSCORE_ENTRIES) {
+        return;
+    }
+
+    PROFILE_ENTER(PROFILE_JOURNAL);
+
+    // The table shifted down a row; the bottom record is now free.
+    for (uint8_t i = SIMON_HIGHSCORE_ENTRIES - 1u; i > index; --i) {
+        journal->entry_slots[i] = journal->entry_slots[i - 1u];
+    }
+    journal->entry_slots[index] = JOURNAL_NO_SLOT;
+
+    uint8_t slot = journal->next_slot;
+    while (slot_is_live(journal, slot)) {
+        slot = (uint8_t)((slot + 1u) % JOURNAL_SLOT_COUNT);
+    }
+
+    put_u24(record + RECORD_SEQUENCE_OFFSET, journal->next_sequence);
+    put_u24(record + RECORD_SCORE_OFFSET, entry->score > JOURNAL_SCORE_MAX ? JOURNAL_SCORE_MAX : entry->score);
+    // Names longer than the record holds are cut; shorter ones are zero padded.
+    size_t name_length = strnlen(entry->name, JOURNAL_NAME_LENGTH);
+    memcpy(record + RECORD_NAME_OFFSET, entry->name, name_length);
+    memset(record + RECORD_NAME_OFFSET + name_length, 0, JOURNAL_NAME_LENGTH - name_length);
+    uint16_t crc = record_crc(record);
+    record[RECORD_CRC_OFFSET] = (uint8_t)(crc >> 8);
+    record[RECORD_CRC_OFFSET + 1u] = (uint8_t)crc;
+    eeprom_write((uint16_t)(slot * JOURNAL_RECORD_SIZE), record, JOURNAL_RECORD_SIZE);
+
+    journal->entry_slots[index] = slot;
+    journal->next_slot = (uint8_t)((slot + 1u) % JOURNAL_SLOT_COUNT);
+    journal->next_sequence = (journal->next_sequence + 1u) & SEQUENCE_MASK;
+    PROFILE_LEAVE(PROFILE_JOURNAL);
+}
+
+#if !defined(__AVR__)
+
+#include <stdio.h>
+#include <time.h>
+
+#define SIMULATION_REBOOT_PERIOD    997u
+#define SIMULATION_POWER_CUT_PERIOD 1009u
+#define SIMULATION_BOOT_SAMPLES     10000u
+
+static uint32_t simulation_next(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static bool tables_match(const simon_highscore_table_t *a, const simon_highscore_table_t *b)
+{
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        if (a->entries[i].score != b->entries[i].score || strcmp(a->entries[i].name, b->entries[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static double boot_time_us(void)
+{
+    simon_highscore_table_t table;
+    highscore_journal_t journal;
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; i < SIMULATION_BOOT_SAMPLES; ++i) {
+        journal_recover(&journal, &table);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed_ns = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+    return elapsed_ns / SIMULATION_BOOT_SAMPLES / 1e3;
+}
+
+int journal_simulate(const char *path, uint32_t inserts)
+{
+    simon_highscore_table_t table;
+    highscore_journal_t journal;
+    uint32_t rng = 0x2545F491u;
+    uint32_t done = 0u;
+    uint32_t reboots = 0u;
+    uint32_t power_cuts = 0u;
+    uint32_t mismatches = 0u;
+
+    if (!eeprom_open(path)) {
+        perror(path);
+        return 1;
+    }
+
+    // Carry on from whatever leaderboard the file already holds.
+    journal_recover(&journal, &table);
+    eeprom_reset_stats();
+
+    for (; done < inserts; ++done) {
+        uint32_t floor = table.entries[SIMON_HIGHSCORE_ENTRIES - 1u].score;
+        if (floor + 8u > JOURNAL_SCORE_MAX) {
+            printf("Score range exhausted after %u inserts\n", done);
+            break;
+        }
+
+        // Every insert qualifies, landing anywhere from first to last place.
+        char name[JOURNAL_NAME_LENGTH + 1u];
+        snprintf(name, sizeof name, "P%u", done % 10000000u);
+        uint32_t score = floor + 1u + simulation_next(&rng) % 8u;
+
+        bool cut_power = (done % SIMULATION_POWER_CUT_PERIOD) == SIMULATION_POWER_CUT_PERIOD - 1u;
+        simon_highscore_table_t before = table;
+        if (cut_power) {
+            eeprom_cut_power_after(simulation_next(&rng) % JOURNAL_RECORD_SIZE);
+        }
+
+        uint8_t index = game_insert_highscore(&table, name, score);
+        journal_record_insert(&journal, index, &table.entries[index]);
+
+        if (cut_power) {
+            // The torn insert must vanish and leave the previous board.
+            eeprom_restore_power();
+            table = before;
+            power_cuts++;
+        } else if ((done % SIMULATION_REBOOT_PERIOD) != SIMULATION_REBOOT_PERIOD - 1u) {
+            continue;
+        }
+
+        simon_highscore_table_t recovered;
+        journal_recover(&journal, &recovered);
+        reboots++;
+        if (!tables_match(&table, &recovered)) {
+            mismatches++;
+        }
+        table = recovered;
+    }
+
+    const eeprom_stats_t *stats = eeprom_get_stats();
+    uint32_t min_writes = UINT32_MAX;
+    uint32_t max_writes = 0u;
+    uint64_t total_writes = 0u;
+
+    printf("EEPROM journal: %u inserts, %u slots of %u bytes on %u pages of %u bytes\n", done, JOURNAL_SLOT_COUNT,
+           JOURNAL_RECORD_SIZE, EEPROM_PAGE_COUNT, EEPROM_PAGE_SIZE);
+    printf("  page cycles:");
+    for (uint16_t page = 0u; page < EEPROM_PAGE_COUNT; ++page) {
+        uint32_t writes = stats->page_writes[page];
+        printf(" %u", writes);
+        min_writes = writes < min_writes ? writes : min_writes;
+        max_writes = writes > max_writes ? writes : max_writes;
+        total_writes += writes;
+    }
+    printf("\n  min %u, max %u, mean %.1f\n", min_writes, max_writes, (double)total_writes / EEPROM_PAGE_COUNT);
+    printf("  programming time: %.1f s total, %.1f ms per insert\n", (double)stats->write_time_us / 1e6,
+           done > 0u ? (double)stats->write_time_us / 1e3 / done : 0.0);
+    if (max_writes > 0u) {
+        printf("  first page reaches %u cycles after about %.0f inserts\n", EEPROM_ENDURANCE_CYCLES,
+               (double)EEPROM_ENDURANCE_CYCLES * done / max_writes);
+    }
+
+    eeprom_reset_stats();
+    double host_us = boot_time_us();
+    uint64_t boot_bytes = eeprom_get_stats()->bytes_read / SIMULATION_BOOT_SAMPLES;
+    printf("  boot: %llu EEPROM bytes read (%.1f us on the part), %.2f us per recovery on this host\n",
+           (unsigned long long)boot_bytes, (double)boot_bytes * EEPROM_READ_NS_PER_BYTE / 1e3, host_us);
+    printf("  reboots checked: %u, power cuts recovered: %u, mismatches: %u\n", reboots, power_cuts, mismatches);
+
+    eeprom_close();
+    return mismatches == 0u ? 0 : 1;
+}
+
+#endif /* !__AVR__ */
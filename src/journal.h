@@ -0,0 +1,58 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#include "eeprom.h"
+#include "game.h"
+
+/*
+ * Log-structured highscore store in EEPROM. Each leaderboard insert
+ * appends one 16-byte record to the next slot of a ring that covers the
+ * whole part:
+ *
+ *   SEQUENCE[3] | SCORE[3] | NAME[8] | CRC16 (big endian)
+ *
+ * Multi-byte fields are little endian and the CRC is CRC-16/CCITT-FALSE
+ * over the first 14 bytes. Slots that still hold a leaderboard entry are
+ * skipped as the write head comes round, so the live records never need
+ * copying and the wear lands on the free slots. On boot the leaderboard
+ * is rebuilt from the best SIMON_HIGHSCORE_ENTRIES valid records, ranked
+ * by score and then by age; a record torn by a power cut fails its CRC
+ * and drops out.
+ *
+ * Names are kept to their first eight characters. Scores are capped at 24
+ * bits, which covers the longest endurance run, and the 24-bit sequence
+ * outlasts the EEPROM's rated cycles.
+ */
+#define JOURNAL_RECORD_SIZE  16u
+#define JOURNAL_NAME_LENGTH  8u
+#define JOURNAL_SLOT_COUNT   (EEPROM_SIZE / JOURNAL_RECORD_SIZE)
+#define JOURNAL_NO_SLOT      0xFFu
+#define JOURNAL_SCORE_MAX    0x00FFFFFFu
+
+// The write head needs at least one slot that is not a live row.
+#if SIMON_HIGHSCORE_ENTRIES >= JOURNAL_SLOT_COUNT
+#error "SIMON_HIGHSCORE_ENTRIES must leave the journal a free slot"
+#endif
+
+typedef struct highscore_journal {
+    uint32_t next_sequence;
+    uint8_t next_slot;
+    // Slot holding each leaderboard row, in table order.
+    uint8_t entry_slots[SIMON_HIGHSCORE_ENTRIES];
+} highscore_journal_t;
+
+void journal_recover(highscore_journal_t *journal, simon_highscore_table_t *table);
+void journal_record_insert(highscore_journal_t *journal, uint8_t index, const simon_highscore_entry_t *entry);
+
+#if !defined(__AVR__)
+/*
+ * Drive `inserts` leaderboard inserts through the journal on a file-backed
+ * EEPROM, rebooting and cutting power along the way, and report wear,
+ * programming time and boot cost.
+ */
+int journal_simulate(const char *path, uint32_t inserts);
+#endif
+
+#endif /* JOURNAL_H */
@@ -1,36 +1,370 @@
 #include "game.h"
 #include "board.h"
 #include "hardware.h"
+#include "input.h"
+#include "journal.h"
+#include "flight.h"
+#include "power.h"
+#include "profile.h"
+#include "protocol.h"
+#include "stimulus.h"
 
-int main(void)
+#if defined(__linux__)
+#include "archive.h"
+#include "bench.h"
+#include "bus.h"
+#include "minimize.h"
+#include "outcome.h"
+#include "render.h"
+#include "selftest.h"
+#include "server.h"
+#include "shm_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+#if defined(__linux__)
+// Only the console and the server record; the batch modes run without it.
+static void arm_flight_recorder(void)
+{
+#if FLIGHT_RECORDER_ENABLED
+    const char *flight_path = getenv("SIMON_FLIGHT_FILE");
+    if (flight_path == NULL) {
+        flight_path = "simon-flight.bin";
+    }
+    if (flight_install(flight_path) != 0) {
+        fprintf(stderr, "flight recorder not armed: cannot dump to %s\n", flight_path);
+    }
+#endif
+}
+#endif
+
+static void deliver_conditioned_events(simon_game_t *game, input_conditioner_t *input)
+{
+    board_event_t event;
+    while (input_poll(input, &event)) {
+        game_handle_event(game, &event);
+    }
+}
+
+/*
+ * Bring the game and the input stage up to `timestamp_ms`. Stretches where
+ * neither has work are skipped in one step; the rest is ticked one
+ * millisecond at a time so conditioned presses land on the millisecond
+ * they settled in.
+ */
+static void advance_to(simon_game_t *game, input_conditioner_t *input, uint32_t *now_ms, uint32_t timestamp_ms)
 {
+    uint32_t elapsed = timestamp_ms - *now_ms;
+    *now_ms = timestamp_ms;
+
+    while (elapsed > 0u) {
+        uint8_t raw_buttons = hardware_read_buttons();
+        uint32_t idle = 0u;
+
+        // A single millisecond is cheaper to tick than to look ahead for.
+        if (elapsed > 1u && input_is_idle(input, raw_buttons)) {
+            idle = game_next_wakeup(game) - 1u;
+        }
+
+        if (idle > 0u) {
+            if (idle > elapsed) {
+                idle = elapsed;
+            }
+            game_advance_ms(game, idle);
+            input_skip_ms(input, idle);
+            elapsed -= idle;
+            continue;
+        }
+
+        game_tick_1ms(game);
+
+        // Sample the buttons and forward whatever the input stage has
+        // settled on.
+        PROFILE_ENTER(PROFILE_INPUT);
+        input_tick_1ms(input, raw_buttons);
+        deliver_conditioned_events(game, input);
+        PROFILE_LEAVE(PROFILE_INPUT);
+        elapsed--;
+    }
+}
+
+int main(int argc, char **argv)
+{
+#if defined(__linux__)
+#if FLIGHT_RECORDER_ENABLED
+    if (argc == 3 && strcmp(argv[1], "--decode-flight") == 0) {
+        return flight_decode(argv[2]);
+    }
+#endif
+
+    if (argc == 4 && strcmp(argv[1], "--eeprom-sim") == 0) {
+        return journal_simulate(argv[2], (uint32_t)strtoul(argv[3], NULL, 10));
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--power-model") == 0) {
+        uint32_t hours = argc == 3 ? (uint32_t)strtoul(argv[2], NULL, 10) : 0u;
+        if (hours == 0u) {
+            fprintf(stderr, "usage: %s --power-model <hours>, at least 1\n", argv[0]);
+            return 1;
+        }
+        return power_simulate(hours);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--view") == 0) {
+        return shm_ring_view(argv[2]);
+    }
+    if (argc == 4 && strcmp(argv[1], "--ring-bench") == 0) {
+        return shm_ring_bench((uint32_t)strtoul(argv[2], NULL, 10), (uint32_t)strtoul(argv[3], NULL, 10));
+    }
+
+    if (argc >= 4 && argc <= 7 && strcmp(argv[1], "--link-sim") == 0) {
+        bus_config_t config = {
+            .boards = (uint32_t)strtoul(argv[2], NULL, 10),
+            .seconds = (uint32_t)strtoul(argv[3], NULL, 10),
+            .baud = argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 10) : 115200u,
+            .latency_us = argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 10) : 500u,
+            .loss_ppm = argc > 6 ? (uint32_t)strtoul(argv[6], NULL, 10) : 0u,
+            .poll_ms = 100u,
+            .seed = 1u,
+        };
+        return bus_simulate(&config);
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--outcome-gen") == 0) {
+        return outcome_generate(argv[2], strtoull(argv[3], NULL, 10));
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--outcome-query") == 0) {
+        return outcome_query(argv[2], (uint32_t)strtoul(argv[3], NULL, 10),
+                             argc == 5 ? (uint32_t)strtoul(argv[4], NULL, 10) : 0u);
+    }
+
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--sequence-bench") == 0) {
+        return bench_sequence(argc == 3 ? (uint32_t)strtoul(argv[2], NULL, 10) : 0u);
+    }
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--pool-bench") == 0) {
+        return bench_pool(argc == 3 ? (uint32_t)strtoul(argv[2], NULL, 10) : 0u);
+    }
+    if (argc == 4 && strcmp(argv[1], "--highscore-stress") == 0) {
+        return bench_highscore_stress((uint32_t)strtoul(argv[2], NULL, 10), (uint32_t)strtoul(argv[3], NULL, 10));
+    }
+    if (argc == 3 && strcmp(argv[1], "--reaction-bench") == 0) {
+        return bench_reaction((uint32_t)strtoul(argv[2], NULL, 10));
+    }
+    if (argc == 2 && strcmp(argv[1], "--protocol-selftest") == 0) {
+        return selftest_protocol();
+    }
+    if (argc == 2 && strcmp(argv[1], "--wheel-selftest") == 0) {
+        return selftest_wheel();
+    }
+    if (argc == 2 && strcmp(argv[1], "--journal-selftest") == 0) {
+        return selftest_journal();
+    }
+    if (argc == 2 && strcmp(argv[1], "--outcome-selftest") == 0) {
+        return selftest_outcome();
+    }
+    if (argc == 5 && strcmp(argv[1], "--archive-bench") == 0) {
+        return bench_archive(argv[2], (uint32_t)strtoul(argv[3], NULL, 10), (uint32_t)strtoul(argv[4], NULL, 10));
+    }
+    // --archive-pack <archive> <dictionary samples...> -- <logs...>
+    if (argc >= 4 && strcmp(argv[1], "--archive-pack") == 0) {
+        int split = 3;
+        while (split < argc && strcmp(argv[split], "--") != 0) {
+            split++;
+        }
+        if (split == argc) {
+            fprintf(stderr, "no -- between the dictionary samples and the logs\n");
+            return 1;
+        }
+        return archive_pack(argv[2], (const char *const *)&argv[3], (uint32_t)(split - 3),
+                            (const char *const *)&argv[split + 1], (uint32_t)(argc - split - 1));
+    }
+    // --archive-get <archive> id|seed|time <n>
+    if (argc == 5 && strcmp(argv[1], "--archive-get") == 0) {
+        return archive_get(argv[2], argv[3], (uint32_t)strtoul(argv[4], NULL, 10));
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--archive-scan") == 0) {
+        return archive_scan(argv[2], (uint32_t)strtoul(argv[3], NULL, 10), argc == 5 ? argv[4] : NULL);
+    }
+
+    // --minimize <trace> <out> <threads> line <text> | invariant | tickless
+    if (argc >= 6 && argc <= 7 && strcmp(argv[1], "--minimize") == 0) {
+        minimize_config_t config = {
+            .input = argv[2],
+            .output = argv[3],
+            .threads = (uint32_t)strtoul(argv[4], NULL, 10),
+        };
+        if (argc == 7 && strcmp(argv[5], "line") == 0) {
+            config.predicate = MINIMIZE_PREDICATE_LINE;
+            config.text = argv[6];
+        } else if (argc == 6 && strcmp(argv[5], "invariant") == 0) {
+            config.predicate = MINIMIZE_PREDICATE_INVARIANT;
+        } else if (argc == 6 && strcmp(argv[5], "tickless") == 0) {
+            config.predicate = MINIMIZE_PREDICATE_TICKLESS;
+        } else {
+            fprintf(stderr, "unknown predicate %s\n", argv[5]);
+            return 1;
+        }
+        return minimize_trace(&config);
+    }
+
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--render-compare") == 0) {
+        return render_compare(argv[2], argv[3], argc == 5 ? (unsigned)strtoul(argv[4], NULL, 10) : 0u);
+    }
+
+    // The console board keeps its leaderboard in a file when asked to.
+    const char *eeprom_path = getenv("SIMON_EEPROM_FILE");
+    if (eeprom_path != NULL && !eeprom_open(eeprom_path)) {
+        perror(eeprom_path);
+    }
+
+    // Host-only: serve many games over a socket instead of the console.
+    if (argc == 3 && strcmp(argv[1], "--server") == 0) {
+        arm_flight_recorder();
+        return server_run(argv[2]);
+    }
+    // --server-load <address> <sessions> [rounds], against a running server
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--server-load") == 0) {
+        return server_load(argv[2], (uint32_t)strtoul(argv[3], NULL, 10),
+                           argc == 5 ? (uint32_t)strtoul(argv[4], NULL, 10) : 5u);
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
+
     // Initialize hardware and board
     hardware_init();
     board_init();
+    power_init();
+
+#if defined(__linux__)
+    arm_flight_recorder();
+
+    // Publish LED, display and buzzer changes for visual frontends
+    static shm_ring_t ring;
+    const char *ring_name = getenv("SIMON_SHM_RING");
+    if (ring_name != NULL) {
+        if (shm_ring_create(&ring, ring_name)) {
+            shm_ring_unlink_on_signal(&ring);
+            hardware_add_observer(shm_ring_observer, &ring);
+        } else {
+            perror(ring_name);
+        }
+    }
+
+    // Draw every display change offscreen and log a hash per frame
+    static render_t render;
+    const char *render_dir = getenv("SIMON_RENDER_DIR");
+    if (render_dir != NULL) {
+        if (render_open(&render, render_dir, getenv("SIMON_RENDER_PNG") != NULL)) {
+            hardware_add_observer(render_observer, &render);
+        } else {
+            perror(render_dir);
+        }
+    }
+#endif
 
     // Initialize the Simon game
+    static simon_game_cold_t game_cold;
+    static timer_wheel_t game_wheel;
     simon_game_t game;
-    game_init(&game);
+    timer_wheel_init(&game_wheel);
+    game_init(&game, &game_cold, &game_wheel);
+
+    // Bring back the leaderboard saved before the last power cycle
+    static highscore_journal_t journal;
+    game_attach_journal(&game, &journal);
+
+#if defined(__linux__)
+    // Keep finished games in a columnar store for offline queries
+    static outcome_writer_t outcomes;
+    uint32_t outcomes_flushed_s = 0u;
+    const char *outcome_path = getenv("SIMON_OUTCOME_FILE");
+    if (outcome_path != NULL) {
+        if (outcome_writer_open(&outcomes, outcome_path)) {
+            game_set_outcome_sink(&game, outcome_writer_sink, &outcomes);
+        } else {
+            perror(outcome_path);
+        }
+    }
+#endif
+
+    // Debounce buttons and coalesce pot updates before they reach the game
+    input_conditioner_t input;
+    input_init(&input);
+
+    simon_protocol_t protocol;
+    protocol_init(&protocol);
+    protocol_attach_input(&protocol, &input);
+
+#if defined(SIMON_SCRIPTED_STIMULUS)
+    stimulus_player_t stimulus;
+    stimulus_init(&stimulus);
+#endif
 
     // Start the game loop
+    uint32_t now_ms = 0u;
     while (1) {
+#if defined(SIMON_SCRIPTED_STIMULUS)
+        // Replay the built-in script; every pass is one millisecond.
+        board_event_t event = {.type = BOARD_EVENT_TICK};
+        if (!stimulus_poll(&stimulus, &game, &event) && stimulus_finished(&stimulus)) {
+            stimulus_halt();
+            break;
+        }
+#elif defined(__AVR__)
+        // Sleep through the milliseconds with nothing due; a UART byte ends
+        // the sleep early. The game and input stage are caught up already.
+        uint32_t slept = power_idle(&game, &input, hardware_read_buttons(), POWER_MAX_SLEEP_MS);
+        now_ms += slept;
+        board_event_t event = board_event_after_sleep(slept);
+#else
         // Wait for an event (button press, tick, etc.)
         board_event_t event = board_wait_for_event();
+#endif
+        PROFILE_ENTER(PROFILE_TICK);
 
-        // Handle the event
-        game_handle_event(&game, &event);
+        // Time only moves with the timestamps, so a burst of input costs no
+        // ticks and a long "tick <n>" is caught up in one call.
+        advance_to(&game, &input, &now_ms, event.timestamp_ms);
 
-        // Perform any game-related operations on each tick when not already
-        // handled through an explicit tick event.
-        if (event.type != BOARD_EVENT_TICK) {
-            game_tick_1ms(&game);
+        // Handle the event once the input stage has accepted it
+        if (input_filter_event(&input, &event)) {
+            protocol_handle_event(&protocol, &game, &event);
         }
 
         // Update hardware if needed (LED, buzzer, etc.)
+        PROFILE_ENTER(PROFILE_DISPLAY);
         hardware_task_display();
+        PROFILE_LEAVE(PROFILE_DISPLAY);
+        PROFILE_LEAVE(PROFILE_TICK);
+
+#if defined(__linux__)
+        // As on the server, finished games go out a block per second rather
+        // than a block each; a killed session loses at most that second.
+        uint32_t now_s = (uint32_t)time(NULL);
+        if (outcomes.file != NULL && now_s != outcomes_flushed_s) {
+            (void)outcome_writer_flush(&outcomes);
+            outcomes_flushed_s = now_s;
+        }
+#endif
+
+        // The game has reported the one in progress; now leave.
+        if (event.type == BOARD_EVENT_QUIT) {
+            break;
+        }
     }
 
-    // Shutdown the board and hardware (this part will never be reached in this infinite loop)
+    // Shutdown the board and hardware (reached on quit or when a stimulus
+    // script ends)
     board_shutdown();
+#if defined(__linux__)
+    outcome_writer_close(&outcomes);
+    shm_ring_destroy(&ring);
+#endif
     return 0;
 }
@@ -0,0 +1,795 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "minimize.h"
+#include "board.h"
+#include "game.h"
+#include "hardware.h"
+#include "input.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_THREADS   64u
+#define MAX_SNAPSHOTS 4096u      // spread over the trace, however long
+#define MAX_TICK_MS   86400000u  // the longest tick line board_parse_line accepts
+#define NO_CANDIDATE  UINT32_MAX
+#define FNV_OFFSET    0xCBF29CE484222325ull
+#define FNV_PRIME     0x100000001B3ull
+
+typedef struct {
+    board_event_t event;
+    uint32_t advance_ms;
+    const char *text;  // as loaded; NULL for ticks, which are written from advance_ms
+} trace_item_t;
+
+struct minimize_job;
+
+typedef struct {
+    simon_game_t game;
+    simon_game_cold_t cold;
+    timer_wheel_t wheel;
+    input_conditioner_t input;
+    simon_protocol_t protocol;
+    hardware_context_t hardware;
+    const struct minimize_job *job;
+    uint64_t hash;
+    bool matched;
+    uint16_t line_length;
+    char line[BOARD_MAX_LINE];
+} replica_t;
+
+/*
+ * One worker's boards. The second replica only runs for TICKLESS, where it
+ * is the reference that ticks every millisecond.
+ */
+typedef struct {
+    replica_t replicas[2];
+    uint64_t evaluations;
+    uint64_t steps;
+    uint64_t skipped;  // steps a snapshot saved replaying
+} lane_t;
+
+typedef struct {
+    simon_game_snapshot_t game;
+    input_conditioner_t input;
+    simon_protocol_t protocol;
+    hardware_context_t hardware;
+    uint64_t hash;
+    bool matched;
+    uint16_t line_length;
+    char line[BOARD_MAX_LINE];
+} replica_snapshot_t;
+
+typedef struct {
+    replica_snapshot_t replicas[2];
+    bool failed;  // the predicate already failed on the way here
+} lane_snapshot_t;
+
+typedef struct minimize_job {
+    minimize_config_t config;
+    uint32_t replica_count;
+
+    trace_item_t *loaded;  // owns the texts
+    uint32_t loaded_length;
+    trace_item_t *trace;
+    trace_item_t *next;
+    uint32_t length;
+
+    /*
+     * The first pass only drops input events and keeps every tick where it
+     * is, so the ticks between dropped events fold into runs before the
+     * second pass considers them at all.
+     */
+    bool ticks_pinned;
+    uint32_t *droppable;  // positions of the events this pass may drop
+    uint32_t droppable_count;
+
+    lane_t *lanes;
+    uint32_t lane_count;
+    /*
+     * Snapshot i is the state after the first i * spacing events; [0] is
+     * power-on. A reduction leaves the ones before the first event it
+     * changed valid, and only those past it are taken again.
+     */
+    lane_snapshot_t *snapshots;
+    uint32_t snapshot_count;
+    uint32_t spacing;
+    uint32_t valid_snapshots;
+
+    // The current round.
+    uint32_t chunks;
+    uint32_t subsets;           // candidates keeping one chunk, tried first
+    uint32_t first_complement;  // the chunk the complements start dropping at
+    uint32_t candidates;
+    uint32_t next_candidate;
+    uint32_t lowest_failing;
+
+    uint32_t rounds;
+    uint32_t reductions;
+} minimize_job_t;
+
+typedef struct {
+    minimize_job_t *job;
+    lane_t *lane;
+} worker_t;
+
+static void replica_output(void *user, const char *data, size_t length)
+{
+    replica_t *replica = user;
+    bool want_lines = replica->job->config.predicate == MINIMIZE_PREDICATE_LINE;
+
+    for (size_t i = 0u; i < length; ++i) {
+        replica->hash = (replica->hash ^ (uint8_t)data[i]) * FNV_PRIME;
+        if (!want_lines) {
+            continue;
+        }
+        if (data[i] == '\n') {
+            replica->line[replica->line_length] = '\0';
+            if (strstr(replica->line, replica->job->config.text) != NULL) {
+                replica->matched = true;
+            }
+            replica->line_length = 0u;
+        } else if (replica->line_length + 1u < sizeof replica->line) {
+            replica->line[replica->line_length++] = data[i];
+        }
+    }
+}
+
+static void replica_init(replica_t *replica, const minimize_job_t *job)
+{
+    replica->job = job;
+    replica->hash = FNV_OFFSET;
+    replica->matched = false;
+    replica->line_length = 0u;
+    hardware_context_init(&replica->hardware, replica_output, replica);
+    hardware_bind_context(&replica->hardware);
+    timer_wheel_init(&replica->wheel);
+    game_init(&replica->game, &replica->cold, &replica->wheel);
+    input_init(&replica->input);
+    protocol_init(&replica->protocol);
+    protocol_attach_input(&replica->protocol, &replica->input);
+    hardware_bind_context(NULL);
+}
+
+/*
+ * Catch the game and the input stage up by `ms`, as the console's main
+ * loop does: stretches where neither has work are skipped in one step,
+ * the rest is ticked a millisecond at a time with the buttons sampled and
+ * settled presses handed to the game. `every_ms` ticks all of it, for the
+ * TICKLESS reference.
+ */
+static void replica_advance(replica_t *replica, uint32_t ms, bool every_ms)
+{
+    while (ms > 0u) {
+        uint8_t raw_buttons = hardware_read_buttons();
+        uint32_t idle = 0u;
+
+        if (!every_ms && ms > 1u && input_is_idle(&replica->input, raw_buttons)) {
+            idle = game_next_wakeup(&replica->game) - 1u;
+        }
+        if (idle > 0u) {
+            if (idle > ms) {
+                idle = ms;
+            }
+            game_advance_ms(&replica->game, idle);
+            input_skip_ms(&replica->input, idle);
+            ms -= idle;
+            continue;
+        }
+
+        board_event_t event;
+        game_tick_1ms(&replica->game);
+        input_tick_1ms(&replica->input, raw_buttons);
+        while (input_poll(&replica->input, &event)) {
+            game_handle_event(&replica->game, &event);
+        }
+        ms--;
+    }
+}
+
+static void replica_step(replica_t *replica, const trace_item_t *item, bool every_ms)
+{
+    board_event_t event = item->event;
+
+    hardware_bind_context(&replica->hardware);
+    replica_advance(replica, item->advance_ms, every_ms);
+    if (input_filter_event(&replica->input, &event)) {
+        protocol_handle_event(&replica->protocol, &replica->game, &event);
+    }
+    hardware_bind_context(NULL);
+}
+
+static bool replica_take(replica_snapshot_t *snapshot, const replica_t *replica)
+{
+    if (!game_snapshot_take(&snapshot->game, &replica->game)) {
+        return false;
+    }
+    snapshot->input = replica->input;
+    snapshot->protocol = replica->protocol;
+    snapshot->hardware = replica->hardware;
+    snapshot->hash = replica->hash;
+    snapshot->matched = replica->matched;
+    snapshot->line_length = replica->line_length;
+    memcpy(snapshot->line, replica->line, replica->line_length);
+    return true;
+}
+
+static void replica_restore(replica_t *replica, const replica_snapshot_t *snapshot)
+{
+    game_snapshot_restore(&snapshot->game, &replica->game);
+    replica->input = snapshot->input;
+    replica->protocol = snapshot->protocol;
+    protocol_attach_input(&replica->protocol, &replica->input);
+    replica->hardware = snapshot->hardware;
+    replica->hardware.output_user = replica;
+    replica->hash = snapshot->hash;
+    replica->matched = snapshot->matched;
+    replica->line_length = snapshot->line_length;
+    memcpy(replica->line, snapshot->line, snapshot->line_length);
+}
+
+static bool lane_failing(const minimize_job_t *job, const lane_t *lane)
+{
+    switch (job->config.predicate) {
+    case MINIMIZE_PREDICATE_LINE:
+        return lane->replicas[0].matched;
+    case MINIMIZE_PREDICATE_INVARIANT:
+        return game_check_invariants(&lane->replicas[0].game) != NULL;
+    case MINIMIZE_PREDICATE_TICKLESS:
+        return lane->replicas[0].hash != lane->replicas[1].hash;
+    }
+    return false;
+}
+
+static bool lane_step(const minimize_job_t *job, lane_t *lane, const trace_item_t *item)
+{
+    lane->steps++;
+    replica_step(&lane->replicas[0], item, false);
+    if (job->replica_count > 1u) {
+        replica_step(&lane->replicas[1], item, true);
+    }
+    return lane_failing(job, lane);
+}
+
+static bool lane_take(const minimize_job_t *job, lane_snapshot_t *snapshot, const lane_t *lane, bool failed)
+{
+    snapshot->failed = failed;
+    if (failed) {
+        // Anything restored from here fails straight away.
+        return true;
+    }
+    for (uint32_t i = 0u; i < job->replica_count; ++i) {
+        if (!replica_take(&snapshot->replicas[i], &lane->replicas[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True when the snapshot had already failed, so there is nothing to replay.
+static bool lane_restore(const minimize_job_t *job, lane_t *lane, const lane_snapshot_t *snapshot)
+{
+    if (snapshot->failed) {
+        return true;
+    }
+    for (uint32_t i = 0u; i < job->replica_count; ++i) {
+        replica_restore(&lane->replicas[i], &snapshot->replicas[i]);
+    }
+    return false;
+}
+
+static bool item_droppable(const minimize_job_t *job, const trace_item_t *item)
+{
+    return !job->ticks_pinned || item->event.type != BOARD_EVENT_TICK;
+}
+
+// With `pinned_only`, the events this pass may drop are left out.
+static bool lane_replay(const minimize_job_t *job, lane_t *lane, const trace_item_t *items, uint32_t begin,
+                        uint32_t end, bool pinned_only)
+{
+    for (uint32_t i = begin; i < end; ++i) {
+        if (pinned_only && item_droppable(job, &items[i])) {
+            continue;
+        }
+        if (lane_step(job, lane, &items[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void index_droppable(minimize_job_t *job)
+{
+    job->droppable_count = 0u;
+    for (uint32_t i = 0u; i < job->length; ++i) {
+        if (item_droppable(job, &job->trace[i])) {
+            job->droppable[job->droppable_count++] = i;
+        }
+    }
+}
+
+// Chunks split the droppable events evenly; chunk `chunk` spans [begin, end) of the trace.
+static void chunk_span(const minimize_job_t *job, uint32_t chunk, uint32_t *begin, uint32_t *end)
+{
+    uint32_t first = (uint32_t)((uint64_t)chunk * job->droppable_count / job->chunks);
+    uint32_t last = (uint32_t)((uint64_t)(chunk + 1u) * job->droppable_count / job->chunks);
+
+    *begin = job->droppable[first];
+    *end = job->droppable[last - 1u] + 1u;
+}
+
+// The chunk candidate `index` keeps, if it is a subset, or drops.
+static uint32_t candidate_chunk(const minimize_job_t *job, uint32_t index)
+{
+    return index < job->subsets ? index : (job->first_complement + index - job->subsets) % job->chunks;
+}
+
+/*
+ * Subsets replay their one chunk from power-on; complements pick up from
+ * the snapshot nearest before the chunk they drop.
+ */
+static bool candidate_fails(const minimize_job_t *job, lane_t *lane, uint32_t index)
+{
+    uint32_t begin = 0u, end = 0u;
+    chunk_span(job, candidate_chunk(job, index), &begin, &end);
+
+    if (index < job->subsets) {
+        return lane_restore(job, lane, &job->snapshots[0]) ||
+               (job->ticks_pinned && lane_replay(job, lane, job->trace, 0u, begin, true)) ||
+               lane_replay(job, lane, job->trace, begin, end, false) ||
+               (job->ticks_pinned && lane_replay(job, lane, job->trace, end, job->length, true));
+    }
+
+    uint32_t snapshot = begin / job->spacing;
+    uint32_t resume = snapshot * job->spacing;
+    lane->skipped += resume;
+    return lane_restore(job, lane, &job->snapshots[snapshot]) ||
+           lane_replay(job, lane, job->trace, resume, begin, false) ||
+           lane_replay(job, lane, job->trace, begin, end, true) ||
+           lane_replay(job, lane, job->trace, end, job->length, false);
+}
+
+static void evaluate_candidates(minimize_job_t *job, lane_t *lane)
+{
+    for (;;) {
+        uint32_t index = __atomic_fetch_add(&job->next_candidate, 1u, __ATOMIC_RELAXED);
+        // Candidates go out in order, so once one fails no later one can win.
+        if (index >= job->candidates || index > __atomic_load_n(&job->lowest_failing, __ATOMIC_RELAXED)) {
+            return;
+        }
+
+        lane->evaluations++;
+        if (candidate_fails(job, lane, index)) {
+            uint32_t lowest = __atomic_load_n(&job->lowest_failing, __ATOMIC_RELAXED);
+            while (index < lowest && !__atomic_compare_exchange_n(&job->lowest_failing, &lowest, index, true,
+                                                                  __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            }
+        }
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *worker = arg;
+    evaluate_candidates(worker->job, worker->lane);
+    return NULL;
+}
+
+// Retake the snapshots past the last valid one on lane 0.
+static bool update_snapshots(minimize_job_t *job)
+{
+    lane_t *lane = &job->lanes[0];
+    uint32_t count = (job->length + job->spacing - 1u) / job->spacing;
+    uint32_t position = (job->valid_snapshots - 1u) * job->spacing;
+    bool failed = lane_restore(job, lane, &job->snapshots[job->valid_snapshots - 1u]);
+
+    for (uint32_t i = job->valid_snapshots; i < count; ++i) {
+        while (!failed && position < i * job->spacing) {
+            failed = lane_step(job, lane, &job->trace[position++]);
+        }
+        if (!lane_take(job, &job->snapshots[i], lane, failed)) {
+            return false;
+        }
+    }
+    if (count > job->valid_snapshots) {
+        job->valid_snapshots = count;
+    }
+    return true;
+}
+
+// Spread the snapshots over the whole trace again once it has shrunk.
+static void reset_spacing(minimize_job_t *job)
+{
+    uint32_t spacing = (job->length + MAX_SNAPSHOTS - 1u) / MAX_SNAPSHOTS;
+
+    if (spacing == 0u) {
+        spacing = 1u;
+    }
+    if (spacing != job->spacing) {
+        job->spacing = spacing;
+        job->valid_snapshots = 1u;
+    }
+}
+
+static void invalidate_snapshots(minimize_job_t *job, uint32_t changed)
+{
+    uint32_t valid = changed / job->spacing + 1u;
+
+    if (valid < job->valid_snapshots) {
+        job->valid_snapshots = valid;
+    }
+}
+
+static uint32_t run_round(minimize_job_t *job)
+{
+    pthread_t threads[MAX_THREADS];
+    worker_t workers[MAX_THREADS];
+    uint32_t started = 0u;
+
+    job->next_candidate = 0u;
+    job->lowest_failing = NO_CANDIDATE;
+    for (uint32_t i = 1u; i < job->config.threads; ++i) {
+        workers[started] = (worker_t){.job = job, .lane = &job->lanes[i]};
+        if (pthread_create(&threads[started], NULL, worker_main, &workers[started]) != 0) {
+            break;
+        }
+        started++;
+    }
+    evaluate_candidates(job, &job->lanes[0]);
+    for (uint32_t i = 0u; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    return job->lowest_failing;
+}
+
+static uint32_t merge_ticks(trace_item_t *items, uint32_t length)
+{
+    uint32_t merged = 0u;
+
+    for (uint32_t i = 0u; i < length; ++i) {
+        trace_item_t *last = merged > 0u ? &items[merged - 1u] : NULL;
+        if (last != NULL && last->event.type == BOARD_EVENT_TICK && items[i].event.type == BOARD_EVENT_TICK &&
+            items[i].advance_ms <= MAX_TICK_MS - last->advance_ms) {
+            last->advance_ms += items[i].advance_ms;
+            continue;
+        }
+        items[merged++] = items[i];
+    }
+    return merged;
+}
+
+static bool trace_fails(minimize_job_t *job, const trace_item_t *items, uint32_t length)
+{
+    lane_t *lane = &job->lanes[0];
+    return lane_restore(job, lane, &job->snapshots[0]) || lane_replay(job, lane, items, 0u, length, false);
+}
+
+/*
+ * Fold the tick runs a reduction left behind from event `changed` on.
+ * Ticks carry no work of their own, so this only loses the checks between
+ * them; keep the merge only if the trace still fails without those.
+ */
+static void try_merge_ticks(minimize_job_t *job, uint32_t changed)
+{
+    uint32_t first = changed > 0u ? changed - 1u : 0u;
+    uint32_t snapshot = first / job->spacing;
+
+    memcpy(job->next, job->trace, job->length * sizeof *job->trace);
+    uint32_t merged = first + merge_ticks(job->next + first, job->length - first);
+    if (merged == job->length) {
+        return;
+    }
+
+    lane_t *lane = &job->lanes[0];
+    if (lane_restore(job, lane, &job->snapshots[snapshot]) ||
+        lane_replay(job, lane, job->next, snapshot * job->spacing, merged, false)) {
+        trace_item_t *swap = job->trace;
+        job->trace = job->next;
+        job->next = swap;
+        job->length = merged;
+        invalidate_snapshots(job, first);
+    }
+}
+
+static uint32_t keep_events(const minimize_job_t *job, trace_item_t *out, uint32_t begin, uint32_t end,
+                            bool pinned_only)
+{
+    uint32_t kept = 0u;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        if (!pinned_only || !item_droppable(job, &job->trace[i])) {
+            out[kept++] = job->trace[i];
+        }
+    }
+    return kept;
+}
+
+// Returns the first event that changed.
+static uint32_t apply_candidate(minimize_job_t *job, uint32_t index)
+{
+    uint32_t chunk = candidate_chunk(job, index);
+    uint32_t begin = 0u, end = 0u, length = 0u;
+    chunk_span(job, chunk, &begin, &end);
+
+    if (index < job->subsets) {
+        length += keep_events(job, job->next + length, 0u, begin, true);
+        length += keep_events(job, job->next + length, begin, end, false);
+        length += keep_events(job, job->next + length, end, job->length, true);
+        job->chunks = 2u;
+        job->first_complement = 0u;
+        begin = 0u;
+    } else {
+        length += keep_events(job, job->next + length, 0u, begin, false);
+        length += keep_events(job, job->next + length, begin, end, true);
+        length += keep_events(job, job->next + length, end, job->length, false);
+        job->chunks = job->chunks > 2u ? job->chunks - 1u : 2u;
+        // The chunks before this one just survived; start past them next time.
+        job->first_complement = chunk < job->chunks ? chunk : 0u;
+    }
+
+    trace_item_t *swap = job->trace;
+    job->trace = job->next;
+    job->next = swap;
+    job->length = length;
+    invalidate_snapshots(job, begin);
+    return begin;
+}
+
+static bool ddmin(minimize_job_t *job)
+{
+    bool try_subsets = true;
+
+    job->chunks = 2u;
+    job->first_complement = 0u;
+    reset_spacing(job);
+    for (;;) {
+        index_droppable(job);
+        if (job->droppable_count < 2u) {
+            return true;
+        }
+        if (job->chunks > job->droppable_count) {
+            job->chunks = job->droppable_count;
+            job->first_complement = 0u;
+        }
+        if (!update_snapshots(job)) {
+            return false;
+        }
+        /*
+         * With two chunks each complement is the other subset. Subsets are
+         * skipped after a complement was dropped: they rarely fail then,
+         * and 1-minimality only rests on the complements.
+         */
+        job->subsets = try_subsets || job->chunks == 2u ? job->chunks : 0u;
+        job->candidates = job->subsets + (job->chunks == 2u ? 0u : job->chunks);
+        job->rounds++;
+
+        uint32_t failing = run_round(job);
+        if (failing != NO_CANDIDATE) {
+            try_subsets = failing < job->subsets;
+            try_merge_ticks(job, apply_candidate(job, failing));
+            job->reductions++;
+            continue;
+        }
+        if (job->chunks == job->droppable_count) {
+            return true;
+        }
+        job->chunks = job->chunks * 2u < job->droppable_count ? job->chunks * 2u : job->droppable_count;
+        job->first_complement = 0u;
+        try_subsets = true;
+        reset_spacing(job);
+    }
+}
+
+static bool load_trace(minimize_job_t *job)
+{
+    FILE *file = fopen(job->config.input, "r");
+    if (file == NULL) {
+        perror(job->config.input);
+        return false;
+    }
+
+    char line[BOARD_MAX_LINE];
+    uint32_t clock_ms = 0u;
+    uint32_t capacity = 0u;
+    bool ok = true;
+    while (fgets(line, sizeof line, file) != NULL) {
+        uint32_t previous_ms = clock_ms;
+        board_event_t event = board_parse_line(line, &clock_ms);
+        if (event.type == BOARD_EVENT_QUIT) {
+            break;
+        }
+        if (event.type == BOARD_EVENT_NONE && clock_ms == previous_ms) {
+            // The game ignores lines it cannot parse.
+            continue;
+        }
+
+        if (job->loaded_length == capacity) {
+            capacity = capacity > 0u ? capacity * 2u : 1024u;
+            trace_item_t *items = realloc(job->loaded, capacity * sizeof *items);
+            if (items == NULL) {
+                ok = false;
+                break;
+            }
+            job->loaded = items;
+        }
+        trace_item_t *item = &job->loaded[job->loaded_length];
+        item->event = event;
+        item->advance_ms = clock_ms - previous_ms;
+        item->text = NULL;
+        if (event.type != BOARD_EVENT_TICK && (item->text = strdup(line)) == NULL) {
+            ok = false;
+            break;
+        }
+        job->loaded_length++;
+    }
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "%s: out of memory\n", job->config.input);
+    }
+    return ok;
+}
+
+static bool write_trace(const minimize_job_t *job)
+{
+    FILE *file = fopen(job->config.output, "w");
+    if (file == NULL) {
+        perror(job->config.output);
+        return false;
+    }
+
+    for (uint32_t i = 0u; i < job->length; ++i) {
+        const trace_item_t *item = &job->trace[i];
+        if (item->text != NULL) {
+            fprintf(file, "%s\n", item->text);
+        } else if (item->advance_ms == 1u) {
+            fputs("tick\n", file);
+        } else {
+            fprintf(file, "tick %u\n", item->advance_ms);
+        }
+    }
+
+    if (fclose(file) != 0) {
+        perror(job->config.output);
+        return false;
+    }
+    return true;
+}
+
+static bool job_init(minimize_job_t *job)
+{
+    size_t trace_bytes = (job->loaded_length > 0u ? job->loaded_length : 1u) * sizeof *job->trace;
+
+    job->replica_count = job->config.predicate == MINIMIZE_PREDICATE_TICKLESS ? 2u : 1u;
+    job->trace = malloc(trace_bytes);
+    job->next = malloc(trace_bytes);
+    job->droppable = malloc(trace_bytes / sizeof *job->trace * sizeof *job->droppable);
+    job->lanes = aligned_alloc(SIMON_CACHE_LINE, job->config.threads * sizeof *job->lanes);
+    job->snapshots = aligned_alloc(SIMON_CACHE_LINE, (MAX_SNAPSHOTS + 1u) * sizeof *job->snapshots);
+    if (job->trace == NULL || job->next == NULL || job->droppable == NULL || job->lanes == NULL || job->snapshots == NULL) {
+        return false;
+    }
+    memcpy(job->trace, job->loaded, job->loaded_length * sizeof *job->trace);
+    job->length = job->loaded_length;
+
+    for (uint32_t i = 0u; i <= MAX_SNAPSHOTS; ++i) {
+        for (uint32_t r = 0u; r < 2u; ++r) {
+            game_snapshot_init(&job->snapshots[i].replicas[r].game);
+        }
+    }
+    job->snapshot_count = MAX_SNAPSHOTS + 1u;
+
+    for (uint32_t i = 0u; i < job->config.threads; ++i) {
+        memset(&job->lanes[i], 0, sizeof job->lanes[i]);
+        for (uint32_t r = 0u; r < job->replica_count; ++r) {
+            replica_init(&job->lanes[i].replicas[r], job);
+        }
+        job->lane_count++;
+    }
+
+    // Every candidate starts from this power-on state.
+    lane_t *lane = &job->lanes[0];
+    job->valid_snapshots = 1u;
+    return lane_take(job, &job->snapshots[0], lane, lane_failing(job, lane));
+}
+
+static void job_free(minimize_job_t *job)
+{
+    for (uint32_t i = 0u; i < job->lane_count; ++i) {
+        for (uint32_t r = 0u; r < job->replica_count; ++r) {
+            hardware_bind_context(&job->lanes[i].replicas[r].hardware);
+            game_shutdown(&job->lanes[i].replicas[r].game);
+        }
+    }
+    hardware_bind_context(NULL);
+    for (uint32_t i = 0u; i < job->snapshot_count; ++i) {
+        for (uint32_t r = 0u; r < 2u; ++r) {
+            game_snapshot_free(&job->snapshots[i].replicas[r].game);
+        }
+    }
+    for (uint32_t i = 0u; i < job->loaded_length; ++i) {
+        free((char *)job->loaded[i].text);
+    }
+    free(job->loaded);
+    free(job->trace);
+    free(job->next);
+    free(job->droppable);
+    free(job->lanes);
+    free(job->snapshots);
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int minimize_trace(const minimize_config_t *config)
+{
+    minimize_job_t job = {.config = *config};
+    int result = 1;
+
+    if (job.config.threads == 0u) {
+        job.config.threads = 1u;
+    }
+    if (job.config.threads > MAX_THREADS) {
+        job.config.threads = MAX_THREADS;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!load_trace(&job)) {
+        goto done;
+    }
+    if (!job_init(&job)) {
+        fprintf(stderr, "minimizer: out of memory\n");
+        goto done;
+    }
+    if (!trace_fails(&job, job.trace, job.length)) {
+        fprintf(stderr, "%s: the trace does not fail the predicate\n", config->input);
+        goto done;
+    }
+    reset_spacing(&job);
+    try_merge_ticks(&job, 0u);
+
+    job.ticks_pinned = true;
+    bool minimized = ddmin(&job);
+    job.ticks_pinned = false;
+    if (!minimized || !ddmin(&job)) {
+        fprintf(stderr, "minimizer: out of memory\n");
+        goto done;
+    }
+
+    if (!write_trace(&job)) {
+        goto done;
+    }
+
+    uint64_t evaluations = 0u, steps = 0u, skipped = 0u;
+    for (uint32_t i = 0u; i < job.lane_count; ++i) {
+        evaluations += job.lanes[i].evaluations;
+        steps += job.lanes[i].steps;
+        skipped += job.lanes[i].skipped;
+    }
+    double wall = seconds_since(&start);
+    printf("%u events minimized to %u in %.3f s\n", job.loaded_length, job.length, wall);
+    printf("%u rounds, %u reductions, %llu candidates on %u threads\n", job.rounds, job.reductions,
+           (unsigned long long)evaluations, job.config.threads);
+    printf("%llu events replayed, %llu skipped by snapshots\n", (unsigned long long)steps,
+           (unsigned long long)skipped);
+    result = 0;
+
+done:
+    job_free(&job);
+    return result;
+}
+
+#endif /* __linux__ */
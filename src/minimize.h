@@ -0,0 +1,42 @@
+#ifndef MINIMIZE_H
+#define MINIMIZE_H
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+/*
+ * Delta-debugging minimizer for console traces. It loads a script of
+ * console lines, replays it the way the console does (catch the game and
+ * the input stage up to each event, then pass the event through the input
+ * stage to the protocol layer) and shrinks it with ddmin to a trace that
+ * still fails the chosen predicate. Runs of tick lines are folded into
+ * single "tick <n>" lines whenever a reduction leaves them next to each
+ * other.
+ *
+ * Each ddmin round replays its trace once, snapshotting the game at chunk
+ * boundaries, so a candidate that drops a chunk restarts from the snapshot
+ * before it instead of from power-on. Candidates are evaluated by a pool of
+ * threads, each driving boards of its own; the first failing candidate in
+ * ddmin order wins whatever order they finish in, so the result does not
+ * depend on the thread count.
+ */
+typedef enum {
+    MINIMIZE_PREDICATE_LINE = 0,   // some complete output line contains `text`
+    MINIMIZE_PREDICATE_INVARIANT,  // game_check_invariants fails after an event
+    MINIMIZE_PREDICATE_TICKLESS    // game_advance_ms and per-ms ticks print different output
+} minimize_predicate_t;
+
+typedef struct {
+    const char *input;
+    const char *output;
+    uint32_t threads;
+    minimize_predicate_t predicate;
+    const char *text;  // LINE only
+} minimize_config_t;
+
+int minimize_trace(const minimize_config_t *config);
+
+#endif /* __linux__ */
+
+#endif /* MINIMIZE_H */
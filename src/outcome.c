@@ -0,0 +1,673 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "outcome.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DICT_SLOTS           (OUTCOME_DICT_MAX * 2u)
+#define COLUMN_BYTES_MAX     (OUTCOME_BLOCK_ROWS * sizeof(uint32_t) + 8u)
+#define DELAY_BUCKET_MS      250u
+#define DELAY_BUCKETS        9u  // the last one takes everything from 2000 ms
+#define SCORE_BINS           65u // the last one takes everything from 64
+#define QUERY_MAX_THREADS    64u
+#define GENERATE_CABINETS    200u
+
+_Static_assert(sizeof(outcome_file_header_t) == 16u, "the file header is 16 bytes");
+_Static_assert(sizeof(outcome_block_header_t) % 8u == 0u, "columns start eight-byte aligned");
+
+static bool column_is_signed(outcome_column_t column)
+{
+    return column == OUTCOME_COLUMN_OCTAVE;
+}
+
+static int64_t column_key(outcome_column_t column, uint32_t value)
+{
+    return column_is_signed(column) ? (int64_t)(int32_t)value : (int64_t)value;
+}
+
+static uint8_t bit_width(uint64_t value)
+{
+    return value == 0u ? 0u : (uint8_t)(64 - __builtin_clzll(value));
+}
+
+static uint32_t packed_bytes(uint32_t count, uint8_t width)
+{
+    // Whole words, and a spare one for decoders loading past the last field.
+    return (uint32_t)((((uint64_t)count * width + 63u) / 64u) * 8u + 8u);
+}
+
+static uint32_t zigzag(uint32_t step)
+{
+    return (step << 1) ^ (uint32_t)((int32_t)step >> 31);
+}
+
+static uint32_t unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1u));
+}
+
+static void pack_bits(uint8_t *out, const uint32_t *values, uint32_t count, uint8_t width)
+{
+    uint64_t word = 0u;
+    uint32_t used = 0u;
+
+    for (uint32_t i = 0u; i < count; ++i) {
+        word |= (uint64_t)values[i] << used;
+        used += width;
+        if (used >= 64u) {
+            memcpy(out, &word, sizeof word);
+            out += sizeof word;
+            used -= 64u;
+            word = used == 0u ? 0u : (uint64_t)values[i] >> (width - used);
+        }
+    }
+    if (used > 0u) {
+        memcpy(out, &word, sizeof word);
+        out += sizeof word;
+    }
+    memset(out, 0, sizeof word);
+}
+
+static void unpack_bits(const uint8_t *in, uint32_t count, uint8_t width, uint32_t *out)
+{
+    if (width == 0u) {
+        memset(out, 0, count * sizeof *out);
+        return;
+    }
+
+    uint64_t mask = (width == 64u) ? ~0ull : ((1ull << width) - 1u);
+    for (uint32_t i = 0u; i < count; ++i) {
+        uint64_t bit = (uint64_t)i * width;
+        uint64_t word;
+        memcpy(&word, in + (bit >> 3), sizeof word);
+        out[i] = (uint32_t)((word >> (bit & 7u)) & mask);
+    }
+}
+
+/*
+ * Distinct values of a column, sorted, or 0 if there are more than a
+ * dictionary holds. `slots` maps each value to its dictionary index.
+ */
+typedef struct {
+    uint32_t values[DICT_SLOTS];
+    int16_t index[DICT_SLOTS];
+} dict_map_t;
+
+static uint32_t dict_slot(const dict_map_t *map, uint32_t value)
+{
+    uint32_t slot = (value * 2654435761u) >> 23;  // DICT_SLOTS is 512
+    while (map->index[slot] >= 0 && map->values[slot] != value) {
+        slot = (slot + 1u) & (DICT_SLOTS - 1u);
+    }
+    return slot;
+}
+
+static int compare_key(const void *a, const void *b)
+{
+    int64_t left = *(const int64_t *)a;
+    int64_t right = *(const int64_t *)b;
+    return (left > right) - (left < right);
+}
+
+static uint32_t build_dict(dict_map_t *map, outcome_column_t column, const uint32_t *values, uint32_t rows,
+                           int64_t *keys)
+{
+    uint32_t count = 0u;
+
+    memset(map->index, 0xFF, sizeof map->index);
+    for (uint32_t i = 0u; i < rows; ++i) {
+        uint32_t slot = dict_slot(map, values[i]);
+        if (map->index[slot] < 0) {
+            if (count == OUTCOME_DICT_MAX) {
+                return 0u;
+            }
+            map->values[slot] = values[i];
+            map->index[slot] = 0;
+            keys[count++] = column_key(column, values[i]);
+        }
+    }
+
+    qsort(keys, count, sizeof keys[0], compare_key);
+    for (uint32_t i = 0u; i < count; ++i) {
+        map->index[dict_slot(map, (uint32_t)keys[i])] = (int16_t)i;
+    }
+    return count;
+}
+
+/*
+ * Encode one column into `out` in the smallest encoding, scratch space
+ * permitting, and fill in its descriptor apart from the offset.
+ */
+static void encode_column(outcome_column_t column, const uint32_t *values, uint32_t rows, uint8_t *out,
+                          uint32_t *scratch, outcome_column_header_t *header)
+{
+    static dict_map_t map;
+    int64_t keys[OUTCOME_DICT_MAX];
+    int64_t min = column_key(column, values[0]);
+    int64_t max = min;
+    uint32_t widest_step = 0u;
+
+    for (uint32_t i = 0u; i < rows; ++i) {
+        int64_t key = column_key(column, values[i]);
+        min = key < min ? key : min;
+        max = key > max ? key : max;
+        if (i > 0u) {
+            uint32_t step = zigzag(values[i] - values[i - 1u]);
+            widest_step = step > widest_step ? step : widest_step;
+        }
+    }
+
+    uint8_t for_width = bit_width((uint64_t)(max - min));
+    uint8_t delta_width = bit_width(widest_step);
+    uint32_t for_bytes = packed_bytes(rows, for_width);
+    uint32_t delta_bytes = packed_bytes(rows - 1u, delta_width);
+    uint32_t dict_count = build_dict(&map, column, values, rows, keys);
+    uint8_t index_width = dict_count > 0u ? bit_width(dict_count - 1u) : 0u;
+    uint32_t dict_bytes = dict_count > 0u ? packed_bytes(dict_count, for_width) + packed_bytes(rows, index_width)
+                                          : UINT32_MAX;
+
+    *header = (outcome_column_header_t){.min = min, .max = max, .base = min, .width = for_width};
+    if (delta_bytes < for_bytes && delta_bytes <= dict_bytes) {
+        header->encoding = OUTCOME_ENCODING_DELTA;
+        header->width = delta_width;
+        header->base = column_key(column, values[0]);
+        for (uint32_t i = 1u; i < rows; ++i) {
+            scratch[i - 1u] = zigzag(values[i] - values[i - 1u]);
+        }
+        pack_bits(out, scratch, rows - 1u, delta_width);
+        header->bytes = delta_bytes;
+    } else if (dict_bytes < for_bytes) {
+        uint32_t entries = packed_bytes(dict_count, for_width);
+        header->encoding = OUTCOME_ENCODING_DICT;
+        header->index_width = index_width;
+        header->dict_count = dict_count;
+        for (uint32_t i = 0u; i < dict_count; ++i) {
+            scratch[i] = (uint32_t)(keys[i] - min);
+        }
+        pack_bits(out, scratch, dict_count, for_width);
+        for (uint32_t i = 0u; i < rows; ++i) {
+            scratch[i] = (uint32_t)map.index[dict_slot(&map, values[i])];
+        }
+        pack_bits(out + entries, scratch, rows, index_width);
+        header->bytes = dict_bytes;
+    } else {
+        header->encoding = OUTCOME_ENCODING_FOR;
+        for (uint32_t i = 0u; i < rows; ++i) {
+            scratch[i] = values[i] - (uint32_t)min;
+        }
+        pack_bits(out, scratch, rows, for_width);
+        header->bytes = for_bytes;
+    }
+}
+
+// Whether a block header fits the `remaining` bytes from its start.
+static bool block_header_valid(const outcome_block_header_t *block, size_t remaining)
+{
+    return block->magic == OUTCOME_BLOCK_MAGIC && block->rows != 0u && block->rows <= OUTCOME_BLOCK_ROWS &&
+           block->payload_bytes <= remaining - sizeof *block;
+}
+
+/*
+ * Cut a block torn by a crash off the end of the file, so the next block
+ * appended is not hidden behind it. Returns false for a file that is not
+ * an outcome store at all; a header cut short is written again.
+ */
+static bool truncate_torn_tail(int fd)
+{
+    outcome_file_header_t file_header;
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+    size_t size = (size_t)info.st_size;
+    size_t head = size < sizeof file_header ? size : sizeof file_header;
+    size_t magic = head < sizeof file_header.magic ? head : sizeof file_header.magic;
+    if (pread(fd, &file_header, head, 0) != (ssize_t)head || memcmp(file_header.magic, OUTCOME_MAGIC, magic) != 0) {
+        errno = EINVAL;
+        return false;
+    }
+    if (size < sizeof file_header) {
+        return ftruncate(fd, 0) == 0;
+    }
+
+    size_t offset = sizeof file_header;
+    while (size - offset >= sizeof(outcome_block_header_t)) {
+        outcome_block_header_t block;
+        if (pread(fd, &block, sizeof block, (off_t)offset) != (ssize_t)sizeof block ||
+            !block_header_valid(&block, size - offset)) {
+            break;
+        }
+        offset += sizeof block + block.payload_bytes;
+    }
+    return offset == size || ftruncate(fd, (off_t)offset) == 0;
+}
+
+bool outcome_writer_open(outcome_writer_t *writer, const char *path)
+{
+    memset(writer, 0, sizeof *writer);
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (!truncate_torn_tail(fd) || (writer->file = fdopen(fd, "ab")) == NULL) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+    // fdopen leaves the position at 0 until the first write.
+    (void)fseek(writer->file, 0, SEEK_END);
+
+    for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+        writer->columns[i] = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+    }
+    writer->payload = malloc(OUTCOME_COLUMN_COUNT * COLUMN_BYTES_MAX);
+
+    bool ok = writer->payload != NULL;
+    for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+        ok = ok && writer->columns[i] != NULL;
+    }
+    // Appending to a file that already has blocks keeps its header.
+    if (ok && ftell(writer->file) == 0) {
+        outcome_file_header_t header = {.version = OUTCOME_VERSION, .column_count = OUTCOME_COLUMN_COUNT};
+        memcpy(header.magic, OUTCOME_MAGIC, sizeof header.magic);
+        ok = fwrite(&header, sizeof header, 1u, writer->file) == 1u && fflush(writer->file) == 0;
+    }
+    if (!ok) {
+        outcome_writer_close(writer);
+    }
+    return ok;
+}
+
+bool outcome_writer_append(outcome_writer_t *writer, const simon_outcome_t *outcome, uint32_t ended_at)
+{
+    uint32_t row = writer->rows++;
+
+    writer->columns[OUTCOME_COLUMN_ENDED_AT][row] = ended_at;
+    writer->columns[OUTCOME_COLUMN_SCORE][row] = outcome->score;
+    writer->columns[OUTCOME_COLUMN_LEVEL][row] = outcome->level;
+    writer->columns[OUTCOME_COLUMN_SEED][row] = outcome->seed;
+    writer->columns[OUTCOME_COLUMN_DURATION_MS][row] = outcome->duration_ms;
+    writer->columns[OUTCOME_COLUMN_DELAY_MS][row] = outcome->playback_delay_ms;
+    writer->columns[OUTCOME_COLUMN_OCTAVE][row] = (uint32_t)(int32_t)outcome->octave_shift;
+    return writer->rows < OUTCOME_BLOCK_ROWS || outcome_writer_flush(writer);
+}
+
+bool outcome_writer_flush(outcome_writer_t *writer)
+{
+    static uint32_t scratch[OUTCOME_BLOCK_ROWS];
+    outcome_block_header_t header = {.magic = OUTCOME_BLOCK_MAGIC, .rows = writer->rows};
+    uint32_t offset = 0u;
+
+    if (writer->rows == 0u) {
+        return true;
+    }
+    for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+        outcome_column_header_t *column = &header.columns[i];
+        encode_column((outcome_column_t)i, writer->columns[i], writer->rows, writer->payload + offset, scratch,
+                      column);
+        column->offset = offset;
+        offset += column->bytes;
+    }
+    header.payload_bytes = offset;
+    writer->rows = 0u;
+
+    return fwrite(&header, sizeof header, 1u, writer->file) == 1u &&
+           fwrite(writer->payload, offset, 1u, writer->file) == 1u && fflush(writer->file) == 0;
+}
+
+void outcome_writer_close(outcome_writer_t *writer)
+{
+    if (writer->file != NULL) {
+        (void)outcome_writer_flush(writer);
+        fclose(writer->file);
+        writer->file = NULL;
+    }
+    for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+        free(writer->columns[i]);
+        writer->columns[i] = NULL;
+    }
+    free(writer->payload);
+    writer->payload = NULL;
+}
+
+void outcome_writer_sink(void *user, const simon_outcome_t *outcome)
+{
+    (void)outcome_writer_append(user, outcome, (uint32_t)time(NULL));
+}
+
+static uint32_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (uint32_t)(*state >> 32);
+}
+
+int outcome_generate(const char *path, uint64_t rows)
+{
+    outcome_writer_t writer;
+    uint16_t cabinet_delay[GENERATE_CABINETS];
+    int8_t cabinet_octave[GENERATE_CABINETS];
+    uint64_t rng = 0x5EED5EEDull;
+    uint32_t ended_at = 1700000000u;
+
+    if (!outcome_writer_open(&writer, path)) {
+        perror(path);
+        return 1;
+    }
+
+    // Each cabinet keeps its pot and octave where the operator left them;
+    // half are still on the fastest setting.
+    for (uint32_t i = 0u; i < GENERATE_CABINETS; ++i) {
+        uint32_t roll = next_random(&rng);
+        cabinet_delay[i] = (roll & 1u) != 0u ? 250u : (uint16_t)(250u + (roll >> 1) % 1751u);
+        cabinet_octave[i] = (int8_t)(next_random(&rng) % 8u == 0u ? (int)(next_random(&rng) % 5u) - 2 : 0);
+    }
+
+    // Slower games run further.
+    for (uint64_t i = 0u; i < rows; ++i) {
+        simon_outcome_t outcome;
+        uint32_t cabinet = next_random(&rng) % GENERATE_CABINETS;
+        uint16_t delay = cabinet_delay[cabinet];
+        uint32_t reach = 4u + delay / 100u;
+        uint32_t score = next_random(&rng) % reach + next_random(&rng) % reach;
+
+        outcome.score = score > SIMON_MAX_SEQUENCE ? SIMON_MAX_SEQUENCE : score;
+        outcome.level = outcome.score < SIMON_MAX_SEQUENCE ? outcome.score + 1u : outcome.score;
+        outcome.seed = next_random(&rng);
+        outcome.duration_ms = outcome.level * (outcome.level + 1u) * delay + next_random(&rng) % 4096u;
+        outcome.playback_delay_ms = delay;
+        outcome.octave_shift = cabinet_octave[cabinet];
+        ended_at += next_random(&rng) % 3u;
+        if (!outcome_writer_append(&writer, &outcome, ended_at)) {
+            perror(path);
+            outcome_writer_close(&writer);
+            return 1;
+        }
+    }
+
+    outcome_writer_close(&writer);
+    return 0;
+}
+
+typedef struct {
+    uint64_t games[DELAY_BUCKETS];
+    uint64_t score_total[DELAY_BUCKETS];
+    uint32_t score_max[DELAY_BUCKETS];
+    uint64_t bins[DELAY_BUCKETS][SCORE_BINS];
+} score_stats_t;
+
+typedef struct {
+    const uint8_t *base;
+    const uint64_t *blocks;
+    uint32_t block_count;
+    uint32_t min_score;
+    uint32_t *next_block;
+    uint64_t rows;
+    uint64_t pruned;
+    score_stats_t stats;
+} query_worker_t;
+
+void outcome_decode_column(const outcome_block_header_t *block, outcome_column_t column, uint32_t *out,
+                           uint32_t *scratch)
+{
+    const outcome_column_header_t *header = &block->columns[column];
+    const uint8_t *in = (const uint8_t *)(block + 1) + header->offset;
+    uint32_t base = (uint32_t)header->base;
+    uint32_t rows = block->rows;
+
+    switch ((outcome_encoding_t)header->encoding) {
+    case OUTCOME_ENCODING_DELTA:
+        unpack_bits(in, rows - 1u, header->width, scratch);
+        out[0] = base;
+        for (uint32_t i = 1u; i < rows; ++i) {
+            out[i] = out[i - 1u] + unzigzag(scratch[i - 1u]);
+        }
+        break;
+
+    case OUTCOME_ENCODING_DICT: {
+        uint32_t entries[OUTCOME_DICT_MAX];
+        unpack_bits(in, header->dict_count, header->width, entries);
+        for (uint32_t i = 0u; i < header->dict_count; ++i) {
+            entries[i] += base;
+        }
+        unpack_bits(in + packed_bytes(header->dict_count, header->width), rows, header->index_width, scratch);
+        for (uint32_t i = 0u; i < rows; ++i) {
+            out[i] = entries[scratch[i]];
+        }
+        break;
+    }
+
+    case OUTCOME_ENCODING_FOR:
+    default:
+        unpack_bits(in, rows, header->width, out);
+        for (uint32_t i = 0u; i < rows; ++i) {
+            out[i] += base;
+        }
+        break;
+    }
+}
+
+static void *query_worker_main(void *argument)
+{
+    query_worker_t *worker = argument;
+    uint32_t *scores = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+    uint32_t *delays = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+    uint32_t *scratch = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+
+    if (scores == NULL || delays == NULL || scratch == NULL) {
+        free(scores);
+        free(delays);
+        free(scratch);
+        return NULL;
+    }
+
+    for (;;) {
+        uint32_t index = __atomic_fetch_add(worker->next_block, 1u, __ATOMIC_RELAXED);
+        if (index >= worker->block_count) {
+            break;
+        }
+
+        const outcome_block_header_t *block = (const void *)(worker->base + worker->blocks[index]);
+        const outcome_column_header_t *score = &block->columns[OUTCOME_COLUMN_SCORE];
+        uint32_t rows = block->rows;
+
+        worker->rows += rows;
+        if (score->max < (int64_t)worker->min_score) {
+            worker->pruned++;
+            continue;
+        }
+
+        // Only the two columns the query reads are decoded.
+        outcome_decode_column(block, OUTCOME_COLUMN_SCORE, scores, scratch);
+        outcome_decode_column(block, OUTCOME_COLUMN_DELAY_MS, delays, scratch);
+        for (uint32_t i = 0u; i < rows; ++i) {
+            uint32_t bucket = delays[i] / DELAY_BUCKET_MS;
+            uint32_t bin = scores[i];
+            if (scores[i] < worker->min_score) {
+                continue;
+            }
+            bucket = bucket < DELAY_BUCKETS ? bucket : DELAY_BUCKETS - 1u;
+            bin = bin < SCORE_BINS ? bin : SCORE_BINS - 1u;
+            worker->stats.games[bucket]++;
+            worker->stats.score_total[bucket] += scores[i];
+            worker->stats.bins[bucket][bin]++;
+            if (scores[i] > worker->stats.score_max[bucket]) {
+                worker->stats.score_max[bucket] = scores[i];
+            }
+        }
+    }
+
+    free(scores);
+    free(delays);
+    free(scratch);
+    return NULL;
+}
+
+static uint32_t bin_at(const uint64_t *bins, uint64_t rank)
+{
+    uint64_t seen = 0u;
+    for (uint32_t bin = 0u; bin < SCORE_BINS; ++bin) {
+        seen += bins[bin];
+        if (seen > rank) {
+            return bin;
+        }
+    }
+    return SCORE_BINS - 1u;
+}
+
+/*
+ * Offsets of every whole block in the mapping; a torn block at the end
+ * and anything after it are left out.
+ */
+static uint32_t index_blocks(const uint8_t *base, size_t size, uint64_t **blocks,
+                             uint32_t encodings[OUTCOME_COLUMN_COUNT][OUTCOME_ENCODING_COUNT])
+{
+    uint32_t count = 0u;
+    uint32_t capacity = 0u;
+    size_t offset = sizeof(outcome_file_header_t);
+
+    *blocks = NULL;
+    while (size - offset >= sizeof(outcome_block_header_t)) {
+        const outcome_block_header_t *block = (const void *)(base + offset);
+        if (!block_header_valid(block, size - offset)) {
+            break;
+        }
+        if (count == capacity) {
+            capacity = capacity == 0u ? 1024u : capacity * 2u;
+            uint64_t *grown = realloc(*blocks, capacity * sizeof **blocks);
+            if (grown == NULL) {
+                break;
+            }
+            *blocks = grown;
+        }
+        for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+            encodings[i][block->columns[i].encoding % OUTCOME_ENCODING_COUNT]++;
+        }
+        (*blocks)[count++] = offset;
+        offset += sizeof *block + block->payload_bytes;
+    }
+    return count;
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int outcome_query(const char *path, uint32_t threads, uint32_t min_score)
+{
+    static const char *const column_names[OUTCOME_COLUMN_COUNT] = {
+        "ended_at", "score", "level", "seed", "duration_ms", "delay_ms", "octave",
+    };
+    static query_worker_t workers[QUERY_MAX_THREADS];
+    pthread_t ids[QUERY_MAX_THREADS];
+    uint32_t encodings[OUTCOME_COLUMN_COUNT][OUTCOME_ENCODING_COUNT] = {{0u}};
+    uint32_t next_block = 0u;
+    struct stat info;
+    uint64_t *blocks;
+
+    threads = threads == 0u ? 1u : (threads > QUERY_MAX_THREADS ? QUERY_MAX_THREADS : threads);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        perror(path);
+        return 1;
+    }
+    const uint8_t *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((size_t)info.st_size < sizeof(outcome_file_header_t) || base == MAP_FAILED ||
+        memcmp(base, OUTCOME_MAGIC, 8u) != 0) {
+        fprintf(stderr, "%s: not an outcome store\n", path);
+        return 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t block_count = index_blocks(base, (size_t)info.st_size, &blocks, encodings);
+    uint32_t started = 0u;
+    for (; started < threads; ++started) {
+        workers[started] = (query_worker_t){.base = base, .blocks = blocks, .block_count = block_count,
+                                            .min_score = min_score, .next_block = &next_block};
+        if (pthread_create(&ids[started], NULL, query_worker_main, &workers[started]) != 0) {
+            break;
+        }
+    }
+    // Workers take blocks from a shared counter, so fewer threads only
+    // cost time; with none at all the query runs here.
+    uint32_t ran = started;
+    if (started == 0u) {
+        (void)query_worker_main(&workers[0]);
+        ran = 1u;
+    }
+
+    score_stats_t total;
+    memset(&total, 0, sizeof total);
+    uint64_t rows = 0u;
+    uint64_t pruned = 0u;
+    for (uint32_t i = 0u; i < ran; ++i) {
+        if (i < started) {
+            pthread_join(ids[i], NULL);
+        }
+        rows += workers[i].rows;
+        pruned += workers[i].pruned;
+        for (uint32_t bucket = 0u; bucket < DELAY_BUCKETS; ++bucket) {
+            total.games[bucket] += workers[i].stats.games[bucket];
+            total.score_total[bucket] += workers[i].stats.score_total[bucket];
+            if (workers[i].stats.score_max[bucket] > total.score_max[bucket]) {
+                total.score_max[bucket] = workers[i].stats.score_max[bucket];
+            }
+            for (uint32_t bin = 0u; bin < SCORE_BINS; ++bin) {
+                total.bins[bucket][bin] += workers[i].stats.bins[bucket][bin];
+            }
+        }
+    }
+    double elapsed = seconds_since(&start);
+
+    printf("%llu rows in %u blocks, %.2f bytes/row; %llu blocks pruned by score >= %u\n", (unsigned long long)rows,
+           block_count, rows > 0u ? (double)info.st_size / (double)rows : 0.0, (unsigned long long)pruned, min_score);
+    printf("scanned in %.3f s with %u threads: %.1f M rows/s\n\n", elapsed, ran,
+           elapsed > 0.0 ? (double)rows / elapsed / 1e6 : 0.0);
+    printf("%-12s %12s %8s %6s %6s %6s\n", "delay ms", "games", "mean", "p50", "p90", "max");
+    for (uint32_t bucket = 0u; bucket < DELAY_BUCKETS; ++bucket) {
+        uint64_t games = total.games[bucket];
+        char label[16];
+        if (games == 0u) {
+            continue;
+        }
+        if (bucket == DELAY_BUCKETS - 1u) {
+            snprintf(label, sizeof label, "%u+", bucket * DELAY_BUCKET_MS);
+        } else {
+            snprintf(label, sizeof label, "%u-%u", bucket * DELAY_BUCKET_MS, (bucket + 1u) * DELAY_BUCKET_MS - 1u);
+        }
+        // Percentiles come from the bins, so they read 64 for anything above.
+        printf("%-12s %12llu %8.2f %6u %6u %6u\n", label, (unsigned long long)games,
+               (double)total.score_total[bucket] / (double)games, bin_at(total.bins[bucket], games / 2u),
+               bin_at(total.bins[bucket], games * 9u / 10u), total.score_max[bucket]);
+    }
+
+    printf("\n%-12s %8s %8s %8s\n", "column", "FOR", "DELTA", "DICT");
+    for (size_t i = 0; i < OUTCOME_COLUMN_COUNT; ++i) {
+        printf("%-12s %8u %8u %8u\n", column_names[i], encodings[i][OUTCOME_ENCODING_FOR],
+               encodings[i][OUTCOME_ENCODING_DELTA], encodings[i][OUTCOME_ENCODING_DICT]);
+    }
+
+    free(blocks);
+    munmap((void *)base, (size_t)info.st_size);
+    return 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,117 @@
+#ifndef OUTCOME_H
+#define OUTCOME_H
+
+#if defined(__linux__)
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+/*
+ * Append-only columnar store of finished games. The file is a 16-byte
+ * header followed by self-contained blocks of up to OUTCOME_BLOCK_ROWS
+ * rows; every writer that opens the file appends whole blocks, so a file
+ * collects the output of many runs and a block cut short by a crash is
+ * simply where readers stop.
+ *
+ * Each block holds one descriptor per column and then the columns one
+ * after another. A column keeps the block's min and max, so a query can
+ * skip blocks its filter rules out without decoding them, and is stored
+ * in whichever of three encodings packs it smallest:
+ *
+ *   FOR    value - min, bit-packed at the width of max - min
+ *   DELTA  the first value, then zigzagged steps bit-packed at the width
+ *          of the largest; for the end time, which only creeps upward
+ *   DICT   up to OUTCOME_DICT_MAX distinct values bit-packed as above,
+ *          then an index per row bit-packed at the width of the count
+ *
+ * Bit-packed fields run little endian from bit 0 of the first byte, and
+ * every column is padded to a multiple of eight bytes with at least eight
+ * to spare, so decoders may load eight bytes at any field.
+ */
+#define OUTCOME_MAGIC       "SIMONOUT"
+#define OUTCOME_VERSION     1u
+#define OUTCOME_BLOCK_MAGIC 0x4B4C424Fu  // "OBLK"
+#define OUTCOME_BLOCK_ROWS  65536u
+#define OUTCOME_DICT_MAX    256u
+
+typedef enum {
+    OUTCOME_COLUMN_ENDED_AT = 0,  // unix seconds when the game ended
+    OUTCOME_COLUMN_SCORE,
+    OUTCOME_COLUMN_LEVEL,
+    OUTCOME_COLUMN_SEED,
+    OUTCOME_COLUMN_DURATION_MS,
+    OUTCOME_COLUMN_DELAY_MS,
+    OUTCOME_COLUMN_OCTAVE,       // signed
+    OUTCOME_COLUMN_COUNT
+} outcome_column_t;
+
+typedef enum {
+    OUTCOME_ENCODING_FOR = 0,
+    OUTCOME_ENCODING_DELTA,
+    OUTCOME_ENCODING_DICT,
+    OUTCOME_ENCODING_COUNT
+} outcome_encoding_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+} outcome_file_header_t;
+
+typedef struct {
+    uint8_t encoding;
+    uint8_t width;        // bits per value, or per dictionary entry
+    uint8_t index_width;  // DICT only: bits per row index
+    uint8_t reserved;
+    uint32_t dict_count;
+    int64_t min;
+    int64_t max;
+    int64_t base;         // FOR and DICT: min; DELTA: the first value
+    uint32_t offset;      // from the end of the block header
+    uint32_t bytes;
+} outcome_column_header_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t rows;
+    uint32_t payload_bytes;
+    uint32_t reserved;
+    outcome_column_header_t columns[OUTCOME_COLUMN_COUNT];
+} outcome_block_header_t;
+
+typedef struct {
+    FILE *file;
+    uint32_t rows;
+    uint32_t *columns[OUTCOME_COLUMN_COUNT];
+    uint8_t *payload;
+} outcome_writer_t;
+
+bool outcome_writer_open(outcome_writer_t *writer, const char *path);
+// Buffer one row; a full block is written out straight away.
+bool outcome_writer_append(outcome_writer_t *writer, const simon_outcome_t *outcome, uint32_t ended_at);
+// Write out the buffered rows, if any, as a block of their own.
+bool outcome_writer_flush(outcome_writer_t *writer);
+void outcome_writer_close(outcome_writer_t *writer);
+// simon_outcome_fn adapter stamping the wall clock; `user` is the writer.
+void outcome_writer_sink(void *user, const simon_outcome_t *outcome);
+/*
+ * Decode one column of `block`, whose payload follows it in memory, into
+ * `out`. Both `out` and `scratch` hold a value per row of the block.
+ */
+void outcome_decode_column(const outcome_block_header_t *block, outcome_column_t column, uint32_t *out,
+                           uint32_t *scratch);
+
+// Write `rows` synthetic outcomes, for sizing and query benchmarks.
+int outcome_generate(const char *path, uint64_t rows);
+/*
+ * Score distribution per playback delay bucket over every game scoring
+ * at least `min_score`, scanned by `threads` threads.
+ */
+int outcome_query(const char *path, uint32_t threads, uint32_t min_score);
+
+#endif /* __linux__ */
+
+#endif /* OUTCOME_H */
@@ -0,0 +1,133 @@
+#if !defined(__AVR__)
+
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static simon_pool_slot_t *slot_for(const simon_pool_t *pool, uint32_t index)
+{
+    return &pool->slots[index >> SIMON_POOL_SLAB_BITS][index & (SIMON_POOL_SLAB_GAMES - 1u)];
+}
+
+static simon_game_t *game_for(const simon_pool_t *pool, uint32_t index)
+{
+    return &pool->hot[index >> SIMON_POOL_SLAB_BITS][index & (SIMON_POOL_SLAB_GAMES - 1u)];
+}
+
+static simon_game_cold_t *cold_for(const simon_pool_t *pool, uint32_t index)
+{
+    return &pool->cold[index >> SIMON_POOL_SLAB_BITS][index & (SIMON_POOL_SLAB_GAMES - 1u)];
+}
+
+static bool add_slab(simon_pool_t *pool)
+{
+    if (pool->slab_count >= SIMON_POOL_MAX_SLABS) {
+        return false;
+    }
+
+    uint32_t slab = pool->slab_count;
+    pool->hot[slab] = aligned_alloc(SIMON_CACHE_LINE, SIMON_POOL_SLAB_GAMES * sizeof(simon_game_t));
+    pool->cold[slab] = malloc(SIMON_POOL_SLAB_GAMES * sizeof(simon_game_cold_t));
+    pool->slots[slab] = calloc(SIMON_POOL_SLAB_GAMES, sizeof(simon_pool_slot_t));
+
+    if (pool->hot[slab] == NULL || pool->cold[slab] == NULL || pool->slots[slab] == NULL) {
+        free(pool->hot[slab]);
+        free(pool->cold[slab]);
+        free(pool->slots[slab]);
+        return false;
+    }
+
+    pool->slab_count++;
+    return true;
+}
+
+void simon_pool_init(simon_pool_t *pool)
+{
+    memset(pool, 0, sizeof *pool);
+    pool->free_head = SIMON_POOL_NO_SLOT;
+}
+
+void simon_pool_destroy(simon_pool_t *pool)
+{
+    for (uint32_t index = 0u; index < pool->high_water; ++index) {
+        if (slot_for(pool, index)->initialised) {
+            game_shutdown(game_for(pool, index));
+        }
+    }
+
+    for (uint32_t slab = 0u; slab < pool->slab_count; ++slab) {
+        free(pool->hot[slab]);
+        free(pool->cold[slab]);
+        free(pool->slots[slab]);
+    }
+    simon_pool_init(pool);
+}
+
+simon_pool_handle_t simon_pool_acquire(simon_pool_t *pool, timer_wheel_t *wheel, bool fresh_cold)
+{
+    uint32_t index;
+
+    if (pool->free_head != SIMON_POOL_NO_SLOT) {
+        index = pool->free_head;
+        pool->free_head = slot_for(pool, index)->next_free;
+    } else {
+        if (pool->high_water >= SIMON_POOL_MAX_GAMES) {
+            return SIMON_POOL_INVALID;
+        }
+        if ((pool->high_water >> SIMON_POOL_SLAB_BITS) >= pool->slab_count && !add_slab(pool)) {
+            return SIMON_POOL_INVALID;
+        }
+        index = pool->high_water++;
+    }
+
+    simon_pool_slot_t *slot = slot_for(pool, index);
+    simon_game_t *game = game_for(pool, index);
+
+    if (!slot->initialised) {
+        game_init(game, cold_for(pool, index), wheel);
+        slot->initialised = true;
+    } else {
+        game_recycle(game, wheel, fresh_cold);
+    }
+
+    slot->live = true;
+    pool->live++;
+    return ((uint64_t)slot->generation << 32u) | index;
+}
+
+void simon_pool_release(simon_pool_t *pool, simon_pool_handle_t handle)
+{
+    if (simon_pool_get(pool, handle) == NULL) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)handle;
+    simon_pool_slot_t *slot = slot_for(pool, index);
+
+    // Only the pending deadline is dropped; the next acquire recycles the rest.
+    simon_game_t *game = game_for(pool, index);
+    timer_wheel_cancel(game->wheel, &game->timer);
+    slot->live = false;
+    slot->generation++;
+    slot->next_free = pool->free_head;
+    pool->free_head = index;
+    pool->live--;
+}
+
+simon_game_t *simon_pool_get(const simon_pool_t *pool, simon_pool_handle_t handle)
+{
+    uint32_t index = (uint32_t)handle;
+
+    if (handle == SIMON_POOL_INVALID || index >= pool->high_water) {
+        return NULL;
+    }
+
+    const simon_pool_slot_t *slot = slot_for(pool, index);
+    if (!slot->live || slot->generation != (uint32_t)(handle >> 32u)) {
+        return NULL;
+    }
+    return game_for(pool, index);
+}
+
+#endif /* !__AVR__ */
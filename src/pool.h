@@ -0,0 +1,58 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define SIMON_POOL_SLAB_BITS     10u
+#define SIMON_POOL_SLAB_GAMES    (1u << SIMON_POOL_SLAB_BITS)
+#define SIMON_POOL_MAX_SLABS     4096u
+#define SIMON_POOL_MAX_GAMES     (SIMON_POOL_SLAB_GAMES * SIMON_POOL_MAX_SLABS)
+#define SIMON_POOL_INVALID       UINT64_MAX
+#define SIMON_POOL_NO_SLOT       UINT32_MAX  // ends the free list
+
+/*
+ * Handles pack the slot index in the low 32 bits and the slot's generation
+ * in the high 32, so a handle kept after release stops resolving once the
+ * slot is reused. A stale handle only aliases after 2^32 reuses of its
+ * slot.
+ */
+typedef uint64_t simon_pool_handle_t;
+
+typedef struct {
+    uint32_t next_free;
+    uint32_t generation;
+    bool live;
+    bool initialised;
+} simon_pool_slot_t;
+
+/*
+ * Slab allocator for games. Hot state lives in cache-line aligned arrays,
+ * cold state in parallel arrays of its own, so ticking a fleet walks only
+ * the hot slabs. Slabs are never moved or freed while the pool exists,
+ * which keeps game pointers stable.
+ */
+typedef struct {
+    simon_game_t *hot[SIMON_POOL_MAX_SLABS];
+    simon_game_cold_t *cold[SIMON_POOL_MAX_SLABS];
+    simon_pool_slot_t *slots[SIMON_POOL_MAX_SLABS];
+    uint32_t slab_count;
+    uint32_t high_water;
+    uint32_t free_head;
+    uint32_t live;
+} simon_pool_t;
+
+void simon_pool_init(simon_pool_t *pool);
+void simon_pool_destroy(simon_pool_t *pool);
+/*
+ * A slot's first game is set up with game_init; after that a released
+ * game is handed on through game_recycle, which keeps its sequence buffer
+ * and, unless `fresh_cold`, the cold part's leaderboard and sketches.
+ */
+simon_pool_handle_t simon_pool_acquire(simon_pool_t *pool, timer_wheel_t *wheel, bool fresh_cold);
+void simon_pool_release(simon_pool_t *pool, simon_pool_handle_t handle);
+simon_game_t *simon_pool_get(const simon_pool_t *pool, simon_pool_handle_t handle);
+
+#endif /* POOL_H */
@@ -0,0 +1,292 @@
+#include "power.h"
+
+#if defined(__AVR__)
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+// The RTC runs at 1.024 kHz, so one count is 0.977 ms.
+#define RTC_HZ 1024u
+
+// Fractions of a millisecond slept, in 1/RTC_HZ ms, carried to the next
+// sleep so the game clock does not drift behind the RTC.
+static uint32_t residue;
+
+void power_init(void)
+{
+    // The internal ULP oscillator, kept running in STANDBY.
+    while (RTC.STATUS != 0u) {
+    }
+    RTC.CLKSEL = RTC_CLKSEL_INT1K_gc;
+    RTC.CTRLA = RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+
+    // A start bit on the UART wakes the part out of STANDBY.
+    USART0.CTRLB |= USART_SFDEN_bm;
+    USART0.CTRLA |= USART_RXSIE_bm;
+}
+
+ISR(RTC_CNT_vect)
+{
+    RTC.INTFLAGS = RTC_CMP_bm;
+}
+
+ISR(USART0_RXC_vect)
+{
+    // Only the start-of-frame interrupt is enabled; the byte itself is
+    // left for the console to read.
+    USART0.STATUS = USART_RXSIF_bm;
+}
+
+static uint32_t sleep_ms(uint32_t ms)
+{
+    // Round down, so the wake lands on or before the deadline.
+    uint16_t counts = (uint16_t)(ms * RTC_HZ / 1000u);
+    // A byte already waiting would not raise another start-of-frame wake.
+    if (counts == 0u || (USART0.STATUS & USART_RXCIF_bm) != 0u) {
+        return 0u;
+    }
+
+    while (RTC.STATUS != 0u) {
+    }
+    RTC.CNT = 0u;
+    RTC.CMP = counts;
+    RTC.INTFLAGS = RTC_CMP_bm;
+    RTC.INTCTRL = RTC_CMP_bm;
+
+    set_sleep_mode(SLEEP_MODE_STANDBY);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+
+    RTC.INTCTRL = 0u;
+    uint16_t slept = RTC.CNT;
+    if (slept > counts) {
+        slept = counts;
+    }
+
+    uint32_t scaled = (uint32_t)slept * 1000u + residue;
+    residue = scaled % RTC_HZ;
+    return scaled / RTC_HZ;
+}
+
+static void record_wakeup(uint8_t state, uint32_t slept)
+{
+    (void)state;
+    (void)slept;
+}
+
+#else
+
+#include <stdio.h>
+
+static power_stats_t stats;
+
+void power_init(void)
+{
+    power_reset_stats();
+}
+
+static uint32_t sleep_ms(uint32_t ms)
+{
+    // Virtual time: the caller's limit stands in for the next interrupt.
+    return ms;
+}
+
+static void record_wakeup(uint8_t state, uint32_t slept)
+{
+    if (state < SIMON_STATE_COUNT) {
+        stats.wakeups[state]++;
+        stats.elapsed_ms[state] += (uint64_t)slept + 1u;
+    }
+}
+
+const power_stats_t *power_get_stats(void)
+{
+    return &stats;
+}
+
+void power_reset_stats(void)
+{
+    for (uint8_t i = 0u; i < SIMON_STATE_COUNT; ++i) {
+        stats.elapsed_ms[i] = 0u;
+        stats.wakeups[i] = 0u;
+    }
+}
+
+#endif /* __AVR__ */
+
+uint32_t power_idle(simon_game_t *game, input_conditioner_t *input, uint8_t raw_buttons, uint32_t limit_ms)
+{
+    uint8_t state = game->state;
+    uint32_t next = input_is_idle(input, raw_buttons) ? game_next_wakeup(game) : 1u;
+    // The tick at `next` has work; everything before it can be slept.
+    uint32_t sleep = next - 1u;
+    uint32_t slept = 0u;
+
+    if (sleep > limit_ms) {
+        sleep = limit_ms;
+    }
+    if (sleep > POWER_MAX_SLEEP_MS) {
+        sleep = POWER_MAX_SLEEP_MS;
+    }
+
+    if (sleep > 0u) {
+        slept = sleep_ms(sleep);
+        game_advance_ms(game, slept);
+        input_skip_ms(input, slept);
+    }
+
+    record_wakeup(state, slept);
+    return slept;
+}
+
+#if !defined(__AVR__)
+
+#define SIM_IDLE_MIN_MS      10000u
+#define SIM_IDLE_SPAN_MS     50000u
+#define SIM_REACTION_MIN_MS  300u
+#define SIM_REACTION_SPAN_MS 600u
+#define SIM_HOLD_MIN_MS      80u
+#define SIM_HOLD_SPAN_MS     120u
+#define SIM_NO_ACTION        UINT64_MAX
+#define MS_PER_HOUR          3600000ull
+
+static const char *const state_names[SIMON_STATE_COUNT] = {
+    "attract", "playback", "wait input", "level complete", "failure", "name entry",
+};
+
+typedef struct {
+    uint32_t rng;
+    uint64_t next_action;
+    uint8_t raw_buttons;
+    uint8_t held_button;
+} sim_player_t;
+
+static uint32_t sim_random(sim_player_t *player, uint32_t span)
+{
+    player->rng = player->rng * 1103515245u + 12345u;
+    return (player->rng >> 8) % span;
+}
+
+/*
+ * The player starts a game after a long idle spell, then answers each
+ * step after a human reaction time, slipping more often as the sequence
+ * grows. They never type a name, so the name prompt times out.
+ */
+static void plan_next_action(sim_player_t *player, const simon_game_t *game, uint64_t now)
+{
+    if (player->raw_buttons != 0u || player->next_action != SIM_NO_ACTION) {
+        return;
+    }
+
+    switch ((simon_state_t)game->state) {
+    case SIMON_STATE_ATTRACT:
+        player->held_button = (uint8_t)sim_random(player, SIMON_BUTTON_COUNT);
+        player->next_action = now + SIM_IDLE_MIN_MS + sim_random(player, SIM_IDLE_SPAN_MS);
+        break;
+
+    case SIMON_STATE_WAIT_INPUT: {
+        uint8_t expected = sequence_get(&game->sequence, game->input_step);
+        bool slip = sim_random(player, 24u) < game->level;
+        player->held_button = slip ? (uint8_t)((expected + 1u) % SIMON_BUTTON_COUNT) : expected;
+        player->next_action = now + SIM_REACTION_MIN_MS + sim_random(player, SIM_REACTION_SPAN_MS);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+static void run_player_edge(sim_player_t *player, uint64_t now)
+{
+    if (player->raw_buttons == 0u) {
+        player->raw_buttons = (uint8_t)(1u << player->held_button);
+        player->next_action = now + SIM_HOLD_MIN_MS + sim_random(player, SIM_HOLD_SPAN_MS);
+    } else {
+        player->raw_buttons = 0u;
+        player->next_action = SIM_NO_ACTION;
+    }
+}
+
+static void print_report(uint32_t hours)
+{
+    uint64_t total_ms = 0u;
+    uint64_t total_wakeups = 0u;
+
+    printf("%-15s %10s %14s %14s %8s\n", "state", "share", "1 ms tick/h", "tickless/h", "saving");
+    for (uint8_t i = 0u; i < SIMON_STATE_COUNT; ++i) {
+        uint64_t elapsed = stats.elapsed_ms[i];
+        total_ms += elapsed;
+        total_wakeups += stats.wakeups[i];
+        if (elapsed == 0u) {
+            continue;
+        }
+        // Ticking every millisecond wakes once per millisecond spent.
+        double tickless_per_hour = (double)stats.wakeups[i] * MS_PER_HOUR / (double)elapsed;
+        printf("%-15s %9.1f%% %14llu %14.0f %7.1fx\n", state_names[i], 100.0 * (double)elapsed / (hours * MS_PER_HOUR),
+               MS_PER_HOUR, tickless_per_hour, (double)MS_PER_HOUR / tickless_per_hour);
+    }
+
+    double per_hour = (double)total_wakeups * MS_PER_HOUR / (double)total_ms;
+    printf("%-15s %9.1f%% %14llu %14.0f %7.1fx\n", "overall", 100.0 * (double)total_ms / (hours * MS_PER_HOUR),
+           MS_PER_HOUR, per_hour, (double)MS_PER_HOUR / per_hour);
+}
+
+int power_simulate(uint32_t hours)
+{
+    static simon_game_cold_t cold;
+    static timer_wheel_t wheel;
+    static simon_game_t game;
+    hardware_context_t context;
+    input_conditioner_t input;
+    sim_player_t player = {.rng = 0x5EEDu, .next_action = SIM_NO_ACTION};
+    uint64_t end = (uint64_t)hours * MS_PER_HOUR;
+    uint64_t now = 0u;
+    uint32_t games = 0u;
+
+    // Nobody is watching the console, so skip formatting altogether.
+    hardware_context_init(&context, NULL, NULL);
+    hardware_bind_context(&context);
+    timer_wheel_init(&wheel);
+    game_init(&game, &cold, &wheel);
+    input_init(&input);
+    power_reset_stats();
+
+    while (now < end) {
+        uint64_t until_action = player.next_action - now;
+        uint64_t until_end = end - now - 1u;
+        uint64_t limit = until_action < until_end ? until_action : until_end;
+
+        now += power_idle(&game, &input, player.raw_buttons, limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit);
+
+        // The interrupt that ended the sleep, if it was the player.
+        if (now == player.next_action) {
+            run_player_edge(&player, now);
+        }
+
+        // The tick the main loop runs on every wakeup.
+        uint8_t state = game.state;
+        board_event_t event;
+        game_tick_1ms(&game);
+        input_tick_1ms(&input, player.raw_buttons);
+        while (input_poll(&input, &event)) {
+            game_handle_event(&game, &event);
+        }
+        if (state == SIMON_STATE_ATTRACT && game.state != SIMON_STATE_ATTRACT) {
+            games++;
+        }
+        now++;
+
+        plan_next_action(&player, &game, now);
+    }
+
+    hardware_bind_context(NULL);
+    printf("%u simulated hours, %u games\n", hours, games);
+    print_report(hours);
+    return 0;
+}
+
+#endif /* !__AVR__ */
@@ -0,0 +1,51 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+#include "game.h"
+#include "input.h"
+
+/*
+ * Tickless idle. The main loop normally wakes every millisecond, but in
+ * most states neither the game's wheel nor the debouncer has anything to
+ * do on most of those ticks. power_idle sleeps through them: until the
+ * next deadline, or until a button or UART interrupt, whichever comes
+ * first. Then it catches the game and the input stage up so that the
+ * caller's next tick is the one that has work.
+ *
+ * On the board the sleep is STANDBY with the RTC as the wake timer. Host
+ * builds sleep in virtual time and count wakeups per game state instead,
+ * so the saving can be measured without hardware.
+ */
+#define POWER_MAX_SLEEP_MS 60000u
+
+void power_init(void);
+
+/*
+ * Sleep before the next tick. `limit_ms` caps the sleep; on the board
+ * interrupts end it early as well. Returns the milliseconds slept, which
+ * have already been applied to `game` and `input`.
+ */
+uint32_t power_idle(simon_game_t *game, input_conditioner_t *input, uint8_t raw_buttons, uint32_t limit_ms);
+
+#if !defined(__AVR__)
+
+typedef struct {
+    uint64_t elapsed_ms[SIMON_STATE_COUNT];
+    uint64_t wakeups[SIMON_STATE_COUNT];
+} power_stats_t;
+
+const power_stats_t *power_get_stats(void);
+void power_reset_stats(void);
+
+/*
+ * Play `hours` of simulated time against a scripted player that leaves
+ * the board idle between games, and report wakeups per simulated hour in
+ * each state for a 1 ms tick against tickless idle.
+ */
+int power_simulate(uint32_t hours);
+
+#endif /* !__AVR__ */
+
+#endif /* POWER_H */
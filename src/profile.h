@@ -0,0 +1,47 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+/*
+ * Tick profiler markers for the QUTy build under simavr. With
+ * SIMON_TICK_PROFILE defined, instrumented paths write their id to GPIOR0
+ * on entry and id | PROFILE_EXIT on exit, and every state change writes
+ * the new state to GPIOR1. simavr traces both registers into a VCD, and
+ * scripts/tick_profile.py turns the edges into cycle counts per function
+ * and per tick. Each marker is a single OUT instruction; builds without
+ * the flag compile them away.
+ */
+#define PROFILE_EXIT 0x80u
+
+typedef enum {
+    PROFILE_TICK = 1,       // one pass of the main loop
+    PROFILE_GAME_TICK,      // game_tick_1ms
+    PROFILE_GAME_TIMER,     // on_game_timer
+    PROFILE_EVENT,          // game_handle_event
+    PROFILE_UART_CHAR,      // game_handle_uart_char
+    PROFILE_HIGHSCORE,      // finalise_pending_highscore
+    PROFILE_SEED,           // apply_seed_from_buffer
+    PROFILE_JOURNAL,        // journal_record_insert
+    PROFILE_INPUT,          // input_tick_1ms and delivery of its events
+    PROFILE_DISPLAY,        // hardware_task_display
+    PROFILE_DONE = 0x7F     // stimulus script finished
+} profile_marker_t;
+
+#if defined(__AVR__) && defined(SIMON_TICK_PROFILE)
+
+#include <avr/io.h>
+
+#define PROFILE_ENTER(marker) (GPIOR0 = (uint8_t)(marker))
+#define PROFILE_LEAVE(marker) (GPIOR0 = (uint8_t)((marker) | PROFILE_EXIT))
+#define PROFILE_STATE(state)  (GPIOR1 = (uint8_t)(state))
+
+#else
+
+#define PROFILE_ENTER(marker) ((void)0)
+#define PROFILE_LEAVE(marker) ((void)0)
+#define PROFILE_STATE(state)  ((void)0)
+
+#endif
+
+#endif /* PROFILE_H */
@@ -0,0 +1,435 @@
+#include "protocol.h"
+#include "hardware.h"
+
+#include <string.h>
+
+#define STATUS_RECORD_LENGTH 17u
+#define INPUT_RECORD_LENGTH  21u
+
+typedef struct {
+    uint8_t bytes[PROTOCOL_MAX_PAYLOAD];
+    uint16_t length;
+} reply_t;
+
+uint16_t protocol_crc16(uint16_t crc, uint8_t value)
+{
+    crc ^= (uint16_t)((uint16_t)value << 8u);
+    for (uint8_t bit = 0u; bit < 8u; ++bit) {
+        if ((crc & 0x8000u) != 0u) {
+            crc = (uint16_t)((crc << 1u) ^ 0x1021u);
+        } else {
+            crc = (uint16_t)(crc << 1u);
+        }
+    }
+    return crc;
+}
+
+static bool reply_has_room(const reply_t *reply, uint16_t count)
+{
+    return reply->length + count <= PROTOCOL_MAX_PAYLOAD;
+}
+
+static void reply_u8(reply_t *reply, uint8_t value)
+{
+    reply->bytes[reply->length++] = value;
+}
+
+static void reply_u16(reply_t *reply, uint16_t value)
+{
+    reply_u8(reply, (uint8_t)(value >> 8u));
+    reply_u8(reply, (uint8_t)value);
+}
+
+static void reply_u32(reply_t *reply, uint32_t value)
+{
+    reply_u16(reply, (uint16_t)(value >> 16u));
+    reply_u16(reply, (uint16_t)value);
+}
+
+static void reply_error(reply_t *reply, uint8_t code)
+{
+    // Leave the last two bytes free so an error always fits.
+    if (reply->length + 2u > PROTOCOL_MAX_PAYLOAD) {
+        reply->length = PROTOCOL_MAX_PAYLOAD - 2u;
+    }
+    reply_u8(reply, PROTOCOL_REPLY_ERROR);
+    reply_u8(reply, code);
+}
+
+void protocol_send_frame(const uint8_t *payload, uint16_t length)
+{
+    uint16_t crc = protocol_crc16(0xFFFFu, (uint8_t)length);
+    for (uint16_t i = 0u; i < length; ++i) {
+        crc = protocol_crc16(crc, payload[i]);
+    }
+
+    hardware_uart_write_char((char)PROTOCOL_SOF);
+    hardware_uart_write_char((char)length);
+    for (uint16_t i = 0u; i < length; ++i) {
+        hardware_uart_write_char((char)payload[i]);
+    }
+    hardware_uart_write_char((char)(crc >> 8u));
+    hardware_uart_write_char((char)crc);
+}
+
+static bool reply_status(reply_t *reply, const simon_game_t *game)
+{
+    if (!reply_has_room(reply, STATUS_RECORD_LENGTH + 2u)) {
+        return false;
+    }
+    reply_u8(reply, PROTOCOL_CMD_STATUS | PROTOCOL_REPLY_FLAG);
+    reply_u32(reply, game->cold->score);
+    reply_u32(reply, game->cold->best_score);
+    reply_u16(reply, game->playback_delay_ms);
+    reply_u32(reply, game->level);
+    reply_u8(reply, (uint8_t)game->state);
+    reply_u8(reply, (uint8_t)game->cold->octave_shift);
+    return true;
+}
+
+static bool reply_input_stats(reply_t *reply, const input_stats_t *stats)
+{
+    if (!reply_has_room(reply, INPUT_RECORD_LENGTH + 2u)) {
+        return false;
+    }
+    reply_u8(reply, PROTOCOL_CMD_INPUT_STATS | PROTOCOL_REPLY_FLAG);
+    reply_u32(reply, stats->raw_buttons);
+    reply_u32(reply, stats->delivered_buttons);
+    reply_u32(reply, stats->raw_pot);
+    reply_u32(reply, stats->delivered_pot);
+    reply_u32(reply, stats->dropped);
+    return true;
+}
+
+static bool reply_highscores(reply_t *reply, const simon_game_t *game)
+{
+#if defined(__AVR__)
+    const simon_highscore_table_t *table = &game->cold->highscores;
+#else
+    // One copy for sizing and writing, so both see the same table even if
+    // the reply is built off the game's thread.
+    simon_highscore_table_t copy;
+    (void)game_read_highscores(game, &copy);
+    const simon_highscore_table_t *table = &copy;
+#endif
+    uint16_t needed = 2u;
+    for (size_t i = 0; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        needed += 5u + (uint16_t)strlen(table->entries[i].name);
+    }
+    if (!reply_has_room(reply, needed + 2u)) {
+        return false;
+    }
+
+    reply_u8(reply, PROTOCOL_CMD_HIGHSCORES | PROTOCOL_REPLY_FLAG);
+    reply_u8(reply, SIMON_HIGHSCORE_ENTRIES);
+    for (size_t i = 0; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        const simon_highscore_entry_t *entry = &table->entries[i];
+        uint8_t name_length = (uint8_t)strlen(entry->name);
+        reply_u32(reply, entry->score);
+        reply_u8(reply, name_length);
+        memcpy(&reply->bytes[reply->length], entry->name, name_length);
+        reply->length += name_length;
+    }
+    return true;
+}
+
+static const uint8_t *frame_payload(const simon_protocol_t *protocol)
+{
+    return &protocol->frame[1];
+}
+
+static void execute_frame(const simon_protocol_t *protocol, simon_game_t *game)
+{
+    const uint8_t *payload = frame_payload(protocol);
+    reply_t reply = {.length = 0u};
+    uint8_t pos = 0u;
+
+    while (pos < protocol->length) {
+        uint8_t command = payload[pos++];
+        bool ok = true;
+        bool acknowledge = true;
+
+        switch (command) {
+        case PROTOCOL_CMD_STATUS:
+            ok = reply_status(&reply, game);
+            acknowledge = false;
+            break;
+
+        case PROTOCOL_CMD_START:
+            game_start(game);
+            break;
+
+        case PROTOCOL_CMD_RESET:
+            game_reset(game);
+            break;
+
+        case PROTOCOL_CMD_HIGHSCORES:
+            ok = reply_highscores(&reply, game);
+            acknowledge = false;
+            break;
+
+        case PROTOCOL_CMD_OCTAVE_UP:
+            game_handle_uart_char(game, '+');
+            break;
+
+        case PROTOCOL_CMD_OCTAVE_DOWN:
+            game_handle_uart_char(game, '-');
+            break;
+
+        case PROTOCOL_CMD_BUTTON:
+            if (pos + 1u > protocol->length) {
+                reply_error(&reply, PROTOCOL_ERROR_TRUNCATED);
+                protocol_send_frame(reply.bytes, reply.length);
+                return;
+            }
+            game_handle_button(game, (uint8_t)(1u << (payload[pos++] & 0x07u)));
+            break;
+
+        case PROTOCOL_CMD_POT:
+            if (pos + 2u > protocol->length) {
+                reply_error(&reply, PROTOCOL_ERROR_TRUNCATED);
+                protocol_send_frame(reply.bytes, reply.length);
+                return;
+            }
+            game_update_playback_delay(
+                game,
+                (uint16_t)(((uint16_t)payload[pos] << 8u) | payload[pos + 1u]));
+            pos += 2u;
+            break;
+
+        case PROTOCOL_CMD_ECHO:
+            if (pos + 1u > protocol->length) {
+                reply_error(&reply, PROTOCOL_ERROR_TRUNCATED);
+                protocol_send_frame(reply.bytes, reply.length);
+                return;
+            }
+            if (!reply_has_room(&reply, 4u)) {
+                ok = false;
+                break;
+            }
+            reply_u8(&reply, command | PROTOCOL_REPLY_FLAG);
+            reply_u8(&reply, payload[pos++]);
+            acknowledge = false;
+            break;
+
+        case PROTOCOL_CMD_INPUT_STATS:
+            if (protocol->input == NULL) {
+                reply_error(&reply, PROTOCOL_ERROR_UNKNOWN);
+                protocol_send_frame(reply.bytes, reply.length);
+                return;
+            }
+            ok = reply_input_stats(&reply, input_get_stats(protocol->input));
+            acknowledge = false;
+            break;
+
+        default:
+            reply_error(&reply, PROTOCOL_ERROR_UNKNOWN);
+            protocol_send_frame(reply.bytes, reply.length);
+            return;
+        }
+
+        if (!ok) {
+            reply_error(&reply, PROTOCOL_ERROR_OVERFLOW);
+            break;
+        }
+
+        // Actions are acknowledged with their opcode; queries already wrote
+        // their record above.
+        if (acknowledge) {
+            if (!reply_has_room(&reply, 3u)) {
+                reply_error(&reply, PROTOCOL_ERROR_OVERFLOW);
+                break;
+            }
+            reply_u8(&reply, command | PROTOCOL_REPLY_FLAG);
+        }
+    }
+
+    protocol_send_frame(reply.bytes, reply.length);
+}
+
+void protocol_init(simon_protocol_t *protocol)
+{
+    protocol->phase = PROTOCOL_PHASE_IDLE;
+    protocol->length = 0u;
+    protocol->received = 0u;
+    protocol->crc = 0xFFFFu;
+    protocol->expected_crc = 0u;
+    protocol->last_byte_ms = 0u;
+    protocol->frames_ok = 0u;
+    protocol->frames_bad = 0u;
+    protocol->frames_timed_out = 0u;
+    protocol->bytes_dropped = 0u;
+    protocol->on_reply = NULL;
+    protocol->reply_user = NULL;
+    protocol->input = NULL;
+    protocol->frame_bytes = 0u;
+}
+
+void protocol_attach_input(simon_protocol_t *protocol, const input_conditioner_t *input)
+{
+    protocol->input = input;
+}
+
+void protocol_set_link(simon_protocol_t *protocol, protocol_reply_fn on_reply, void *user)
+{
+    protocol->on_reply = on_reply;
+    protocol->reply_user = user;
+}
+
+static bool is_reply(const simon_protocol_t *protocol)
+{
+    const uint8_t *payload = frame_payload(protocol);
+    return protocol->length == 0u || (payload[0] & PROTOCOL_REPLY_FLAG) != 0u || payload[0] == PROTOCOL_REPLY_ERROR;
+}
+
+typedef enum {
+    FRAME_PENDING = 0,
+    FRAME_DONE,
+    FRAME_BAD
+} frame_result_t;
+
+static void start_frame(simon_protocol_t *protocol)
+{
+    protocol->phase = PROTOCOL_PHASE_LENGTH;
+    protocol->crc = 0xFFFFu;
+    protocol->frame_bytes = 0u;
+}
+
+// Take the next byte of the frame after its SOF, running the frame once whole.
+static frame_result_t frame_byte(simon_protocol_t *protocol, simon_game_t *game, uint8_t value)
+{
+    protocol->frame[protocol->frame_bytes++] = value;
+
+    switch (protocol->phase) {
+    case PROTOCOL_PHASE_LENGTH:
+        protocol->length = value;
+        protocol->received = 0u;
+        protocol->crc = protocol_crc16(protocol->crc, value);
+        protocol->phase = (value == 0u) ? PROTOCOL_PHASE_CRC_HIGH : PROTOCOL_PHASE_PAYLOAD;
+        break;
+
+    case PROTOCOL_PHASE_PAYLOAD:
+        protocol->received++;
+        protocol->crc = protocol_crc16(protocol->crc, value);
+        if (protocol->received >= protocol->length) {
+            protocol->phase = PROTOCOL_PHASE_CRC_HIGH;
+        }
+        break;
+
+    case PROTOCOL_PHASE_CRC_HIGH:
+        protocol->expected_crc = (uint16_t)((uint16_t)value << 8u);
+        protocol->phase = PROTOCOL_PHASE_CRC_LOW;
+        break;
+
+    case PROTOCOL_PHASE_CRC_LOW:
+        protocol->expected_crc |= value;
+        protocol->phase = PROTOCOL_PHASE_IDLE;
+        if (protocol->expected_crc != protocol->crc) {
+            return FRAME_BAD;
+        }
+        protocol->frames_ok++;
+        if (protocol->on_reply != NULL && is_reply(protocol)) {
+            protocol->on_reply(protocol->reply_user, frame_payload(protocol), protocol->length);
+        } else {
+            execute_frame(protocol, game);
+        }
+        return FRAME_DONE;
+
+    case PROTOCOL_PHASE_IDLE:
+        break;
+    }
+
+    return FRAME_PENDING;
+}
+
+/*
+ * The frame just taken failed its CRC: its SOF was noise, or it lost a
+ * byte and ran on into the next frame. Parse again from the next SOF among
+ * its bytes. Those skipped on the way are dropped, never run as ASCII
+ * commands, and frames that fail here are not NAKed again.
+ *
+ * The bytes are rescanned in place; a new attempt writes its own bytes
+ * from the start of the buffer, always behind the one being read.
+ */
+static void resync(simon_protocol_t *protocol, simon_game_t *game)
+{
+    uint16_t pending = protocol->frame_bytes;
+    uint16_t next = 0u;
+
+    protocol->phase = PROTOCOL_PHASE_IDLE;
+    protocol->frame_bytes = 0u;
+
+    while (next < pending) {
+        if (protocol->frame[next++] != PROTOCOL_SOF) {
+            protocol->bytes_dropped++;
+            continue;
+        }
+
+        frame_result_t result = FRAME_PENDING;
+        start_frame(protocol);
+        while (next < pending && result == FRAME_PENDING) {
+            result = frame_byte(protocol, game, protocol->frame[next]);
+            next++;
+        }
+
+        if (result == FRAME_BAD) {
+            // Rescan what this attempt took, then what it had not reached.
+            uint16_t taken = protocol->frame_bytes;
+            memmove(&protocol->frame[taken], &protocol->frame[next], (size_t)(pending - next));
+            pending = (uint16_t)(taken + pending - next);
+            next = 0u;
+            protocol->frame_bytes = 0u;
+        }
+    }
+}
+
+void protocol_handle_uart_byte(simon_protocol_t *protocol, simon_game_t *game, uint8_t value)
+{
+    uint32_t now = game->wheel->now;
+
+    if (protocol->phase != PROTOCOL_PHASE_IDLE && now - protocol->last_byte_ms > PROTOCOL_BYTE_TIMEOUT_MS) {
+        // The rest of that frame is not coming; start over with this byte.
+        protocol->frames_timed_out++;
+        protocol->bytes_dropped += 1u + protocol->frame_bytes;
+        protocol->phase = PROTOCOL_PHASE_IDLE;
+    }
+    protocol->last_byte_ms = now;
+
+    if (protocol->phase != PROTOCOL_PHASE_IDLE) {
+        if (frame_byte(protocol, game, value) == FRAME_BAD) {
+            protocol->frames_bad++;
+            if (protocol->on_reply == NULL) {
+                uint8_t nak[2] = {PROTOCOL_REPLY_ERROR, PROTOCOL_ERROR_CRC};
+                protocol_send_frame(nak, sizeof nak);
+            }
+            resync(protocol, game);
+        }
+    } else if (value == PROTOCOL_SOF) {
+        start_frame(protocol);
+    } else if (protocol->on_reply != NULL) {
+        protocol->bytes_dropped++;
+    } else {
+        game_handle_uart_char(game, (char)value);
+    }
+}
+
+void protocol_handle_event(simon_protocol_t *protocol, simon_game_t *game, const board_event_t *event)
+{
+    // UART traffic goes through the frame parser first; anything outside a
+    // frame falls through to the ASCII command handler.
+    switch (event->type) {
+    case BOARD_EVENT_COMMAND:
+        protocol_handle_uart_byte(protocol, game, (uint8_t)event->data.command.value);
+        break;
+
+    case BOARD_EVENT_UART:
+        for (uint8_t i = 0u; i < event->data.uart.length; ++i) {
+            protocol_handle_uart_byte(protocol, game, event->data.uart.bytes[i]);
+        }
+        break;
+
+    default:
+        game_handle_event(game, event);
+        break;
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "input.h"
+
+/*
+ * Framed binary control protocol carried on the same UART as the ASCII
+ * commands:
+ *
+ *   SOF | LEN | PAYLOAD[LEN] | CRC16 (big endian)
+ *
+ * The CRC is CRC-16/CCITT-FALSE over LEN and PAYLOAD. A request payload is
+ * a run of commands; the reply is a single frame holding one record per
+ * command, in order. SOF is never a valid ASCII command, so both styles can
+ * share the link. A requester that may give up on a reply tags its request
+ * with an ECHO first, so a reply that turns up late is recognised as such.
+ *
+ * A frame whose bytes stop coming for PROTOCOL_BYTE_TIMEOUT_MS of game time
+ * is abandoned. One that fails its CRC is searched for a later SOF, and
+ * parsing starts again from there, so a frame that lost a byte costs only
+ * itself and not the frame that ran into it.
+ */
+#define PROTOCOL_SOF             0x02u
+#define PROTOCOL_MAX_PAYLOAD     255u
+#define PROTOCOL_MAX_FRAME       (1u + PROTOCOL_MAX_PAYLOAD + 2u)  // after the SOF
+#define PROTOCOL_BYTE_TIMEOUT_MS 20u
+
+#define PROTOCOL_CMD_STATUS      0x01u
+#define PROTOCOL_CMD_START       0x02u
+#define PROTOCOL_CMD_RESET       0x03u
+#define PROTOCOL_CMD_HIGHSCORES  0x04u
+#define PROTOCOL_CMD_OCTAVE_UP   0x05u
+#define PROTOCOL_CMD_OCTAVE_DOWN 0x06u
+#define PROTOCOL_CMD_BUTTON      0x07u
+#define PROTOCOL_CMD_POT         0x08u
+#define PROTOCOL_CMD_INPUT_STATS 0x09u  // only where an input stage is attached
+#define PROTOCOL_CMD_ECHO        0x0Au  // one byte, returned after the opcode
+
+#define PROTOCOL_REPLY_FLAG      0x80u
+#define PROTOCOL_REPLY_ERROR     0x7Fu
+
+#define PROTOCOL_ERROR_CRC       0x01u
+#define PROTOCOL_ERROR_UNKNOWN   0x02u
+#define PROTOCOL_ERROR_TRUNCATED 0x03u
+#define PROTOCOL_ERROR_OVERFLOW  0x04u
+
+typedef enum {
+    PROTOCOL_PHASE_IDLE = 0,
+    PROTOCOL_PHASE_LENGTH,
+    PROTOCOL_PHASE_PAYLOAD,
+    PROTOCOL_PHASE_CRC_HIGH,
+    PROTOCOL_PHASE_CRC_LOW
+} protocol_phase_t;
+
+typedef void (*protocol_reply_fn)(void *user, const uint8_t *payload, uint8_t length);
+
+typedef struct {
+    protocol_phase_t phase;
+    uint8_t length;
+    uint8_t received;
+    uint16_t crc;
+    uint16_t expected_crc;
+    uint32_t last_byte_ms;
+    uint32_t frames_ok;
+    uint32_t frames_bad;
+    uint32_t frames_timed_out;
+    // Skipped while resynchronising, and in link mode anything outside a frame.
+    uint32_t bytes_dropped;
+    // Link mode only; see protocol_set_link.
+    protocol_reply_fn on_reply;
+    void *reply_user;
+    const input_conditioner_t *input;
+    // Every byte since the SOF: LEN, the payload, then the CRC.
+    uint16_t frame_bytes;
+    uint8_t frame[PROTOCOL_MAX_FRAME];
+} simon_protocol_t;
+
+void protocol_init(simon_protocol_t *protocol);
+/*
+ * Put the protocol on a board-to-board link, where both ends speak frames
+ * and anything else is the peer's console chatter. Bytes outside a frame
+ * are dropped instead of run as commands, and replies from the peer
+ * (flagged records, errors and empty frames) go to `on_reply` rather than
+ * being answered, so two boards can never bounce errors back and forth.
+ * For the same reason a frame that fails its CRC is dropped without a NAK;
+ * the sender's own timeout covers it.
+ */
+void protocol_set_link(simon_protocol_t *protocol, protocol_reply_fn on_reply, void *user);
+// Answer INPUT_STATS from `input`'s counters; without one it is an unknown command.
+void protocol_attach_input(simon_protocol_t *protocol, const input_conditioner_t *input);
+// Frame `length` bytes of `payload`, at most PROTOCOL_MAX_PAYLOAD, onto the UART.
+void protocol_send_frame(const uint8_t *payload, uint16_t length);
+void protocol_handle_uart_byte(simon_protocol_t *protocol, simon_game_t *game, uint8_t value);
+void protocol_handle_event(simon_protocol_t *protocol, simon_game_t *game, const board_event_t *event);
+uint16_t protocol_crc16(uint16_t crc, uint8_t value);
+
+#endif /* PROTOCOL_H */
@@ -0,0 +1,510 @@
+#include "render.h"
+
+#if !defined(__AVR__)
+
+#include <string.h>
+
+#define DIGIT_WIDTH   20u
+#define DIGIT_HEIGHT  32u
+#define DIGIT_TOP     4u
+// The LED bar spans 56 pixels whatever the pad count.
+#define LED_PITCH     (56u / RENDER_LEDS)
+#define LED_WIDTH     (LED_PITCH * 5u / 7u)
+#define LED_HEIGHT    5u
+#define LED_TOP       40u
+#define LED_LEFT      6u
+
+#define GLYPH_BLANK   16u
+#define GLYPH_DASH    17u
+#define GLYPH_COUNT   18u
+
+#define SEGMENT_A     0x01u
+#define SEGMENT_G     0x40u
+
+#define PNG_STORED_BLOCK_MAX 65535u
+#define PNG_RAW_BYTES        (RENDER_HEIGHT * (1u + RENDER_ROW_BYTES))
+#define PNG_STORED_BLOCKS    ((PNG_RAW_BYTES + PNG_STORED_BLOCK_MAX - 1u) / PNG_STORED_BLOCK_MAX)
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} colour_t;
+
+static const colour_t background = {18u, 18u, 22u};
+static const colour_t segment_lit = {255u, 48u, 32u};
+static const colour_t segment_unlit = {58u, 22u, 22u};
+static const colour_t led_lit = {64u, 230u, 80u};
+static const colour_t led_unlit = {22u, 52u, 26u};
+
+static const uint16_t digit_left[RENDER_DIGITS] = {8u, 36u};
+
+// Segments a..g within a digit cell, as {x0, y0, x1, y1}.
+static const uint8_t segment_rects[7][4] = {
+    {4u, 1u, 16u, 4u},    // a
+    {16u, 4u, 19u, 15u},  // b
+    {16u, 17u, 19u, 28u}, // c
+    {4u, 28u, 16u, 31u},  // d
+    {1u, 17u, 4u, 28u},   // e
+    {1u, 4u, 4u, 15u},    // f
+    {4u, 14u, 16u, 17u},  // g
+};
+
+// Segment masks (bit 0 = a) for 0-F, blank and a dash.
+static const uint8_t glyph_segments[GLYPH_COUNT] = {
+    0x3Fu, 0x06u, 0x5Bu, 0x4Fu, 0x66u, 0x6Du, 0x7Du, 0x07u,
+    0x7Fu, 0x6Fu, 0x77u, 0x7Cu, 0x39u, 0x5Eu, 0x79u, 0x71u,
+    0x00u, SEGMENT_G,
+};
+
+static uint8_t glyph_bitmaps[GLYPH_COUNT][DIGIT_HEIGHT][DIGIT_WIDTH * RENDER_CHANNELS];
+static uint8_t led_bitmaps[2][LED_HEIGHT][LED_WIDTH * RENDER_CHANNELS];
+static uint32_t crc_table[256];
+static bool tables_built;
+
+static void put_pixel(uint8_t *pixel, colour_t colour)
+{
+    pixel[0] = colour.r;
+    pixel[1] = colour.g;
+    pixel[2] = colour.b;
+    pixel[3] = 0xFFu;
+}
+
+static void build_tables(void)
+{
+    for (uint8_t glyph = 0u; glyph < GLYPH_COUNT; ++glyph) {
+        for (uint16_t y = 0u; y < DIGIT_HEIGHT; ++y) {
+            for (uint16_t x = 0u; x < DIGIT_WIDTH; ++x) {
+                colour_t colour = background;
+                for (uint8_t segment = 0u; segment < 7u; ++segment) {
+                    const uint8_t *rect = segment_rects[segment];
+                    if (x >= rect[0] && x < rect[2] && y >= rect[1] && y < rect[3]) {
+                        bool lit = (glyph_segments[glyph] & (SEGMENT_A << segment)) != 0u;
+                        colour = lit ? segment_lit : segment_unlit;
+                    }
+                }
+                put_pixel(&glyph_bitmaps[glyph][y][x * RENDER_CHANNELS], colour);
+            }
+        }
+    }
+
+    for (uint16_t y = 0u; y < LED_HEIGHT; ++y) {
+        for (uint16_t x = 0u; x < LED_WIDTH; ++x) {
+            put_pixel(&led_bitmaps[0][y][x * RENDER_CHANNELS], led_unlit);
+            put_pixel(&led_bitmaps[1][y][x * RENDER_CHANNELS], led_lit);
+        }
+    }
+
+    for (uint32_t n = 0u; n < 256u; ++n) {
+        uint32_t c = n;
+        for (uint8_t bit = 0u; bit < 8u; ++bit) {
+            c = (c & 1u) != 0u ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+
+    tables_built = true;
+}
+
+static uint8_t glyph_for_value(uint8_t value)
+{
+    if (value < 16u) {
+        return value;
+    }
+    return value == 0xFFu ? GLYPH_BLANK : GLYPH_DASH;
+}
+
+static void mark_dirty(render_t *render, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    render_rect_t *dirty = &render->dirty;
+
+    if (dirty->x1 == 0u) {
+        *dirty = (render_rect_t){x0, y0, x1, y1};
+        return;
+    }
+    dirty->x0 = x0 < dirty->x0 ? x0 : dirty->x0;
+    dirty->y0 = y0 < dirty->y0 ? y0 : dirty->y0;
+    dirty->x1 = x1 > dirty->x1 ? x1 : dirty->x1;
+    dirty->y1 = y1 > dirty->y1 ? y1 : dirty->y1;
+}
+
+static void blit(render_t *render, uint16_t left, uint16_t top, const uint8_t *bitmap, uint16_t width, uint16_t height)
+{
+    size_t row_bytes = (size_t)width * RENDER_CHANNELS;
+
+    for (uint16_t y = 0u; y < height; ++y) {
+        memcpy(&render->pixels[top + y][left * RENDER_CHANNELS], bitmap + y * row_bytes, row_bytes);
+    }
+    mark_dirty(render, left, top, (uint16_t)(left + width), (uint16_t)(top + height));
+}
+
+static void draw_digit(render_t *render, uint8_t digit, uint8_t glyph)
+{
+    render->digit_glyphs[digit] = glyph;
+    blit(render, digit_left[digit], DIGIT_TOP, &glyph_bitmaps[glyph][0][0], DIGIT_WIDTH, DIGIT_HEIGHT);
+}
+
+static void draw_led(render_t *render, uint8_t led, bool lit)
+{
+    blit(render, (uint16_t)(LED_LEFT + led * LED_PITCH), LED_TOP, &led_bitmaps[lit ? 1 : 0][0][0], LED_WIDTH, LED_HEIGHT);
+}
+
+bool render_open(render_t *render, const char *directory, bool write_png)
+{
+    if (!tables_built) {
+        build_tables();
+    }
+
+    memset(render, 0, sizeof *render);
+    for (uint16_t y = 0u; y < RENDER_HEIGHT; ++y) {
+        for (uint16_t x = 0u; x < RENDER_WIDTH; ++x) {
+            put_pixel(&render->pixels[y][x * RENDER_CHANNELS], background);
+        }
+    }
+    for (uint8_t digit = 0u; digit < RENDER_DIGITS; ++digit) {
+        draw_digit(render, digit, GLYPH_BLANK);
+    }
+    for (uint8_t led = 0u; led < RENDER_LEDS; ++led) {
+        draw_led(render, led, false);
+    }
+    render->dirty = (render_rect_t){0u, 0u, 0u, 0u};
+
+    if (directory == NULL) {
+        return true;
+    }
+
+    char path[sizeof render->directory + 16u];
+    snprintf(render->directory, sizeof render->directory, "%s", directory);
+    snprintf(path, sizeof path, "%s/frames.txt", render->directory);
+    render->hash_log = fopen(path, "w");
+    render->write_png = write_png;
+    if (render->hash_log == NULL) {
+        return false;
+    }
+    // The console loop never returns, so keep the log whole line by line.
+    setvbuf(render->hash_log, NULL, _IOLBF, 0);
+    return true;
+}
+
+void render_close(render_t *render)
+{
+    if (render->hash_log != NULL) {
+        fclose(render->hash_log);
+        render->hash_log = NULL;
+    }
+}
+
+bool render_apply(render_t *render, const hardware_change_t *change)
+{
+    bool changed = false;
+
+    switch (change->kind) {
+    case HARDWARE_CHANGE_PATTERN:
+        // Same bit order as the console log: the top pad bit is the
+        // leftmost LED.
+        for (uint8_t led = 0u; led < RENDER_LEDS; ++led) {
+            uint8_t mask = (uint8_t)((1u << (RENDER_LEDS - 1u)) >> led);
+            if (((change->a ^ render->led_pattern) & mask) != 0u) {
+                draw_led(render, led, (change->a & mask) != 0u);
+                changed = true;
+            }
+        }
+        render->led_pattern = (uint8_t)(change->a & SIMON_BUTTON_MASK);
+        break;
+
+    case HARDWARE_CHANGE_SEGMENTS: {
+        uint8_t glyphs[RENDER_DIGITS] = {glyph_for_value(change->a), glyph_for_value(change->b)};
+        for (uint8_t digit = 0u; digit < RENDER_DIGITS; ++digit) {
+            if (glyphs[digit] != render->digit_glyphs[digit]) {
+                draw_digit(render, digit, glyphs[digit]);
+                changed = true;
+            }
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return changed;
+}
+
+static uint8_t luma(const uint8_t *pixel)
+{
+    return (uint8_t)((pixel[0] * 77u + pixel[1] * 150u + pixel[2] * 29u) >> 8);
+}
+
+// Area-average the frame's luma onto a cols x rows grid.
+static void downsample(const render_t *render, uint8_t cols, uint8_t rows, uint32_t *grid)
+{
+    for (uint8_t row = 0u; row < rows; ++row) {
+        uint16_t y0 = (uint16_t)(row * RENDER_HEIGHT / rows);
+        uint16_t y1 = (uint16_t)((row + 1u) * RENDER_HEIGHT / rows);
+        for (uint8_t col = 0u; col < cols; ++col) {
+            uint16_t x0 = (uint16_t)(col * RENDER_WIDTH / cols);
+            uint16_t x1 = (uint16_t)((col + 1u) * RENDER_WIDTH / cols);
+            uint32_t sum = 0u;
+            for (uint16_t y = y0; y < y1; ++y) {
+                for (uint16_t x = x0; x < x1; ++x) {
+                    sum += luma(&render->pixels[y][x * RENDER_CHANNELS]);
+                }
+            }
+            grid[row * cols + col] = sum / ((uint32_t)(y1 - y0) * (x1 - x0));
+        }
+    }
+}
+
+uint64_t render_average_hash(const render_t *render)
+{
+    uint32_t grid[64];
+    uint32_t total = 0u;
+    uint64_t hash = 0u;
+
+    downsample(render, 8u, 8u, grid);
+    for (uint8_t i = 0u; i < 64u; ++i) {
+        total += grid[i];
+    }
+    for (uint8_t i = 0u; i < 64u; ++i) {
+        if (grid[i] * 64u > total) {
+            hash |= 1ull << i;
+        }
+    }
+    return hash;
+}
+
+uint64_t render_difference_hash(const render_t *render)
+{
+    uint32_t grid[9 * 8];
+    uint64_t hash = 0u;
+
+    downsample(render, 9u, 8u, grid);
+    for (uint8_t row = 0u; row < 8u; ++row) {
+        for (uint8_t col = 0u; col < 8u; ++col) {
+            if (grid[row * 9u + col] < grid[row * 9u + col + 1u]) {
+                hash |= 1ull << (row * 8u + col);
+            }
+        }
+    }
+    return hash;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0u; i < length; ++i) {
+        crc = crc_table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_u32_be(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+// Length, type and payload must already be in place; appends the CRC.
+static size_t finish_chunk(uint8_t *chunk, size_t payload_length)
+{
+    uint32_t crc = crc32_update(0xFFFFFFFFu, chunk + 4u, payload_length + 4u) ^ 0xFFFFFFFFu;
+    put_u32_be(chunk + 8u + payload_length, crc);
+    return 12u + payload_length;
+}
+
+size_t render_png_size(void)
+{
+    // Signature, IHDR, IDAT (zlib header, stored blocks, Adler-32), IEND.
+    return 8u + 25u + 12u + 2u + PNG_STORED_BLOCKS * 5u + PNG_RAW_BYTES + 4u + 12u;
+}
+
+size_t render_encode_png(const render_t *render, uint8_t *out, size_t capacity)
+{
+    static const uint8_t signature[8] = {0x89u, 'P', 'N', 'G', '\r', '\n', 0x1Au, '\n'};
+    size_t pos = 0u;
+
+    if (capacity < render_png_size()) {
+        return 0u;
+    }
+
+    memcpy(out, signature, sizeof signature);
+    pos += sizeof signature;
+
+    uint8_t *ihdr = out + pos;
+    put_u32_be(ihdr, 13u);
+    memcpy(ihdr + 4u, "IHDR", 4u);
+    put_u32_be(ihdr + 8u, RENDER_WIDTH);
+    put_u32_be(ihdr + 12u, RENDER_HEIGHT);
+    ihdr[16] = 8u; // bit depth
+    ihdr[17] = 6u; // RGBA
+    ihdr[18] = 0u;
+    ihdr[19] = 0u;
+    ihdr[20] = 0u;
+    pos += finish_chunk(ihdr, 13u);
+
+    // Uncompressed deflate: the frame is tiny and speed matters more
+    // than size here.
+    uint8_t *idat = out + pos;
+    size_t data = 8u;
+    uint32_t adler_a = 1u;
+    uint32_t adler_b = 0u;
+    size_t block_left = 0u;
+    size_t raw_left = PNG_RAW_BYTES;
+
+    memcpy(idat + 4u, "IDAT", 4u);
+    idat[data++] = 0x78u;
+    idat[data++] = 0x01u;
+    for (uint16_t y = 0u; y < RENDER_HEIGHT; ++y) {
+        for (size_t i = 0u; i < 1u + RENDER_ROW_BYTES;) {
+            if (block_left == 0u) {
+                block_left = raw_left < PNG_STORED_BLOCK_MAX ? raw_left : PNG_STORED_BLOCK_MAX;
+                idat[data++] = raw_left == block_left ? 1u : 0u;
+                idat[data++] = (uint8_t)block_left;
+                idat[data++] = (uint8_t)(block_left >> 8);
+                idat[data++] = (uint8_t)~block_left;
+                idat[data++] = (uint8_t)(~block_left >> 8);
+            }
+
+            // Filter byte 0 (none) ahead of each row.
+            const uint8_t *source = (i == 0u) ? (const uint8_t *)"\0" : &render->pixels[y][i - 1u];
+            size_t run = (i == 0u) ? 1u : 1u + RENDER_ROW_BYTES - i;
+            run = run < block_left ? run : block_left;
+
+            memcpy(idat + data, source, run);
+            for (size_t k = 0u; k < run; ++k) {
+                adler_a += source[k];
+                adler_b += adler_a;
+            }
+            adler_a %= 65521u;
+            adler_b %= 65521u;
+
+            data += run;
+            i += run;
+            block_left -= run;
+            raw_left -= run;
+        }
+    }
+    put_u32_be(idat + data, (adler_b << 16) | adler_a);
+    data += 4u;
+    put_u32_be(idat, (uint32_t)(data - 8u));
+    pos += finish_chunk(idat, data - 8u);
+
+    uint8_t *iend = out + pos;
+    put_u32_be(iend, 0u);
+    memcpy(iend + 4u, "IEND", 4u);
+    pos += finish_chunk(iend, 0u);
+    return pos;
+}
+
+static void write_png_frame(const render_t *render)
+{
+    static uint8_t png[8u + 25u + 12u + 2u + PNG_STORED_BLOCKS * 5u + PNG_RAW_BYTES + 4u + 12u];
+    char path[sizeof render->directory + 32u];
+    size_t length = render_encode_png(render, png, sizeof png);
+
+    snprintf(path, sizeof path, "%s/frame-%06u.png", render->directory, render->frame_count);
+    FILE *file = fopen(path, "wb");
+    if (file != NULL) {
+        fwrite(png, 1u, length, file);
+        fclose(file);
+    }
+}
+
+void render_observer(void *user, const hardware_change_t *change)
+{
+    render_t *render = user;
+
+    if (!render_apply(render, change)) {
+        return;
+    }
+
+    if (render->hash_log != NULL) {
+        const render_rect_t *dirty = &render->dirty;
+        fprintf(render->hash_log, "%u %016llx %016llx %u,%u-%u,%u\n", render->frame_count,
+                (unsigned long long)render_average_hash(render), (unsigned long long)render_difference_hash(render),
+                dirty->x0, dirty->y0, dirty->x1, dirty->y1);
+    }
+    if (render->write_png) {
+        write_png_frame(render);
+    }
+
+    render->dirty = (render_rect_t){0u, 0u, 0u, 0u};
+    render->frame_count++;
+}
+
+// A scan that stopped at the end of the log, not on a bad line or a read error.
+static bool log_ended(FILE *log, int scanned)
+{
+    return scanned == EOF && !ferror(log);
+}
+
+int render_compare(const char *expected_path, const char *actual_path, unsigned threshold)
+{
+    FILE *expected = fopen(expected_path, "r");
+    FILE *actual = fopen(actual_path, "r");
+    unsigned frames = 0u;
+    unsigned differing = 0u;
+    int status = 0;
+
+    if (expected == NULL || actual == NULL) {
+        perror(expected == NULL ? expected_path : actual_path);
+        status = 2;
+        goto done;
+    }
+
+    for (;;) {
+        unsigned expected_frame;
+        unsigned actual_frame;
+        unsigned long long hashes[4];
+        int got_expected = fscanf(expected, "%u %llx %llx %*s", &expected_frame, &hashes[0], &hashes[1]);
+        int got_actual = fscanf(actual, "%u %llx %llx %*s", &actual_frame, &hashes[2], &hashes[3]);
+
+        if (got_expected != 3 && !log_ended(expected, got_expected)) {
+            fprintf(stderr, "%s: unreadable or malformed after %u frames\n", expected_path, frames);
+            status = 2;
+            goto done;
+        }
+        if (got_actual != 3 && !log_ended(actual, got_actual)) {
+            fprintf(stderr, "%s: unreadable or malformed after %u frames\n", actual_path, frames);
+            status = 2;
+            goto done;
+        }
+        if (got_expected != 3 || got_actual != 3) {
+            if (got_expected == 3 || got_actual == 3) {
+                printf("frame counts differ after %u frames\n", frames);
+                status = 1;
+            }
+            break;
+        }
+
+        unsigned average = (unsigned)__builtin_popcountll(hashes[0] ^ hashes[2]);
+        unsigned difference = (unsigned)__builtin_popcountll(hashes[1] ^ hashes[3]);
+        if (average > threshold || difference > threshold) {
+            printf("frame %u: average hash %u bits, difference hash %u bits apart\n", expected_frame, average,
+                   difference);
+            differing++;
+        }
+        frames++;
+    }
+
+    printf("%u frames compared, %u differ by more than %u bits\n", frames, differing, threshold);
+    if (frames == 0u) {
+        // Two empty logs prove nothing about the frames they should hold.
+        fprintf(stderr, "no frames to compare\n");
+        status = 2;
+    } else if (differing > 0u) {
+        status = 1;
+    }
+
+done:
+    if (expected != NULL) {
+        fclose(expected);
+    }
+    if (actual != NULL) {
+        fclose(actual);
+    }
+    return status;
+}
+
+#endif /* !__AVR__ */
@@ -0,0 +1,81 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#if !defined(__AVR__)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hardware.h"
+#include "variant.h"
+
+/*
+ * Offscreen picture of the board's display: the two 7-segment digits above
+ * the bar of pad LEDs, in a small RGBA framebuffer. Attached as a hardware
+ * observer it redraws only the digit or LED that changed, from glyph
+ * bitmaps built once at start-up, and emits a frame whenever the picture
+ * changes.
+ *
+ * Each frame gets two 64-bit perceptual hashes (average and difference
+ * hash) written to frames.txt in the output directory, and optionally a
+ * PNG. Comparing hash logs between builds flags frames that look
+ * different without keeping reference images around.
+ */
+#define RENDER_WIDTH      64u
+#define RENDER_HEIGHT     48u
+#define RENDER_CHANNELS   4u
+#define RENDER_ROW_BYTES  (RENDER_WIDTH * RENDER_CHANNELS)
+#define RENDER_DIGITS     2u
+#define RENDER_LEDS       SIMON_BUTTON_COUNT
+
+typedef struct {
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1; // exclusive
+    uint16_t y1; // exclusive
+} render_rect_t;
+
+typedef struct {
+    uint8_t pixels[RENDER_HEIGHT][RENDER_ROW_BYTES];
+    uint8_t digit_glyphs[RENDER_DIGITS];
+    uint8_t led_pattern;
+    render_rect_t dirty;
+    uint32_t frame_count;
+    bool write_png;
+    char directory[200];
+    FILE *hash_log;
+} render_t;
+
+/*
+ * Start a blank board. `directory` receives frames.txt and, if
+ * `write_png` is set, frame-NNNNNN.png per frame; NULL keeps everything
+ * in memory.
+ */
+bool render_open(render_t *render, const char *directory, bool write_png);
+void render_close(render_t *render);
+
+// Redraw for one change; true when any pixel changed.
+bool render_apply(render_t *render, const hardware_change_t *change);
+// hardware_observer_fn adapter; `user` is the render_t.
+void render_observer(void *user, const hardware_change_t *change);
+
+uint64_t render_average_hash(const render_t *render);
+uint64_t render_difference_hash(const render_t *render);
+
+// Encode the framebuffer as a PNG. Returns the length, or 0 if it does not fit.
+size_t render_encode_png(const render_t *render, uint8_t *out, size_t capacity);
+size_t render_png_size(void);
+
+/*
+ * Compare two frames.txt logs frame by frame and list the frames whose
+ * hashes are more than `threshold` bits apart. Returns 0 when none are,
+ * 1 when some are or the frame counts differ, and 2 when a log cannot be
+ * read, has a malformed line or holds no frames at all.
+ */
+int render_compare(const char *expected_path, const char *actual_path, unsigned threshold);
+
+#endif /* !__AVR__ */
+
+#endif /* RENDER_H */
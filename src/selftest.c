@@ -0,0 +1,821 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "selftest.h"
+#include "game.h"
+#include "eeprom.h"
+#include "hardware.h"
+#include "journal.h"
+#include "outcome.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void check(bool *all, const char *name, bool ok)
+{
+    printf("%-44s %s\n", name, ok ? "ok" : "FAIL");
+    *all = *all && ok;
+}
+
+static void discard_output(void *user, const char *data, size_t length)
+{
+    (void)user;
+    (void)data;
+    (void)length;
+}
+
+static uint32_t selftest_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// --- framed protocol ---
+
+#define CAPTURE_MAX     1024u
+#define CAPTURE_REPLIES 8u
+
+typedef struct {
+    uint8_t bytes[CAPTURE_MAX];
+    size_t length;
+} capture_t;
+
+typedef struct {
+    simon_game_t game;
+    simon_game_cold_t cold;
+    timer_wheel_t wheel;
+    simon_protocol_t protocol;
+    hardware_context_t hardware;
+    capture_t uart;
+    // Replies handed over in link mode.
+    uint32_t link_replies;
+    uint8_t link_reply[PROTOCOL_MAX_PAYLOAD];
+    uint8_t link_reply_length;
+} protocol_rig_t;
+
+// Reply payloads split out of the captured UART bytes.
+typedef struct {
+    uint32_t count;
+    const uint8_t *payloads[CAPTURE_REPLIES];
+    uint8_t lengths[CAPTURE_REPLIES];
+    bool malformed;
+} replies_t;
+
+static void capture_output(void *user, const char *data, size_t length)
+{
+    capture_t *capture = user;
+    if (length > CAPTURE_MAX - capture->length) {
+        length = CAPTURE_MAX - capture->length;
+    }
+    memcpy(capture->bytes + capture->length, data, length);
+    capture->length += length;
+}
+
+static void capture_link_reply(void *user, const uint8_t *payload, uint8_t length)
+{
+    protocol_rig_t *rig = user;
+    rig->link_replies++;
+    memcpy(rig->link_reply, payload, length);
+    rig->link_reply_length = length;
+}
+
+static void rig_open(protocol_rig_t *rig)
+{
+    memset(rig, 0, sizeof *rig);
+    hardware_context_init(&rig->hardware, discard_output, NULL);
+    hardware_context_set_uart(&rig->hardware, capture_output, &rig->uart);
+    hardware_bind_context(&rig->hardware);
+    timer_wheel_init(&rig->wheel);
+    game_init(&rig->game, &rig->cold, &rig->wheel);
+    protocol_init(&rig->protocol);
+}
+
+static void rig_close(protocol_rig_t *rig)
+{
+    game_shutdown(&rig->game);
+    hardware_bind_context(NULL);
+}
+
+// SOF, LEN, the payload and its CRC into `out`; returns the bytes written.
+static size_t build_frame(uint8_t *out, const uint8_t *payload, uint8_t length)
+{
+    uint16_t crc = protocol_crc16(0xFFFFu, length);
+    size_t pos = 0u;
+
+    out[pos++] = PROTOCOL_SOF;
+    out[pos++] = length;
+    for (uint8_t i = 0u; i < length; ++i) {
+        crc = protocol_crc16(crc, payload[i]);
+        out[pos++] = payload[i];
+    }
+    out[pos++] = (uint8_t)(crc >> 8);
+    out[pos++] = (uint8_t)crc;
+    return pos;
+}
+
+// Feed `bytes` to the parser and split what it wrote back into frames.
+static replies_t rig_send(protocol_rig_t *rig, const uint8_t *bytes, size_t length)
+{
+    replies_t replies = {.count = 0u};
+    const capture_t *uart = &rig->uart;
+
+    rig->uart.length = 0u;
+    for (size_t i = 0u; i < length; ++i) {
+        protocol_handle_uart_byte(&rig->protocol, &rig->game, bytes[i]);
+    }
+
+    size_t pos = 0u;
+    while (pos < uart->length && replies.count < CAPTURE_REPLIES) {
+        if (uart->bytes[pos] != PROTOCOL_SOF) {
+            pos++;
+            continue;
+        }
+        if (pos + 2u > uart->length || pos + 4u + uart->bytes[pos + 1u] > uart->length) {
+            replies.malformed = true;
+            break;
+        }
+        uint8_t frame_length = uart->bytes[pos + 1u];
+        uint16_t crc = protocol_crc16(0xFFFFu, frame_length);
+        for (uint8_t i = 0u; i < frame_length; ++i) {
+            crc = protocol_crc16(crc, uart->bytes[pos + 2u + i]);
+        }
+        const uint8_t *tail = &uart->bytes[pos + 2u + frame_length];
+        if (crc != (uint16_t)((tail[0] << 8) | tail[1])) {
+            replies.malformed = true;
+            break;
+        }
+        replies.payloads[replies.count] = &uart->bytes[pos + 2u];
+        replies.lengths[replies.count] = frame_length;
+        replies.count++;
+        pos += 4u + frame_length;
+    }
+    return replies;
+}
+
+static bool is_status_reply(const replies_t *replies, uint32_t index)
+{
+    return index < replies->count && replies->lengths[index] > 0u &&
+           replies->payloads[index][0] == (PROTOCOL_CMD_STATUS | PROTOCOL_REPLY_FLAG);
+}
+
+static bool is_error_reply(const replies_t *replies, uint32_t index, uint8_t code)
+{
+    return index < replies->count && replies->lengths[index] == 2u &&
+           replies->payloads[index][0] == PROTOCOL_REPLY_ERROR && replies->payloads[index][1] == code;
+}
+
+int selftest_protocol(void)
+{
+    static protocol_rig_t rig;
+    static const uint8_t status_payload[] = {PROTOCOL_CMD_STATUS};
+    uint8_t status[8];
+    uint8_t bytes[64];
+    size_t length;
+    replies_t replies;
+    bool all = true;
+
+    // CRC-16/CCITT-FALSE of "123456789" is 0x29B1.
+    uint16_t crc = 0xFFFFu;
+    for (const char *digit = "123456789"; *digit != '\0'; ++digit) {
+        crc = protocol_crc16(crc, (uint8_t)*digit);
+    }
+    check(&all, "crc16 check value", crc == 0x29B1u);
+
+    rig_open(&rig);
+    size_t status_length = build_frame(status, status_payload, sizeof status_payload);
+
+    replies = rig_send(&rig, status, status_length);
+    check(&all, "status frame gets one status reply",
+          !replies.malformed && replies.count == 1u && is_status_reply(&replies, 0u) && rig.protocol.frames_ok == 1u);
+
+    static const uint8_t batch_payload[] = {PROTOCOL_CMD_STATUS, PROTOCOL_CMD_HIGHSCORES};
+    length = build_frame(bytes, batch_payload, sizeof batch_payload);
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "batched commands answer in one frame",
+          replies.count == 1u && is_status_reply(&replies, 0u) &&
+              replies.lengths[0] > 17u && replies.payloads[0][17] == (PROTOCOL_CMD_HIGHSCORES | PROTOCOL_REPLY_FLAG));
+
+    static const uint8_t echo_payload[] = {PROTOCOL_CMD_ECHO, 0x5Au, PROTOCOL_CMD_STATUS};
+    length = build_frame(bytes, echo_payload, sizeof echo_payload);
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "echo returns its tag ahead of the records",
+          replies.count == 1u && replies.lengths[0] >= 3u &&
+              replies.payloads[0][0] == (PROTOCOL_CMD_ECHO | PROTOCOL_REPLY_FLAG) && replies.payloads[0][1] == 0x5Au &&
+              replies.payloads[0][2] == (PROTOCOL_CMD_STATUS | PROTOCOL_REPLY_FLAG));
+
+    static const uint8_t unknown_payload[] = {0x33u};
+    length = build_frame(bytes, unknown_payload, sizeof unknown_payload);
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "unknown command is refused",
+          replies.count == 1u && is_error_reply(&replies, 0u, PROTOCOL_ERROR_UNKNOWN));
+
+    static const uint8_t truncated_payload[] = {PROTOCOL_CMD_POT, 0x01u};
+    length = build_frame(bytes, truncated_payload, sizeof truncated_payload);
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "truncated argument is refused",
+          replies.count == 1u && is_error_reply(&replies, 0u, PROTOCOL_ERROR_TRUNCATED));
+
+    memcpy(bytes, status, status_length);
+    bytes[status_length - 1u] ^= 0xFFu;
+    uint32_t bad_before = rig.protocol.frames_bad;
+    replies = rig_send(&rig, bytes, status_length);
+    check(&all, "bad CRC is NAKed",
+          replies.count == 1u && is_error_reply(&replies, 0u, PROTOCOL_ERROR_CRC) &&
+              rig.protocol.frames_bad == bad_before + 1u);
+
+    // A frame that lost its tail runs into the next one; the parser must
+    // find the second SOF again rather than lose both.
+    length = 0u;
+    bytes[length++] = PROTOCOL_SOF;
+    bytes[length++] = 5u;
+    bytes[length++] = PROTOCOL_CMD_STATUS;
+    memcpy(bytes + length, status, status_length);
+    length += status_length;
+    memset(bytes + length, 0, 4u);
+    length += 4u;
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "resync after a torn frame",
+          replies.count == 2u && is_error_reply(&replies, 0u, PROTOCOL_ERROR_CRC) && is_status_reply(&replies, 1u));
+
+    // A frame that stalls is abandoned once the line has been quiet.
+    static const uint8_t stalled[] = {PROTOCOL_SOF, 3u, PROTOCOL_CMD_STATUS};
+    uint32_t timed_out_before = rig.protocol.frames_timed_out;
+    (void)rig_send(&rig, stalled, sizeof stalled);
+    game_advance_ms(&rig.game, PROTOCOL_BYTE_TIMEOUT_MS + 1u);
+    replies = rig_send(&rig, status, status_length);
+    check(&all, "stalled frame times out",
+          replies.count == 1u && is_status_reply(&replies, 0u) &&
+              rig.protocol.frames_timed_out == timed_out_before + 1u);
+
+    // The same stall inside the timeout is one frame, not two.
+    (void)rig_send(&rig, status, 3u);
+    game_advance_ms(&rig.game, PROTOCOL_BYTE_TIMEOUT_MS);
+    replies = rig_send(&rig, status + 3u, status_length - 3u);
+    check(&all, "slow frame within the timeout completes",
+          replies.count == 1u && is_status_reply(&replies, 0u) &&
+              rig.protocol.frames_timed_out == timed_out_before + 1u);
+
+    static const uint8_t ascii[] = {'c'};
+    replies = rig_send(&rig, ascii, sizeof ascii);
+    check(&all, "ASCII commands answer outside frames",
+          replies.count == 0u && rig.uart.length >= 7u && memcmp(rig.uart.bytes, "SCORE 0", 7u) == 0);
+
+    // On a link, replies go to the handler, chatter is dropped and a bad
+    // CRC is not NAKed back.
+    protocol_set_link(&rig.protocol, capture_link_reply, &rig);
+    static const uint8_t peer_reply[] = {PROTOCOL_CMD_STATUS | PROTOCOL_REPLY_FLAG, 0x01u, 0x02u};
+    length = build_frame(bytes, peer_reply, sizeof peer_reply);
+    replies = rig_send(&rig, bytes, length);
+    check(&all, "link: a reply goes to the handler",
+          rig.uart.length == 0u && rig.link_replies == 1u && rig.link_reply_length == sizeof peer_reply &&
+              memcmp(rig.link_reply, peer_reply, sizeof peer_reply) == 0);
+
+    uint32_t dropped_before = rig.protocol.bytes_dropped;
+    replies = rig_send(&rig, ascii, sizeof ascii);
+    check(&all, "link: bytes outside a frame are dropped",
+          rig.uart.length == 0u && rig.protocol.bytes_dropped == dropped_before + 1u);
+
+    memcpy(bytes, status, status_length);
+    bytes[status_length - 1u] ^= 0xFFu;
+    replies = rig_send(&rig, bytes, status_length);
+    check(&all, "link: bad CRC is dropped without a NAK", rig.uart.length == 0u);
+
+    replies = rig_send(&rig, status, status_length);
+    check(&all, "link: requests are still answered", replies.count == 1u && is_status_reply(&replies, 0u));
+
+    rig_close(&rig);
+    return all ? 0 : 1;
+}
+
+// --- timer wheel ---
+
+#define WHEEL_PROBES      600u
+#define WHEEL_REARMS      3u     // times a re-arming probe schedules itself again
+#define WHEEL_CANCEL_AT   50000u // ticks in, a second batch is cancelled
+#define WHEEL_ADVANCE_MAX 5000u  // longest single timer_wheel_advance step
+
+typedef struct {
+    timer_node_t node;
+    timer_wheel_t *wheel;
+    uint32_t due;
+    uint32_t fired_at;
+    uint32_t fires;
+    uint32_t rearm_delay;  // 0 for a one-shot
+    uint32_t rearms_left;
+    bool cancelled;
+    bool late_fire;        // fired after being cancelled
+    bool off_time;         // fired on a tick other than its deadline
+} wheel_probe_t;
+
+typedef struct {
+    timer_wheel_t wheel;
+    wheel_probe_t probes[WHEEL_PROBES];
+    uint32_t fires;
+} wheel_rig_t;
+
+typedef struct {
+    bool on_time;
+    bool cancels_hold;
+    bool drained;
+    bool next_work_safe;
+    bool advance_matches;
+} wheel_result_t;
+
+static uint32_t clamp_delay(uint32_t delay)
+{
+    if (delay == 0u) {
+        return 1u;
+    }
+    return delay > TIMER_WHEEL_MAX_DELAY ? (uint32_t)TIMER_WHEEL_MAX_DELAY : delay;
+}
+
+static void wheel_probe_fired(timer_node_t *node)
+{
+    wheel_probe_t *probe = (wheel_probe_t *)((char *)node - offsetof(wheel_probe_t, node));
+    wheel_rig_t *rig = (wheel_rig_t *)((char *)probe->wheel - offsetof(wheel_rig_t, wheel));
+
+    probe->fires++;
+    probe->fired_at = probe->wheel->now;
+    probe->late_fire = probe->late_fire || probe->cancelled;
+    probe->off_time = probe->off_time || probe->wheel->now != probe->due;
+    rig->fires++;
+    if (probe->rearm_delay != 0u && probe->rearms_left > 0u) {
+        probe->rearms_left--;
+        probe->due = probe->wheel->now + clamp_delay(probe->rearm_delay);
+        timer_wheel_schedule(probe->wheel, &probe->node, probe->rearm_delay);
+    }
+}
+
+// The same timers on both rigs: delays spread over every level, a few at
+// or past the maximum, some re-arming and some cancelled before they run.
+static void wheel_rig_setup(wheel_rig_t *rig, uint32_t start, uint32_t seed)
+{
+    uint32_t rng = seed;
+
+    timer_wheel_init(&rig->wheel);
+    rig->wheel.now = start;
+    rig->fires = 0u;
+    for (uint32_t i = 0u; i < WHEEL_PROBES; ++i) {
+        wheel_probe_t *probe = &rig->probes[i];
+        // One bit past the wheel's span stands for an over-long delay.
+        uint32_t span = TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS;
+        uint32_t bits = selftest_random(&rng) % (span + 2u);
+        uint32_t delay = bits > span ? UINT32_MAX : (uint32_t)(selftest_random(&rng) & ((1ul << bits) - 1ul));
+
+        memset(probe, 0, sizeof *probe);
+        timer_node_init(&probe->node, wheel_probe_fired);
+        probe->wheel = &rig->wheel;
+        if (i % 5u == 1u) {
+            probe->rearm_delay = 1u + selftest_random(&rng) % 3000u;
+            probe->rearms_left = WHEEL_REARMS;
+        }
+        probe->due = start + clamp_delay(delay);
+        timer_wheel_schedule(&rig->wheel, &probe->node, delay);
+        if (i % 11u == 4u) {
+            timer_wheel_cancel(&rig->wheel, &probe->node);
+            probe->cancelled = true;
+        }
+    }
+}
+
+static void wheel_rig_cancel_batch(wheel_rig_t *rig)
+{
+    for (uint32_t i = 0u; i < WHEEL_PROBES; ++i) {
+        wheel_probe_t *probe = &rig->probes[i];
+        if (i % 7u == 2u && timer_node_pending(&probe->node)) {
+            timer_wheel_cancel(&rig->wheel, &probe->node);
+            probe->cancelled = true;
+        }
+    }
+}
+
+/*
+ * Run one rig a tick at a time and the other through timer_wheel_advance
+ * in uneven steps, to past the longest deadline. On the ticked rig, no
+ * timer may fire before the tick timer_wheel_next_work last promised.
+ */
+static wheel_result_t wheel_scenario(uint32_t start, uint32_t seed)
+{
+    static wheel_rig_t ticked;
+    static wheel_rig_t advanced;
+    wheel_result_t result = {.next_work_safe = true};
+    uint32_t horizon = (uint32_t)TIMER_WHEEL_MAX_DELAY + WHEEL_REARMS * 3000u + 2u;
+    uint32_t rng = seed ^ 0x9E3779B9u;
+
+    wheel_rig_setup(&ticked, start, seed);
+    wheel_rig_setup(&advanced, start, seed);
+
+    // Ticks the wheel has promised to spend without firing anything.
+    uint32_t quiet = 0u;
+    for (uint32_t elapsed = 0u; elapsed < horizon; ++elapsed) {
+        if (elapsed == WHEEL_CANCEL_AT) {
+            wheel_rig_cancel_batch(&ticked);
+        }
+        if (quiet == 0u) {
+            uint32_t next = timer_wheel_next_work(&ticked.wheel);
+            quiet = next == TIMER_WHEEL_IDLE ? UINT32_MAX : next - 1u;
+        }
+        uint32_t fires = ticked.fires;
+        timer_wheel_tick(&ticked.wheel);
+        if (ticked.fires != fires) {
+            result.next_work_safe = result.next_work_safe && quiet == 0u;
+            quiet = 0u;
+        } else if (quiet != 0u && quiet != UINT32_MAX) {
+            quiet--;
+        }
+    }
+
+    uint32_t elapsed = 0u;
+    while (elapsed < horizon) {
+        uint32_t step = 1u + selftest_random(&rng) % WHEEL_ADVANCE_MAX;
+        if (elapsed < WHEEL_CANCEL_AT && elapsed + step > WHEEL_CANCEL_AT) {
+            step = WHEEL_CANCEL_AT - elapsed;
+        } else if (step > horizon - elapsed) {
+            step = horizon - elapsed;
+        }
+        if (elapsed == WHEEL_CANCEL_AT) {
+            wheel_rig_cancel_batch(&advanced);
+        }
+        timer_wheel_advance(&advanced.wheel, step);
+        elapsed += step;
+    }
+
+    result.on_time = true;
+    result.cancels_hold = true;
+    result.advance_matches = advanced.wheel.now == ticked.wheel.now;
+    for (uint32_t i = 0u; i < WHEEL_PROBES; ++i) {
+        const wheel_probe_t *probe = &ticked.probes[i];
+        const wheel_probe_t *twin = &advanced.probes[i];
+        uint32_t expected = probe->cancelled ? probe->fires : (probe->rearm_delay != 0u ? 1u + WHEEL_REARMS : 1u);
+
+        result.on_time = result.on_time && !probe->off_time && probe->fires == expected;
+        result.cancels_hold = result.cancels_hold && !probe->late_fire && !twin->late_fire &&
+                              (i % 11u != 4u || probe->fires == 0u);
+        result.advance_matches = result.advance_matches && twin->fires == probe->fires &&
+                                 twin->fired_at == probe->fired_at && !twin->off_time;
+    }
+    result.drained = ticked.wheel.pending == 0u && advanced.wheel.pending == 0u &&
+                     timer_wheel_next_work(&ticked.wheel) == TIMER_WHEEL_IDLE;
+    return result;
+}
+
+int selftest_wheel(void)
+{
+    // From zero, across the top level's wrap and across the 32-bit wrap.
+    static const uint32_t starts[] = {0u, (uint32_t)TIMER_WHEEL_MAX_DELAY - 1000u, UINT32_MAX - 1000u};
+    static const char *const labels[] = {"from 0", "past 2^24", "past 2^32"};
+    char name[64];
+    bool all = true;
+
+    for (uint32_t i = 0u; i < sizeof starts / sizeof starts[0]; ++i) {
+        wheel_result_t result = wheel_scenario(starts[i], 0x5EED0000u + i);
+        snprintf(name, sizeof name, "%s: timers fire once, on their tick", labels[i]);
+        check(&all, name, result.on_time);
+        snprintf(name, sizeof name, "%s: cancelled timers stay quiet", labels[i]);
+        check(&all, name, result.cancels_hold);
+        snprintf(name, sizeof name, "%s: next_work never skips a deadline", labels[i]);
+        check(&all, name, result.next_work_safe);
+        snprintf(name, sizeof name, "%s: advance matches ticking", labels[i]);
+        check(&all, name, result.advance_matches);
+        snprintf(name, sizeof name, "%s: the wheel drains", labels[i]);
+        check(&all, name, result.drained);
+    }
+
+    // An over-long delay is clamped, and a zero one waits a tick.
+    static wheel_rig_t rig;
+    timer_wheel_init(&rig.wheel);
+    wheel_probe_t *probe = &rig.probes[0];
+    memset(probe, 0, sizeof *probe);
+    timer_node_init(&probe->node, wheel_probe_fired);
+    probe->wheel = &rig.wheel;
+    probe->due = (uint32_t)TIMER_WHEEL_MAX_DELAY;
+    timer_wheel_schedule(&rig.wheel, &probe->node, UINT32_MAX);
+    timer_wheel_advance(&rig.wheel, (uint32_t)TIMER_WHEEL_MAX_DELAY);
+    check(&all, "over-long delays clamp to the maximum", probe->fires == 1u && !probe->off_time);
+    probe->due = rig.wheel.now + 1u;
+    timer_wheel_schedule(&rig.wheel, &probe->node, 0u);
+    timer_wheel_tick(&rig.wheel);
+    check(&all, "a zero delay fires on the next tick", probe->fires == 2u && !probe->off_time);
+    return all ? 0 : 1;
+}
+
+// --- highscore journal ---
+
+#define JOURNAL_WRAP_INSERTS 80u // five trips round the ring
+#define JOURNAL_WRAP_REBOOT  7u  // reboot after every this many inserts
+
+static void erase_eeprom(void)
+{
+    uint8_t erased[EEPROM_SIZE];
+    memset(erased, EEPROM_ERASED, sizeof erased);
+    eeprom_write(0u, erased, sizeof erased);
+}
+
+static bool boards_match(const simon_highscore_table_t *a, const simon_highscore_table_t *b)
+{
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        if (a->entries[i].score != b->entries[i].score || strcmp(a->entries[i].name, b->entries[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The leaderboard insert and its journal record, as the game makes them.
+static uint8_t journal_insert(highscore_journal_t *journal, simon_highscore_table_t *table, const char *name,
+                              simon_score_t score)
+{
+    uint8_t index = game_insert_highscore(table, name, score);
+    journal_record_insert(journal, index, &table->entries[index]);
+    return index;
+}
+
+// Boot: rebuild the journal and the board from the part alone.
+static bool boots_to(highscore_journal_t *journal, simon_highscore_table_t *table,
+                     const simon_highscore_table_t *expected)
+{
+    journal_recover(journal, table);
+    return boards_match(table, expected);
+}
+
+// An erased part with a full board on it, left as a fresh boot sees it.
+static void journal_fill(highscore_journal_t *journal, simon_highscore_table_t *table)
+{
+    static const char *const names[] = {"ADA", "GRACE", "LINUS", "KEN", "DENNIS", "BARBARA", "EDSGER"};
+    simon_highscore_table_t scratch;
+
+    erase_eeprom();
+    journal_recover(journal, table);
+    for (uint32_t i = 0u; i < sizeof names / sizeof names[0]; ++i) {
+        (void)journal_insert(journal, table, names[i], 10u + (i * 37u) % 50u);
+    }
+    journal_recover(journal, &scratch);
+}
+
+int selftest_journal(void)
+{
+    highscore_journal_t journal;
+    simon_highscore_table_t table;
+    simon_highscore_table_t recovered;
+    simon_highscore_table_t before;
+    bool all = true;
+
+    erase_eeprom();
+    journal_recover(&journal, &table);
+    bool empty = journal.next_slot == 0u;
+    for (uint8_t i = 0u; i < SIMON_HIGHSCORE_ENTRIES; ++i) {
+        empty = empty && table.entries[i].score == 0u && table.entries[i].name[0] == '\0' &&
+                journal.entry_slots[i] == JOURNAL_NO_SLOT;
+    }
+    check(&all, "erased part boots an empty board", empty);
+
+    journal_fill(&journal, &table);
+    check(&all, "inserts survive a reboot", boots_to(&journal, &recovered, &table));
+
+    // Scores past 24 bits clamp, and names past eight characters are cut.
+    before = table;
+    (void)journal_insert(&journal, &table, "MARGARETH", 0x01000000u);
+    (void)game_insert_highscore(&before, "MARGARET", JOURNAL_SCORE_MAX);
+    check(&all, "long scores clamp and names keep 8 chars", boots_to(&journal, &recovered, &before));
+
+    // Corrupt the newest record in place: the boot must fall back to the
+    // board before it, and the journal must still take new records.
+    journal_fill(&journal, &table);
+    before = table;
+    uint8_t index = journal_insert(&journal, &table, "NEWEST", 45u);
+    uint8_t slot = journal.entry_slots[index];
+    uint8_t record[JOURNAL_RECORD_SIZE];
+    eeprom_read((uint16_t)(slot * JOURNAL_RECORD_SIZE), record, sizeof record);
+    record[JOURNAL_RECORD_SIZE / 2u] ^= 0x01u; // a bit of the name
+    eeprom_write((uint16_t)(slot * JOURNAL_RECORD_SIZE), record, sizeof record);
+    check(&all, "corrupt newest record boots the prior board", boots_to(&journal, &table, &before));
+    (void)journal_insert(&journal, &table, "AFTER", 44u);
+    check(&all, "inserts after the corrupted record survive", boots_to(&journal, &recovered, &table));
+
+    // Cut power after each byte of the record: a torn record must vanish.
+    bool torn_ok = true;
+    bool torn_then_insert_ok = true;
+    for (uint32_t cut = 0u; cut < JOURNAL_RECORD_SIZE; ++cut) {
+        journal_fill(&journal, &table);
+        before = table;
+        eeprom_cut_power_after(cut);
+        (void)journal_insert(&journal, &table, "TORN", 45u);
+        eeprom_restore_power();
+        torn_ok = torn_ok && boots_to(&journal, &table, &before);
+        (void)journal_insert(&journal, &table, "AFTER", 44u);
+        torn_then_insert_ok = torn_then_insert_ok && boots_to(&journal, &recovered, &table);
+    }
+    check(&all, "torn write at any byte boots the prior board", torn_ok);
+    check(&all, "inserts after a torn write survive", torn_then_insert_ok);
+
+    // Many more inserts than slots, rebooting along the way. An early high
+    // score has to outlive the head passing its slot, and the rest
+    // sometimes miss the board and sometimes tie a row.
+    uint32_t rng = 0x7E57AB1Eu;
+    bool wrap_ok = true;
+    char name[JOURNAL_NAME_LENGTH + 1u];
+    erase_eeprom();
+    journal_recover(&journal, &table);
+    for (uint32_t i = 1u; i <= JOURNAL_WRAP_INSERTS; ++i) {
+        snprintf(name, sizeof name, "W%u", i);
+        (void)journal_insert(&journal, &table, name, i == 2u ? 1000u : 1u + i / 2u + selftest_random(&rng) % 8u);
+        if (i % JOURNAL_WRAP_REBOOT == 0u || i == JOURNAL_WRAP_INSERTS) {
+            simon_highscore_table_t kept = table;
+            wrap_ok = wrap_ok && boots_to(&journal, &table, &kept);
+        }
+    }
+    check(&all, "board survives the ring wrapping round", wrap_ok);
+    return all ? 0 : 1;
+}
+
+// --- outcome store ---
+
+#define OUTCOME_TEST_TAIL   1000u // rows in the partial block after the full one
+#define OUTCOME_TEST_LATE   10u   // rows appended after reopening the file
+#define OUTCOME_TEST_ROWS   (1u + OUTCOME_BLOCK_ROWS + OUTCOME_TEST_TAIL + OUTCOME_TEST_LATE)
+#define OUTCOME_TEST_BLOCKS 4u
+
+typedef struct {
+    simon_outcome_t outcome;
+    uint32_t ended_at;
+} outcome_row_t;
+
+typedef struct {
+    uint64_t rows;
+    uint32_t blocks;
+    uint32_t mismatches;
+    uint32_t encodings[OUTCOME_ENCODING_COUNT];
+    size_t last_block;   // offset of the last whole block
+    bool header_ok;
+} outcome_readback_t;
+
+/*
+ * Rows that push every column to its edges: a clock that creeps up for
+ * DELTA, a handful of delays for DICT, full-width seeds for FOR, signed
+ * octaves, and zero and all-ones values.
+ */
+static void outcome_rows(outcome_row_t *rows, uint32_t count)
+{
+    static const uint16_t delays[] = {250u, 400u, 600u, 900u, 1500u, 2400u};
+    uint32_t rng = 0x0C7C0A1Eu;
+
+    for (uint32_t i = 0u; i < count; ++i) {
+        simon_outcome_t *outcome = &rows[i].outcome;
+        rows[i].ended_at = 1700000000u + i / 3u;
+        outcome->score = selftest_random(&rng) % 40u;
+        outcome->level = outcome->score + 1u;
+        outcome->seed = i == 0u ? 0u : (i == 1u ? UINT32_MAX : selftest_random(&rng));
+        outcome->duration_ms = selftest_random(&rng) % 600000u;
+        outcome->playback_delay_ms = delays[selftest_random(&rng) % (sizeof delays / sizeof delays[0])];
+        outcome->octave_shift = (int8_t)((int32_t)(selftest_random(&rng) % 5u) - 2);
+    }
+}
+
+static bool outcome_append_rows(const char *path, const outcome_row_t *rows, uint32_t count, bool flush_first)
+{
+    outcome_writer_t writer;
+    bool ok = outcome_writer_open(&writer, path);
+
+    for (uint32_t i = 0u; ok && i < count; ++i) {
+        ok = outcome_writer_append(&writer, &rows[i].outcome, rows[i].ended_at);
+        if (flush_first && i == 0u) {
+            ok = ok && outcome_writer_flush(&writer);
+        }
+    }
+    outcome_writer_close(&writer);
+    return ok;
+}
+
+// Decode every whole block of `path` and compare it with `expected`.
+static outcome_readback_t outcome_read_back(const char *path, const outcome_row_t *expected, uint32_t count)
+{
+    outcome_readback_t result = {0};
+    uint32_t *values = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+    uint32_t *scratch = malloc(OUTCOME_BLOCK_ROWS * sizeof(uint32_t));
+    uint8_t *bytes = NULL;
+    size_t size = 0u;
+    FILE *file = fopen(path, "rb");
+
+    if (file != NULL && fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        size = length > 0 ? (size_t)length : 0u;
+        bytes = malloc(size + 1u);
+        rewind(file);
+        if (bytes == NULL || fread(bytes, 1u, size, file) != size) {
+            size = 0u;
+        }
+    }
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    const outcome_file_header_t *header = (const void *)bytes;
+    result.header_ok = size >= sizeof *header && memcmp(header->magic, OUTCOME_MAGIC, sizeof header->magic) == 0 &&
+                       header->version == OUTCOME_VERSION && header->column_count == OUTCOME_COLUMN_COUNT;
+    size_t offset = sizeof *header;
+    while (result.header_ok && values != NULL && scratch != NULL &&
+           size - offset >= sizeof(outcome_block_header_t)) {
+        outcome_block_header_t block;
+        memcpy(&block, bytes + offset, sizeof block);
+        if (block.magic != OUTCOME_BLOCK_MAGIC || block.rows == 0u || block.rows > OUTCOME_BLOCK_ROWS ||
+            block.payload_bytes > size - offset - sizeof block) {
+            break;
+        }
+
+        // The payload has to follow its header, so decode from an aligned copy.
+        outcome_block_header_t *copy = malloc(sizeof block + block.payload_bytes);
+        if (copy == NULL) {
+            break;
+        }
+        memcpy(copy, bytes + offset, sizeof block + block.payload_bytes);
+        for (uint32_t column = 0u; column < OUTCOME_COLUMN_COUNT; ++column) {
+            result.encodings[copy->columns[column].encoding % OUTCOME_ENCODING_COUNT]++;
+            outcome_decode_column(copy, (outcome_column_t)column, values, scratch);
+            for (uint32_t i = 0u; i < block.rows; ++i) {
+                uint64_t row = result.rows + i;
+                if (row >= count) {
+                    result.mismatches++;
+                    continue;
+                }
+                const simon_outcome_t *outcome = &expected[row].outcome;
+                uint32_t want[OUTCOME_COLUMN_COUNT] = {
+                    [OUTCOME_COLUMN_ENDED_AT] = expected[row].ended_at,
+                    [OUTCOME_COLUMN_SCORE] = outcome->score,
+                    [OUTCOME_COLUMN_LEVEL] = outcome->level,
+                    [OUTCOME_COLUMN_SEED] = outcome->seed,
+                    [OUTCOME_COLUMN_DURATION_MS] = outcome->duration_ms,
+                    [OUTCOME_COLUMN_DELAY_MS] = outcome->playback_delay_ms,
+                    [OUTCOME_COLUMN_OCTAVE] = (uint32_t)(int32_t)outcome->octave_shift,
+                };
+                result.mismatches += values[i] != want[column];
+            }
+        }
+        free(copy);
+        result.last_block = offset;
+        result.rows += block.rows;
+        result.blocks++;
+        offset += sizeof block + block.payload_bytes;
+    }
+
+    free(bytes);
+    free(values);
+    free(scratch);
+    return result;
+}
+
+int selftest_outcome(void)
+{
+    char path[] = "/tmp/simon-outcome-XXXXXX";
+    outcome_row_t *rows = malloc(OUTCOME_TEST_ROWS * sizeof *rows);
+    bool all = true;
+
+    int fd = mkstemp(path);
+    if (fd < 0 || rows == NULL) {
+        perror("outcome selftest");
+        free(rows);
+        return 1;
+    }
+    close(fd);
+    outcome_rows(rows, OUTCOME_TEST_ROWS);
+
+    // A one-row block, a block filled to the limit and a partial block on
+    // close, then one more block from a second writer on the same file.
+    uint32_t first = 1u + OUTCOME_BLOCK_ROWS + OUTCOME_TEST_TAIL;
+    bool written = outcome_append_rows(path, rows, first, true) &&
+                   outcome_append_rows(path, rows + first, OUTCOME_TEST_LATE, false);
+    check(&all, "writer opens, appends and closes", written);
+
+    outcome_readback_t back = outcome_read_back(path, rows, OUTCOME_TEST_ROWS);
+    check(&all, "file header written once", back.header_ok);
+    check(&all, "every row decodes to what was written", back.rows == OUTCOME_TEST_ROWS && back.mismatches == 0u);
+    check(&all, "blocks split at the row limit and on flush", back.blocks == OUTCOME_TEST_BLOCKS);
+    check(&all, "FOR, DELTA and DICT all round-trip",
+          back.encodings[OUTCOME_ENCODING_FOR] > 0u && back.encodings[OUTCOME_ENCODING_DELTA] > 0u &&
+              back.encodings[OUTCOME_ENCODING_DICT] > 0u);
+
+    // Tear the last block inside its header, as a crash would: the next
+    // writer cuts it off and its own rows follow the blocks before it.
+    off_t tear = (off_t)(back.last_block + sizeof(outcome_block_header_t) / 2u);
+    bool torn = truncate(path, tear) == 0 &&
+                outcome_append_rows(path, rows + first, OUTCOME_TEST_LATE, false);
+    back = outcome_read_back(path, rows, OUTCOME_TEST_ROWS);
+    check(&all, "torn last block is replaced on reopen",
+          torn && back.rows == OUTCOME_TEST_ROWS && back.mismatches == 0u && back.blocks == OUTCOME_TEST_BLOCKS);
+
+    unlink(path);
+    free(rows);
+    return all ? 0 : 1;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,45 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#if defined(__linux__)
+
+/*
+ * Host self-checks for the parts every game depends on. Each prints one
+ * line per check and returns the process exit status: 0 when all pass.
+ */
+
+/*
+ * Framed protocol: the CRC against its published check value, replies to
+ * well-formed and batched frames, the NAK for a bad CRC, resync after a
+ * torn frame, the timeout for a stalled one, and link mode.
+ */
+int selftest_protocol(void);
+
+/*
+ * Timer wheel: randomized timers on every level, some re-armed from their
+ * callbacks and some cancelled, must fire exactly on their deadlines, from
+ * zero and across the 32-bit wrap. timer_wheel_advance must fire them on
+ * the same ticks as ticking one at a time, and timer_wheel_next_work must
+ * never promise idle ticks past a deadline.
+ */
+int selftest_wheel(void);
+
+/*
+ * Highscore journal on the in-memory EEPROM: an erased part, a reboot after
+ * inserts, a corrupted newest record, power cut after each byte of a
+ * record, and the write head wrapping the ring several times. Every boot
+ * must rebuild the board the game last saw in full, and the journal must
+ * keep taking inserts afterwards.
+ */
+int selftest_journal(void);
+
+/*
+ * Outcome store: rows written through the block writer decode to the same
+ * values in every column and encoding, blocks split where they should, and
+ * a torn last block is cut off by the next writer.
+ */
+int selftest_outcome(void);
+
+#endif /* __linux__ */
+
+#endif /* SELFTEST_H */
@@ -0,0 +1,69 @@
+#include "seqlock.h"
+
+#include <string.h>
+
+void seqlock_init(seqlock_t *lock)
+{
+    lock->sequence = 0u;
+}
+
+#if defined(__AVR__)
+
+void seqlock_write_begin(seqlock_t *lock)
+{
+    lock->sequence++;
+}
+
+void seqlock_write_end(seqlock_t *lock)
+{
+    lock->sequence++;
+}
+
+uint32_t seqlock_read(const seqlock_t *lock, const void *shared, void *data, size_t size)
+{
+    (void)lock;
+    memcpy(data, shared, size);
+    return 0u;
+}
+
+#else
+
+void seqlock_write_begin(seqlock_t *lock)
+{
+    uint32_t sequence = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->sequence, sequence + 1u, __ATOMIC_RELAXED);
+    // Keep the block stores after the odd sequence is visible.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void seqlock_write_end(seqlock_t *lock)
+{
+    uint32_t sequence = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->sequence, sequence + 1u, __ATOMIC_RELEASE);
+}
+
+uint32_t seqlock_read(const seqlock_t *lock, const void *shared, void *data, size_t size)
+{
+    const uint32_t *words = shared;
+    uint32_t *copy = data;
+    uint32_t retries = 0u;
+
+    for (;;) {
+        uint32_t before = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE);
+        if ((before & 1u) == 0u) {
+            for (size_t i = 0u; i < size / sizeof(uint32_t); ++i) {
+                copy[i] = __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+            }
+            // Keep the block loads before the second look at the sequence.
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) == before) {
+                return retries;
+            }
+        }
+        retries++;
+    }
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sequence lock for a block written by one thread and read by any number
+ * of others. The writer never waits: it makes the sequence odd, updates
+ * the block in place and makes the sequence even again. A reader copies
+ * the block out and starts over if the sequence was odd or moved
+ * meanwhile, so it only ever returns a copy no write overlapped.
+ *
+ * The owning thread reads the block directly. Other threads copy it a
+ * 32-bit word at a time, so it must be word aligned and a whole number of
+ * words long. The board has a single thread and never calls seqlock_read.
+ */
+typedef struct {
+    uint32_t sequence;
+} seqlock_t;
+
+void seqlock_init(seqlock_t *lock);
+void seqlock_write_begin(seqlock_t *lock);
+void seqlock_write_end(seqlock_t *lock);
+// Copy `shared` into `data`; returns how many torn attempts were retried.
+uint32_t seqlock_read(const seqlock_t *lock, const void *shared, void *data, size_t size);
+
+#endif /* SEQLOCK_H */
@@ -0,0 +1,71 @@
+#include "sequence.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t bytes_for_steps(uint32_t steps)
+{
+    return (steps + SEQUENCE_STEPS_PER_BYTE - 1u) / SEQUENCE_STEPS_PER_BYTE;
+}
+
+static bool grow(simon_sequence_t *sequence)
+{
+    if (sequence->capacity > UINT32_MAX / 2u) {
+        return false;
+    }
+
+    uint32_t capacity = sequence->capacity * 2u;
+    uint8_t *bytes = realloc(sequence->heap, bytes_for_steps(capacity));
+    if (bytes == NULL) {
+        return false;
+    }
+
+    if (sequence->heap == NULL) {
+        memcpy(bytes, sequence->inline_data, sizeof sequence->inline_data);
+    }
+    sequence->heap = bytes;
+    sequence->capacity = capacity;
+    return true;
+}
+
+void sequence_init(simon_sequence_t *sequence)
+{
+    sequence->heap = NULL;
+    sequence->length = 0u;
+    sequence->capacity = SEQUENCE_INLINE_STEPS;
+    memset(sequence->inline_data, 0, sizeof sequence->inline_data);
+}
+
+void sequence_clear(simon_sequence_t *sequence)
+{
+    // Keep any heap buffer and its capacity: the next endurance run will
+    // want it again, and appends go on writing into it.
+    sequence->length = 0u;
+}
+
+void sequence_free(simon_sequence_t *sequence)
+{
+    free(sequence->heap);
+    sequence_init(sequence);
+}
+
+bool sequence_append(simon_sequence_t *sequence, uint8_t colour)
+{
+    if (sequence->length == sequence->capacity && !grow(sequence)) {
+        return false;
+    }
+
+    uint8_t *bytes = (sequence->heap != NULL) ? sequence->heap : sequence->inline_data;
+    uint32_t index = sequence->length;
+    uint8_t shift = (uint8_t)((index % SEQUENCE_STEPS_PER_BYTE) * SEQUENCE_BITS_PER_STEP);
+    uint8_t *byte = &bytes[index / SEQUENCE_STEPS_PER_BYTE];
+
+    *byte = (uint8_t)((*byte & ~(SEQUENCE_STEP_MASK << shift)) | ((colour & SEQUENCE_STEP_MASK) << shift));
+    sequence->length++;
+    return true;
+}
+
+uint32_t sequence_storage_bytes(const simon_sequence_t *sequence)
+{
+    return bytes_for_steps(sequence->capacity);
+}
@@ -0,0 +1,46 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "variant.h"
+
+// Up to four pads fit two bits a step; six and eight take a nibble.
+#if SIMON_BUTTON_COUNT <= 4
+#define SEQUENCE_BITS_PER_STEP  2u
+#else
+#define SEQUENCE_BITS_PER_STEP  4u
+#endif
+#define SEQUENCE_STEPS_PER_BYTE (8u / SEQUENCE_BITS_PER_STEP)
+#define SEQUENCE_STEP_MASK      ((1u << SEQUENCE_BITS_PER_STEP) - 1u)
+#define SEQUENCE_INLINE_STEPS   32u
+
+/*
+ * Colour sequence packed SEQUENCE_BITS_PER_STEP bits per step. Short games
+ * live in the inline bytes; longer ones move to a heap buffer that doubles
+ * as it fills. Clearing keeps the buffer and its capacity for the next
+ * game; the capacity takes the padding after the length, so the struct
+ * stays small enough to sit in a game's hot cache line.
+ */
+typedef struct {
+    uint8_t *heap;
+    uint32_t length;
+    uint32_t capacity;  // in steps; SEQUENCE_INLINE_STEPS until the heap is used
+    uint8_t inline_data[SEQUENCE_INLINE_STEPS / SEQUENCE_STEPS_PER_BYTE];
+} simon_sequence_t;
+
+void sequence_init(simon_sequence_t *sequence);
+void sequence_clear(simon_sequence_t *sequence);
+void sequence_free(simon_sequence_t *sequence);
+bool sequence_append(simon_sequence_t *sequence, uint8_t colour);
+uint32_t sequence_storage_bytes(const simon_sequence_t *sequence);
+
+static inline uint8_t sequence_get(const simon_sequence_t *sequence, uint32_t index)
+{
+    const uint8_t *bytes = (sequence->heap != 0) ? sequence->heap : sequence->inline_data;
+    uint8_t shift = (uint8_t)((index % SEQUENCE_STEPS_PER_BYTE) * SEQUENCE_BITS_PER_STEP);
+    return (uint8_t)((bytes[index / SEQUENCE_STEPS_PER_BYTE] >> shift) & SEQUENCE_STEP_MASK);
+}
+
+#endif /* SEQUENCE_H */
@@ -0,0 +1,598 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "server.h"
+#include "board.h"
+#include "game.h"
+#include "hardware.h"
+#include "outcome.h"
+#include "pool.h"
+#include "protocol.h"
+#include "timer_wheel.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVER_MAX_EVENTS     256
+#define SERVER_BACKLOG        1024
+#define SERVER_OUTPUT_LIMIT   (256u * 1024u)
+#define SERVER_IDLE_TIMEOUT_S 300u
+#define SERVER_WAIT_MS        1000
+
+typedef struct server_session {
+    int fd;
+    bool discarding_line;
+    bool closing;
+    size_t input_length;
+    char input[BOARD_MAX_LINE];
+    char *output;
+    size_t output_length;
+    size_t output_capacity;
+    bool output_overflow;
+    bool waiting_for_writable;
+    timer_node_t idle_timer;
+    struct server *server;
+    hardware_context_t hardware;
+    simon_protocol_t protocol;
+    simon_pool_handle_t game_handle;
+    simon_game_t *game;
+    timer_wheel_t game_wheel;
+    uint32_t clock_ms;
+} server_session_t;
+
+/*
+ * Each session keeps its own game wheel because its clock only moves on
+ * the client's tick commands. Idle connections share one wheel that
+ * advances once per wall-clock second.
+ */
+typedef struct server {
+    int epoll_fd;
+    int listen_fd;
+    uint32_t session_count;
+    uint32_t idle_clock_s;
+    timer_wheel_t idle_wheel;
+    simon_pool_t games;
+    // Finished games from every session; file is NULL when not recording.
+    outcome_writer_t outcomes;
+} server_t;
+
+static uint32_t monotonic_seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec;
+}
+
+static void session_output(void *user, const char *data, size_t length)
+{
+    server_session_t *session = user;
+
+    if (session->output_overflow) {
+        return;
+    }
+
+    if (session->output_length + length > session->output_capacity) {
+        size_t capacity = (session->output_capacity == 0u) ? 1024u : session->output_capacity;
+        while (capacity < session->output_length + length) {
+            capacity *= 2u;
+        }
+        if (capacity > SERVER_OUTPUT_LIMIT) {
+            // The client is not reading; stop buffering and drop it.
+            session->output_overflow = true;
+            return;
+        }
+        char *grown = realloc(session->output, capacity);
+        if (grown == NULL) {
+            session->output_overflow = true;
+            return;
+        }
+        session->output = grown;
+        session->output_capacity = capacity;
+    }
+
+    memcpy(session->output + session->output_length, data, length);
+    session->output_length += length;
+}
+
+static void session_close(server_t *server, server_session_t *session)
+{
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, session->fd, NULL);
+    close(session->fd);
+    timer_wheel_cancel(&server->idle_wheel, &session->idle_timer);
+    simon_pool_release(&server->games, session->game_handle);
+    free(session->output);
+    free(session);
+    server->session_count--;
+}
+
+static void session_idle_expired(timer_node_t *node)
+{
+    server_session_t *session = (server_session_t *)((char *)node - offsetof(server_session_t, idle_timer));
+    session_close(session->server, session);
+}
+
+static void session_watch_writable(server_t *server, server_session_t *session, bool enable)
+{
+    if (session->waiting_for_writable == enable) {
+        return;
+    }
+
+    struct epoll_event event = {
+        .events = EPOLLIN | EPOLLRDHUP | (enable ? EPOLLOUT : 0u),
+        .data.ptr = session,
+    };
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, session->fd, &event);
+    session->waiting_for_writable = enable;
+}
+
+static bool session_flush(server_t *server, server_session_t *session)
+{
+    size_t sent = 0u;
+
+    while (sent < session->output_length) {
+        ssize_t written = send(session->fd, session->output + sent, session->output_length - sent, MSG_NOSIGNAL);
+        if (written > 0) {
+            sent += (size_t)written;
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+
+    if (sent > 0u) {
+        memmove(session->output, session->output + sent, session->output_length - sent);
+        session->output_length -= sent;
+    }
+
+    session_watch_writable(server, session, session->output_length > 0u);
+    return !session->output_overflow;
+}
+
+static void session_handle_line(server_session_t *session, char *line)
+{
+    uint32_t previous_ms = session->clock_ms;
+    board_event_t event = board_parse_line(line, &session->clock_ms);
+
+    if (event.type == BOARD_EVENT_QUIT) {
+        session->closing = true;
+        return;
+    }
+
+    // Only tick lines move the session clock; catch the game up in one go.
+    game_advance_ms(session->game, event.timestamp_ms - previous_ms);
+    protocol_handle_event(&session->protocol, session->game, &event);
+}
+
+static void session_consume_input(server_session_t *session, const char *data, size_t length)
+{
+    hardware_bind_context(&session->hardware);
+
+    for (size_t i = 0u; i < length && !session->closing; ++i) {
+        char value = data[i];
+
+        if (value == '\n') {
+            if (!session->discarding_line) {
+                session->input[session->input_length] = '\0';
+                session_handle_line(session, session->input);
+            }
+            session->input_length = 0u;
+            session->discarding_line = false;
+            continue;
+        }
+
+        if (session->input_length + 1u >= sizeof session->input) {
+            // Oversized lines are dropped whole, like fgets would split them.
+            session->discarding_line = true;
+            continue;
+        }
+        session->input[session->input_length++] = value;
+    }
+
+    hardware_bind_context(NULL);
+}
+
+static void session_readable(server_t *server, server_session_t *session)
+{
+    char buffer[4096];
+
+    for (;;) {
+        ssize_t received = recv(session->fd, buffer, sizeof buffer, 0);
+        if (received > 0) {
+            session_consume_input(session, buffer, (size_t)received);
+            if (session->closing) {
+                break;
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        session->closing = true;
+        break;
+    }
+
+    timer_wheel_schedule(&server->idle_wheel, &session->idle_timer, SERVER_IDLE_TIMEOUT_S);
+}
+
+static void server_accept(server_t *server)
+{
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        server_session_t *session = calloc(1u, sizeof *session);
+        if (session == NULL) {
+            close(fd);
+            continue;
+        }
+
+        session->fd = fd;
+        session->server = server;
+        timer_node_init(&session->idle_timer, session_idle_expired);
+        timer_wheel_init(&session->game_wheel);
+        hardware_context_init(&session->hardware, session_output, session);
+        protocol_init(&session->protocol);
+
+        // Every connection is a new player at a cabinet the server keeps:
+        // a recycled game keeps that slot's leaderboard and sketches.
+        hardware_bind_context(&session->hardware);
+        session->game_handle = simon_pool_acquire(&server->games, &session->game_wheel, false);
+        session->game = simon_pool_get(&server->games, session->game_handle);
+        hardware_bind_context(NULL);
+        if (session->game != NULL && server->outcomes.file != NULL) {
+            game_set_outcome_sink(session->game, outcome_writer_sink, &server->outcomes);
+        }
+
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = session};
+        if (session->game == NULL || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            simon_pool_release(&server->games, session->game_handle);
+            close(fd);
+            free(session->output);
+            free(session);
+            continue;
+        }
+
+        server->session_count++;
+        timer_wheel_schedule(&server->idle_wheel, &session->idle_timer, SERVER_IDLE_TIMEOUT_S);
+
+        if (!session_flush(server, session)) {
+            session_close(server, session);
+        }
+    }
+}
+
+static void server_expire_idle(server_t *server, uint32_t now_s)
+{
+    // Outcomes reach the file within a second even when games are few.
+    if (server->idle_clock_s != now_s && server->outcomes.file != NULL) {
+        (void)outcome_writer_flush(&server->outcomes);
+    }
+    while (server->idle_clock_s != now_s) {
+        server->idle_clock_s++;
+        timer_wheel_tick(&server->idle_wheel);
+    }
+}
+
+// A Unix socket for paths, else a loopback TCP port; false if neither.
+static bool parse_address(const char *address, struct sockaddr_storage *storage, socklen_t *length)
+{
+    memset(storage, 0, sizeof *storage);
+
+    if (address[0] == '/' || address[0] == '.') {
+        struct sockaddr_un *local = (struct sockaddr_un *)storage;
+        if (strlen(address) >= sizeof local->sun_path) {
+            fprintf(stderr, "socket path too long: %s\n", address);
+            return false;
+        }
+        local->sun_family = AF_UNIX;
+        strcpy(local->sun_path, address);
+        *length = sizeof *local;
+        return true;
+    }
+
+    char *end = NULL;
+    long port = strtol(address, &end, 10);
+    if (end == address || *end != '\0' || port <= 0 || port > 65535) {
+        fprintf(stderr, "invalid server address: %s\n", address);
+        return false;
+    }
+
+    struct sockaddr_in *loopback = (struct sockaddr_in *)storage;
+    loopback->sin_family = AF_INET;
+    loopback->sin_port = htons((uint16_t)port);
+    loopback->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    *length = sizeof *loopback;
+    return true;
+}
+
+static int open_listener(const char *address)
+{
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int reuse = 1;
+
+    if (!parse_address(address, &storage, &length)) {
+        return -1;
+    }
+    if (storage.ss_family == AF_UNIX) {
+        unlink(address);
+    }
+
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if (storage.ss_family == AF_INET) {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+    }
+    if (bind(fd, (struct sockaddr *)&storage, length) != 0) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, SERVER_BACKLOG) != 0) {
+        perror("listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const char *address)
+{
+    static server_t server;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+
+    signal(SIGPIPE, SIG_IGN);
+
+    server.listen_fd = open_listener(address);
+    if (server.listen_fd < 0) {
+        return 1;
+    }
+
+    server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (server.epoll_fd < 0 || epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &listen_event) != 0) {
+        perror("epoll");
+        return 1;
+    }
+
+    simon_pool_init(&server.games);
+    const char *outcome_path = getenv("SIMON_OUTCOME_FILE");
+    if (outcome_path != NULL && !outcome_writer_open(&server.outcomes, outcome_path)) {
+        perror(outcome_path);
+    }
+    timer_wheel_init(&server.idle_wheel);
+    server.idle_clock_s = monotonic_seconds();
+    printf("Simon server listening on %s\n", address);
+    fflush(stdout);
+
+    for (;;) {
+        int count = epoll_wait(server.epoll_fd, events, SERVER_MAX_EVENTS, SERVER_WAIT_MS);
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return 1;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            server_session_t *session = events[i].data.ptr;
+
+            if (session == NULL) {
+                server_accept(&server);
+                continue;
+            }
+
+            if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0u) {
+                session_readable(&server, session);
+            }
+
+            bool healthy = session_flush(&server, session);
+            if (!healthy || (session->closing && session->output_length == 0u)) {
+                session_close(&server, session);
+            }
+        }
+
+        server_expire_idle(&server, monotonic_seconds());
+    }
+}
+
+// --- load generator ---
+
+typedef struct {
+    int fd;
+    uint32_t matched;      // bytes of LOAD_REPLY seen so far
+    bool waiting;
+    uint64_t sent_ns;
+} load_client_t;
+
+// Each round moves every game on a little and asks for its score.
+#define LOAD_REQUEST "tick 10\ncmd c\n"
+#define LOAD_REPLY   "SCORE "
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return (left > right) - (left < right);
+}
+
+// Read what has arrived; true once the reply this client waits for is in.
+static bool load_client_readable(load_client_t *client)
+{
+    static const char reply[] = LOAD_REPLY;
+    char buffer[4096];
+    bool done = false;
+
+    for (;;) {
+        ssize_t received = recv(client->fd, buffer, sizeof buffer, 0);
+        if (received <= 0) {
+            return done;
+        }
+        for (ssize_t i = 0; i < received && client->waiting; ++i) {
+            client->matched = (buffer[i] == reply[client->matched]) ? client->matched + 1u
+                              : (buffer[i] == reply[0])             ? 1u
+                                                                    : 0u;
+            if (client->matched == sizeof reply - 1u) {
+                client->matched = 0u;
+                client->waiting = false;
+                done = true;
+            }
+        }
+    }
+}
+
+static bool raise_fd_limit(uint32_t wanted)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return false;
+    }
+    if (limit.rlim_cur >= wanted) {
+        return true;
+    }
+    limit.rlim_cur = (limit.rlim_max == RLIM_INFINITY || limit.rlim_max >= wanted) ? wanted : limit.rlim_max;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur >= wanted;
+}
+
+int server_load(const char *address, uint32_t sessions, uint32_t rounds)
+{
+    struct sockaddr_storage storage;
+    socklen_t length;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int status = 1;
+
+    if (sessions == 0u || !parse_address(address, &storage, &length)) {
+        return 1;
+    }
+    if (!raise_fd_limit(sessions + 64u)) {
+        fprintf(stderr, "cannot open %u descriptors; raise ulimit -n\n", sessions + 64u);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    load_client_t *clients = calloc(sessions, sizeof *clients);
+    uint64_t *latency = calloc(sessions, sizeof *latency);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    uint32_t connected = 0u;
+
+    if (clients == NULL || latency == NULL || epoll_fd < 0) {
+        perror("server_load");
+        goto done;
+    }
+
+    uint64_t start = monotonic_ns();
+    for (; connected < sessions; ++connected) {
+        load_client_t *client = &clients[connected];
+        client->fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (client->fd < 0 || connect(client->fd, (struct sockaddr *)&storage, length) != 0) {
+            perror("connect");
+            if (client->fd >= 0) {
+                close(client->fd);
+            }
+            goto done;
+        }
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        if (fcntl(client->fd, F_SETFL, O_NONBLOCK) != 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client->fd, &event) != 0) {
+            perror("epoll_ctl");
+            close(client->fd);
+            goto done;
+        }
+    }
+    printf("%u sessions connected in %.2f s\n", sessions, (double)(monotonic_ns() - start) / 1e9);
+
+    status = 0;
+    for (uint32_t round = 0u; round < rounds && status == 0; ++round) {
+        uint32_t answered = 0u;
+
+        start = monotonic_ns();
+        for (uint32_t i = 0u; i < sessions; ++i) {
+            clients[i].waiting = true;
+            clients[i].sent_ns = monotonic_ns();
+            if (send(clients[i].fd, LOAD_REQUEST, sizeof LOAD_REQUEST - 1u, MSG_NOSIGNAL) !=
+                (ssize_t)(sizeof LOAD_REQUEST - 1u)) {
+                perror("send");
+                status = 1;
+                break;
+            }
+        }
+
+        while (status == 0 && answered < sessions) {
+            int count = epoll_wait(epoll_fd, events, SERVER_MAX_EVENTS, 5000);
+            if (count <= 0) {
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                fprintf(stderr, "round %u: %u of %u sessions never answered\n", round + 1u, sessions - answered,
+                        sessions);
+                status = 1;
+                break;
+            }
+            uint64_t now = monotonic_ns();
+            for (int i = 0; i < count; ++i) {
+                load_client_t *client = events[i].data.ptr;
+                if (client->waiting && load_client_readable(client)) {
+                    latency[answered++] = now - client->sent_ns;
+                } else if (!client->waiting) {
+                    (void)load_client_readable(client);
+                }
+            }
+        }
+        if (status != 0) {
+            break;
+        }
+
+        double wall = (double)(monotonic_ns() - start) / 1e9;
+        qsort(latency, sessions, sizeof *latency, compare_u64);
+        printf("round %u: %u replies in %.3f s, %.0f/s, latency p50 %.2f ms p99 %.2f ms max %.2f ms\n",
+               round + 1u, sessions, wall, sessions / wall, (double)latency[sessions / 2u] / 1e6,
+               (double)latency[(uint64_t)sessions * 99u / 100u] / 1e6, (double)latency[sessions - 1u] / 1e6);
+    }
+
+done:
+    for (uint32_t i = 0u; i < connected; ++i) {
+        close(clients[i].fd);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+    free(latency);
+    free(clients);
+    return status;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,20 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdint.h>
+
+/*
+ * Multi-session game server. Each connection gets its own game and
+ * hardware context and speaks the console command set, one command per
+ * line. The address is either a filesystem path for a Unix socket or a
+ * TCP port number bound to the loopback interface.
+ */
+int server_run(const char *address);
+/*
+ * Load generator for a running server: open `sessions` connections to
+ * `address`, then for each of `rounds` rounds tick every game and ask it
+ * for its score, reporting reply latency percentiles per round.
+ */
+int server_load(const char *address, uint32_t sessions, uint32_t rounds);
+
+#endif /* SERVER_H */
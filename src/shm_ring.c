@@ -0,0 +1,435 @@
+#if defined(__linux__)
+
+#define _GNU_SOURCE
+
+#include "shm_ring.h"
+#include "variant.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_RING_MASK      (SHM_RING_CAPACITY - 1u)
+#define VIEW_POLL_NS       1000000L
+
+_Static_assert(sizeof(hardware_change_t) == sizeof(uint64_t), "a change must fit one slot payload");
+_Static_assert((SHM_RING_CAPACITY & SHM_RING_MASK) == 0u, "ring capacity must be a power of two");
+
+static void object_name(char *buffer, size_t size, const char *name)
+{
+    // shm_open wants a single leading slash.
+    snprintf(buffer, size, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+static uint64_t pack_change(const hardware_change_t *change)
+{
+    uint64_t payload;
+    memcpy(&payload, change, sizeof payload);
+    return payload;
+}
+
+static void unpack_change(uint64_t payload, hardware_change_t *change)
+{
+    memcpy(change, &payload, sizeof payload);
+}
+
+static bool ring_is_compatible(const shm_ring_header_t *header)
+{
+    return __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == SHM_RING_MAGIC &&
+           header->version == SHM_RING_VERSION && header->capacity == SHM_RING_CAPACITY &&
+           header->slot_size == sizeof(shm_ring_slot_t);
+}
+
+// Take over a ring a previous producer left under this name, if it is one.
+static bool adopt_existing(shm_ring_t *ring)
+{
+    struct stat status;
+    int fd = shm_open(ring->name, O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &status) != 0 || status.st_size != (off_t)sizeof(shm_ring_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    shm_ring_header_t *header = mmap(NULL, sizeof(shm_ring_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) {
+        return false;
+    }
+    if (!ring_is_compatible(header)) {
+        munmap(header, sizeof(shm_ring_header_t));
+        return false;
+    }
+
+    // Head and the slot stamps carry on from where they were, so attached
+    // readers see new records and never a ring zeroed under them.
+    __atomic_fetch_add(&header->generation, 1u, __ATOMIC_RELEASE);
+    ring->header = header;
+    return true;
+}
+
+bool shm_ring_create(shm_ring_t *ring, const char *name)
+{
+    object_name(ring->name, sizeof ring->name, name);
+
+    if (adopt_existing(ring)) {
+        return true;
+    }
+
+    // Anything else under the name is replaced, not truncated: a reader
+    // still mapping the old object keeps it intact.
+    shm_unlink(ring->name);
+    int fd = shm_open(ring->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, sizeof(shm_ring_header_t)) != 0) {
+        close(fd);
+        shm_unlink(ring->name);
+        return false;
+    }
+
+    ring->header = mmap(NULL, sizeof(shm_ring_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring->header == MAP_FAILED) {
+        ring->header = NULL;
+        shm_unlink(ring->name);
+        return false;
+    }
+
+    // A fresh mapping is zeroed, which marks every slot as unwritten.
+    ring->header->version = SHM_RING_VERSION;
+    ring->header->capacity = SHM_RING_CAPACITY;
+    ring->header->slot_size = sizeof(shm_ring_slot_t);
+    ring->header->generation = 1u;
+    __atomic_store_n(&ring->header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+void shm_ring_destroy(shm_ring_t *ring)
+{
+    if (ring->header != NULL) {
+        munmap(ring->header, sizeof(shm_ring_header_t));
+        shm_unlink(ring->name);
+        ring->header = NULL;
+    }
+}
+
+static char signal_unlink_name[64];
+
+static void unlink_on_signal(int signal_number)
+{
+    // shm_unlink is an unlink(2) under /dev/shm on Linux, which is safe here.
+    shm_unlink(signal_unlink_name);
+    signal(signal_number, SIG_DFL);
+    raise(signal_number);
+}
+
+void shm_ring_unlink_on_signal(const shm_ring_t *ring)
+{
+    memcpy(signal_unlink_name, ring->name, sizeof signal_unlink_name);
+    signal(SIGINT, unlink_on_signal);
+    signal(SIGTERM, unlink_on_signal);
+    signal(SIGHUP, unlink_on_signal);
+}
+
+void shm_ring_publish(shm_ring_t *ring, const hardware_change_t *change)
+{
+    shm_ring_header_t *header = ring->header;
+    uint64_t sequence = header->head;
+    shm_ring_slot_t *slot = &header->slots[sequence & SHM_RING_MASK];
+
+    // Per-slot seqlock: clear the stamp, write the payload, then publish
+    // the new stamp. A reader that sees the same stamp before and after
+    // its copy got a whole record.
+    __atomic_store_n(&slot->stamp, 0u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->payload, pack_change(change), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->stamp, sequence + 1u, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->head, sequence + 1u, __ATOMIC_RELEASE);
+}
+
+void shm_ring_observer(void *user, const hardware_change_t *change)
+{
+    shm_ring_publish(user, change);
+}
+
+bool shm_ring_attach(shm_ring_reader_t *reader, const char *name, bool from_oldest)
+{
+    char object[64];
+    object_name(object, sizeof object, name);
+
+    int fd = shm_open(object, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    const shm_ring_header_t *header = mmap(NULL, sizeof(shm_ring_header_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) {
+        return false;
+    }
+    if (!ring_is_compatible(header)) {
+        munmap((void *)header, sizeof(shm_ring_header_t));
+        return false;
+    }
+
+    uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    reader->header = header;
+    reader->lost = 0u;
+    reader->next = head;
+    if (from_oldest) {
+        reader->next = (head > SHM_RING_CAPACITY) ? head - SHM_RING_CAPACITY : 0u;
+    }
+    return true;
+}
+
+void shm_ring_detach(shm_ring_reader_t *reader)
+{
+    if (reader->header != NULL) {
+        munmap((void *)reader->header, sizeof(shm_ring_header_t));
+        reader->header = NULL;
+    }
+}
+
+static shm_ring_read_result_t skip_to_oldest(shm_ring_reader_t *reader)
+{
+    uint64_t head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+    // Leave one slot of slack: the producer may already be rewriting the
+    // oldest one.
+    uint64_t oldest = (head > SHM_RING_CAPACITY - 1u) ? head - (SHM_RING_CAPACITY - 1u) : 0u;
+
+    if (oldest > reader->next) {
+        reader->lost += oldest - reader->next;
+        reader->next = oldest;
+    }
+    return SHM_RING_READ_OVERRUN;
+}
+
+shm_ring_read_result_t shm_ring_read(shm_ring_reader_t *reader, hardware_change_t *change, uint64_t *sequence)
+{
+    const shm_ring_slot_t *slot = &reader->header->slots[reader->next & SHM_RING_MASK];
+    uint64_t wanted = reader->next + 1u;
+
+    uint64_t before = __atomic_load_n(&slot->stamp, __ATOMIC_ACQUIRE);
+    uint64_t payload = __atomic_load_n(&slot->payload, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t after = __atomic_load_n(&slot->stamp, __ATOMIC_RELAXED);
+
+    if (before == wanted && after == wanted) {
+        unpack_change(payload, change);
+        if (sequence != NULL) {
+            *sequence = reader->next;
+        }
+        reader->next++;
+        return SHM_RING_READ_OK;
+    }
+
+    // The slot moved on past us, or is being rewritten for a later lap.
+    if (before > wanted || after > wanted || __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE) > wanted) {
+        return skip_to_oldest(reader);
+    }
+    return SHM_RING_READ_EMPTY;
+}
+
+static void print_change(uint64_t sequence, const hardware_change_t *change)
+{
+    switch (change->kind) {
+    case HARDWARE_CHANGE_PATTERN: {
+        char leds[SIMON_BUTTON_COUNT + 1];
+        for (uint8_t i = 0u; i < SIMON_BUTTON_COUNT; ++i) {
+            leds[i] = (change->a & (1u << (SIMON_BUTTON_COUNT - 1u - i))) ? '|' : '.';
+        }
+        leds[SIMON_BUTTON_COUNT] = '\0';
+        printf("%10llu  LED  %s\n", (unsigned long long)sequence, leds);
+        break;
+    }
+    case HARDWARE_CHANGE_SEGMENTS:
+        printf("%10llu  SEG  %02X:%02X\n", (unsigned long long)sequence, change->a, change->b);
+        break;
+    case HARDWARE_CHANGE_BUZZER:
+        if (change->a == 0xFFu) {
+            printf("%10llu  BUZ  off\n", (unsigned long long)sequence);
+        } else {
+            printf("%10llu  BUZ  tone %u octave %d  %u.%02u Hz\n", (unsigned long long)sequence, change->a,
+                   (int8_t)change->b, change->value / 100u, change->value % 100u);
+        }
+        break;
+    default:
+        printf("%10llu  ???  kind %u\n", (unsigned long long)sequence, change->kind);
+        break;
+    }
+}
+
+int shm_ring_view(const char *name)
+{
+    shm_ring_reader_t reader;
+    const struct timespec poll_interval = {.tv_sec = 0, .tv_nsec = VIEW_POLL_NS};
+
+    if (!shm_ring_attach(&reader, name, true)) {
+        fprintf(stderr, "cannot attach to ring %s\n", name);
+        return 1;
+    }
+    uint64_t generation = __atomic_load_n(&reader.header->generation, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        hardware_change_t change;
+        uint64_t sequence;
+        uint64_t lost = reader.lost;
+
+        switch (shm_ring_read(&reader, &change, &sequence)) {
+        case SHM_RING_READ_OK:
+            print_change(sequence, &change);
+            break;
+        case SHM_RING_READ_OVERRUN:
+            printf("    overrun: %llu records lost\n", (unsigned long long)(reader.lost - lost));
+            break;
+        case SHM_RING_READ_EMPTY:
+            if (__atomic_load_n(&reader.header->generation, __ATOMIC_ACQUIRE) != generation) {
+                generation = __atomic_load_n(&reader.header->generation, __ATOMIC_ACQUIRE);
+                printf("    producer restarted (generation %llu)\n", (unsigned long long)generation);
+            }
+            fflush(stdout);
+            nanosleep(&poll_interval, NULL);
+            break;
+        }
+    }
+}
+
+typedef struct {
+    const char *name;
+    const bool *stop;
+    uint32_t *ready;  // readers that have attached, or given up trying
+    bool attached;
+    uint64_t received;
+    uint64_t lost;
+    uint64_t out_of_order;
+} bench_reader_t;
+
+static void *bench_reader_main(void *argument)
+{
+    bench_reader_t *bench = argument;
+    shm_ring_reader_t reader;
+    uint64_t expected = 0u;
+    bool stopping = false;
+
+    bench->attached = shm_ring_attach(&reader, bench->name, true);
+    __atomic_fetch_add(bench->ready, 1u, __ATOMIC_RELEASE);
+    if (!bench->attached) {
+        return NULL;
+    }
+
+    for (;;) {
+        hardware_change_t change;
+        uint64_t sequence;
+        shm_ring_read_result_t result = shm_ring_read(&reader, &change, &sequence);
+
+        if (result == SHM_RING_READ_OK) {
+            // The bench producer stores each record's sequence in it.
+            if (change.value != (uint32_t)sequence || sequence < expected) {
+                bench->out_of_order++;
+            }
+            expected = sequence + 1u;
+            bench->received++;
+        } else if (result == SHM_RING_READ_EMPTY) {
+            // An empty read from before the stop may predate the last
+            // records, so only one made after seeing it ends the run.
+            if (stopping) {
+                break;
+            }
+            stopping = __atomic_load_n(bench->stop, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    bench->lost = reader.lost;
+    shm_ring_detach(&reader);
+    return NULL;
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int shm_ring_bench(uint32_t readers, uint32_t records)
+{
+    char name[64];
+    shm_ring_t ring;
+    pthread_t threads[64];
+    bench_reader_t benches[64];
+    bool stop = false;
+    uint32_t ready = 0u;
+    uint32_t started = 0u;
+
+    if (readers > 64u) {
+        readers = 64u;
+    }
+    snprintf(name, sizeof name, "/simon-bench-%d", (int)getpid());
+    if (!shm_ring_create(&ring, name)) {
+        perror("shm_ring_create");
+        return 1;
+    }
+
+    int error = 0;
+    for (; started < readers; ++started) {
+        benches[started] = (bench_reader_t){.name = name, .stop = &stop, .ready = &ready};
+        error = pthread_create(&threads[started], NULL, bench_reader_main, &benches[started]);
+        if (error != 0) {
+            break;
+        }
+    }
+
+    // Readers attach where the ring's head is; publishing before they all
+    // have would hide the early records from the late ones.
+    const struct timespec attach_poll = {.tv_nsec = 100000};
+    while (__atomic_load_n(&ready, __ATOMIC_ACQUIRE) < started) {
+        nanosleep(&attach_poll, NULL);
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0u; error == 0 && i < records; ++i) {
+        hardware_change_t change = {.kind = HARDWARE_CHANGE_PATTERN, .a = (uint8_t)i, .value = i};
+        shm_ring_publish(&ring, &change);
+    }
+    double elapsed = seconds_since(&start);
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    bool attached = true;
+    for (uint32_t i = 0u; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+        attached = attached && benches[i].attached;
+    }
+    if (error != 0 || !attached) {
+        if (error != 0) {
+            fprintf(stderr, "ring bench: cannot start reader %u: %s\n", started, strerror(error));
+        } else {
+            fprintf(stderr, "ring bench: a reader could not attach to %s\n", name);
+        }
+        shm_ring_destroy(&ring);
+        return 1;
+    }
+
+    printf("published %u records in %.3f s: %.1f M records/s with %u readers\n", records, elapsed,
+           records / elapsed / 1e6, readers);
+    for (uint32_t i = 0u; i < readers; ++i) {
+        printf("  reader %u: %llu received, %llu lost to overruns, %llu out of order\n", i,
+               (unsigned long long)benches[i].received, (unsigned long long)benches[i].lost,
+               (unsigned long long)benches[i].out_of_order);
+    }
+
+    shm_ring_destroy(&ring);
+    return 0;
+}
+
+#endif /* __linux__ */
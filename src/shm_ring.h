@@ -0,0 +1,84 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#if defined(__linux__)
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware.h"
+
+/*
+ * Single-producer, multi-consumer ring of hardware changes in POSIX shared
+ * memory, for visual frontends. The game never waits for a reader: every
+ * slot carries the sequence number of the record in it, so a reader that
+ * falls more than a ring behind sees the newer sequence and reports the
+ * records it lost instead of reading stale or torn data.
+ *
+ * Readers map the ring read-only and can attach and detach at any time,
+ * starting either at the live edge or at the oldest record still held.
+ * A producer that finds a compatible ring under its name takes it over
+ * where the last one left off, bumping the generation, so readers that
+ * stayed attached across a restart carry on rather than see it zeroed.
+ */
+#define SHM_RING_MAGIC    0x53524E47u  // "SRNG"
+#define SHM_RING_VERSION  1u
+#define SHM_RING_CAPACITY 4096u        // records; a power of two
+
+typedef struct {
+    uint64_t stamp;   // sequence + 1 once written, 0 while being written
+    uint64_t payload; // hardware_change_t
+} shm_ring_slot_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slot_size;
+    uint64_t head;    // sequence of the next record to publish
+    uint64_t generation;  // producers that have published here
+    uint64_t reserved[4];
+    shm_ring_slot_t slots[SHM_RING_CAPACITY];
+} shm_ring_header_t;
+
+typedef struct {
+    shm_ring_header_t *header;
+    char name[64];
+} shm_ring_t;
+
+typedef enum {
+    SHM_RING_READ_OK = 0,
+    SHM_RING_READ_EMPTY,
+    SHM_RING_READ_OVERRUN
+} shm_ring_read_result_t;
+
+typedef struct {
+    const shm_ring_header_t *header;
+    uint64_t next;
+    uint64_t lost;
+} shm_ring_reader_t;
+
+bool shm_ring_create(shm_ring_t *ring, const char *name);
+// Unmap the ring and remove its name; readers already attached keep it.
+void shm_ring_destroy(shm_ring_t *ring);
+// Also remove the name if the process is stopped by SIGINT, SIGTERM or SIGHUP.
+void shm_ring_unlink_on_signal(const shm_ring_t *ring);
+void shm_ring_publish(shm_ring_t *ring, const hardware_change_t *change);
+// hardware_observer_fn adapter; `user` is the shm_ring_t.
+void shm_ring_observer(void *user, const hardware_change_t *change);
+
+bool shm_ring_attach(shm_ring_reader_t *reader, const char *name, bool from_oldest);
+void shm_ring_detach(shm_ring_reader_t *reader);
+/*
+ * Take the next record. On overrun the reader skips to the oldest record
+ * still held, adds the gap to `lost` and returns SHM_RING_READ_OVERRUN;
+ * the following call carries on from there.
+ */
+shm_ring_read_result_t shm_ring_read(shm_ring_reader_t *reader, hardware_change_t *change, uint64_t *sequence);
+
+int shm_ring_view(const char *name);
+int shm_ring_bench(uint32_t readers, uint32_t records);
+
+#endif /* __linux__ */
+
+#endif /* SHM_RING_H */
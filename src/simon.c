@@ -1,8 +1,8 @@
 #include "simon.h"
 
-void simon_game_init(simon_game_t *game)
+void simon_game_init(simon_game_t *game, simon_game_cold_t *cold, timer_wheel_t *wheel)
 {
-    game_init(game);
+    game_init(game, cold, wheel);
 }
 
 void simon_game_handle_event(simon_game_t *game, const board_event_t *event)
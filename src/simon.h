@@ -3,7 +3,7 @@
 
 #include "game.h"
 
-void simon_game_init(simon_game_t *game);
+void simon_game_init(simon_game_t *game, simon_game_cold_t *cold, timer_wheel_t *wheel);
 void simon_game_handle_event(simon_game_t *game, const board_event_t *event);
 void simon_game_tick(simon_game_t *game);
 
@@ -0,0 +1,278 @@
+#include "sketch.h"
+
+#if SIMON_SKETCH_K > 0
+
+#include <string.h>
+
+#define MIN_LEVEL_CAPACITY 2u
+
+static uint8_t level_size(const sketch_t *sketch, uint8_t level)
+{
+    return (uint8_t)(sketch->starts[level + 1u] - sketch->starts[level]);
+}
+
+// K for the top level, two thirds of the level above for the rest.
+static uint8_t level_capacity(const sketch_t *sketch, uint8_t level)
+{
+    uint16_t capacity = SIMON_SKETCH_K;
+
+    for (uint8_t depth = (uint8_t)(sketch->levels - 1u - level); depth > 0u && capacity > MIN_LEVEL_CAPACITY;
+         --depth) {
+        capacity = (uint16_t)(capacity * 2u / 3u);
+    }
+    return capacity < MIN_LEVEL_CAPACITY ? MIN_LEVEL_CAPACITY : (uint8_t)capacity;
+}
+
+static void add_level(sketch_t *sketch)
+{
+    sketch->levels++;
+    sketch->starts[sketch->levels] = SKETCH_CAPACITY;
+}
+
+// Insertion sort: a level is a few sorted runs, which this handles in near linear time.
+static void sort_items(uint16_t *items, uint8_t count)
+{
+    for (uint8_t i = 1u; i < count; ++i) {
+        uint16_t value = items[i];
+        uint8_t j = i;
+        while (j > 0u && items[j - 1u] > value) {
+            items[j] = items[j - 1u];
+            j--;
+        }
+        items[j] = value;
+    }
+}
+
+/*
+ * Halve `level` into the one above. An odd sample out stays behind, and
+ * the space freed goes to the front of the block, where level 0 grows.
+ */
+static void compact_level(sketch_t *sketch, uint8_t level)
+{
+    uint8_t begin = sketch->starts[level];
+    uint8_t end = sketch->starts[level + 1u];
+    uint8_t size = (uint8_t)(end - begin);
+    uint8_t odd = size & 1u;
+    uint8_t half = (uint8_t)(size / 2u);
+    uint8_t offset = sketch->coin & 1u;
+
+    // Galois LFSR over eight bits: a fair coin that never lines up with the data.
+    sketch->coin = (uint8_t)((sketch->coin >> 1) ^ (-(sketch->coin & 1u) & 0xB8u));
+    sort_items(&sketch->items[begin], size);
+
+    // Survivors move to the top of the range, next to the level above;
+    // going downwards never overwrites one still to be read.
+    for (uint8_t i = half; i-- > 0u;) {
+        sketch->items[end - half + i] = sketch->items[begin + odd + 2u * i + offset];
+    }
+    if (odd != 0u) {
+        sketch->items[end - half - 1u] = sketch->items[begin];
+    }
+
+    uint8_t freed = (uint8_t)(end - half - odd - begin);
+    memmove(&sketch->items[sketch->starts[0] + freed], &sketch->items[sketch->starts[0]],
+            (size_t)(begin - sketch->starts[0]) * sizeof sketch->items[0]);
+    for (uint8_t h = 0u; h < level; ++h) {
+        sketch->starts[h] = (uint8_t)(sketch->starts[h] + freed);
+    }
+    sketch->starts[level] = (uint8_t)(end - half - odd);
+    sketch->starts[level + 1u] = (uint8_t)(end - half);
+}
+
+// Make room for one more sample at the front of the block.
+static void compress(sketch_t *sketch)
+{
+    uint8_t level = 0u;
+
+    while (level + 1u < sketch->levels && level_size(sketch, level) < level_capacity(sketch, level)) {
+        level++;
+    }
+    if (level + 1u == sketch->levels) {
+        // Compactions keep the total weight at `count`, so two samples at
+        // level 31 would already be 2^32 of them: the levels always fit.
+        add_level(sketch);
+    }
+    compact_level(sketch, level);
+}
+
+// Put `value` at `level`, moving the levels below it down a slot.
+static void insert_at_level(sketch_t *sketch, uint8_t level, uint16_t value)
+{
+    if (sketch->starts[0] == 0u) {
+        compress(sketch);
+    }
+
+    uint8_t first = sketch->starts[0];
+    memmove(&sketch->items[first - 1u], &sketch->items[first],
+            (size_t)(sketch->starts[level] - first) * sizeof sketch->items[0]);
+    for (uint8_t h = 0u; h <= level; ++h) {
+        sketch->starts[h]--;
+    }
+    sketch->items[sketch->starts[level]] = value;
+}
+
+void sketch_init(sketch_t *sketch)
+{
+    sketch->count = 0u;
+    sketch->min = UINT16_MAX;
+    sketch->max = 0u;
+    sketch->levels = 1u;
+    sketch->coin = 0xA5u;
+    sketch->starts[0] = SKETCH_CAPACITY;
+    sketch->starts[1] = SKETCH_CAPACITY;
+}
+
+void sketch_update(sketch_t *sketch, uint16_t value)
+{
+    if (sketch->count == UINT32_MAX) {
+        return;
+    }
+    sketch->count++;
+    if (value < sketch->min) {
+        sketch->min = value;
+    }
+    if (value > sketch->max) {
+        sketch->max = value;
+    }
+
+    if (sketch->starts[0] == 0u) {
+        compress(sketch);
+    }
+    sketch->items[--sketch->starts[0]] = value;
+}
+
+void sketch_merge(sketch_t *into, const sketch_t *from)
+{
+    if (from->count == 0u) {
+        return;
+    }
+    if (from->count > UINT32_MAX - into->count) {
+        return;
+    }
+    into->count += from->count;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+
+    for (uint8_t level = 0u; level < from->levels; ++level) {
+        while (into->levels <= level) {
+            add_level(into);
+        }
+        for (uint8_t i = from->starts[level]; i < from->starts[level + 1u]; ++i) {
+            insert_at_level(into, level, from->items[i]);
+        }
+    }
+}
+
+/*
+ * Quadratic in the block size, but it needs no scratch memory and only
+ * runs when someone asks.
+ */
+uint16_t sketch_quantile(const sketch_t *sketch, uint16_t permille)
+{
+    if (sketch->count == 0u) {
+        return 0u;
+    }
+    if (permille == 0u) {
+        return sketch->min;
+    }
+    if (permille >= 1000u) {
+        return sketch->max;
+    }
+
+    uint64_t target = ((uint64_t)sketch->count * permille + 999u) / 1000u;
+
+    uint16_t best = sketch->max;
+    for (uint8_t i = sketch->starts[0]; i < SKETCH_CAPACITY; ++i) {
+        uint16_t candidate = sketch->items[i];
+        if (candidate >= best) {
+            continue;
+        }
+        uint64_t rank = 0u;
+        for (uint8_t level = 0u; level < sketch->levels; ++level) {
+            for (uint8_t j = sketch->starts[level]; j < sketch->starts[level + 1u]; ++j) {
+                if (sketch->items[j] <= candidate) {
+                    rank += 1ull << level;
+                }
+            }
+        }
+        if (rank >= target) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+uint16_t sketch_export(const sketch_t *sketch, uint8_t *out, uint16_t capacity)
+{
+    uint16_t used = (uint16_t)(SKETCH_CAPACITY - sketch->starts[0]);
+    uint16_t length = (uint16_t)(SKETCH_EXPORT_HEADER + sketch->levels + 2u * used);
+    uint16_t pos = 0u;
+
+    if (length > capacity) {
+        return 0u;
+    }
+    out[pos++] = (uint8_t)(sketch->count >> 24);
+    out[pos++] = (uint8_t)(sketch->count >> 16);
+    out[pos++] = (uint8_t)(sketch->count >> 8);
+    out[pos++] = (uint8_t)sketch->count;
+    out[pos++] = (uint8_t)(sketch->min >> 8);
+    out[pos++] = (uint8_t)sketch->min;
+    out[pos++] = (uint8_t)(sketch->max >> 8);
+    out[pos++] = (uint8_t)sketch->max;
+    out[pos++] = sketch->levels;
+    out[pos++] = sketch->coin;
+    for (uint8_t level = 0u; level < sketch->levels; ++level) {
+        out[pos++] = level_size(sketch, level);
+    }
+    // Levels sit in order from starts[0] to the end of the block.
+    for (uint8_t i = sketch->starts[0]; i < SKETCH_CAPACITY; ++i) {
+        out[pos++] = (uint8_t)(sketch->items[i] >> 8);
+        out[pos++] = (uint8_t)sketch->items[i];
+    }
+    return pos;
+}
+
+bool sketch_import(sketch_t *sketch, const uint8_t *in, uint16_t length)
+{
+    if (length < SKETCH_EXPORT_HEADER) {
+        return false;
+    }
+    uint8_t levels = in[8];
+    if (levels == 0u || levels > SKETCH_MAX_LEVELS || length < SKETCH_EXPORT_HEADER + levels) {
+        return false;
+    }
+
+    uint32_t count = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+    const uint8_t *sizes = &in[SKETCH_EXPORT_HEADER];
+    uint16_t used = 0u;
+    uint64_t weight = 0u;
+    for (uint8_t level = 0u; level < levels; ++level) {
+        used = (uint16_t)(used + sizes[level]);
+        weight += (uint64_t)sizes[level] << level;
+    }
+    if (used > SKETCH_CAPACITY || length != SKETCH_EXPORT_HEADER + levels + 2u * used || weight != count) {
+        return false;
+    }
+
+    sketch->count = count;
+    sketch->min = (uint16_t)(((uint16_t)in[4] << 8) | in[5]);
+    sketch->max = (uint16_t)(((uint16_t)in[6] << 8) | in[7]);
+    sketch->levels = levels;
+    sketch->coin = in[9];
+    sketch->starts[levels] = SKETCH_CAPACITY;
+    for (uint8_t level = levels; level-- > 0u;) {
+        sketch->starts[level] = (uint8_t)(sketch->starts[level + 1u] - sizes[level]);
+    }
+    const uint8_t *samples = &sizes[levels];
+    for (uint8_t i = sketch->starts[0]; i < SKETCH_CAPACITY; ++i) {
+        sketch->items[i] = (uint16_t)(((uint16_t)samples[0] << 8) | samples[1]);
+        samples += 2;
+    }
+    return true;
+}
+
+#endif /* SIMON_SKETCH_K > 0 */
@@ -0,0 +1,67 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "variant.h"
+
+#if SIMON_SKETCH_K > 0
+
+/*
+ * KLL quantile sketch of 16-bit samples in a fixed block of memory.
+ *
+ * Samples sit in levels; one at level h stands for 2^h of the originals.
+ * New samples go to level 0, and once the block is full the lowest level
+ * over its capacity is sorted and every other sample (a coin picks which
+ * half) moves up a level at double the weight. Level capacities shrink by
+ * a third per level down from SIMON_SKETCH_K at the top, so the block
+ * holds every level a 32-bit count can need and updates never allocate.
+ * A sample costs O(1) amortized; the rank error is about 1.7 / K in the
+ * worst case and well under that in practice.
+ *
+ * Two sketches merge by adding one's samples to the other at their own
+ * levels, so the result is the sketch of both streams.
+ */
+#define SKETCH_MAX_LEVELS 32u
+#define SKETCH_CAPACITY   (3u * SIMON_SKETCH_K + 2u * SKETCH_MAX_LEVELS)
+
+_Static_assert(SKETCH_CAPACITY <= UINT8_MAX, "level offsets are eight bits");
+
+/*
+ * Export form, for moving a sketch off the board or between builds, all
+ * big endian: count (4), min (2), max (2), levels (1), coin (1), then the
+ * size of each level (1 each, level 0 first) and the samples (2 each) in
+ * the same level order. Only the samples in use are written.
+ */
+#define SKETCH_EXPORT_HEADER 10u
+#define SKETCH_EXPORT_MAX    (SKETCH_EXPORT_HEADER + SKETCH_MAX_LEVELS + 2u * SKETCH_CAPACITY)
+
+typedef struct {
+    uint32_t count;  // samples seen
+    uint16_t min;
+    uint16_t max;
+    uint8_t levels;  // in use, at least one
+    uint8_t coin;    // LFSR; bit 0 picks the half the next compaction keeps
+    // Level h spans items[starts[h], starts[h + 1]); the block fills downwards.
+    uint8_t starts[SKETCH_MAX_LEVELS + 1u];
+    uint16_t items[SKETCH_CAPACITY];
+} sketch_t;
+
+void sketch_init(sketch_t *sketch);
+void sketch_update(sketch_t *sketch, uint16_t value);
+void sketch_merge(sketch_t *into, const sketch_t *from);
+// The sample at `permille` thousandths of the way up; 0 when empty.
+uint16_t sketch_quantile(const sketch_t *sketch, uint16_t permille);
+// Bytes written to `out`, or 0 if `capacity` is too small.
+uint16_t sketch_export(const sketch_t *sketch, uint8_t *out, uint16_t capacity);
+/*
+ * Rebuild a sketch from its export. Fails, leaving `sketch` untouched, if
+ * the bytes are cut short, overlong or describe levels whose weights do
+ * not add up to the count.
+ */
+bool sketch_import(sketch_t *sketch, const uint8_t *in, uint16_t length);
+
+#endif /* SIMON_SKETCH_K > 0 */
+
+#endif /* SKETCH_H */
@@ -0,0 +1,119 @@
+#include "stimulus.h"
+#include "profile.h"
+#include "sequence.h"
+#include "stimulus_table.h"
+
+#include <string.h>
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#endif
+
+#define STIMULUS_STEP_COUNT ((uint16_t)(sizeof stimulus_steps / sizeof stimulus_steps[0]))
+
+static bool waits_for_input(uint8_t kind)
+{
+    return kind == STIMULUS_EXPECTED || kind == STIMULUS_WRONG || kind == STIMULUS_PLAY;
+}
+
+static void make_button_event(board_event_t *event, uint8_t button)
+{
+    event->type = BOARD_EVENT_BUTTON;
+    event->data.button.button = (board_button_t)button;
+    event->data.button.long_press = false;
+}
+
+void stimulus_init(stimulus_player_t *player)
+{
+    player->clock_ms = 0u;
+    player->step = 0u;
+    player->waited_ms = 0u;
+}
+
+bool stimulus_finished(const stimulus_player_t *player)
+{
+    return player->step >= STIMULUS_STEP_COUNT || stimulus_steps[player->step].kind == STIMULUS_END;
+}
+
+static bool next_step(stimulus_player_t *player, const simon_game_t *game, board_event_t *event)
+{
+    if (stimulus_finished(player)) {
+        return false;
+    }
+
+    const stimulus_step_t *step = &stimulus_steps[player->step];
+
+    if (step->kind == STIMULUS_PLAY && (game->level > step->value || game->state == SIMON_STATE_ATTRACT)) {
+        player->step++;
+        player->waited_ms = 0u;
+        return next_step(player, game, event);
+    }
+    if (waits_for_input(step->kind) && game->state != SIMON_STATE_WAIT_INPUT) {
+        player->waited_ms = 0u;
+        return false;
+    }
+    if (player->waited_ms < step->delay_ms) {
+        player->waited_ms++;
+        return false;
+    }
+    player->waited_ms = 0u;
+
+    uint8_t expected = sequence_get(&game->sequence, game->input_step);
+    switch ((stimulus_kind_t)step->kind) {
+    case STIMULUS_PRESS:
+        make_button_event(event, (uint8_t)step->value);
+        break;
+
+    case STIMULUS_EXPECTED:
+    case STIMULUS_PLAY:
+        make_button_event(event, expected);
+        break;
+
+    case STIMULUS_WRONG:
+        make_button_event(event, (uint8_t)((expected + 1u) % SIMON_BUTTON_COUNT));
+        break;
+
+    case STIMULUS_POT:
+        event->type = BOARD_EVENT_POT;
+        event->data.pot.value = step->value;
+        break;
+
+    case STIMULUS_UART: {
+        size_t length = strlen(step->text);
+        if (length > BOARD_MAX_UART_BYTES) {
+            length = BOARD_MAX_UART_BYTES;
+        }
+        event->type = BOARD_EVENT_UART;
+        event->data.uart.length = (uint8_t)length;
+        memcpy(event->data.uart.bytes, step->text, length);
+        break;
+    }
+
+    case STIMULUS_END:
+        return false;
+    }
+
+    // A play step stays current until its last level is cleared.
+    if (step->kind != STIMULUS_PLAY) {
+        player->step++;
+    }
+    return true;
+}
+
+bool stimulus_poll(stimulus_player_t *player, const simon_game_t *game, board_event_t *event)
+{
+    event->timestamp_ms = ++player->clock_ms;
+    return next_step(player, game, event);
+}
+
+void stimulus_halt(void)
+{
+    PROFILE_ENTER(PROFILE_DONE);
+#if defined(__AVR__)
+    // simavr ends the run when the core sleeps with interrupts off.
+    cli();
+    sleep_enable();
+    sleep_cpu();
+#endif
+}
@@ -0,0 +1,52 @@
+#ifndef STIMULUS_H
+#define STIMULUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "game.h"
+
+/*
+ * Scripted input for builds with SIMON_SCRIPTED_STIMULUS, which run
+ * without a console or a person at the buttons, such as the tick
+ * profiler under simavr. The steps come from stimulus_table.h, generated
+ * by scripts/tick_profile.py from a text script.
+ *
+ * Each step fires `delay_ms` ticks after the previous one. Steps that
+ * press the expected or a wrong button, or play whole levels, also wait
+ * until the game is asking for input, and then use the delay as the
+ * player's reaction time.
+ */
+typedef enum {
+    STIMULUS_PRESS = 1, // value = button
+    STIMULUS_EXPECTED,
+    STIMULUS_WRONG,
+    STIMULUS_PLAY,      // press the expected buttons until level `value` is cleared
+    STIMULUS_POT,       // value = reading
+    STIMULUS_UART,      // text = bytes, sent in one tick
+    STIMULUS_END
+} stimulus_kind_t;
+
+typedef struct {
+    uint16_t delay_ms;
+    uint8_t kind;
+    uint16_t value;
+    const char *text;
+} stimulus_step_t;
+
+typedef struct {
+    uint32_t clock_ms;
+    uint16_t step;
+    uint16_t waited_ms;
+} stimulus_player_t;
+
+void stimulus_init(stimulus_player_t *player);
+// Once per millisecond; stamps `event` with the player's clock. True when
+// `event` holds input to deliver this millisecond.
+bool stimulus_poll(stimulus_player_t *player, const simon_game_t *game, board_event_t *event);
+bool stimulus_finished(const stimulus_player_t *player);
+// Mark the end of the run; on the board this also stops the simulator.
+void stimulus_halt(void);
+
+#endif /* STIMULUS_H */
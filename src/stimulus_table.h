@@ -0,0 +1,35 @@
+#ifndef STIMULUS_TABLE_H
+#define STIMULUS_TABLE_H
+
+/* Generated by scripts/tick_profile.py from scripts/profile_stimulus.txt; do not edit. */
+
+#include "stimulus.h"
+
+static const stimulus_step_t stimulus_steps[] = {
+    {100u, STIMULUS_POT, 512u, NULL},
+    {50u, STIMULUS_UART, 0u, "d"},
+    {2000u, STIMULUS_PRESS, 0u, NULL},
+    {300u, STIMULUS_PLAY, 6u, NULL},
+    {300u, STIMULUS_EXPECTED, 0u, NULL},
+    {300u, STIMULUS_EXPECTED, 0u, NULL},
+    {300u, STIMULUS_EXPECTED, 0u, NULL},
+    {300u, STIMULUS_EXPECTED, 0u, NULL},
+    {300u, STIMULUS_EXPECTED, 0u, NULL},
+    {300u, STIMULUS_WRONG, 0u, NULL},
+    {1500u, STIMULUS_UART, 0u, "ALICE\r"},
+    {500u, STIMULUS_UART, 0u, "h"},
+    {200u, STIMULUS_UART, 0u, "g"},
+    {10u, STIMULUS_UART, 0u, "0123456789afijklmnopqtuvwxyz0\r"},
+    {100u, STIMULUS_UART, 0u, "e"},
+    {100u, STIMULUS_POT, 0u, NULL},
+    {100u, STIMULUS_UART, 0u, "s"},
+    {250u, STIMULUS_PLAY, 4u, NULL},
+    {250u, STIMULUS_EXPECTED, 0u, NULL},
+    {250u, STIMULUS_EXPECTED, 0u, NULL},
+    {250u, STIMULUS_EXPECTED, 0u, NULL},
+    {250u, STIMULUS_WRONG, 0u, NULL},
+    {7000u, STIMULUS_UART, 0u, "h"},
+    {500u, STIMULUS_END, 0u, NULL},
+};
+
+#endif /* STIMULUS_TABLE_H */
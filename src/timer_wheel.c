@@ -0,0 +1,167 @@
+#include "timer_wheel.h"
+
+static void link_node(timer_wheel_t *wheel, timer_node_t *node)
+{
+    uint32_t delta = node->expires - wheel->now;
+    uint8_t level = 0u;
+
+    while (level + 1u < TIMER_WHEEL_LEVELS && delta >= (1ul << (TIMER_WHEEL_SLOT_BITS * (level + 1u)))) {
+        level++;
+    }
+
+    uint8_t shift = (uint8_t)(TIMER_WHEEL_SLOT_BITS * level);
+    timer_node_t **slot = &wheel->slots[level][(node->expires >> shift) & TIMER_WHEEL_SLOT_MASK];
+
+    node->next = *slot;
+    if (*slot != NULL) {
+        (*slot)->pprev = &node->next;
+    }
+    node->pprev = slot;
+    *slot = node;
+}
+
+static void unlink_node(timer_node_t *node)
+{
+    *node->pprev = node->next;
+    if (node->next != NULL) {
+        node->next->pprev = node->pprev;
+    }
+    node->next = NULL;
+    node->pprev = NULL;
+}
+
+static uint8_t cascade(timer_wheel_t *wheel, uint8_t level)
+{
+    uint8_t index = (uint8_t)((wheel->now >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK);
+    timer_node_t *node = wheel->slots[level][index];
+
+    wheel->slots[level][index] = NULL;
+    while (node != NULL) {
+        timer_node_t *next = node->next;
+        link_node(wheel, node);
+        node = next;
+    }
+    return index;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel)
+{
+    for (uint8_t level = 0u; level < TIMER_WHEEL_LEVELS; ++level) {
+        for (uint8_t slot = 0u; slot < TIMER_WHEEL_SLOTS; ++slot) {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+    wheel->now = 0u;
+    wheel->pending = 0u;
+}
+
+void timer_node_init(timer_node_t *node, timer_callback_t callback)
+{
+    node->next = NULL;
+    node->pprev = NULL;
+    node->callback = callback;
+    node->expires = 0u;
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_node_t *node, uint32_t delay)
+{
+    timer_wheel_cancel(wheel, node);
+
+    if (delay == 0u) {
+        delay = 1u;
+    } else if (delay > TIMER_WHEEL_MAX_DELAY) {
+        delay = (uint32_t)TIMER_WHEEL_MAX_DELAY;
+    }
+
+    node->expires = wheel->now + delay;
+    link_node(wheel, node);
+    wheel->pending++;
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *node)
+{
+    if (node->pprev != NULL) {
+        unlink_node(node);
+        wheel->pending--;
+    }
+}
+
+void timer_wheel_tick(timer_wheel_t *wheel)
+{
+    wheel->now++;
+
+    if (wheel->pending == 0u) {
+        return;
+    }
+
+    for (uint8_t level = 1u; level < TIMER_WHEEL_LEVELS; ++level) {
+        if (((wheel->now >> (TIMER_WHEEL_SLOT_BITS * (level - 1u))) & TIMER_WHEEL_SLOT_MASK) != 0u) {
+            break;
+        }
+        (void)cascade(wheel, level);
+    }
+
+    timer_node_t **slot = &wheel->slots[0][wheel->now & TIMER_WHEEL_SLOT_MASK];
+    while (*slot != NULL) {
+        // Callbacks may re-arm their own timer; a re-armed timer lands in a
+        // later slot, so this loop always drains.
+        timer_node_t *node = *slot;
+        unlink_node(node);
+        wheel->pending--;
+        node->callback(node);
+    }
+}
+
+uint32_t timer_wheel_next_work(const timer_wheel_t *wheel)
+{
+    uint32_t best = TIMER_WHEEL_IDLE;
+
+    if (wheel->pending == 0u) {
+        return best;
+    }
+
+    // Level 0 only holds deadlines within one revolution, so the first
+    // occupied slot is the exact next expiry.
+    for (uint32_t ahead = 1u; ahead <= TIMER_WHEEL_SLOTS; ++ahead) {
+        if (wheel->slots[0][(wheel->now + ahead) & TIMER_WHEEL_SLOT_MASK] != NULL) {
+            best = ahead;
+            break;
+        }
+    }
+
+    // Above that a slot only bounds its deadlines, so the wheel has to run
+    // at the boundary where the slot cascades.
+    for (uint8_t level = 1u; level < TIMER_WHEEL_LEVELS; ++level) {
+        uint8_t shift = (uint8_t)(TIMER_WHEEL_SLOT_BITS * level);
+        uint32_t base = wheel->now >> shift;
+
+        // Boundaries only get further away, so stop at the best so far.
+        for (uint32_t ahead = 1u; ahead <= TIMER_WHEEL_SLOTS; ++ahead) {
+            uint32_t delta = ((base + ahead) << shift) - wheel->now;
+            if (delta >= best) {
+                break;
+            }
+            if (wheel->slots[level][(base + ahead) & TIMER_WHEEL_SLOT_MASK] != NULL) {
+                best = delta;
+                break;
+            }
+        }
+    }
+
+    return best;
+}
+
+void timer_wheel_advance(timer_wheel_t *wheel, uint32_t ticks)
+{
+    while (ticks > 0u) {
+        uint32_t next = timer_wheel_next_work(wheel);
+
+        if (next > ticks) {
+            wheel->now += ticks;
+            return;
+        }
+        wheel->now += next - 1u;
+        ticks -= next;
+        timer_wheel_tick(wheel);
+    }
+}
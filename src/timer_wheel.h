@@ -0,0 +1,65 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__AVR__)
+#define TIMER_WHEEL_SLOT_BITS 4u
+#else
+#define TIMER_WHEEL_SLOT_BITS 6u
+#endif
+#define TIMER_WHEEL_LEVELS    4u
+#define TIMER_WHEEL_SLOTS     (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1u)
+#define TIMER_WHEEL_MAX_DELAY ((1ul << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1ul)
+#define TIMER_WHEEL_IDLE      UINT32_MAX
+
+struct timer_node;
+typedef void (*timer_callback_t)(struct timer_node *node);
+
+/*
+ * Intrusive timer. Embed one in the owning object and recover the owner in
+ * the callback with offsetof. `pprev` is NULL while the timer is idle.
+ */
+typedef struct timer_node {
+    struct timer_node *next;
+    struct timer_node **pprev;
+    timer_callback_t callback;
+    uint32_t expires;
+} timer_node_t;
+
+/*
+ * Hierarchical timing wheel: the first level resolves single ticks and each
+ * further level covers TIMER_WHEEL_SLOTS times the span of the one below.
+ * Timers cascade down a level as their deadline comes into range, so a tick
+ * costs the timers that expire plus an amortised share of cascades.
+ */
+typedef struct {
+    timer_node_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint32_t now;
+    uint32_t pending;
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *wheel);
+void timer_node_init(timer_node_t *node, timer_callback_t callback);
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_node_t *node, uint32_t delay);
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *node);
+void timer_wheel_tick(timer_wheel_t *wheel);
+
+/*
+ * Ticks until the wheel next has work: a timer expiring or a higher level
+ * cascading down. Every tick before that one is a no-op, so a sleeping
+ * caller can skip them. TIMER_WHEEL_IDLE when nothing is pending.
+ */
+uint32_t timer_wheel_next_work(const timer_wheel_t *wheel);
+// Same as `ticks` calls to timer_wheel_tick, jumping over the idle ones.
+void timer_wheel_advance(timer_wheel_t *wheel, uint32_t ticks);
+
+static inline bool timer_node_pending(const timer_node_t *node)
+{
+    return node->pprev != NULL;
+}
+
+#endif /* TIMER_WHEEL_H */
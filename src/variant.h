@@ -0,0 +1,55 @@
+#ifndef VARIANT_H
+#define VARIANT_H
+
+/*
+ * Shape of the cabinet this firmware is built for. Each cabinet gets its
+ * own image (see the QUTy_*pad environments in platformio.ini), so these
+ * are compile-time constants and every pad loop and per-pad table sizes
+ * itself from them. Override with -D; the defaults are the four-pad QUTy.
+ *
+ *   SIMON_BUTTON_COUNT       pads, and so colours and tones: 4, 6 or 8
+ *   SIMON_MAX_SEQUENCE       steps in a normal game before it is won
+ *   SIMON_HIGHSCORE_ENTRIES  leaderboard rows
+ *   SIMON_SKETCH_K           reaction-time sketch size (see sketch.h), 0
+ *                            for none; the QUTy's 2 KB of RAM leaves it out
+ */
+#ifndef SIMON_BUTTON_COUNT
+#define SIMON_BUTTON_COUNT 4
+#endif
+
+#ifndef SIMON_MAX_SEQUENCE
+#define SIMON_MAX_SEQUENCE 32
+#endif
+
+#ifndef SIMON_HIGHSCORE_ENTRIES
+#define SIMON_HIGHSCORE_ENTRIES 5
+#endif
+
+#ifndef SIMON_SKETCH_K
+#if defined(__AVR__)
+#define SIMON_SKETCH_K 0
+#else
+#define SIMON_SKETCH_K 32
+#endif
+#endif
+
+#if SIMON_BUTTON_COUNT != 4 && SIMON_BUTTON_COUNT != 6 && SIMON_BUTTON_COUNT != 8
+#error "SIMON_BUTTON_COUNT must be 4, 6 or 8"
+#endif
+
+#if SIMON_MAX_SEQUENCE < 1
+#error "SIMON_MAX_SEQUENCE must be at least 1"
+#endif
+
+#if SIMON_HIGHSCORE_ENTRIES < 1
+#error "SIMON_HIGHSCORE_ENTRIES must be at least 1"
+#endif
+
+#if SIMON_SKETCH_K != 0 && (SIMON_SKETCH_K < 4 || SIMON_SKETCH_K > 63)
+#error "SIMON_SKETCH_K must be 0 or between 4 and 63"
+#endif
+
+// One bit per pad in button masks and LED patterns, first pad leftmost.
+#define SIMON_BUTTON_MASK ((1u << SIMON_BUTTON_COUNT) - 1u)
+
+#endif /* VARIANT_H */